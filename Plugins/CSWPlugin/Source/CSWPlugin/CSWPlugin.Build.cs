@@ -84,13 +84,14 @@ public class CSWPlugin : ModuleRules
                 //"InputCore",
 				
                 "MeshDescription",
-				//"RenderCore",
-				//"RHI",
+				"RenderCore",
+				"RHI",
 				"StaticMeshDescription",
 				//"PhysicsCore",
                 "CSW",
 				"Projects",				// Plugins
 				"MeshConversion",
+				"ProceduralMeshComponent",
                 // ... add other public dependencies that you statically link with here ...
 				     
             }
@@ -38,23 +38,552 @@
 
 // GizmoSDK
 #include "gzGeometry.h"
+#include "gzTime.h"
 
 // Glue
 #include "UEGlue/cswUEMatrix.h"
 
+#include "Utility/cswVertexCache.h"
+
 #include "cswResourceManager.h"
 #include "cswSceneManagerBase.h"
 
 #include "MeshDescription.h"
 #include "StaticMeshAttributes.h"
+#include "ProceduralMeshComponent.h"
 
 GZ_DECLARE_TYPE_CHILD(gzReference, cswGeometryBuild, "cswGeometryBuild");
+GZ_DECLARE_TYPE_CHILD(gzReference, cswDynamicMeshData, "cswDynamicMeshData");
+
+//---------------------- Mesh conversion -------------------------------------
+
+bool cswBuildMeshDescription(gzGeometry* geom, FMeshDescription& MeshDescription, const BuildProperties& buildProperties, const FName& materialSlot, const cswAtlasRegion* atlasRegion)
+{
+	GZ_INSTRUMENT_NAME("cswBuildMeshDescription");
+
+	if (!geom || geom->getGeoPrimType() != GZ_PRIM_TRIS)
+		return false;
+
+	// Registrera s mnga UV-lager du behver (standard r 1) // Om du vill ha fler lager:
+	const int32 NumUVChannels = geom->getTextureUnits();
+
+	MeshDescription.SetNumUVChannels(NumUVChannels);
+
+	FStaticMeshAttributes Attributes(MeshDescription);
+
+	Attributes.Register();
+
+	// Skapa en PolygonGroup (en grupp fr polygoner, oftast en grupp = ett material) 
+	FPolygonGroupID PolygonGroupID = MeshDescription.CreatePolygonGroup();
+
+	// Named slots are matched against static material imported slot names
+	if (materialSlot != NAME_None)
+		Attributes.GetPolygonGroupMaterialSlotNames()[PolygonGroupID] = materialSlot;
+
+
+	// --------------- coordinates (vertices) ----------------------
+
+	gzArray<gzVec3>& coordinates = geom->getCoordinateArray(FALSE);
+
+	const gzUInt32 vcount = coordinates.getSize();
+
+	{
+		GZ_INSTRUMENT_NAME("UCSWGeometry::build::vertice setup");
+
+		// Reserve vertices in mesh description
+		MeshDescription.ReserveNewVertices(vcount);
+
+		TVertexAttributesRef<FVector3f> vertex = Attributes.GetVertexPositions();
+
+		for (gzUInt32 i = 0; i < vcount; i++)
+		{
+			MeshDescription.CreateVertex();
+			vertex[i] = cswVector3::UEVector3(coordinates[i]);
+		}
+	}
+
+	// --------------- indices -------------------------------------
+
+	gzArray<gzUInt32>& indices = geom->getIndexArray(FALSE);
+
+	// Triangle list of vertex indices. Non indexed geometry uses coordinates in order
+	TArray<uint32> triangles;
+
+	if (indices.getSize())
+	{
+		triangles.SetNumUninitialized(indices.getSize());
+
+		for (gzUInt32 i = 0; i < indices.getSize(); i++)
+			triangles[i] = indices[i];
+	}
+	else
+	{
+		triangles.SetNumUninitialized(vcount);
+
+		for (gzUInt32 i = 0; i < vcount; i++)
+			triangles[i] = i;
+	}
+
+	const gzUInt32 icount = triangles.Num() - triangles.Num() % 3;
+
+	// Attributes bound per primitive need one vertex instance per corner and the original triangle order
+	gzBool perPrim = geom->getNormalBind() == GZ_BIND_PER_PRIM || geom->getColorBind() == GZ_BIND_PER_PRIM;
+
+	for (gzUInt32 layer = 0; layer < geom->getTextureUnits(); layer++)
+	{
+		if (geom->getTexBind(layer) == GZ_BIND_PER_PRIM)
+			perPrim = TRUE;
+	}
+
+	if (!perPrim && buildProperties.optimizeVertexCache)
+	{
+		cswBuildStatistics* statistics = buildProperties.statistics;
+
+		const gzUInt32 tcount = icount / 3;
+
+		if (statistics)
+			statistics->vertexCacheMissesBefore += FMath::RoundToInt(cswVertexCacheACMR(triangles) * tcount);
+
+		cswOptimizeVertexCache(triangles, vcount);
+
+		if (statistics)
+		{
+			statistics->vertexCacheMissesAfter += FMath::RoundToInt(cswVertexCacheACMR(triangles) * tcount);
+			statistics->vertexCacheTriangles += tcount;
+		}
+	}
+
+	// Reserve indices in mesh description
+	MeshDescription.ReserveNewVertexInstances(perPrim ? icount : vcount);
+	MeshDescription.ReserveNewTriangles(icount / 3);
+
+	TVertexInstanceAttributesRef<FVector3f> normal = Attributes.GetVertexInstanceNormals();
+	TVertexInstanceAttributesRef<FVector2f> texcoord = Attributes.GetVertexInstanceUVs();
+	TVertexInstanceAttributesRef<FVector4f> colors = Attributes.GetVertexInstanceColors();
+
+	gzArray<gzVec3>& normal_in(geom->getNormalArray(FALSE));
+	gzArray<gzVec4>& colors_in(geom->getColorArray(FALSE));
+	gzArray<gzArray<gzVec2>>& texcoord_in(geom->getTexCoordinateArrays(FALSE));
+
+	auto uv = [&](gzUInt32 layer, gzUInt32 element) -> FVector2f
+	{
+		FVector2f value = cswVector2::UEVector2(texcoord_in[layer][element]);
+
+		if (layer == 0 && atlasRegion)
+			value = atlasRegion->uvOffset + value * atlasRegion->uvScale;
+
+		return value;
+	};
+
+	auto createInstance = [&](gzUInt32 index, gzUInt32 prim) -> FVertexInstanceID
+	{
+		FVertexInstanceID ind = MeshDescription.CreateVertexInstance(index);
+
+		// Normal -----------------------------------------------
+
+		switch (geom->getNormalBind())
+		{
+			case GZ_BIND_OFF:
+				normal[ind] = cswVector3::UEVector3(gzVec3(0, 1, 0));
+				break;
+
+			case GZ_BIND_OVERALL:
+				normal[ind] = cswVector3::UEVector3(normal_in[0]);
+				break;
+
+			case GZ_BIND_PER_PRIM:
+				normal[ind] = cswVector3::UEVector3(normal_in[prim]);
+				break;
+
+			case GZ_BIND_ON:
+				normal[ind] = cswVector3::UEVector3(normal_in[index]);
+				break;
+
+		}
+
+		// Tex -----------------------------------------------
+
+		for (gzUInt32 layer = 0; layer < geom->getTextureUnits(); layer++)
+		{
+			switch (geom->getTexBind(layer))
+			{
+				case GZ_BIND_OFF:
+					break;
+
+				case GZ_BIND_OVERALL:
+					texcoord.Set(ind, layer, uv(layer, 0));
+					break;
+
+				case GZ_BIND_PER_PRIM:
+					texcoord.Set(ind, layer, uv(layer, prim));
+					break;
+
+
+				case GZ_BIND_ON:
+					texcoord.Set(ind, layer, uv(layer, index));
+					break;
+
+			}
+		}
+
+		// Color -----------------------------------------------
+
+		switch (geom->getColorBind())
+		{
+			case GZ_BIND_OFF:
+				break;
+
+			case GZ_BIND_OVERALL:
+				colors[ind] = cswVector4::UEVector4(colors_in[0]);
+				break;
+
+			case GZ_BIND_PER_PRIM:
+				colors[ind] = cswVector4::UEVector4(colors_in[prim]);
+				break;
+
+			case GZ_BIND_ON:
+				colors[ind] = cswVector4::UEVector4(colors_in[index]);
+				break;
+
+		}
+
+		return ind;
+	};
+
+	TArray<FVertexInstanceID> id;
+	id.SetNum(3);
+
+	{
+		GZ_INSTRUMENT_NAME("UCSWGeometry::build::attrib setup");
+
+		// Shared vertex instances give one render vertex per gizmo vertex and UE selects 16 bit
+		// indices below 65536 vertices. Fast build keeps the order so render vertex i is gizmo vertex i
+		if (!perPrim)
+		{
+			for (gzUInt32 index = 0; index < vcount; index++)
+				createInstance(index, 0);
+		}
+
+		for (gzUInt32 i = 0; i < icount; i += 3)
+		{
+			for (gzUInt32 j = 0; j < 3; j++)
+			{
+				const gzUInt32 index = triangles[i + 2 - j];
+
+				if (index >= vcount)
+					return false;
+
+				id[j] = perPrim ? createInstance(index, i / 3) : FVertexInstanceID(index);
+			}
+
+			{
+				GZ_INSTRUMENT_NAME("UCSWGeometry::build::poly");
+				MeshDescription.CreatePolygon(PolygonGroupID, id);
+			}
+		}
+	}
+
+
+	return true;
+}
+
+bool cswBuildMeshDescription(const cswDynamicMeshData& data, FMeshDescription& MeshDescription)
+{
+	GZ_INSTRUMENT_NAME("cswBuildMeshDescription");
+
+	MeshDescription.SetNumUVChannels(1);
+
+	FStaticMeshAttributes Attributes(MeshDescription);
+
+	Attributes.Register();
+
+	FPolygonGroupID PolygonGroupID = MeshDescription.CreatePolygonGroup();
+
+	const int32 vcount = data.vertices.Num();
+
+	MeshDescription.ReserveNewVertices(vcount);
+	MeshDescription.ReserveNewVertexInstances(vcount);
+	MeshDescription.ReserveNewTriangles(data.triangles.Num() / 3);
+
+	TVertexAttributesRef<FVector3f> vertex = Attributes.GetVertexPositions();
+	TVertexInstanceAttributesRef<FVector3f> normal = Attributes.GetVertexInstanceNormals();
+	TVertexInstanceAttributesRef<FVector2f> texcoord = Attributes.GetVertexInstanceUVs();
+	TVertexInstanceAttributesRef<FVector4f> colors = Attributes.GetVertexInstanceColors();
+
+	for (int32 i = 0; i < vcount; i++)
+	{
+		FVertexID id = MeshDescription.CreateVertex();
+		vertex[id] = FVector3f(data.vertices[i]);
+
+		FVertexInstanceID ind = MeshDescription.CreateVertexInstance(id);
+
+		if (data.normals.IsValidIndex(i))
+			normal[ind] = FVector3f(data.normals[i]);
+
+		if (data.uv0.IsValidIndex(i))
+			texcoord.Set(ind, 0, FVector2f(data.uv0[i]));
+
+		if (data.colors.IsValidIndex(i))
+			colors[ind] = FVector4f(data.colors[i].R, data.colors[i].G, data.colors[i].B, data.colors[i].A);
+	}
+
+	TArray<FVertexInstanceID> id;
+	id.SetNum(3);
+
+	for (int32 i = 0; i + 2 < data.triangles.Num(); i += 3)
+	{
+		for (int32 j = 0; j < 3; j++)
+			id[j] = FVertexInstanceID(data.triangles[i + j]);
+
+		MeshDescription.CreatePolygon(PolygonGroupID, id);
+	}
+
+	return true;
+}
+
+bool cswBuildDynamicMeshData(gzGeometry* geom, cswDynamicMeshData& data, const cswAtlasRegion* atlasRegion)
+{
+	GZ_INSTRUMENT_NAME("cswBuildDynamicMeshData");
+
+	if (!geom || geom->getGeoPrimType() != GZ_PRIM_TRIS)
+		return false;
+
+	gzArray<gzVec3>& coordinates = geom->getCoordinateArray(FALSE);
+	gzArray<gzUInt32>& indices = geom->getIndexArray(FALSE);
+	gzArray<gzVec3>& normal_in(geom->getNormalArray(FALSE));
+	gzArray<gzVec4>& colors_in(geom->getColorArray(FALSE));
+	gzArray<gzArray<gzVec2>>& texcoord_in(geom->getTexCoordinateArrays(FALSE));
+
+	const gzUInt32 vcount = coordinates.getSize();
+	const gzUInt32 icount = indices.getSize() ? indices.getSize() : vcount;
+
+	const gzGeoAttribBinding normalBind = geom->getNormalBind();
+	const gzGeoAttribBinding colorBind = geom->getColorBind();
+	const gzGeoAttribBinding texBind = geom->getTextureUnits() ? geom->getTexBind(0) : GZ_BIND_OFF;
+
+	// Per primitive attributes need one vertex per corner
+	const gzBool perPrim = normalBind == GZ_BIND_PER_PRIM || colorBind == GZ_BIND_PER_PRIM || texBind == GZ_BIND_PER_PRIM;
+
+	// Element of an attribute array for a vertex or -1 if unbound
+	auto element = [](gzGeoAttribBinding bind, gzUInt32 index, gzUInt32 prim) -> int32
+	{
+		switch (bind)
+		{
+			case GZ_BIND_OVERALL:
+				return 0;
+
+			case GZ_BIND_PER_PRIM:
+				return prim;
+
+			case GZ_BIND_ON:
+				return index;
+
+			default:
+				return -1;
+		}
+	};
+
+	auto addVertex = [&](gzUInt32 index, gzUInt32 prim)
+	{
+		data.vertices.Add(FVector(cswVector3::UEVector3(coordinates[index])));
+
+		int32 n = element(normalBind, index, prim);
+		data.normals.Add(n >= 0 ? FVector(cswVector3::UEVector3(normal_in[n])) : FVector(cswVector3::UEVector3(gzVec3(0, 1, 0))));
+
+		int32 t = element(texBind, index, prim);
+		FVector2f uv = t >= 0 ? cswVector2::UEVector2(texcoord_in[0][t]) : FVector2f::ZeroVector;
+
+		if (atlasRegion)
+			uv = atlasRegion->uvOffset + uv * atlasRegion->uvScale;
+
+		data.uv0.Add(FVector2D(uv));
+
+		int32 c = element(colorBind, index, prim);
+
+		if (c >= 0)
+		{
+			FVector4f color = cswVector4::UEVector4(colors_in[c]);
+			data.colors.Add(FLinearColor(color.X, color.Y, color.Z, color.W));
+		}
+		else
+			data.colors.Add(FLinearColor::White);
+	};
+
+	const gzUInt32 reserve = perPrim ? icount : vcount;
+
+	data.vertices.Reserve(reserve);
+	data.normals.Reserve(reserve);
+	data.uv0.Reserve(reserve);
+	data.colors.Reserve(reserve);
+	data.triangles.Reserve(icount);
+
+	if (!perPrim)
+	{
+		for (gzUInt32 index = 0; index < vcount; index++)
+			addVertex(index, 0);
+	}
+
+	for (gzUInt32 i = 0; i + 2 < icount; i += 3)
+	{
+		// Same winding as the static mesh build
+		for (gzUInt32 j = 0; j < 3; j++)
+		{
+			const gzUInt32 index = indices.getSize() ? indices[i + 2 - j] : i + 2 - j;
+
+			if (index >= vcount)
+				return false;
+
+			if (perPrim)
+			{
+				data.triangles.Add(data.vertices.Num());
+				addVertex(index, i / 3);
+			}
+			else
+				data.triangles.Add(index);
+		}
+	}
+
+	return true;
+}
+
+UStaticMesh* cswBuildStaticMesh(const TArray<const FMeshDescription*>& lods, const TArray<FName>& materialSlots, const BuildProperties& buildProperties, bool allowCpuAccess)
+{
+	GZ_INSTRUMENT_NAME("cswBuildStaticMesh");
+
+	if (!lods.Num())
+		return nullptr;
+
+	UStaticMesh* staticMesh(nullptr);
+
+	{
+		FGCScopeGuard guard;
+
+		staticMesh = NewObject<UStaticMesh>();
+	}
+
+	// Get material array
+	TArray<FStaticMaterial>& materials = staticMesh->GetStaticMaterials();
+
+	for (const FName& slot : materialSlots)
+	{
+		// Setup a static material
+		FStaticMaterial staticMaterial(nullptr, slot, slot);
+
+		// Enable UVChannel data
+		staticMaterial.UVChannelData.bInitialized = true;
+
+		// Add the static material for current mesh
+		materials.Add(staticMaterial);
+	}
+
+	staticMesh->bDoFastBuild = buildProperties.fastBuild;
+	staticMesh->bSupportRayTracing = false;
+
+	// Some extra build parmeters
+	UStaticMesh::FBuildMeshDescriptionsParams mdParams;
+
+	mdParams.bBuildSimpleCollision = buildProperties.buildSimpleCollision;
+	mdParams.bFastBuild = buildProperties.fastBuild;
+	mdParams.bCommitMeshDescription = false;
+	mdParams.bAllowCpuAccess = allowCpuAccess;
+	mdParams.bMarkPackageDirty = false;
+
+	// Build static mesh ----------------------------------------------------------------------
+
+	{
+		GZ_INSTRUMENT_NAME("cswBuildStaticMesh::mesh build");
+
+		staticMesh->BuildFromMeshDescriptions(lods, mdParams);
+	}
+
+	// Index stride is chosen by UE from vertex count. Record what we got
+	FStaticMeshRenderData* renderData = staticMesh->GetRenderData();
+
+	if (buildProperties.statistics && renderData)
+	{
+		cswBuildStatistics* statistics = buildProperties.statistics;
+
+		statistics->meshes++;
+
+		for (const FStaticMeshLODResources& lod : renderData->LODResources)
+		{
+			const gzUInt64 numIndices = lod.IndexBuffer.GetNumIndices();
+
+			if (!lod.IndexBuffer.Is32Bit())
+				statistics->meshes16Bit++;
+
+			statistics->vertices += lod.GetNumVertices();
+			statistics->indexBytes += numIndices * (lod.IndexBuffer.Is32Bit() ? 4 : 2);
+			statistics->sourceIndexBytes += numIndices * sizeof(gzUInt32);
+		}
+	}
+
+	return staticMesh;
+}
+
+void cswBuildQueryData(gzGeometry* geom, const BuildProperties& buildProperties, cswHeightTilePtr& heightTile, cswMeshBVHPtr& intersectTree)
+{
+	GZ_INSTRUMENT_NAME("cswBuildQueryData");
+
+	heightTile = buildProperties.buildHeightTiles ? cswBuildHeightTile(geom) : nullptr;
+
+	intersectTree = nullptr;
+
+	if (!buildProperties.buildIntersectTrees)
+		return;
+
+	const gzDouble start = gzTime::systemSeconds();
+
+	intersectTree = cswBuildMeshBVH(geom);
+
+	if (intersectTree && buildProperties.statistics)
+	{
+		buildProperties.statistics->intersectTrees++;
+		buildProperties.statistics->intersectTreeMicroseconds += (gzUInt64)((gzTime::systemSeconds() - start) * 1e6);
+		buildProperties.statistics->intersectTreeBytes += intersectTree->getBytes();
+	}
+}
 
 // Sets default values for this component's properties
 UCSWGeometry::UCSWGeometry(const FObjectInitializer& ObjectInitializer) : Super(ObjectInitializer)
 {
+	// Tick is registered when the first dynamic mesh is shown
+	PrimaryComponentTick.bCanEverTick = false;
+	PrimaryComponentTick.bStartWithTickEnabled = false;
 }
 
+void UCSWGeometry::setupMeshComponent(const BuildProperties& buildProperties)
+{
+	// Settings specific and optims for fast render
+	m_meshComponent->SetSimulatePhysics(buildProperties.simulatePhysics);
+	m_meshComponent->SetCollisionEnabled(buildProperties.collision);
+
+	m_meshComponent->SetUsingAbsoluteLocation(false);
+	m_meshComponent->SetUsingAbsoluteRotation(false);
+	m_meshComponent->SetUsingAbsoluteScale(false);
+	
+	#if CSW_FORCE_LOD0
+	m_meshComponent->ForcedLodModel = 1; // Force LOD0
+	#else
+	m_meshComponent->ForcedLodModel = 0; // Auto LOD
+	#endif
+
+	m_meshComponent->SetMobility(EComponentMobility::Stationary);
+
+	m_meshComponent->SetRenderCustomDepth(false); // stnger av outline effekter
+
+	//m_meshComponent->SetCastShadow(false); // Ingen skuggning
+
+	m_meshComponent->bAffectDistanceFieldLighting = false; // avstndsbaserad 
+
+	m_meshComponent->bAffectDynamicIndirectLighting = false;
+
+	m_meshComponent->bAlwaysCreatePhysicsState = false;
+
+	m_meshComponent->bReceivesDecals = false;
+
+	//m_meshComponent->bUseAttachParentBound = true;
+}
 
 bool UCSWGeometry::build(UCSWSceneComponent* parent, gzNode* buildItem, gzState* state, BuildProperties& buildProperties, cswResourceManager* resources)
 {
@@ -69,6 +598,20 @@ bool UCSWGeometry::build(UCSWSceneComponent* parent, gzNode* buildItem, gzState*
 	if (!buildData)
 		return false;
 
+	// Geometry is rendered by a merged parent mesh (LOD). Keep node only
+	if (buildData->merged)
+	{
+		buildItem->removeAllUserData();
+		return true;
+	}
+
+	// Reported by the factory. Keep node so queries and later updates still find it
+	if (!buildData->staticMesh)
+	{
+		GZMESSAGE(GZ_MESSAGE_DEBUG, "UCSWGeometry::build: no mesh for '%s'", (const char*)buildItem->getName());
+		buildItem->removeAllUserData();
+		return true;
+	}
 
 	{
 		GZ_INSTRUMENT_NAME("UCSWGeometry::build::component setup");
@@ -76,36 +619,7 @@ bool UCSWGeometry::build(UCSWSceneComponent* parent, gzNode* buildItem, gzState*
 		// New object
 		m_meshComponent = NewObject<UStaticMeshComponent>(this, buildItem->getName().getWideString());
 
-		// Settings specific and optims for fast render
-		m_meshComponent->SetSimulatePhysics(buildProperties.simulatePhysics);
-		m_meshComponent->SetCollisionEnabled(buildProperties.collision);
-
-		m_meshComponent->SetUsingAbsoluteLocation(false);
-		m_meshComponent->SetUsingAbsoluteRotation(false);
-		m_meshComponent->SetUsingAbsoluteScale(false);
-		
-		#if CSW_FORCE_LOD0
-		m_meshComponent->ForcedLodModel = 1; // Force LOD0
-		#else
-		m_meshComponent->ForcedLodModel = 0; // Auto LOD
-		#endif
-
-		m_meshComponent->SetMobility(EComponentMobility::Stationary);
-
-		m_meshComponent->SetRenderCustomDepth(false); // stnger av outline effekter
-
-		//m_meshComponent->SetCastShadow(false); // Ingen skuggning
-
-		m_meshComponent->bAffectDistanceFieldLighting = false; // avstndsbaserad 
-
-		m_meshComponent->bAffectDynamicIndirectLighting = false;
-
-		m_meshComponent->bAlwaysCreatePhysicsState = false;
-
-		m_meshComponent->bReceivesDecals = false;
-
-		//m_meshComponent->bUseAttachParentBound = true;
-
+		setupMeshComponent(buildProperties);
 	}
 	
 			
@@ -114,9 +628,12 @@ bool UCSWGeometry::build(UCSWSceneComponent* parent, gzNode* buildItem, gzState*
 	{
 		GZ_INSTRUMENT_NAME("UCSWGeometry::build::set mesh");
 		m_meshComponent->SetStaticMesh(buildData->staticMesh);
+		buildData->shown = true;
 	}
 
-	UMaterialInterface* material = resources->getMaterial(this, state, CSW_MATERIAL_TYPE_BASE_MATERIAL);
+	m_atlasRegion = buildData->atlasRegion;
+
+	UMaterialInterface* material = resources->getMaterial(this, state, CSW_MATERIAL_TYPE_BASE_MATERIAL, m_atlasRegion, buildData->texture);
 
 	if(material)
 		m_meshComponent->SetMaterial(0,material);
@@ -149,6 +666,27 @@ bool UCSWGeometry::update(UCSWSceneComponent* parent, gzNode* buildItem, gzState
 	if (!buildData)
 		return false;
 
+	// High frequency updates are shown by a procedural mesh until they stop
+	if (buildData->dynamicMesh)
+	{
+		if (shouldSkipUpdate(buildItem))
+			return true;
+
+		if (!updateDynamicMesh(buildData, state, buildProperties, resources))
+			return false;
+
+		markUpdated(buildItem);
+
+		return true;
+	}
+
+	// Merged, or a failed rebuild reported by the factory. Keep what we show
+	if (buildData->merged || !buildData->staticMesh)
+	{
+		markUpdated(buildItem);
+		return true;
+	}
+
 	if (!m_meshComponent)
 	{
 		GZMESSAGE(GZ_MESSAGE_WARNING, "UCSWGeometry::update: missing mesh component, rebuilding");
@@ -158,32 +696,52 @@ bool UCSWGeometry::update(UCSWSceneComponent* parent, gzNode* buildItem, gzState
 	if (shouldSkipUpdate(buildItem))
 		return true;
 
-	// Update component settings and mesh without creating a new component
-	m_meshComponent->SetSimulatePhysics(buildProperties.simulatePhysics);
-	m_meshComponent->SetCollisionEnabled(buildProperties.collision);
-	m_meshComponent->SetUsingAbsoluteLocation(false);
-	m_meshComponent->SetUsingAbsoluteRotation(false);
-	m_meshComponent->SetUsingAbsoluteScale(false);
+	// Only vertex attributes changed. Write them into the mesh we already show
+	if (buildData->delta && m_meshComponent->GetStaticMesh() == buildData->staticMesh)
+	{
+		if (cswApplyGeometryDelta(buildData->staticMesh, buildData->delta, &m_deltaFence))
+		{
+			buildData->delta->applied = true;
 
-	#if CSW_FORCE_LOD0
-	m_meshComponent->ForcedLodModel = 1; // Force LOD0
-	#else
-	m_meshComponent->ForcedLodModel = 0; // Auto LOD
-	#endif
+			markUpdated(buildItem);
 
-	m_meshComponent->SetMobility(EComponentMobility::Stationary);
-	m_meshComponent->SetRenderCustomDepth(false);
-	m_meshComponent->bAffectDistanceFieldLighting = false;
-	m_meshComponent->bAffectDynamicIndirectLighting = false;
-	m_meshComponent->bAlwaysCreatePhysicsState = false;
-	m_meshComponent->bReceivesDecals = false;
+			return true;
+		}
+
+		GZMESSAGE(GZ_MESSAGE_WARNING, "UCSWGeometry::update: failed to apply vertex delta");
+	}
+
+	// Update component settings and mesh without creating a new component
+	setupMeshComponent(buildProperties);
+
+	// Previous mesh can be collected once it is replaced
+	if (m_meshComponent->GetStaticMesh() != buildData->staticMesh)
+		m_deltaFence.Wait();
 
 	if (buildData->staticMesh)
+	{
 		m_meshComponent->SetStaticMesh(buildData->staticMesh);
+		buildData->shown = true;
+	}
+
+	// Factory is back on static meshes
+	if (m_dynamicComponent)
+	{
+		m_dynamicComponent->DestroyComponent();
+		m_dynamicComponent = nullptr;
+		m_dynamicMesh = nullptr;
+
+		m_meshComponent->SetVisibility(true);
+	}
 
 	markUpdated(buildItem);
 
-	UMaterialInterface* material = resources->getMaterial(this, state, CSW_MATERIAL_TYPE_BASE_MATERIAL);
+	// State may have changed. Reacquire shared material
+	resources->releaseMaterials(this);
+
+	m_atlasRegion = buildData->atlasRegion;
+
+	UMaterialInterface* material = resources->getMaterial(this, state, CSW_MATERIAL_TYPE_BASE_MATERIAL, m_atlasRegion, buildData->texture);
 	if (material)
 		m_meshComponent->SetMaterial(0, material);
 
@@ -202,7 +760,146 @@ bool  UCSWGeometry::destroy(gzNode* destroyItem, cswResourceManager* resources)
 
 	GZ_INSTRUMENT_NAME("UCSWGeometry::destroy");
 
-	m_meshComponent->DestroyComponent();
+	// Delta uploads read the render data of our mesh
+	m_deltaFence.Wait();
+
+	if (m_meshComponent)
+		m_meshComponent->DestroyComponent();
+
+	if (m_dynamicComponent)
+		m_dynamicComponent->DestroyComponent();
+
+	if (resources)
+		resources->releaseMaterials(this);
+
+	m_dynamicMesh = nullptr;
+
+	// Frees the page area
+	m_atlasRegion = nullptr;
 
 	return Super::destroy(destroyItem, resources);
 }
+
+bool UCSWGeometry::updateDynamicMesh(cswGeometryBuild* buildData, gzState* state, const BuildProperties& buildProperties, cswResourceManager* resources)
+{
+	GZ_INSTRUMENT_NAME("UCSWGeometry::updateDynamicMesh");
+
+	cswDynamicMeshData* dynamicMesh = buildData->dynamicMesh;
+
+	if (!m_dynamicComponent)
+	{
+		m_dynamicComponent = NewObject<UProceduralMeshComponent>(this);
+
+		m_dynamicComponent->SetCollisionEnabled(buildProperties.collision);
+		m_dynamicComponent->bUseAsyncCooking = true;
+		m_dynamicComponent->SetMobility(EComponentMobility::Movable);
+
+		m_dynamicComponent->AttachToComponent(this, FAttachmentTransformRules::KeepRelativeTransform);
+		m_dynamicComponent->RegisterComponent();
+	}
+
+	// Same vertex layout rewrites the section buffers in place
+	const bool sameLayout = m_dynamicMesh && m_dynamicMesh->vertices.Num() == dynamicMesh->vertices.Num() && m_dynamicMesh->triangles == dynamicMesh->triangles;
+
+	if (sameLayout)
+	{
+		GZ_INSTRUMENT_NAME("UCSWGeometry::updateDynamicMesh::update section");
+		m_dynamicComponent->UpdateMeshSection_LinearColor(0, dynamicMesh->vertices, dynamicMesh->normals, dynamicMesh->uv0, dynamicMesh->colors, TArray<FProcMeshTangent>());
+	}
+	else
+	{
+		GZ_INSTRUMENT_NAME("UCSWGeometry::updateDynamicMesh::create section");
+		m_dynamicComponent->CreateMeshSection_LinearColor(0, dynamicMesh->vertices, dynamicMesh->triangles, dynamicMesh->normals, dynamicMesh->uv0, dynamicMesh->colors, TArray<FProcMeshTangent>(), false);
+	}
+
+	// State may have changed. Cached materials make this a lookup
+	resources->releaseMaterials(this);
+
+	m_atlasRegion = buildData->atlasRegion;
+
+	UMaterialInterface* material = resources->getMaterial(this, state, CSW_MATERIAL_TYPE_BASE_MATERIAL, m_atlasRegion, buildData->texture);
+
+	if (material)
+		m_dynamicComponent->SetMaterial(0, material);
+
+	// Keep static component for when updates stop
+	if (m_meshComponent)
+		m_meshComponent->SetVisibility(false);
+
+	m_dynamicMesh = dynamicMesh;
+	m_dynamicUpdateTime = gzTime::systemSeconds();
+	m_dynamicBuildProperties = buildProperties;
+
+	if (!PrimaryComponentTick.bCanEverTick)
+	{
+		PrimaryComponentTick.bCanEverTick = true;
+		RegisterComponentTickFunctions(true);
+	}
+
+	SetComponentTickEnabled(true);
+
+	return true;
+}
+
+void UCSWGeometry::TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	if (!m_dynamicComponent)
+	{
+		SetComponentTickEnabled(false);
+		return;
+	}
+
+	if (gzTime::systemSeconds() - m_dynamicUpdateTime < m_dynamicBuildProperties.dynamicMeshIdleTime)
+		return;
+
+	convertDynamicToStatic();
+
+	SetComponentTickEnabled(false);
+}
+
+void UCSWGeometry::convertDynamicToStatic()
+{
+	GZ_INSTRUMENT_NAME("UCSWGeometry::convertDynamicToStatic");
+
+	UMaterialInterface* material = m_dynamicComponent->GetMaterial(0);
+
+	FMeshDescription MeshDescription;
+
+	if (m_dynamicMesh && cswBuildMeshDescription(*m_dynamicMesh, MeshDescription))
+	{
+		TArray<const FMeshDescription*> meshDescPtrs;
+		meshDescPtrs.Emplace(&MeshDescription);
+
+		UStaticMesh* staticMesh = cswBuildStaticMesh(meshDescPtrs, { NAME_None }, m_dynamicBuildProperties);
+
+		if (staticMesh)
+		{
+			if (!m_meshComponent)
+			{
+				m_meshComponent = NewObject<UStaticMeshComponent>(this);
+
+				setupMeshComponent(m_dynamicBuildProperties);
+
+				m_meshComponent->AttachToComponent(this, FAttachmentTransformRules::KeepRelativeTransform);
+				m_meshComponent->RegisterComponent();
+			}
+
+			// Delta uploads may still read the render data of the mesh we replace
+			m_deltaFence.Wait();
+
+			m_meshComponent->SetStaticMesh(staticMesh);
+
+			if (material)
+				m_meshComponent->SetMaterial(0, material);
+
+			// Baked with the uvs and material of the last update, so m_atlasRegion stays
+			m_meshComponent->SetVisibility(true);
+		}
+	}
+
+	m_dynamicComponent->DestroyComponent();
+	m_dynamicComponent = nullptr;
+	m_dynamicMesh = nullptr;
+}
@@ -37,8 +37,31 @@
 #pragma once
 
 #include "cswNode.h"
+#include "cswResourceManager.h"
+#include "cswHeightCache.h"
+#include "cswMeshBVH.h"
+#include "Builders/cswGeometryDelta.h"
+#include "RenderingThread.h"
 #include "cswGeometry.generated.h"
 
+class UProceduralMeshComponent;
+class cswGeometryBuild;
+
+// Vertex data for a procedural mesh section. Render vertex order like static meshes
+class cswDynamicMeshData : public gzReference
+{
+public:
+	GZ_DECLARE_TYPE_INTERFACE;
+
+	TArray<FVector>			vertices;
+	TArray<int32>			triangles;
+	TArray<FVector>			normals;
+	TArray<FVector2D>		uv0;
+	TArray<FLinearColor>	colors;
+};
+
+GZ_DECLARE_REFPTR(cswDynamicMeshData);
+
 UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
 class CSWPLUGIN_API UCSWGeometry : public UCSWNode
 {
@@ -54,12 +77,30 @@ public:
 
 	virtual bool destroy(gzNode* destroyItem, cswResourceManager* resources) override;
 
+	// Only ticks while a dynamic mesh is shown
+	virtual void TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
 	
 protected:
 
+	void setupMeshComponent(const BuildProperties& buildProperties);
+
+	bool updateDynamicMesh(cswGeometryBuild* buildData, gzState* state, const BuildProperties& buildProperties, cswResourceManager* resources);
+
+	// Updates stopped. Bake last dynamic data into a static mesh
+	void convertDynamicToStatic();
+
 	UPROPERTY()
 	TObjectPtr<UStaticMeshComponent>	m_meshComponent;
 
+	UPROPERTY()
+	TObjectPtr<UProceduralMeshComponent>	m_dynamicComponent;
+
+	cswDynamicMeshDataPtr	m_dynamicMesh;				// Data shown by m_dynamicComponent
+	cswAtlasRegionPtr		m_atlasRegion;				// Page area used by the static mesh uvs
+	gzDouble				m_dynamicUpdateTime = 0;
+	BuildProperties			m_dynamicBuildProperties;
+
+	FRenderCommandFence		m_deltaFence;				// Last vertex delta upload into the shown mesh
 };
 
 class cswGeometryBuild : public gzReference
@@ -69,5 +110,54 @@ public:
 
 	gzUInt32				updateID;
 
-	TObjectPtr<UStaticMesh> staticMesh;
+	TObjectPtr<UStaticMesh> staticMesh;		// nullptr if merged or if the mesh build failed
+
+	gzBool					merged = FALSE;	// Rendered by a merged parent LOD mesh
+
+	cswGeometryFingerprintPtr	fingerprint;	// Retained for partial updates. nullptr if not tracked
+
+	cswGeometryDeltaPtr			delta;			// Vertex ranges to write into staticMesh. nullptr for full builds
+
+	std::atomic<bool>			shown = false;	// staticMesh has been set on the component. Deltas need it
+
+	cswDynamicMeshDataPtr		dynamicMesh;	// Set for high frequency updates shown by a procedural mesh
+
+	cswAtlasRegionPtr			atlasRegion;	// Texture 0 placed in an atlas page. Uvs of staticMesh are remapped
+
+	cswTextureBuildPtr			texture;		// Texture 0 data prepared in prebuild. nullptr if not prepared
+
+	gzImagePtr					textureImage;	// Texture 0 image when built. Dynamic updates reuse region and texture while equal
+
+	cswHeightTilePtr			heightTile;		// Terrain height grid for the height cache. nullptr if not terrain
+
+	cswMeshBVHPtr				intersectTree;	// Triangle BVH for local intersections. nullptr if not built
+
+	gzDouble					updateTime = 0;	// gzTime::systemSeconds of this build
+	gzFloat						updateRate = 0;	// Smoothed updates per second
 };
+
+GZ_DECLARE_REFPTR(cswGeometryBuild);
+
+// Mesh conversion shared by factories. Called in prebuild from manager thread
+
+class gzGeometry;
+struct FMeshDescription;
+
+//! Fill a mesh description with a GZ_PRIM_TRIS geometry. Optional material slot for the polygon group
+//! Vertex instances are shared per vertex unless attributes are bound per primitive
+//! Uv channel 0 is remapped into the atlas region if one is given
+bool cswBuildMeshDescription(gzGeometry* geom, FMeshDescription& meshDescription, const BuildProperties& buildProperties, const FName& materialSlot = NAME_None, const cswAtlasRegion* atlasRegion = nullptr);
+
+//! Fill a mesh description from dynamic mesh data. Used when baking a dynamic mesh to static
+bool cswBuildMeshDescription(const cswDynamicMeshData& data, FMeshDescription& meshDescription);
+
+//! Fill procedural mesh section data with a GZ_PRIM_TRIS geometry. First texture unit only
+//! Uvs are remapped into the atlas region if one is given
+bool cswBuildDynamicMeshData(gzGeometry* geom, cswDynamicMeshData& data, const cswAtlasRegion* atlasRegion = nullptr);
+
+//! Build a static mesh with one LOD per mesh description and one material per slot name
+//! CPU access keeps vertex data for in place updates
+UStaticMesh* cswBuildStaticMesh(const TArray<const FMeshDescription*>& lods, const TArray<FName>& materialSlots, const BuildProperties& buildProperties, bool allowCpuAccess = false);
+
+//! Height tile and intersect tree as enabled in build properties. Must be rebuilt whenever vertices change
+void cswBuildQueryData(gzGeometry* geom, const BuildProperties& buildProperties, cswHeightTilePtr& heightTile, cswMeshBVHPtr& intersectTree);
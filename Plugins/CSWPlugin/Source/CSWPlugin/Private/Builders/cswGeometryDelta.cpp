@@ -0,0 +1,421 @@
+//*****************************************************************************
+//
+// Copyright (C) SAAB AB
+//
+// All rights, including the copyright, to the computer program(s)
+// herein belong to SAAB AB. The program(s) may be used and/or
+// copied only with the written permission of SAAB AB, or in
+// accordance with the terms and conditions stipulated in the
+// agreement/contract under which the program(s) have been
+// supplied.
+//
+//
+// Information Class:	COMPANY UNCLASSIFIED
+// Defence Secrecy:		NOT CLASSIFIED
+// Export Control:		NOT EXPORT CONTROLLED
+//
+//
+// File			: cswGeometryDelta.cpp
+// Module		: CSW StreamingMap Unreal
+// Description	: Fingerprint and in place vertex updates for gzGeometry
+// Author		: agent
+// Product		: CSW 1.1.2
+//
+//
+//
+// NOTE:	CSW (Common Synthetic World) is a simulation and presentation
+//			framework for large scale digital twins on multiple platforms
+//
+//
+// Revision History...
+//
+// Who	Date	Description
+//
+// AGT	261019	Created file 					(1.1.3)
+//
+//******************************************************************************
+#include "Builders/cswGeometryDelta.h"
+
+// Glue
+#include "UEGlue/cswUEMatrix.h"
+
+#include "gzPerformance.h"
+
+#include "Engine/StaticMesh.h"
+#include "StaticMeshResources.h"
+#include "RenderingThread.h"
+#include "RHICommandList.h"
+
+GZ_DECLARE_TYPE_CHILD(gzReference, cswGeometryFingerprint, "cswGeometryFingerprint");
+GZ_DECLARE_TYPE_CHILD(gzReference, cswGeometryDelta, "cswGeometryDelta");
+
+//---------------------- cswGeometryFingerprint -------------------------------------
+
+gzBool cswGeometryFingerprint::compute(gzGeometry* geom)
+{
+	GZ_INSTRUMENT_NAME("cswGeometryFingerprint::compute");
+
+	if (!geom || geom->getGeoPrimType() != GZ_PRIM_TRIS)
+		return FALSE;
+
+	gzGeoAttribBinding normalBind = geom->getNormalBind();
+	gzGeoAttribBinding colorBind = geom->getColorBind();
+
+	// Per primitive attributes split vertices so render order does not match gizmo order
+	if (normalBind == GZ_BIND_PER_PRIM || colorBind == GZ_BIND_PER_PRIM)
+		return FALSE;
+
+	textureUnits = geom->getTextureUnits();
+
+	for (gzUInt32 layer = 0; layer < textureUnits; layer++)
+	{
+		if (geom->getTexBind(layer) == GZ_BIND_PER_PRIM)
+			return FALSE;
+	}
+
+	gzArray<gzVec3>& coordinates = geom->getCoordinateArray(FALSE);
+	gzArray<gzUInt32>& indices = geom->getIndexArray(FALSE);
+	gzArray<gzVec3>& normal_in(geom->getNormalArray(FALSE));
+	gzArray<gzVec4>& colors_in(geom->getColorArray(FALSE));
+	gzArray<gzArray<gzVec2>>& texcoord_in(geom->getTexCoordinateArrays(FALSE));
+
+	vertexCount = coordinates.getSize();
+
+	// Topology is indices, bindings and overall values -------------------
+
+	topologyHash = FCrc::MemCrc32(indices.getAddress(), indices.getSize() * sizeof(gzUInt32));
+
+	topologyHash = FCrc::MemCrc32(&normalBind, sizeof(normalBind), topologyHash);
+	topologyHash = FCrc::MemCrc32(&colorBind, sizeof(colorBind), topologyHash);
+
+	if (normalBind == GZ_BIND_OVERALL && normal_in.getSize())
+		topologyHash = FCrc::MemCrc32(&normal_in[0], sizeof(gzVec3), topologyHash);
+
+	if (colorBind == GZ_BIND_OVERALL && colors_in.getSize())
+		topologyHash = FCrc::MemCrc32(&colors_in[0], sizeof(gzVec4), topologyHash);
+
+	for (gzUInt32 layer = 0; layer < textureUnits; layer++)
+	{
+		gzGeoAttribBinding texBind = geom->getTexBind(layer);
+
+		topologyHash = FCrc::MemCrc32(&texBind, sizeof(texBind), topologyHash);
+
+		if (texBind == GZ_BIND_OVERALL && texcoord_in[layer].getSize())
+			topologyHash = FCrc::MemCrc32(&texcoord_in[layer][0], sizeof(gzVec2), topologyHash);
+	}
+
+	// Per vertex blocks ---------------------------------------------------
+
+	const gzUInt32 blocks = (vertexCount + CSW_FINGERPRINT_BLOCK - 1) / CSW_FINGERPRINT_BLOCK;
+
+	auto hashBlocks = [&](TArray<uint32>& result, const void* data, gzUInt32 stride, uint32 seed)
+	{
+		for (gzUInt32 block = 0; block < blocks; block++)
+		{
+			const gzUInt32 first = block * CSW_FINGERPRINT_BLOCK;
+			const gzUInt32 count = FMath::Min(CSW_FINGERPRINT_BLOCK, vertexCount - first);
+
+			result[block] = FCrc::MemCrc32((const uint8*)data + first * stride, count * stride, seed ? result[block] : 0);
+		}
+	};
+
+	positionBlocks.SetNumUninitialized(blocks);
+	hashBlocks(positionBlocks, coordinates.getAddress(), sizeof(gzVec3), 0);
+
+	normalBlocks.Reset();
+
+	if (normalBind == GZ_BIND_ON)
+	{
+		if (normal_in.getSize() < vertexCount)
+			return FALSE;
+
+		normalBlocks.SetNumUninitialized(blocks);
+		hashBlocks(normalBlocks, normal_in.getAddress(), sizeof(gzVec3), 0);
+	}
+
+	colorBlocks.Reset();
+
+	if (colorBind == GZ_BIND_ON)
+	{
+		if (colors_in.getSize() < vertexCount)
+			return FALSE;
+
+		colorBlocks.SetNumUninitialized(blocks);
+		hashBlocks(colorBlocks, colors_in.getAddress(), sizeof(gzVec4), 0);
+	}
+
+	texcoordBlocks.Reset();
+
+	for (gzUInt32 layer = 0; layer < textureUnits; layer++)
+	{
+		if (geom->getTexBind(layer) != GZ_BIND_ON)
+			continue;
+
+		if (texcoord_in[layer].getSize() < vertexCount)
+			return FALSE;
+
+		// All layers chained into one hash per block
+		const bool first = texcoordBlocks.Num() == 0;
+
+		if (first)
+			texcoordBlocks.SetNumZeroed(blocks);
+
+		hashBlocks(texcoordBlocks, texcoord_in[layer].getAddress(), sizeof(gzVec2), first ? 0 : 1);
+	}
+
+	bounds.Init();
+
+	for (gzUInt32 i = 0; i < vertexCount; i++)
+		bounds += cswVector3::UEVector3(coordinates[i]);
+
+	return TRUE;
+}
+
+gzBool cswGeometryFingerprint::sameTopology(const cswGeometryFingerprint& other) const
+{
+	return vertexCount == other.vertexCount && textureUnits == other.textureUnits && topologyHash == other.topologyHash;
+}
+
+//---------------------- delta -------------------------------------
+
+cswGeometryDelta* cswBuildGeometryDelta(gzGeometry* geom, const cswGeometryFingerprint& previous, const cswGeometryFingerprint& current, const cswGeometryDelta* pending)
+{
+	GZ_INSTRUMENT_NAME("cswBuildGeometryDelta");
+
+	if (!geom || !current.sameTopology(previous))
+		return nullptr;
+
+	const int32 blocks = current.positionBlocks.Num();
+
+	TArray<uint8> blockMask;
+	blockMask.Init(0, blocks);
+
+	auto compare = [&](const TArray<uint32>& a, const TArray<uint32>& b, cswGeometryAttribute attribute)
+	{
+		for (int32 block = 0; block < a.Num(); block++)
+		{
+			if (a.Num() != b.Num() || a[block] != b[block])
+				blockMask[block] |= (uint8)attribute;
+		}
+	};
+
+	compare(current.positionBlocks, previous.positionBlocks, CSW_GEOMETRY_ATTRIBUTE_POSITION);
+	compare(current.normalBlocks, previous.normalBlocks, CSW_GEOMETRY_ATTRIBUTE_NORMAL);
+	compare(current.colorBlocks, previous.colorBlocks, CSW_GEOMETRY_ATTRIBUTE_COLOR);
+	compare(current.texcoordBlocks, previous.texcoordBlocks, CSW_GEOMETRY_ATTRIBUTE_TEXCOORD);
+
+	// Blocks not yet written by the game thread are sent again with current data
+	if (pending && !pending->applied && pending->blockMask.Num() == blocks)
+	{
+		for (int32 block = 0; block < blocks; block++)
+			blockMask[block] |= pending->blockMask[block];
+	}
+
+	cswGeometryAttribute attributes = CSW_GEOMETRY_ATTRIBUTE_NONE;
+
+	for (int32 block = 0; block < blocks; block++)
+		attributes = attributes | (cswGeometryAttribute)blockMask[block];
+
+	// Mesh was built without vertex colors
+	if ((attributes & CSW_GEOMETRY_ATTRIBUTE_COLOR) && !current.renderColors)
+		return nullptr;
+
+	cswGeometryDelta* delta = new cswGeometryDelta;
+
+	delta->attributes = attributes;
+	delta->textureUnits = current.textureUnits;
+
+	// Coalesce changed blocks into ranges
+
+	for (int32 block = 0; block < blocks; block++)
+	{
+		if (!blockMask[block])
+			continue;
+
+		const gzUInt32 first = block * CSW_FINGERPRINT_BLOCK;
+		const gzUInt32 count = FMath::Min(CSW_FINGERPRINT_BLOCK, current.vertexCount - first);
+
+		if (delta->ranges.Num() && delta->ranges.Last().first + delta->ranges.Last().count == first)
+			delta->ranges.Last().count += count;
+		else
+			delta->ranges.Add({ first, count });
+	}
+
+	delta->blockMask = MoveTemp(blockMask);
+
+	// Copy current data for the ranges in render layout
+
+	gzArray<gzVec3>& coordinates = geom->getCoordinateArray(FALSE);
+	gzArray<gzVec3>& normal_in(geom->getNormalArray(FALSE));
+	gzArray<gzVec4>& colors_in(geom->getColorArray(FALSE));
+	gzArray<gzArray<gzVec2>>& texcoord_in(geom->getTexCoordinateArrays(FALSE));
+
+	for (const cswVertexRange& range : delta->ranges)
+	{
+		for (gzUInt32 i = range.first; i < range.first + range.count; i++)
+		{
+			if (attributes & CSW_GEOMETRY_ATTRIBUTE_POSITION)
+				delta->positions.Add(cswVector3::UEVector3(coordinates[i]));
+
+			if (attributes & CSW_GEOMETRY_ATTRIBUTE_NORMAL)
+				delta->normals.Add(cswVector3::UEVector3(normal_in[i]));
+
+			if (attributes & CSW_GEOMETRY_ATTRIBUTE_COLOR)
+			{
+				FVector4f color = cswVector4::UEVector4(colors_in[i]);
+
+				// Same conversion as the static mesh build
+				delta->colors.Add(FLinearColor(color.X, color.Y, color.Z, color.W).ToFColor(true));
+			}
+
+			if (attributes & CSW_GEOMETRY_ATTRIBUTE_TEXCOORD)
+			{
+				for (gzUInt32 layer = 0; layer < current.textureUnits; layer++)
+				{
+					switch (geom->getTexBind(layer))
+					{
+						case GZ_BIND_OVERALL:
+							delta->texcoords.Add(cswVector2::UEVector2(texcoord_in[layer][0]));
+							break;
+
+						case GZ_BIND_ON:
+							delta->texcoords.Add(cswVector2::UEVector2(texcoord_in[layer][i]));
+							break;
+
+						default:
+							delta->texcoords.Add(FVector2f::ZeroVector);
+							break;
+					}
+				}
+			}
+		}
+	}
+
+	return delta;
+}
+
+bool cswApplyGeometryDelta(UStaticMesh* staticMesh, const cswGeometryDelta* delta, FRenderCommandFence* fence)
+{
+	GZ_INSTRUMENT_NAME("cswApplyGeometryDelta");
+
+	if (!staticMesh || !delta)
+		return false;
+
+	FStaticMeshRenderData* renderData = staticMesh->GetRenderData();
+
+	if (!renderData || !renderData->LODResources.Num())
+		return false;
+
+	FStaticMeshVertexBuffers& buffers = renderData->LODResources[0].VertexBuffers;
+
+	const cswGeometryAttribute attributes = delta->attributes;
+
+	const uint32 numVertices = buffers.PositionVertexBuffer.GetNumVertices();
+
+	// CPU copy is only kept with bAllowCpuAccess
+	if (!buffers.PositionVertexBuffer.GetVertexData() || !buffers.StaticMeshVertexBuffer.GetTangentData())
+		return false;
+
+	if ((attributes & CSW_GEOMETRY_ATTRIBUTE_COLOR) && buffers.ColorVertexBuffer.GetNumVertices() != numVertices)
+		return false;
+
+	for (const cswVertexRange& range : delta->ranges)
+	{
+		if (range.first + range.count > numVertices)
+			return false;
+	}
+
+	const uint32 textureUnits = FMath::Min(delta->textureUnits, buffers.StaticMeshVertexBuffer.GetNumTexCoords());
+
+	// Update CPU copy -----------------------------------------------------
+
+	uint32 packed = 0;
+
+	for (const cswVertexRange& range : delta->ranges)
+	{
+		for (uint32 i = range.first; i < range.first + range.count; i++, packed++)
+		{
+			if (attributes & CSW_GEOMETRY_ATTRIBUTE_POSITION)
+				buffers.PositionVertexBuffer.VertexPosition(i) = delta->positions[packed];
+
+			if (attributes & CSW_GEOMETRY_ATTRIBUTE_NORMAL)
+			{
+				FStaticMeshVertexBuffer& vertexBuffer = buffers.StaticMeshVertexBuffer;
+
+				vertexBuffer.SetVertexTangents(i, FVector3f(vertexBuffer.VertexTangentX(i)), vertexBuffer.VertexTangentY(i), delta->normals[packed]);
+			}
+
+			if (attributes & CSW_GEOMETRY_ATTRIBUTE_COLOR)
+				buffers.ColorVertexBuffer.VertexColor(i) = delta->colors[packed];
+
+			if (attributes & CSW_GEOMETRY_ATTRIBUTE_TEXCOORD)
+			{
+				for (uint32 layer = 0; layer < textureUnits; layer++)
+					buffers.StaticMeshVertexBuffer.SetVertexUV(i, layer, delta->texcoords[packed * delta->textureUnits + layer]);
+			}
+		}
+	}
+
+	// Upload changed ranges only ------------------------------------------
+
+	const uint32 tangentStride = numVertices ? buffers.StaticMeshVertexBuffer.GetTangentSize() / numVertices : 0;
+	const uint32 texcoordStride = numVertices ? buffers.StaticMeshVertexBuffer.GetTexCoordSize() / numVertices : 0;
+
+	// Ranges are copied now so later deltas can write the CPU copy while the render thread uploads
+	auto pack = [&delta](const void* data, uint32 stride, TArray<uint8>& packed)
+	{
+		if (!data || !stride)
+			return;
+
+		for (const cswVertexRange& range : delta->ranges)
+			packed.Append((const uint8*)data + range.first * stride, range.count * stride);
+	};
+
+	TArray<uint8> positions, tangents, colors, texcoords;
+
+	if (attributes & CSW_GEOMETRY_ATTRIBUTE_POSITION)
+		pack(buffers.PositionVertexBuffer.GetVertexData(), buffers.PositionVertexBuffer.GetStride(), positions);
+
+	if (attributes & CSW_GEOMETRY_ATTRIBUTE_NORMAL)
+		pack(buffers.StaticMeshVertexBuffer.GetTangentData(), tangentStride, tangents);
+
+	if (attributes & CSW_GEOMETRY_ATTRIBUTE_COLOR)
+		pack(buffers.ColorVertexBuffer.GetVertexData(), buffers.ColorVertexBuffer.GetStride(), colors);
+
+	if (attributes & CSW_GEOMETRY_ATTRIBUTE_TEXCOORD)
+		pack(buffers.StaticMeshVertexBuffer.GetTexCoordData(), texcoordStride, texcoords);
+
+	// Render data lives until the mesh is destroyed. Owners wait for the fence before they release it
+	ENQUEUE_RENDER_COMMAND(cswApplyGeometryDelta)([&buffers, ranges = delta->ranges, positions = MoveTemp(positions), tangents = MoveTemp(tangents), colors = MoveTemp(colors), texcoords = MoveTemp(texcoords),
+		positionStride = buffers.PositionVertexBuffer.GetStride(), colorStride = buffers.ColorVertexBuffer.GetStride(), tangentStride, texcoordStride](FRHICommandListImmediate& RHICmdList)
+		{
+			auto upload = [&](FVertexBuffer& buffer, const TArray<uint8>& packed, uint32 stride)
+			{
+				if (!buffer.VertexBufferRHI || !packed.Num() || !stride)
+					return;
+
+				const uint8* source = packed.GetData();
+
+				for (const cswVertexRange& range : ranges)
+				{
+					void* dest = RHICmdList.LockBuffer(buffer.VertexBufferRHI, range.first * stride, range.count * stride, RLM_WriteOnly);
+
+					FMemory::Memcpy(dest, source, range.count * stride);
+
+					RHICmdList.UnlockBuffer(buffer.VertexBufferRHI);
+
+					source += range.count * stride;
+				}
+			};
+
+			upload(buffers.PositionVertexBuffer, positions, positionStride);
+			upload(buffers.StaticMeshVertexBuffer.TangentsVertexBuffer, tangents, tangentStride);
+			upload(buffers.ColorVertexBuffer, colors, colorStride);
+			upload(buffers.StaticMeshVertexBuffer.TexCoordVertexBuffer, texcoords, texcoordStride);
+		});
+
+	if (fence)
+		fence->BeginFence();
+
+	return true;
+}
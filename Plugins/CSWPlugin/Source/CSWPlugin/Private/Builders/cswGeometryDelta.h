@@ -0,0 +1,122 @@
+//*****************************************************************************
+//
+// Copyright (C) SAAB AB
+//
+// All rights, including the copyright, to the computer program(s)
+// herein belong to SAAB AB. The program(s) may be used and/or
+// copied only with the written permission of SAAB AB, or in
+// accordance with the terms and conditions stipulated in the
+// agreement/contract under which the program(s) have been
+// supplied.
+//
+//
+// Information Class:	COMPANY UNCLASSIFIED
+// Defence Secrecy:		NOT CLASSIFIED
+// Export Control:		NOT EXPORT CONTROLLED
+//
+//
+// File			: cswGeometryDelta.h
+// Module		: CSW StreamingMap Unreal
+// Description	: Fingerprint and in place vertex updates for gzGeometry
+// Author		: agent
+// Product		: CSW 1.1.2
+//
+//
+//
+// NOTE:	CSW (Common Synthetic World) is a simulation and presentation
+//			framework for large scale digital twins on multiple platforms
+//
+//
+// Revision History...
+//
+// Who	Date	Description
+//
+// AGT	261019	Created file 					(1.1.3)
+//
+//******************************************************************************
+#pragma once
+
+#include "CoreMinimal.h"
+#include "gzGeometry.h"
+
+#include <atomic>
+
+class UStaticMesh;
+class FRenderCommandFence;
+
+// Vertices per fingerprint block. Changes are detected and uploaded per block
+const gzUInt32 CSW_FINGERPRINT_BLOCK = 64;
+
+enum cswGeometryAttribute
+{
+	CSW_GEOMETRY_ATTRIBUTE_NONE			= 0,
+	CSW_GEOMETRY_ATTRIBUTE_POSITION		= 1<<0,
+	CSW_GEOMETRY_ATTRIBUTE_NORMAL		= 1<<1,
+	CSW_GEOMETRY_ATTRIBUTE_COLOR		= 1<<2,
+	CSW_GEOMETRY_ATTRIBUTE_TEXCOORD		= 1<<3,
+};
+
+GZ_USE_BIT_LOGIC(cswGeometryAttribute);
+
+// Retained per geometry to find what changed in an update
+class cswGeometryFingerprint : public gzReference
+{
+public:
+	GZ_DECLARE_TYPE_INTERFACE;
+
+	//! FALSE if geometry can not use the delta path (per primitive bindings)
+	gzBool compute(gzGeometry* geom);
+
+	//! Same vertex count, indices, bindings and overall values
+	gzBool sameTopology(const cswGeometryFingerprint& other) const;
+
+	gzUInt32		vertexCount = 0;
+	gzUInt32		textureUnits = 0;
+	gzUInt32		topologyHash = 0;
+
+	FBox3f			bounds;				// Current positions in UE space
+	FBox3f			renderBounds;		// Bounds of the built static mesh
+	gzBool			renderColors = FALSE;	// Static mesh has a color buffer
+
+	TArray<uint32>	positionBlocks;
+	TArray<uint32>	normalBlocks;
+	TArray<uint32>	colorBlocks;
+	TArray<uint32>	texcoordBlocks;
+};
+
+GZ_DECLARE_REFPTR(cswGeometryFingerprint);
+
+struct cswVertexRange
+{
+	gzUInt32	first;
+	gzUInt32	count;
+};
+
+// Changed vertex data packed per range in render vertex order
+class cswGeometryDelta : public gzReference
+{
+public:
+	GZ_DECLARE_TYPE_INTERFACE;
+
+	cswGeometryAttribute	attributes = CSW_GEOMETRY_ATTRIBUTE_NONE;
+
+	TArray<uint8>			blockMask;		// Changed attributes per block
+	TArray<cswVertexRange>	ranges;
+
+	TArray<FVector3f>		positions;
+	TArray<FVector3f>		normals;
+	TArray<FColor>			colors;
+	TArray<FVector2f>		texcoords;		// textureUnits per vertex
+	gzUInt32				textureUnits = 0;
+
+	std::atomic<bool>		applied = false;
+};
+
+GZ_DECLARE_REFPTR(cswGeometryDelta);
+
+//! Collect changed blocks between fingerprints. Unapplied blocks in pending are merged in. nullptr if not possible
+cswGeometryDelta* cswBuildGeometryDelta(gzGeometry* geom, const cswGeometryFingerprint& previous, const cswGeometryFingerprint& current, const cswGeometryDelta* pending);
+
+//! Write delta into the CPU copy and the changed GPU ranges. Mesh must be built with CPU access. Game thread
+//! The upload is started on fence. The mesh must stay alive until the fence is complete
+bool cswApplyGeometryDelta(UStaticMesh* staticMesh, const cswGeometryDelta* delta, FRenderCommandFence* fence);
@@ -0,0 +1,163 @@
+//*****************************************************************************
+//
+// Copyright (C) SAAB AB
+//
+// All rights, including the copyright, to the computer program(s)
+// herein belong to SAAB AB. The program(s) may be used and/or
+// copied only with the written permission of SAAB AB, or in
+// accordance with the terms and conditions stipulated in the
+// agreement/contract under which the program(s) have been
+// supplied.
+//
+//
+// Information Class:	COMPANY UNCLASSIFIED
+// Defence Secrecy:		NOT CLASSIFIED
+// Export Control:		NOT EXPORT CONTROLLED
+//
+//
+// File			: cswLod.cpp
+// Module		: CSW StreamingMap Unreal
+// Description	: Builder class for gzLod
+// Author		: agent
+// Product		: CSW 1.1.2
+//
+//
+//
+// NOTE:	CSW (Common Synthetic World) is a simulation and presentation
+//			framework for large scale digital twins on multiple platforms
+//
+//
+// Revision History...
+//
+// Who	Date	Description
+//
+// AGT	261019	Created file 					(1.1.3)
+//
+//******************************************************************************
+#include "Builders/cswLod.h"
+
+#include "cswResourceManager.h"
+#include "cswSceneManagerBase.h"
+
+GZ_DECLARE_TYPE_CHILD(gzReference, cswLodBuild, "cswLodBuild");
+
+// Sets default values for this component's properties
+UCSWLod::UCSWLod(const FObjectInitializer& ObjectInitializer) : Super(ObjectInitializer)
+{
+}
+
+bool UCSWLod::build(UCSWSceneComponent* parent, gzNode* buildItem, gzState* state, BuildProperties& buildProperties, cswResourceManager* resources)
+{
+	if (!Super::build(parent, buildItem, state, buildProperties, resources))
+		return false;
+
+	GZ_INSTRUMENT_NAME("UCSWLod::build");
+
+	// Without a merged mesh we are a plain group and gizmo activations drive the children
+	return buildMeshComponent(buildItem, state, buildProperties, resources);
+}
+
+bool UCSWLod::update(UCSWSceneComponent* parent, gzNode* buildItem, gzState* state, BuildProperties& buildProperties, cswResourceManager* resources)
+{
+	GZ_INSTRUMENT_NAME("UCSWLod::update");
+
+	if (!parent || !buildItem)
+		return false;
+
+	if (shouldSkipUpdate(buildItem))
+		return true;
+
+	AttachToComponent(parent, FAttachmentTransformRules::KeepRelativeTransform);
+
+	if (!buildMeshComponent(buildItem, state, buildProperties, resources))
+		return false;
+
+	markUpdated(buildItem);
+
+	return true;
+}
+
+bool UCSWLod::destroy(gzNode* destroyItem, cswResourceManager* resources)
+{
+	GZ_INSTRUMENT_NAME("UCSWLod::destroy");
+
+	if (m_meshComponent)
+		m_meshComponent->DestroyComponent();
+
+	if (resources)
+		resources->releaseMaterials(this);
+
+	return Super::destroy(destroyItem, resources);
+}
+
+bool UCSWLod::buildMeshComponent(gzNode* buildItem, gzState* state, BuildProperties& buildProperties, cswResourceManager* resources)
+{
+	cswLodBuild* buildData = gzDynamic_Cast<cswLodBuild>(gzDynamic_Cast<gzReference*>(buildItem->getAttribute(CSW_META, CSW_BUILD_DATA)));
+
+	if (!buildData || !buildData->staticMesh)
+		return true;
+
+	{
+		GZ_INSTRUMENT_NAME("UCSWLod::build::component setup");
+
+		if (!m_meshComponent)
+			m_meshComponent = NewObject<UStaticMeshComponent>(this, buildItem->getName().getWideString());
+
+		m_meshComponent->SetSimulatePhysics(buildProperties.simulatePhysics);
+		m_meshComponent->SetCollisionEnabled(buildProperties.collision);
+
+		m_meshComponent->SetUsingAbsoluteLocation(false);
+		m_meshComponent->SetUsingAbsoluteRotation(false);
+		m_meshComponent->SetUsingAbsoluteScale(false);
+
+		// UE selects LOD from screen size. CSW_FORCE_LOD0 does not apply to merged meshes
+		m_meshComponent->ForcedLodModel = 0;
+
+		m_meshComponent->SetMobility(EComponentMobility::Stationary);
+		m_meshComponent->SetRenderCustomDepth(false);
+		m_meshComponent->bAffectDistanceFieldLighting = false;
+		m_meshComponent->bAffectDynamicIndirectLighting = false;
+		m_meshComponent->bAlwaysCreatePhysicsState = false;
+		m_meshComponent->bReceivesDecals = false;
+	}
+
+	{
+		GZ_INSTRUMENT_NAME("UCSWLod::build::set mesh");
+		m_meshComponent->SetStaticMesh(buildData->staticMesh);
+	}
+
+	resources->releaseMaterials(this);
+
+	// One material slot per LOD. Child state wins if it carries a texture
+	for (int32 i = 0; i < buildData->levelStates.Num(); i++)
+	{
+		gzState* levelState = buildData->levelStates[i];
+
+		if (!levelState || !levelState->getTexture(0))
+			levelState = state;
+
+		UMaterialInterface* material = resources->getMaterial(this, levelState, CSW_MATERIAL_TYPE_BASE_MATERIAL);
+
+		if (material)
+			m_meshComponent->SetMaterial(i, material);
+	}
+
+	{
+		GZ_INSTRUMENT_NAME("UCSWLod::build::Attach & Register");
+
+		if (m_meshComponent->GetAttachParent() != this)
+			m_meshComponent->AttachToComponent(this, FAttachmentTransformRules::KeepRelativeTransform);
+
+		// Last far distance culls the whole LOD like gizmo does. Distances are in map units
+		const gzFloat farDistance = buildData->levels.Num() ? buildData->levels.Last().farDistance : 0;
+
+		if (farDistance > 0 && farDistance < FLT_MAX)
+			m_meshComponent->SetCullDistance(farDistance * GetComponentTransform().GetMaximumAxisScale());
+
+		if (!m_meshComponent->IsRegistered())
+			m_meshComponent->RegisterComponent();
+	}
+
+	// Keep the build data as LOD levels are moved out of the gzLod
+	return true;
+}
@@ -0,0 +1,93 @@
+//*****************************************************************************
+//
+// Copyright (C) SAAB AB
+//
+// All rights, including the copyright, to the computer program(s)
+// herein belong to SAAB AB. The program(s) may be used and/or
+// copied only with the written permission of SAAB AB, or in
+// accordance with the terms and conditions stipulated in the
+// agreement/contract under which the program(s) have been
+// supplied.
+//
+//
+// Information Class:	COMPANY UNCLASSIFIED
+// Defence Secrecy:		NOT CLASSIFIED
+// Export Control:		NOT EXPORT CONTROLLED
+//
+//
+// File			: cswLod.h
+// Module		: CSW StreamingMap Unreal
+// Description	: Builder class for gzLod
+// Author		: agent
+// Product		: CSW 1.1.2
+//
+//
+//
+// NOTE:	CSW (Common Synthetic World) is a simulation and presentation
+//			framework for large scale digital twins on multiple platforms
+//
+//
+// Revision History...
+//
+// Who	Date	Description
+//
+// AGT	261019	Created file 					(1.1.3)
+//
+//******************************************************************************
+#pragma once
+
+#include "cswNode.h"
+#include "cswHeightCache.h"
+#include "cswMeshBVH.h"
+#include "cswLod.generated.h"
+
+// Attribute set on a gzLod whose children are merged into one UE mesh
+const gzString CSW_LOD_MERGED = "lodMerged";
+
+UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
+class CSWPLUGIN_API UCSWLod : public UCSWNode
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this component's properties
+	UCSWLod(const FObjectInitializer& ObjectInitializer = FObjectInitializer::Get());
+
+	virtual bool build(UCSWSceneComponent* parent, gzNode* buildItem, gzState* state, BuildProperties& buildProperties, cswResourceManager* resources) override;
+
+	virtual bool update(UCSWSceneComponent* parent, gzNode* buildItem, gzState* state, BuildProperties& buildProperties, cswResourceManager* resources) override;
+
+	virtual bool destroy(gzNode* destroyItem, cswResourceManager* resources) override;
+
+protected:
+
+	bool buildMeshComponent(gzNode* buildItem, gzState* state, BuildProperties& buildProperties, cswResourceManager* resources);
+
+	UPROPERTY()
+	TObjectPtr<UStaticMeshComponent>	m_meshComponent;
+};
+
+struct cswLodRange
+{
+	gzFloat		nearDistance;
+	gzFloat		farDistance;
+	gzUInt32	child;			// Child index in gzLod
+};
+
+class cswLodBuild : public gzReference
+{
+public:
+	GZ_DECLARE_TYPE_INTERFACE;
+
+	gzUInt32				updateID;
+
+	TObjectPtr<UStaticMesh> staticMesh;		// Merged mesh with one UE LOD per gzLod level. nullptr if not merged
+
+	TArray<gzStatePtr>		levelStates;	// Local state of child per UE LOD
+
+	TArray<cswLodRange>		levels;			// Original gzLod ranges per UE LOD, sorted near to far
+
+	cswHeightTilePtr		heightTile;		// From the nearest level. nullptr if not terrain
+
+	cswMeshBVHPtr			intersectTree;	// From the nearest level. nullptr if not built
+};
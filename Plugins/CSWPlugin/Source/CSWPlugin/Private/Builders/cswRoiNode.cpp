@@ -58,21 +58,42 @@ bool UCSWRoiNode::build(UCSWSceneComponent* parent, gzNode* buildItem, gzState*
 	if (!roi)
 		return false;
 
-	FTransform m;
-
 	// Get roi position
 	gzDoubleXYZ position = roi->getPosition();
 
-	// We will send this subtree to roi position in Unreal
+	m_position = gzVec3D(position.x, position.y, position.z);
+
+	m_topLevel = findRoi(parent) == nullptr;
+
+	// We will send this subtree to roi position in Unreal, relative to the floating origin for top level rois
+
+	rebase(m_topLevel ? buildProperties.roiOffset : gzVec3D(0, 0, 0));
+
+	return true;
+}
+
+void UCSWRoiNode::rebase(const gzVec3D& offset)
+{
+	const gzVec3D position = m_position - offset;
+
+	gzMatrix4D translation=gzMatrix4D::translateMatrix(position.v1,position.v2,position.v3);
+
+	FTransform m;
 
-	gzMatrix4D translation=gzMatrix4D::translateMatrix(position.x,position.y,position.z);
-	
 	m.SetFromMatrix(cswMatrix4d::UEMatrix4(translation));
 
 	SetRelativeTransform(m);
-		
+}
 
-	return true;
+UCSWRoiNode* UCSWRoiNode::findRoi(USceneComponent* component)
+{
+	for (; component; component = component->GetAttachParent())
+	{
+		if (UCSWRoiNode* roi = Cast<UCSWRoiNode>(component))
+			return roi;
+	}
+
+	return nullptr;
 }
 
 bool  UCSWRoiNode::destroy(gzNode* destroyItem, cswResourceManager* resources)
@@ -55,5 +55,18 @@ public:
 
 	virtual bool destroy(gzNode* destroyItem, cswResourceManager* resources) override;
 
-		
+	// Moves the subtree to roi position minus offset. The scene rebases top level rois on floating origin
+	void rebase(const gzVec3D& offset);
+
+	// No roi above us
+	bool isTopLevel() const { return m_topLevel; }
+
+	// Nearest roi at or above component. nullptr outside rois
+	static UCSWRoiNode* findRoi(USceneComponent* component);
+
+private:
+
+	gzVec3D	m_position = gzVec3D(0, 0, 0);
+
+	bool	m_topLevel = true;
 };
@@ -36,13 +36,16 @@
 //******************************************************************************
 #include "cswFactory.h"
 #include "Builders/cswGeometry.h"
+#include "Builders/cswLod.h"
 #include "gzGeometry.h"
+#include "gzTime.h"
 
 // Glue
 #include "UEGlue/cswUEMatrix.h"
 
 #include "MeshDescription.h"
 #include "StaticMeshAttributes.h"
+#include "StaticMeshResources.h"
 
 #include "cswSceneManagerBase.h"
 
@@ -66,11 +69,28 @@ public:
 		return geom;
 	}
 
-	virtual gzReference* preBuildReferenceInstance(gzNode* node, const gzUInt64& pathID, gzGroup* parent, const gzUInt64& parentPathID, gzState* state) override;
+	virtual gzReference* preBuildReferenceInstance(gzNode* node, const gzUInt64& pathID, gzGroup* parent, const gzUInt64& parentPathID, gzState* state, const BuildProperties& buildProperties) override;
 
-	virtual gzReference* updateReferenceInstance(gzNode* node, const gzUInt64& pathID, gzGroup* parent, const gzUInt64& parentPathID, gzState* state, gzReference* userdata) override;
+	virtual gzReference* updateReferenceInstance(gzNode* node, const gzUInt64& pathID, gzGroup* parent, const gzUInt64& parentPathID, gzState* state, gzReference* userdata, const BuildProperties& buildProperties) override;
 
 	virtual gzVoid preDestroyReferenceInstance(gzNode* node, const gzUInt64& pathID, gzReference* userdata) override;
+
+private:
+
+	cswGeometryBuild* buildGeometry(gzGeometry* geom, gzGroup* parent, gzState* state, const BuildProperties& buildProperties, gzBool retainFingerprint);
+
+	cswGeometryBuild* buildDelta(gzGeometry* geom, cswGeometryBuild* existing, const BuildProperties& buildProperties);
+
+	cswGeometryBuild* buildDynamic(gzGeometry* geom, gzGroup* parent, gzState* state, cswGeometryBuild* existing, const BuildProperties& buildProperties);
+
+	static gzFloat updateRate(cswGeometryBuild* existing, gzDouble now, const BuildProperties& buildProperties);
+
+	static cswAtlasRegionPtr allocateAtlasRegion(gzGeometry* geom, gzState* state, const BuildProperties& buildProperties);
+
+	// Uvs of texture unit 0 inside 0..1 so they can be remapped into a page
+	static gzBool atlasTexCoords(gzGeometry* geom);
+
+	static cswTextureBuildPtr prepareTexture(gzImage* image, const BuildProperties& buildProperties);
 };
 
 GZ_DECLARE_TYPE_CHILD(cswFactory, cswGeometryFactory, "cswGeometryFactory");
@@ -120,19 +140,97 @@ private:
 gzCleanupReference cleanUpGeometryFactory(new cswGeometryFactoryRegistrar, GZ_CLEANUP_MODULES);
 
 
-gzReference* cswGeometryFactory::preBuildReferenceInstance(gzNode* node, const gzUInt64& pathID, gzGroup* parent, const gzUInt64& parentPathID, gzState* state)
+gzReference* cswGeometryFactory::preBuildReferenceInstance(gzNode* node, const gzUInt64& pathID, gzGroup* parent, const gzUInt64& parentPathID, gzState* state, const BuildProperties& buildProperties)
 {
-	// Assume we are called in dynamic load
-	// We can then exit edit lock mode
-	
-	GZ_EDIT_GUARD_PAUSE;
-
 	// Get Handle to geometry
 	gzGeometry* geom = gzDynamic_Cast<gzGeometry>(node);
 
 	if (!geom)
 		return nullptr;
 
+	cswGeometryBuild* build = buildGeometry(geom, parent, state, buildProperties, FALSE);
+
+	if (build)
+		build->updateTime = gzTime::systemSeconds();
+
+	return build;
+}
+
+// Called in EDIT LOCK
+cswAtlasRegionPtr cswGeometryFactory::allocateAtlasRegion(gzGeometry* geom, gzState* state, const BuildProperties& buildProperties)
+{
+	if (!buildProperties.textureAtlas || !state || !geom->getTextureUnits())
+		return nullptr;
+
+	gzTexture* texture = state->getTexture(0);
+
+	if (!texture || !atlasTexCoords(geom))
+		return nullptr;
+
+	return buildProperties.textureAtlas->allocate(texture->getImage());
+}
+
+gzBool cswGeometryFactory::atlasTexCoords(gzGeometry* geom)
+{
+	// Repeated textures can not be remapped into a page
+	gzArray<gzVec2>& texcoords = geom->getTexCoordinateArray(0, FALSE);
+
+	if (!texcoords.getSize())
+		return FALSE;
+
+	const gzFloat eps = 1e-4f;
+
+	for (gzUInt32 i = 0; i < texcoords.getSize(); i++)
+	{
+		const gzVec2& uv = texcoords[i];
+
+		if (uv.x < -eps || uv.x > 1 + eps || uv.y < -eps || uv.y > 1 + eps)
+			return FALSE;
+	}
+
+	return TRUE;
+}
+
+// Texture copy and format conversion off the game thread
+cswTextureBuildPtr cswGeometryFactory::prepareTexture(gzImage* image, const BuildProperties& buildProperties)
+{
+	const gzDouble start = gzTime::systemSeconds();
+
+	cswTextureBuildPtr texture = cswResourceManager::prepareTexture(image, buildProperties);
+
+	if (texture && buildProperties.statistics)
+	{
+		buildProperties.statistics->texturesPrepared++;
+		buildProperties.statistics->texturePrepareMicroseconds += (gzUInt64)((gzTime::systemSeconds() - start) * 1e6);
+	}
+
+	return texture;
+}
+
+// Called in EDIT LOCK
+cswGeometryBuild* cswGeometryFactory::buildGeometry(gzGeometry* geom, gzGroup* parent, gzState* state, const BuildProperties& buildProperties, gzBool retainFingerprint)
+{
+	// Merged into parent LOD mesh. Still in edit lock so parent is safe to read
+	if (parent && parent->hasAttribute(CSW_META, CSW_LOD_MERGED))
+	{
+		cswGeometryBuild* build = new cswGeometryBuild;
+		build->updateID = geom->getUpdateID();
+		build->merged = TRUE;
+		return build;
+	}
+
+	// Read state before we leave the lock
+	cswAtlasRegionPtr atlasRegion = allocateAtlasRegion(geom, state, buildProperties);
+
+	gzImagePtr textureImage = state && state->getTexture(0) ? state->getTexture(0)->getImage() : nullptr;
+
+	gzImagePtr image = !atlasRegion && buildProperties.prepareTextures ? textureImage : nullptr;
+
+	// Assume we are called in dynamic load
+	// We can then exit edit lock mode
+	
+	GZ_EDIT_GUARD_PAUSE;
+
 	switch (geom->getGeoPrimType())
 	{
 
@@ -160,310 +258,186 @@ gzReference* cswGeometryFactory::preBuildReferenceInstance(gzNode* node, const g
 
 	cswGeometryBuild* build = new cswGeometryBuild;
 	build->updateID = geom->getUpdateID();
+	build->atlasRegion = atlasRegion;
+	build->textureImage = textureImage;
 
+	if (image)
+		build->texture = prepareTexture(image, buildProperties);
 
-	// Registrera s mnga UV-lager du behver (standard r 1) // Om du vill ha fler lager:
-	const int32 NumUVChannels = geom->getTextureUnits();
-
-	// Mesh description will hold all the geometry, uv, normals going into the static mesh
-	FMeshDescription MeshDescription;
-
-	MeshDescription.SetNumUVChannels(NumUVChannels);
-
-	FStaticMeshAttributes Attributes(MeshDescription);
-
-	Attributes.Register();
-
-	// Skapa en PolygonGroup (en grupp fr polygoner, oftast en grupp = ett material) 
-	FPolygonGroupID PolygonGroupID = MeshDescription.CreatePolygonGroup();
+	// Render vertex order follows gizmo order only with fast build. Remapped uvs can not take raw deltas
+	if (retainFingerprint && buildProperties.fastBuild && !atlasRegion)
+	{
+		build->fingerprint = new cswGeometryFingerprint;
 
+		if (!build->fingerprint->compute(geom))
+			build->fingerprint = nullptr;
+	}
 
-	// --------------- coordinates (vertices) ----------------------
+	cswBuildQueryData(geom, buildProperties, build->heightTile, build->intersectTree);
 
-	gzArray<gzVec3>& coordinates = geom->getCoordinateArray(FALSE);
+	// Mesh description will hold all the geometry, uv, normals going into the static mesh
+	FMeshDescription MeshDescription;
 
+	if (!cswBuildMeshDescription(geom, MeshDescription, buildProperties, NAME_None, atlasRegion))
 	{
-		GZ_INSTRUMENT_NAME("UCSWGeometry::build::vertice setup");
-
-		// Reserve vertices in mesh description
-		MeshDescription.ReserveNewVertices(coordinates.getSize());
+		GZMESSAGE(GZ_MESSAGE_WARNING, "cswGeometryFactory: Failed to build mesh description for '%s'", (const char*)geom->getName());
 
-		TVertexAttributesRef<FVector3f> vertex = Attributes.GetVertexPositions();
+		if (buildProperties.statistics)
+			buildProperties.statistics->meshesFailed++;
 
-		for (gzUInt32 i = 0; i < coordinates.getSize(); i++)
-		{
-			MeshDescription.CreateVertex();
-			vertex[i] = cswVector3::UEVector3(coordinates[i]);
-		}
+		return build;
 	}
 
-	// --------------- indices -------------------------------------
-
-	gzArray<gzUInt32>& indices = geom->getIndexArray(FALSE);
-
-	gzUInt32 icount = indices.getSize();
-
-	// Reserve indices in mesh description
-	MeshDescription.ReserveNewVertexInstances(icount);
-	MeshDescription.ReserveNewTriangles(icount / 3);
-
-	TVertexInstanceAttributesRef<FVector3f> normal = Attributes.GetVertexInstanceNormals();
-	TVertexInstanceAttributesRef<FVector2f> texcoord = Attributes.GetVertexInstanceUVs();
-	TVertexInstanceAttributesRef<FVector4f> colors = Attributes.GetVertexInstanceColors();
+	// Build static mesh ----------------------------------------------------------------------
 
-	gzArray<gzVec3>& normal_in(geom->getNormalArray(FALSE));
-	gzArray<gzVec4>& colors_in(geom->getColorArray(FALSE));
-	gzArray<gzArray<gzVec2>>& texcoord_in(geom->getTexCoordinateArrays(FALSE));
+	TArray<const FMeshDescription*> meshDescPtrs;
+	meshDescPtrs.Emplace(&MeshDescription);
 
+	build->staticMesh = cswBuildStaticMesh(meshDescPtrs, { NAME_None }, buildProperties, build->fingerprint != nullptr);
 
-	TArray<FVertexInstanceID> id;
-	id.SetNum(3);
+	if (!build->staticMesh)
+	{
+		GZMESSAGE(GZ_MESSAGE_WARNING, "cswGeometryFactory: Failed to build static mesh for '%s'", (const char*)geom->getName());
 
-	FVertexInstanceID ind;
+		if (buildProperties.statistics)
+			buildProperties.statistics->meshesFailed++;
+	}
 
+	if (build->fingerprint && build->staticMesh)
 	{
-		GZ_INSTRUMENT_NAME("UCSWGeometry::build::attrib setup");
+		FStaticMeshRenderData* renderData = build->staticMesh->GetRenderData();
 
-		if (icount)	// We have an indexed structure
-		{
-			for (gzUInt32 i = 0; i < icount; i += 3)
-			{
-				for (gzUInt32 j = 0; j < 3; j++)
-				{
-					gzUInt32 index = i + 2 - j;
-
-					{
-						GZ_INSTRUMENT_NAME("UCSWGeometry::build::create vertex instance");
-						id[j] = ind = MeshDescription.CreateVertexInstance(indices[index]);
-					}
-
-
-					{
-						GZ_INSTRUMENT_NAME("UCSWGeometry::build::normal");
-						// Normal indexed -----------------------------------------------
-
-						switch (geom->getNormalBind())
-						{
-							case GZ_BIND_OFF:
-								normal[ind] = cswVector3::UEVector3(gzVec3(0, 1, 0));
-								break;
-
-							case GZ_BIND_OVERALL:
-								normal[ind] = cswVector3::UEVector3(normal_in[0]);
-								break;
-
-							case GZ_BIND_PER_PRIM:
-								normal[ind] = cswVector3::UEVector3(normal_in[i / 3]);
-								break;
-
-							case GZ_BIND_ON:
-								normal[ind] = cswVector3::UEVector3(normal_in[indices[index]]);
-								break;
-
-						}
-					}
-
-					{
-						GZ_INSTRUMENT_NAME("UCSWGeometry::build::tex");
-						// Tex indexed -----------------------------------------------
-
-						for (gzUInt32 layer = 0; layer < geom->getTextureUnits(); layer++)
-						{
-							switch (geom->getTexBind(layer))
-							{
-								case GZ_BIND_OFF:
-									break;
-
-								case GZ_BIND_OVERALL:
-									texcoord.Set(ind, layer, cswVector2::UEVector2(texcoord_in[layer][0]));
-									break;
-
-								case GZ_BIND_PER_PRIM:
-									texcoord.Set(ind, layer, cswVector2::UEVector2(texcoord_in[layer][i / 3]));
-									break;
-
-
-								case GZ_BIND_ON:
-									texcoord.Set(ind, layer, cswVector2::UEVector2(texcoord_in[layer][indices[index]]));
-									break;
-
-							}
-						}
-					}
-
-					{
-						GZ_INSTRUMENT_NAME("UCSWGeometry::build::color");
-
-						// Color indexed -----------------------------------------------
-
-						switch (geom->getColorBind())
-						{
-							case GZ_BIND_OFF:
-								break;
-
-							case GZ_BIND_OVERALL:
-								colors[ind] = cswVector4::UEVector4(colors_in[0]);
-								break;
-
-							case GZ_BIND_PER_PRIM:
-								colors[ind] = cswVector4::UEVector4(colors_in[i / 3]);
-								break;
-
-							case GZ_BIND_ON:
-								colors[ind] = cswVector4::UEVector4(colors_in[indices[index]]);
-								break;
-
-						}
-					}
-				}
-
-				{
-					GZ_INSTRUMENT_NAME("UCSWGeometry::build::poly");
-					MeshDescription.CreatePolygon(PolygonGroupID, id);
-				}
-			}
-		}
-		else
-		{
-			// Non indexed. Not so optimal perhapsbut we dont take the penalty here to convert it
+		build->fingerprint->renderBounds = build->fingerprint->bounds;
+		build->fingerprint->renderColors = renderData && renderData->LODResources.Num() && renderData->LODResources[0].VertexBuffers.ColorVertexBuffer.GetNumVertices();
+	}
 
-			for (gzUInt32 i = 0; i < coordinates.getSize(); i += 3)
-			{
-				for (gzUInt32 j = 0; j < 3; j++)
-				{
-					gzUInt32 index = i + 2 - j;
+	return build;
+}
 
-					id[j] = ind = MeshDescription.CreateVertexInstance(index);
+// Called in EDIT LOCK
+cswGeometryBuild* cswGeometryFactory::buildDelta(gzGeometry* geom, cswGeometryBuild* existing, const BuildProperties& buildProperties)
+{
+	GZ_INSTRUMENT_NAME("cswGeometryFactory::buildDelta");
 
+	cswGeometryFingerprintPtr fingerprint = new cswGeometryFingerprint;
 
+	cswGeometryDeltaPtr delta;
 
-					// Normal -----------------------------------------------
+	cswHeightTilePtr	heightTile;
+	cswMeshBVHPtr		intersectTree;
 
-					switch (geom->getNormalBind())
-					{
-						case GZ_BIND_OFF:
-							normal[ind] = cswVector3::UEVector3(gzVec3(0, 1, 0));
-							break;
+	{
+		GZ_EDIT_GUARD_PAUSE;
 
-						case GZ_BIND_OVERALL:
-							normal[ind] = cswVector3::UEVector3(normal_in[0]);
-							break;
+		if (!fingerprint->compute(geom) || !fingerprint->sameTopology(*existing->fingerprint))
+			return nullptr;
 
-						case GZ_BIND_PER_PRIM:
-							normal[ind] = cswVector3::UEVector3(normal_in[i / 3]);
-							break;
+		// Bounds of the built mesh are kept so vertices must stay inside
+		const FBox3f& renderBounds = existing->fingerprint->renderBounds;
 
-						case GZ_BIND_ON:
-							normal[ind] = cswVector3::UEVector3(normal_in[index]);
-							break;
+		if (!renderBounds.IsInsideOrOn(fingerprint->bounds.Min) || !renderBounds.IsInsideOrOn(fingerprint->bounds.Max))
+			return nullptr;
 
-					}
+		fingerprint->renderBounds = renderBounds;
+		fingerprint->renderColors = existing->fingerprint->renderColors;
 
+		delta = cswBuildGeometryDelta(geom, *existing->fingerprint, *fingerprint, existing->delta);
 
-					// Tex -----------------------------------------------
+		// Moved vertices invalidate the old tile and tree
+		if (delta)
+			cswBuildQueryData(geom, buildProperties, heightTile, intersectTree);
+	}
 
-					for (gzUInt32 layer = 0; layer < geom->getTextureUnits(); layer++)
-					{
-						switch (geom->getTexBind(layer))
-						{
-							case GZ_BIND_OFF:
-								break;
+	if (!delta)
+		return nullptr;
 
-							case GZ_BIND_OVERALL:
-								texcoord.Set(ind, layer, cswVector2::UEVector2(texcoord_in[layer][0]));
-								break;
+	cswGeometryBuild* build = new cswGeometryBuild;
 
-							case GZ_BIND_PER_PRIM:
-								texcoord.Set(ind, layer, cswVector2::UEVector2(texcoord_in[layer][i / 3]));
-								break;
+	build->updateID = geom->getUpdateID();
+	build->staticMesh = existing->staticMesh;
+	build->shown = true;
+	build->fingerprint = fingerprint;
+	build->texture = existing->texture;
+	build->textureImage = existing->textureImage;
+	build->heightTile = heightTile;
+	build->intersectTree = intersectTree;
 
+	if (delta->ranges.Num())
+		build->delta = delta;
 
-							case GZ_BIND_ON:
-								texcoord.Set(ind, layer, cswVector2::UEVector2(texcoord_in[layer][index]));
-								break;
+	return build;
+}
 
-						}
-					}
+// Called in EDIT LOCK
+cswGeometryBuild* cswGeometryFactory::buildDynamic(gzGeometry* geom, gzGroup* parent, gzState* state, cswGeometryBuild* existing, const BuildProperties& buildProperties)
+{
+	GZ_INSTRUMENT_NAME("cswGeometryFactory::buildDynamic");
 
-					// Color -----------------------------------------------
+	// Merged LOD children are never shown on their own
+	if (parent && parent->hasAttribute(CSW_META, CSW_LOD_MERGED))
+		return nullptr;
 
-					switch (geom->getColorBind())
-					{
-						case GZ_BIND_OFF:
-							break;
+	gzImagePtr textureImage = state && state->getTexture(0) ? state->getTexture(0)->getImage() : nullptr;
 
-						case GZ_BIND_OVERALL:
-							colors[ind] = cswVector4::UEVector4(colors_in[0]);
-							break;
+	// Same texture keeps the page area or prepared data of the previous build
+	const gzBool sameTexture = existing && textureImage && existing->textureImage == textureImage;
 
-						case GZ_BIND_PER_PRIM:
-							colors[ind] = cswVector4::UEVector4(colors_in[i / 3]);
-							break;
+	cswAtlasRegionPtr atlasRegion;
 
-						case GZ_BIND_ON:
-							colors[ind] = cswVector4::UEVector4(colors_in[index]);
-							break;
+	if (sameTexture && existing->atlasRegion)
+		atlasRegion = atlasTexCoords(geom) ? existing->atlasRegion : nullptr;
+	else
+		atlasRegion = allocateAtlasRegion(geom, state, buildProperties);
 
-					}
-				}
+	cswTextureBuildPtr texture = sameTexture && !atlasRegion ? existing->texture : nullptr;
 
-				MeshDescription.CreatePolygon(PolygonGroupID, id);
-			}
-		}
+	cswDynamicMeshDataPtr dynamicMesh = new cswDynamicMeshData;
 
-	}
+	cswHeightTilePtr	heightTile;
+	cswMeshBVHPtr		intersectTree;
 
 	{
-		FGCScopeGuard guard;
-
-		build->staticMesh = NewObject<UStaticMesh>();
-	}
-
-	// Get material array
-	TArray<FStaticMaterial>& materials = build->staticMesh->GetStaticMaterials();
-
-	// Setup a static material
-	FStaticMaterial staticMaterial;
-
-	// Enable UVChannel data
-	staticMaterial.UVChannelData.bInitialized = true;
+		GZ_EDIT_GUARD_PAUSE;
 
-	// Add the static material for current mesh
-	materials.Add(staticMaterial);
-
-	build->staticMesh->bDoFastBuild = true;
-	build->staticMesh->bSupportRayTracing = false;
-
-	// Some extra build parmeters
-	UStaticMesh::FBuildMeshDescriptionsParams mdParams;
-
-	mdParams.bBuildSimpleCollision = false;
-	mdParams.bFastBuild = true;
-	mdParams.bCommitMeshDescription = false;
-	mdParams.bAllowCpuAccess = false;
-	mdParams.bMarkPackageDirty = false;
+		if (!cswBuildDynamicMeshData(geom, *dynamicMesh, atlasRegion))
+			return nullptr;
 
+		if (!atlasRegion && !texture && textureImage && buildProperties.prepareTextures)
+			texture = prepareTexture(textureImage, buildProperties);
 
+		cswBuildQueryData(geom, buildProperties, heightTile, intersectTree);
+	}
 
-	// Build static mesh ----------------------------------------------------------------------
+	cswGeometryBuild* build = new cswGeometryBuild;
 
-	{
-		GZ_INSTRUMENT_NAME("UCSWGeometry::build::mesh build");
+	build->updateID = geom->getUpdateID();
+	build->dynamicMesh = dynamicMesh;
+	build->atlasRegion = atlasRegion;
+	build->texture = texture;
+	build->textureImage = textureImage;
+	build->heightTile = heightTile;
+	build->intersectTree = intersectTree;
 
-		TArray<const FMeshDescription*> meshDescPtrs;
-		meshDescPtrs.Emplace(&MeshDescription);
-		build->staticMesh->BuildFromMeshDescriptions(meshDescPtrs, mdParams);
-	}
+	return build;
+}
 
+gzFloat cswGeometryFactory::updateRate(cswGeometryBuild* existing, gzDouble now, const BuildProperties& buildProperties)
+{
+	const gzDouble elapsed = now - existing->updateTime;
 
+	if (elapsed <= 0)
+		return existing->updateRate;
 
+	const gzFloat rate = (gzFloat)(1.0 / elapsed);
 
+	// Idle long enough to count as a new burst of updates
+	if (elapsed > buildProperties.dynamicMeshIdleTime)
+		return rate;
 
-	return build;
+	return 0.5f * (existing->updateRate + rate);
 }
 
-
-gzReference* cswGeometryFactory::updateReferenceInstance(gzNode* node, const gzUInt64& pathID, gzGroup* parent, const gzUInt64& parentPathID, gzState* state, gzReference* userdata)
+gzReference* cswGeometryFactory::updateReferenceInstance(gzNode* node, const gzUInt64& pathID, gzGroup* parent, const gzUInt64& parentPathID, gzState* state, gzReference* userdata, const BuildProperties& buildProperties)
 {
 	gzGeometry* geom = gzDynamic_Cast<gzGeometry>(node);
 
@@ -475,12 +449,32 @@ gzReference* cswGeometryFactory::updateReferenceInstance(gzNode* node, const gzU
 	if (existing && existing->updateID == geom->getUpdateID())
 		return existing;
 
-	gzReference* rebuilt = preBuildReferenceInstance(node, pathID, parent, parentPathID, state);
+	const gzDouble now = gzTime::systemSeconds();
+
+	const gzFloat rate = existing ? updateRate(existing, now, buildProperties) : 0;
 
-	if (rebuilt)
-		return rebuilt;
+	cswGeometryBuild* build(nullptr);
 
-	return userdata;
+	// Frequently updated geometry skips static mesh builds
+	if (buildProperties.dynamicMeshUpdateRate > 0 && rate >= buildProperties.dynamicMeshUpdateRate)
+		build = buildDynamic(geom, parent, state, existing, buildProperties);
+
+	// Same topology. Reuse the static mesh and send changed vertex ranges only. A full build not shown yet is
+	// rebuilt, as the component would switch to its mesh without the delta
+	if (!build && buildProperties.partialGeometryUpdates && existing && existing->staticMesh && existing->fingerprint && existing->shown)
+		build = buildDelta(geom, existing, buildProperties);
+
+	// Updated geometry is rebuilt with a fingerprint so the next update can be partial
+	if (!build)
+		build = buildGeometry(geom, parent, state, buildProperties, buildProperties.partialGeometryUpdates);
+
+	if (!build)
+		return userdata;
+
+	build->updateTime = now;
+	build->updateRate = rate;
+
+	return build;
 }
 
 gzVoid cswGeometryFactory::preDestroyReferenceInstance(gzNode* node, const gzUInt64& pathID, gzReference* userdata)
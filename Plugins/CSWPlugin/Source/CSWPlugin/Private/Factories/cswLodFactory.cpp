@@ -0,0 +1,308 @@
+//*****************************************************************************
+//
+// Copyright (C) SAAB AB
+//
+// All rights, including the copyright, to the computer program(s)
+// herein belong to SAAB AB. The program(s) may be used and/or
+// copied only with the written permission of SAAB AB, or in
+// accordance with the terms and conditions stipulated in the
+// agreement/contract under which the program(s) have been
+// supplied.
+//
+//
+// Information Class:	COMPANY UNCLASSIFIED
+// Defence Secrecy:		NOT CLASSIFIED
+// Export Control:		NOT EXPORT CONTROLLED
+//
+//
+// File			: cswLodFactory.cpp
+// Module		: CSW StreamingMap Unreal
+// Description	: Implementation if factory for cswLod
+// Author		: agent
+// Product		: CSW 1.1.2
+//
+//
+//
+// NOTE:	CSW (Common Synthetic World) is a simulation and presentation
+//			framework for large scale digital twins on multiple platforms
+//
+//
+// Revision History...
+//
+// Who	Date	Description
+//
+// AGT	261019	Created file 							(1.1.3)
+//
+//******************************************************************************
+#include "cswFactory.h"
+#include "Builders/cswLod.h"
+#include "Builders/cswGeometry.h"
+#include "gzGeometry.h"
+#include "gzLod.h"
+
+#include "MeshDescription.h"
+
+#include "cswSceneManagerBase.h"
+
+//---------------------- cswLodFactory -------------------------------------
+
+class cswLodFactory : public cswFactory
+{
+public:
+
+	GZ_DECLARE_TYPE_INTERFACE;
+
+	virtual gzReference* clone() const
+	{
+		return new cswLodFactory(*this);
+	}
+
+	virtual UCSWSceneComponent* newObjectInstance(USceneComponent* parent,gzNode* node, EObjectFlags Flags, UObject* Template, bool bCopyTransientsFromClassDefaults, FObjectInstancingGraph* InInstanceGraph) override
+	{
+		UCSWLod *lod = NewObject<UCSWLod>(parent, node->getName().getWideString(),Flags,Template,bCopyTransientsFromClassDefaults,InInstanceGraph);
+
+		return lod;
+	}
+
+	virtual gzReference* preBuildReferenceInstance(gzNode* node, const gzUInt64& pathID, gzGroup* parent, const gzUInt64& parentPathID, gzState* state, const BuildProperties& buildProperties) override;
+
+	virtual gzReference* updateReferenceInstance(gzNode* node, const gzUInt64& pathID, gzGroup* parent, const gzUInt64& parentPathID, gzState* state, gzReference* userdata, const BuildProperties& buildProperties) override;
+
+private:
+
+	cswLodBuild* buildMergedLod(gzLod* lod, const TArray<cswLodRange>& levels, const BuildProperties& buildProperties);
+
+	static bool collectLevels(gzLod* lod, TArray<cswLodRange>& levels);
+};
+
+GZ_DECLARE_TYPE_CHILD(cswFactory, cswLodFactory, "cswLodFactory");
+
+//---------------------- cswLodFactoryRegistrar -------------------------------------
+
+class cswLodFactoryRegistrar : public gzReference
+{
+public:
+
+	cswLodFactoryRegistrar()
+	{
+		cswFactoryPtr factory = new cswLodFactory;
+
+		// register factory for object serialize
+		m_id=gzObject::registerFactoryObject(factory);
+
+		// register factory for component creation
+		cswFactory::registerFactory("gzLod", factory);
+	}
+
+	gzBool	releaseRefs()
+	{
+		if (m_id)
+		{
+			cswFactory::unregisterFactory("gzLod");
+
+			// release factory early
+			gzObject::unregisterFactory(m_id);
+			m_id = 0;
+		}
+
+		return TRUE;
+	}
+
+	~cswLodFactoryRegistrar()
+	{
+		// If not handled by releaseRefs earlier
+		releaseRefs();
+	}
+
+private:
+
+	gzUInt32 m_id;
+};
+
+gzCleanupReference cleanUpLodFactory(new cswLodFactoryRegistrar, GZ_CLEANUP_MODULES);
+
+
+// Only LODs with one triangle geometry per level and all levels enabled can be merged
+bool cswLodFactory::collectLevels(gzLod* lod, TArray<cswLodRange>& levels)
+{
+	if (!lod->useLevels())
+		return false;
+
+	gzUInt32 count = lod->getNumberOfNodes();
+
+	if (count < 2)
+		return false;
+
+	for (gzUInt32 i = 0; i < count; i++)
+	{
+		gzBool enable(FALSE);
+		gzFloat nearDistance(0), farDistance(FLT_MAX);
+
+		lod->getLOD(i, &enable, &nearDistance, &farDistance);
+
+		// The generic range set after merging would show a disabled level again
+		if (!enable)
+			return false;
+
+		gzGeometry* geom = gzDynamic_Cast<gzGeometry>(lod->getNode(i));
+
+		if (!geom || geom->getGeoPrimType() != GZ_PRIM_TRIS)
+			return false;
+
+		levels.Add({ nearDistance, farDistance, i });
+	}
+
+	if (levels.Num() < 2 || levels.Num() > MAX_STATIC_MESH_LODS)
+		return false;
+
+	// UE LOD0 is the nearest level
+	levels.Sort([](const cswLodRange& a, const cswLodRange& b) { return a.nearDistance < b.nearDistance; });
+
+	return true;
+}
+
+gzReference* cswLodFactory::preBuildReferenceInstance(gzNode* node, const gzUInt64& pathID, gzGroup* parent, const gzUInt64& parentPathID, gzState* state, const BuildProperties& buildProperties)
+{
+	if (!buildProperties.mergeLodLevels)
+		return nullptr;
+
+	gzLod* lod = gzDynamic_Cast<gzLod>(node);
+
+	if (!lod)
+		return nullptr;
+
+	TArray<cswLodRange> levels;
+
+	if (!collectLevels(lod, levels))
+		return nullptr;
+
+	return buildMergedLod(lod, levels, buildProperties);
+}
+
+gzReference* cswLodFactory::updateReferenceInstance(gzNode* node, const gzUInt64& pathID, gzGroup* parent, const gzUInt64& parentPathID, gzState* state, gzReference* userdata, const BuildProperties& buildProperties)
+{
+	gzLod* lod = gzDynamic_Cast<gzLod>(node);
+
+	if (!lod)
+		return userdata;
+
+	cswLodBuild* existing = gzDynamic_Cast<cswLodBuild>(userdata);
+
+	if (existing && existing->updateID == lod->getUpdateID())
+		return existing;
+
+	// Levels are moved out of an already merged gzLod so reuse them
+	if (existing && existing->levels.Num() && lod->hasAttribute(CSW_META, CSW_LOD_MERGED))
+	{
+		gzReference* rebuilt = buildMergedLod(lod, existing->levels, buildProperties);
+
+		if (rebuilt)
+			return rebuilt;
+
+		return userdata;
+	}
+
+	gzReference* rebuilt = preBuildReferenceInstance(node, pathID, parent, parentPathID, state, buildProperties);
+
+	if (rebuilt)
+		return rebuilt;
+
+	return userdata;
+}
+
+// Called in EDIT LOCK
+cswLodBuild* cswLodFactory::buildMergedLod(gzLod* lod, const TArray<cswLodRange>& levels, const BuildProperties& buildProperties)
+{
+	GZ_INSTRUMENT_NAME("cswLodFactory::buildMergedLod");
+
+	TArray<gzGeometryPtr>	geometries;
+	TArray<gzStatePtr>		levelStates;
+
+	for (const cswLodRange& level : levels)
+	{
+		gzGeometry* geom = gzDynamic_Cast<gzGeometry>(lod->getNode(level.child));
+
+		if (!geom)
+			return nullptr;
+
+		geometries.Add(geom);
+		levelStates.Add(geom->getState());
+	}
+
+	TArray<FMeshDescription> descriptions;
+	descriptions.SetNum(geometries.Num());
+
+	TArray<const FMeshDescription*> meshDescPtrs;
+	TArray<FName> materialSlots;
+
+	UStaticMesh* staticMesh(nullptr);
+
+	cswHeightTilePtr	heightTile;
+	cswMeshBVHPtr		intersectTree;
+
+	{
+		// Mesh conversion does not need the graph lock
+		GZ_EDIT_GUARD_PAUSE;
+
+		for (int32 i = 0; i < geometries.Num(); i++)
+		{
+			FName slot(*FString::Printf(TEXT("LOD%d"), i));
+
+			if (!cswBuildMeshDescription(geometries[i], descriptions[i], buildProperties, slot))
+				return nullptr;
+
+			meshDescPtrs.Add(&descriptions[i]);
+			materialSlots.Add(slot);
+		}
+
+		staticMesh = cswBuildStaticMesh(meshDescPtrs, materialSlots, buildProperties);
+
+		// Queries use the most detailed level
+		if (staticMesh)
+			cswBuildQueryData(geometries[0], buildProperties, heightTile, intersectTree);
+	}
+
+	if (!staticMesh)
+		return nullptr;
+
+	// Screen size from gizmo switch distances. UE screen size is ~ radius / distance at 90 deg fov
+	FStaticMeshRenderData* renderData = staticMesh->GetRenderData();
+
+	if (renderData)
+	{
+		const float radius = staticMesh->GetBounds().SphereRadius;
+
+		float previous = 1.0f;
+
+		renderData->ScreenSize[0].Default = previous;
+
+		for (int32 i = 1; i < levels.Num(); i++)
+		{
+			float screenSize = levels[i].nearDistance > 0 ? radius / levels[i].nearDistance : previous;
+
+			// Must be strictly decreasing
+			screenSize = FMath::Min(screenSize, previous * 0.99f);
+
+			renderData->ScreenSize[i].Default = screenSize;
+
+			previous = screenSize;
+		}
+	}
+
+	// UE switches the levels now. Let gizmo keep all children active inside the outer range
+	// so no activations are sent for the merged children
+	lod->setGenericLOD(TRUE, 0, levels.Last().farDistance);
+
+	lod->setAttribute(CSW_META, CSW_LOD_MERGED, 1.0);
+
+	cswLodBuild* build = new cswLodBuild;
+
+	build->updateID = lod->getUpdateID();
+	build->staticMesh = staticMesh;
+	build->levelStates = levelStates;
+	build->levels = levels;
+	build->heightTile = heightTile;
+	build->intersectTree = intersectTree;
+
+	return build;
+}
@@ -0,0 +1,509 @@
+//*****************************************************************************
+//
+// Copyright (C) SAAB AB
+//
+// All rights, including the copyright, to the computer program(s)
+// herein belong to SAAB AB. The program(s) may be used and/or
+// copied only with the written permission of SAAB AB, or in
+// accordance with the terms and conditions stipulated in the
+// agreement/contract under which the program(s) have been
+// supplied.
+//
+//
+// Information Class:	COMPANY UNCLASSIFIED
+// Defence Secrecy:		NOT CLASSIFIED
+// Export Control:		NOT EXPORT CONTROLLED
+//
+//
+// File			: cswBlockCompression.cpp
+// Module		: CSW StreamingMap Unreal
+// Description	: BC1 and BC3 block compression of RGBA images
+// Author		: agent
+// Product		: CSW 1.1.2
+//
+//
+//
+// NOTE:	CSW (Common Synthetic World) is a simulation and presentation
+//			framework for large scale digital twins on multiple platforms
+//
+//
+// Revision History...
+//
+// Who	Date	Description
+//
+// AGT	261019	Created file 					(1.1.3)
+//
+//******************************************************************************
+#include "Utility/cswBlockCompression.h"
+#include "gzPerformance.h"
+
+namespace
+{
+	// Weight of endpoint 0 per color index in four color mode
+	const float COLOR_WEIGHTS[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+
+	uint16 pack565(const float color[3])
+	{
+		const uint32 r = FMath::Clamp(FMath::RoundToInt(color[0] * 31.0f / 255.0f), 0, 31);
+		const uint32 g = FMath::Clamp(FMath::RoundToInt(color[1] * 63.0f / 255.0f), 0, 63);
+		const uint32 b = FMath::Clamp(FMath::RoundToInt(color[2] * 31.0f / 255.0f), 0, 31);
+
+		return (uint16)((r << 11) | (g << 5) | b);
+	}
+
+	void unpack565(uint16 color, int32 out[3])
+	{
+		const int32 r = (color >> 11) & 31;
+		const int32 g = (color >> 5) & 63;
+		const int32 b = color & 31;
+
+		out[0] = (r << 3) | (r >> 2);
+		out[1] = (g << 2) | (g >> 4);
+		out[2] = (b << 3) | (b >> 2);
+	}
+
+	void colorPalette(uint16 c0, uint16 c1, int32 palette[4][3])
+	{
+		unpack565(c0, palette[0]);
+		unpack565(c1, palette[1]);
+
+		for (int32 k = 0; k < 3; k++)
+		{
+			palette[2][k] = (2 * palette[0][k] + palette[1][k]) / 3;
+			palette[3][k] = (palette[0][k] + 2 * palette[1][k]) / 3;
+		}
+	}
+
+	// Nearest palette entry per pixel. Returns squared error of the block
+	int32 colorIndices(const uint8 block[64], const int32 palette[4][3], uint32& indices)
+	{
+		int32 total(0);
+
+		indices = 0;
+
+		for (int32 i = 0; i < 16; i++)
+		{
+			const uint8* pixel = block + i * 4;
+
+			int32 best(0);
+			int32 bestError(INT_MAX);
+
+			for (int32 j = 0; j < 4; j++)
+			{
+				const int32 dr = pixel[0] - palette[j][0];
+				const int32 dg = pixel[1] - palette[j][1];
+				const int32 db = pixel[2] - palette[j][2];
+
+				const int32 error = dr * dr + dg * dg + db * db;
+
+				if (error < bestError)
+				{
+					bestError = error;
+					best = j;
+				}
+			}
+
+			indices |= (uint32)best << (i * 2);
+			total += bestError;
+		}
+
+		return total;
+	}
+
+	void colorMean(const uint8 block[64], float mean[3])
+	{
+		mean[0] = mean[1] = mean[2] = 0;
+
+		for (int32 i = 0; i < 16; i++)
+			for (int32 k = 0; k < 3; k++)
+				mean[k] += block[i * 4 + k];
+
+		for (int32 k = 0; k < 3; k++)
+			mean[k] /= 16.0f;
+	}
+
+	// Bounding box diagonal that follows the colors, inset to cut error at the extremes
+	void boxEndpoints(const uint8 block[64], float e0[3], float e1[3])
+	{
+		float low[3] = { 255, 255, 255 };
+		float high[3] = { 0, 0, 0 };
+
+		float mean[3];
+		colorMean(block, mean);
+
+		float covRG(0), covBG(0);
+
+		for (int32 i = 0; i < 16; i++)
+		{
+			const uint8* pixel = block + i * 4;
+
+			for (int32 k = 0; k < 3; k++)
+			{
+				low[k] = FMath::Min(low[k], (float)pixel[k]);
+				high[k] = FMath::Max(high[k], (float)pixel[k]);
+			}
+
+			covRG += (pixel[0] - mean[0]) * (pixel[1] - mean[1]);
+			covBG += (pixel[2] - mean[2]) * (pixel[1] - mean[1]);
+		}
+
+		// Red or blue falling while green rises uses the other diagonal
+		if (covRG < 0)
+			Swap(low[0], high[0]);
+
+		if (covBG < 0)
+			Swap(low[2], high[2]);
+
+		for (int32 k = 0; k < 3; k++)
+		{
+			const float inset = (high[k] - low[k]) / 16.0f;
+
+			e0[k] = high[k] - inset;
+			e1[k] = low[k] + inset;
+		}
+	}
+
+	// Extremes of the colors projected on their principal axis
+	void axisEndpoints(const uint8 block[64], float e0[3], float e1[3])
+	{
+		float mean[3];
+		colorMean(block, mean);
+
+		float cov[6] = { 0, 0, 0, 0, 0, 0 };
+
+		for (int32 i = 0; i < 16; i++)
+		{
+			const float r = block[i * 4 + 0] - mean[0];
+			const float g = block[i * 4 + 1] - mean[1];
+			const float b = block[i * 4 + 2] - mean[2];
+
+			cov[0] += r * r;
+			cov[1] += r * g;
+			cov[2] += r * b;
+			cov[3] += g * g;
+			cov[4] += g * b;
+			cov[5] += b * b;
+		}
+
+		// Power iteration from the box diagonal
+		float axis[3];
+		boxEndpoints(block, e0, e1);
+
+		for (int32 k = 0; k < 3; k++)
+			axis[k] = e0[k] - e1[k];
+
+		for (int32 iteration = 0; iteration < 8; iteration++)
+		{
+			const float x = cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2];
+			const float y = cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2];
+			const float z = cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2];
+
+			const float scale = FMath::Max3(FMath::Abs(x), FMath::Abs(y), FMath::Abs(z));
+
+			if (scale < KINDA_SMALL_NUMBER)
+				break;
+
+			axis[0] = x / scale;
+			axis[1] = y / scale;
+			axis[2] = z / scale;
+		}
+
+		const float length = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+
+		// Flat block. Box endpoints are already the mean
+		if (length < KINDA_SMALL_NUMBER)
+			return;
+
+		float low(FLT_MAX), high(-FLT_MAX);
+
+		for (int32 i = 0; i < 16; i++)
+		{
+			const float t = ((block[i * 4 + 0] - mean[0]) * axis[0] + (block[i * 4 + 1] - mean[1]) * axis[1] + (block[i * 4 + 2] - mean[2]) * axis[2]) / length;
+
+			low = FMath::Min(low, t);
+			high = FMath::Max(high, t);
+		}
+
+		for (int32 k = 0; k < 3; k++)
+		{
+			e0[k] = FMath::Clamp(mean[k] + axis[k] * high, 0.0f, 255.0f);
+			e1[k] = FMath::Clamp(mean[k] + axis[k] * low, 0.0f, 255.0f);
+		}
+	}
+
+	// Least squares endpoints for fixed indices
+	bool refineEndpoints(const uint8 block[64], uint32 indices, float e0[3], float e1[3])
+	{
+		float aa(0), bb(0), ab(0);
+		float ax[3] = { 0, 0, 0 };
+		float bx[3] = { 0, 0, 0 };
+
+		for (int32 i = 0; i < 16; i++)
+		{
+			const float a = COLOR_WEIGHTS[(indices >> (i * 2)) & 3];
+			const float b = 1.0f - a;
+
+			aa += a * a;
+			bb += b * b;
+			ab += a * b;
+
+			for (int32 k = 0; k < 3; k++)
+			{
+				ax[k] += a * block[i * 4 + k];
+				bx[k] += b * block[i * 4 + k];
+			}
+		}
+
+		const float det = aa * bb - ab * ab;
+
+		if (FMath::Abs(det) < KINDA_SMALL_NUMBER)
+			return false;
+
+		for (int32 k = 0; k < 3; k++)
+		{
+			e0[k] = FMath::Clamp((ax[k] * bb - bx[k] * ab) / det, 0.0f, 255.0f);
+			e1[k] = FMath::Clamp((bx[k] * aa - ax[k] * ab) / det, 0.0f, 255.0f);
+		}
+
+		return true;
+	}
+
+	// Four color mode needs c0 > c1. Equal endpoints use index 0 only
+	int32 fitColor(const uint8 block[64], const float e0[3], const float e1[3], uint16& c0, uint16& c1, uint32& indices)
+	{
+		c0 = pack565(e0);
+		c1 = pack565(e1);
+
+		if (c0 < c1)
+			Swap(c0, c1);
+
+		int32 palette[4][3];
+		colorPalette(c0, c1, palette);
+
+		const int32 error = colorIndices(block, palette, indices);
+
+		if (c0 == c1)
+			indices = 0;
+
+		return error;
+	}
+
+	void encodeColor(const uint8 block[64], cswBlockQuality quality, uint8* out)
+	{
+		float e0[3], e1[3];
+
+		if (quality == CSW_BLOCK_QUALITY_HIGH)
+			axisEndpoints(block, e0, e1);
+		else
+			boxEndpoints(block, e0, e1);
+
+		uint16 c0, c1;
+		uint32 indices;
+
+		int32 error = fitColor(block, e0, e1, c0, c1, indices);
+
+		if (quality == CSW_BLOCK_QUALITY_HIGH && c0 != c1 && refineEndpoints(block, indices, e0, e1))
+		{
+			uint16 r0, r1;
+			uint32 refined;
+
+			if (fitColor(block, e0, e1, r0, r1, refined) < error)
+			{
+				c0 = r0;
+				c1 = r1;
+				indices = refined;
+			}
+		}
+
+		out[0] = c0 & 0xff;
+		out[1] = c0 >> 8;
+		out[2] = c1 & 0xff;
+		out[3] = c1 >> 8;
+
+		for (int32 k = 0; k < 4; k++)
+			out[4 + k] = (indices >> (k * 8)) & 0xff;
+	}
+
+	// Eight value mode between block min and max
+	void encodeAlpha(const uint8 block[64], uint8* out)
+	{
+		int32 a0(0), a1(255);
+
+		for (int32 i = 0; i < 16; i++)
+		{
+			a0 = FMath::Max(a0, (int32)block[i * 4 + 3]);
+			a1 = FMath::Min(a1, (int32)block[i * 4 + 3]);
+		}
+
+		out[0] = a0;
+		out[1] = a1;
+
+		uint64 bits(0);
+
+		if (a0 != a1)
+		{
+			int32 palette[8] = { a0, a1 };
+
+			for (int32 j = 1; j < 7; j++)
+				palette[j + 1] = ((7 - j) * a0 + j * a1) / 7;
+
+			for (int32 i = 0; i < 16; i++)
+			{
+				const int32 alpha = block[i * 4 + 3];
+
+				int32 best(0);
+				int32 bestError(INT_MAX);
+
+				for (int32 j = 0; j < 8; j++)
+				{
+					const int32 error = FMath::Abs(alpha - palette[j]);
+
+					if (error < bestError)
+					{
+						bestError = error;
+						best = j;
+					}
+				}
+
+				bits |= (uint64)best << (i * 3);
+			}
+		}
+
+		for (int32 k = 0; k < 6; k++)
+			out[2 + k] = (bits >> (k * 8)) & 0xff;
+	}
+
+	void decodeColor(const uint8* in, bool fourColor, uint8 block[64])
+	{
+		const uint16 c0 = in[0] | (in[1] << 8);
+		const uint16 c1 = in[2] | (in[3] << 8);
+
+		const uint32 indices = in[4] | (in[5] << 8) | (in[6] << 16) | ((uint32)in[7] << 24);
+
+		int32 palette[4][3];
+		colorPalette(c0, c1, palette);
+
+		int32 alpha[4] = { 255, 255, 255, 255 };
+
+		// Three color mode with transparent black
+		if (!fourColor && c0 <= c1)
+		{
+			for (int32 k = 0; k < 3; k++)
+			{
+				palette[2][k] = (palette[0][k] + palette[1][k]) / 2;
+				palette[3][k] = 0;
+			}
+
+			alpha[3] = 0;
+		}
+
+		for (int32 i = 0; i < 16; i++)
+		{
+			const uint32 index = (indices >> (i * 2)) & 3;
+
+			block[i * 4 + 0] = palette[index][0];
+			block[i * 4 + 1] = palette[index][1];
+			block[i * 4 + 2] = palette[index][2];
+			block[i * 4 + 3] = alpha[index];
+		}
+	}
+
+	void decodeAlpha(const uint8* in, uint8 block[64])
+	{
+		const int32 a0 = in[0];
+		const int32 a1 = in[1];
+
+		int32 palette[8] = { a0, a1 };
+
+		if (a0 > a1)
+		{
+			for (int32 j = 1; j < 7; j++)
+				palette[j + 1] = ((7 - j) * a0 + j * a1) / 7;
+		}
+		else
+		{
+			for (int32 j = 1; j < 5; j++)
+				palette[j + 1] = ((5 - j) * a0 + j * a1) / 5;
+
+			palette[6] = 0;
+			palette[7] = 255;
+		}
+
+		uint64 bits(0);
+
+		for (int32 k = 0; k < 6; k++)
+			bits |= (uint64)in[2 + k] << (k * 8);
+
+		for (int32 i = 0; i < 16; i++)
+			block[i * 4 + 3] = palette[(bits >> (i * 3)) & 7];
+	}
+}
+
+uint32 cswBlockBytes(uint32 width, uint32 height, bool alpha)
+{
+	return FMath::Max(1u, (width + 3) / 4) * FMath::Max(1u, (height + 3) / 4) * (alpha ? 16 : 8);
+}
+
+void cswEncodeBlocks(const uint8* rgba, uint32 width, uint32 height, bool alpha, cswBlockQuality quality, uint8* blocks)
+{
+	GZ_INSTRUMENT_NAME("cswEncodeBlocks");
+
+	if (!width || !height)
+		return;
+
+	uint8 block[64];
+
+	for (uint32 by = 0; by < height; by += 4)
+	{
+		for (uint32 bx = 0; bx < width; bx += 4)
+		{
+			for (uint32 i = 0; i < 16; i++)
+			{
+				const uint32 x = FMath::Min(bx + (i & 3), width - 1);
+				const uint32 y = FMath::Min(by + (i >> 2), height - 1);
+
+				FMemory::Memcpy(block + i * 4, rgba + (y * width + x) * 4, 4);
+			}
+
+			if (alpha)
+			{
+				encodeAlpha(block, blocks);
+				blocks += 8;
+			}
+
+			encodeColor(block, quality, blocks);
+			blocks += 8;
+		}
+	}
+}
+
+void cswDecodeBlocks(const uint8* blocks, uint32 width, uint32 height, bool alpha, uint8* rgba)
+{
+	uint8 block[64];
+
+	for (uint32 by = 0; by < height; by += 4)
+	{
+		for (uint32 bx = 0; bx < width; bx += 4)
+		{
+			// BC3 color is always four color mode
+			decodeColor(blocks + (alpha ? 8 : 0), alpha, block);
+
+			if (alpha)
+			{
+				decodeAlpha(blocks, block);
+				blocks += 8;
+			}
+
+			blocks += 8;
+
+			for (uint32 i = 0; i < 16; i++)
+			{
+				const uint32 x = bx + (i & 3);
+				const uint32 y = by + (i >> 2);
+
+				if (x < width && y < height)
+					FMemory::Memcpy(rgba + (y * width + x) * 4, block + i * 4, 4);
+			}
+		}
+	}
+}
@@ -0,0 +1,54 @@
+//*****************************************************************************
+//
+// Copyright (C) SAAB AB
+//
+// All rights, including the copyright, to the computer program(s)
+// herein belong to SAAB AB. The program(s) may be used and/or
+// copied only with the written permission of SAAB AB, or in
+// accordance with the terms and conditions stipulated in the
+// agreement/contract under which the program(s) have been
+// supplied.
+//
+//
+// Information Class:	COMPANY UNCLASSIFIED
+// Defence Secrecy:		NOT CLASSIFIED
+// Export Control:		NOT EXPORT CONTROLLED
+//
+//
+// File			: cswBlockCompression.h
+// Module		: CSW StreamingMap Unreal
+// Description	: BC1 and BC3 block compression of RGBA images
+// Author		: agent
+// Product		: CSW 1.1.2
+//
+//
+//
+// NOTE:	CSW (Common Synthetic World) is a simulation and presentation
+//			framework for large scale digital twins on multiple platforms
+//
+//
+// Revision History...
+//
+// Who	Date	Description
+//
+// AGT	261019	Created file 					(1.1.3)
+//
+//******************************************************************************
+#pragma once
+
+#include "CoreMinimal.h"
+
+enum cswBlockQuality
+{
+	CSW_BLOCK_QUALITY_FAST,		// Bounding box endpoints
+	CSW_BLOCK_QUALITY_HIGH,		// Principal axis endpoints refined by least squares
+};
+
+//! Size of the block data for an image level. BC1 is 8 bytes per 4x4 block and BC3 16 bytes
+uint32 cswBlockBytes(uint32 width, uint32 height, bool alpha);
+
+//! Encode RGBA8 pixels to BC1 (alpha false) or BC3 (alpha true). Edge blocks repeat the last row and column
+void cswEncodeBlocks(const uint8* rgba, uint32 width, uint32 height, bool alpha, cswBlockQuality quality, uint8* blocks);
+
+//! Decode BC1 or BC3 blocks to RGBA8 pixels. Used to measure encoding error
+void cswDecodeBlocks(const uint8* blocks, uint32 width, uint32 height, bool alpha, uint8* rgba);
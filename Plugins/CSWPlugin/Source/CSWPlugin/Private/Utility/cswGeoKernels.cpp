@@ -0,0 +1,238 @@
+//*****************************************************************************
+//
+// Copyright (C) SAAB AB
+//
+// All rights, including the copyright, to the computer program(s)
+// herein belong to SAAB AB. The program(s) may be used and/or
+// copied only with the written permission of SAAB AB, or in
+// accordance with the terms and conditions stipulated in the
+// agreement/contract under which the program(s) have been
+// supplied.
+//
+//
+// Information Class:	COMPANY UNCLASSIFIED
+// Defence Secrecy:		NOT CLASSIFIED
+// Export Control:		NOT EXPORT CONTROLLED
+//
+//
+// File			: cswGeoKernels.cpp
+// Module		: CSW StreamingMap Unreal
+// Description	: WGS84 batch kernels for geodetic, geocentric and UTM
+// Author		: agent
+// Product		: CSW 1.1.2
+//
+//
+//
+// NOTE:	CSW (Common Synthetic World) is a simulation and presentation
+//			framework for large scale digital twins on multiple platforms
+//
+//
+// Revision History...
+//
+// Who	Date	Description
+//
+// AGT	261019	Created file 					(1.1.3)
+//
+//******************************************************************************
+#include "Utility/cswGeoKernels.h"
+
+#include <cmath>
+
+namespace
+{
+	const double A = 6378137.0;
+	const double F = 1.0 / 298.257223563;
+	const double B = A * (1.0 - F);
+	const double E2 = F * (2.0 - F);
+	const double EP2 = E2 / (1.0 - E2);
+	const double E = 0.08181919084262149;		// sqrt(E2)
+
+	const double K0 = 0.9996;
+	const double FALSE_EASTING = 500000.0;
+
+	const int32 ORDER = 6;
+
+	// Kruger series in the third flattening n
+	struct Series
+	{
+		double	rectifying;			// k0 times rectifying radius
+		double	alpha[ORDER];		// Conformal to projected
+		double	beta[ORDER];		// Projected to conformal
+	};
+
+	Series createSeries()
+	{
+		const double n = F / (2.0 - F);
+		const double n2 = n * n, n3 = n2 * n, n4 = n3 * n, n5 = n4 * n, n6 = n5 * n;
+
+		Series s;
+
+		s.rectifying = K0 * A / (1.0 + n) * (1.0 + n2 / 4.0 + n4 / 64.0 + n6 / 256.0);
+
+		s.alpha[0] = n / 2.0 - 2.0 * n2 / 3.0 + 5.0 * n3 / 16.0 + 41.0 * n4 / 180.0 - 127.0 * n5 / 288.0 + 7891.0 * n6 / 37800.0;
+		s.alpha[1] = 13.0 * n2 / 48.0 - 3.0 * n3 / 5.0 + 557.0 * n4 / 1440.0 + 281.0 * n5 / 630.0 - 1983433.0 * n6 / 1935360.0;
+		s.alpha[2] = 61.0 * n3 / 240.0 - 103.0 * n4 / 140.0 + 15061.0 * n5 / 26880.0 + 167603.0 * n6 / 181440.0;
+		s.alpha[3] = 49561.0 * n4 / 161280.0 - 179.0 * n5 / 168.0 + 6601661.0 * n6 / 7257600.0;
+		s.alpha[4] = 34729.0 * n5 / 80640.0 - 3418889.0 * n6 / 1995840.0;
+		s.alpha[5] = 212378941.0 * n6 / 319334400.0;
+
+		s.beta[0] = n / 2.0 - 2.0 * n2 / 3.0 + 37.0 * n3 / 96.0 - n4 / 360.0 - 81.0 * n5 / 512.0 + 96199.0 * n6 / 604800.0;
+		s.beta[1] = n2 / 48.0 + n3 / 15.0 - 437.0 * n4 / 1440.0 + 46.0 * n5 / 105.0 - 1118711.0 * n6 / 3870720.0;
+		s.beta[2] = 17.0 * n3 / 480.0 - 37.0 * n4 / 840.0 - 209.0 * n5 / 4480.0 + 5569.0 * n6 / 90720.0;
+		s.beta[3] = 4397.0 * n4 / 161280.0 - 11.0 * n5 / 504.0 - 830251.0 * n6 / 7257600.0;
+		s.beta[4] = 4583.0 * n5 / 161280.0 - 108847.0 * n6 / 3991680.0;
+		s.beta[5] = 20648693.0 * n6 / 638668800.0;
+
+		return s;
+	}
+
+	const Series& series()
+	{
+		static const Series instance = createSeries();
+
+		return instance;
+	}
+
+	// Conformal latitude tangent from geodetic latitude tangent
+	inline double conformalTau(double tau)
+	{
+		const double root = std::sqrt(1.0 + tau * tau);
+		const double sigma = std::sinh(E * std::atanh(E * tau / root));
+
+		return tau * std::sqrt(1.0 + sigma * sigma) - sigma * root;
+	}
+
+	// Sum of c[j] * (sin, cos)(2j xi) * (cosh, sinh)(2j eta) with multiple angle recurrences
+	inline void krugerSum(const double* c, double xi, double eta, double& sumXi, double& sumEta)
+	{
+		const double s1 = std::sin(2.0 * xi), c1 = std::cos(2.0 * xi);
+		const double sh1 = std::sinh(2.0 * eta), ch1 = std::cosh(2.0 * eta);
+
+		double s = s1, co = c1, sh = sh1, ch = ch1;
+
+		sumXi = 0;
+		sumEta = 0;
+
+		for (int32 j = 0; j < ORDER; j++)
+		{
+			sumXi += c[j] * s * ch;
+			sumEta += c[j] * co * sh;
+
+			const double sn = s * c1 + co * s1;
+			const double cn = co * c1 - s * s1;
+			const double shn = sh * ch1 + ch * sh1;
+			const double chn = ch * ch1 + sh * sh1;
+
+			s = sn;
+			co = cn;
+			sh = shn;
+			ch = chn;
+		}
+	}
+}
+
+void cswGeodeticToGeocentric(const double* __restrict latitude, const double* __restrict longitude, const double* __restrict altitude, int32 count, double* __restrict x, double* __restrict y, double* __restrict z)
+{
+	for (int32 i = 0; i < count; i++)
+	{
+		const double sinLat = std::sin(latitude[i]), cosLat = std::cos(latitude[i]);
+
+		const double n = A / std::sqrt(1.0 - E2 * sinLat * sinLat);
+
+		const double r = (n + altitude[i]) * cosLat;
+
+		x[i] = r * std::cos(longitude[i]);
+		y[i] = r * std::sin(longitude[i]);
+		z[i] = (n * (1.0 - E2) + altitude[i]) * sinLat;
+	}
+}
+
+void cswGeocentricToGeodetic(const double* __restrict x, const double* __restrict y, const double* __restrict z, int32 count, double* __restrict latitude, double* __restrict longitude, double* __restrict altitude)
+{
+	for (int32 i = 0; i < count; i++)
+	{
+		const double p = std::sqrt(x[i] * x[i] + y[i] * y[i]);
+
+		// Bowring start on the parametric latitude
+		const double theta = std::atan2(z[i] * A, p * B);
+
+		const double sinTheta = std::sin(theta), cosTheta = std::cos(theta);
+
+		double lat = std::atan2(z[i] + EP2 * B * sinTheta * sinTheta * sinTheta, p - E2 * A * cosTheta * cosTheta * cosTheta);
+
+		double sinLat = std::sin(lat);
+
+		const double n = A / std::sqrt(1.0 - E2 * sinLat * sinLat);
+
+		lat = std::atan2(z[i] + E2 * n * sinLat, p);
+
+		sinLat = std::sin(lat);
+
+		const double cosLat = std::cos(lat);
+
+		latitude[i] = lat;
+		longitude[i] = std::atan2(y[i], x[i]);
+
+		// Stable at the poles as well
+		altitude[i] = p * cosLat + z[i] * sinLat - A * std::sqrt(1.0 - E2 * sinLat * sinLat);
+	}
+}
+
+void cswGeodeticToUTM(const double* __restrict latitude, const double* __restrict longitude, int32 count, double centralMeridian, double falseNorthing, double* __restrict easting, double* __restrict northing)
+{
+	const Series& s = series();
+
+	for (int32 i = 0; i < count; i++)
+	{
+		const double tau = conformalTau(std::tan(latitude[i]));
+
+		const double lambda = longitude[i] - centralMeridian;
+
+		const double cosLambda = std::cos(lambda);
+
+		const double xi = std::atan2(tau, cosLambda);
+		const double eta = std::asinh(std::sin(lambda) / std::sqrt(tau * tau + cosLambda * cosLambda));
+
+		double sumXi, sumEta;
+
+		krugerSum(s.alpha, xi, eta, sumXi, sumEta);
+
+		easting[i] = FALSE_EASTING + s.rectifying * (eta + sumEta);
+		northing[i] = falseNorthing + s.rectifying * (xi + sumXi);
+	}
+}
+
+void cswUTMToGeodetic(const double* __restrict easting, const double* __restrict northing, int32 count, double centralMeridian, double falseNorthing, double* __restrict latitude, double* __restrict longitude)
+{
+	const Series& s = series();
+
+	for (int32 i = 0; i < count; i++)
+	{
+		const double xi = (northing[i] - falseNorthing) / s.rectifying;
+		const double eta = (easting[i] - FALSE_EASTING) / s.rectifying;
+
+		double sumXi, sumEta;
+
+		krugerSum(s.beta, xi, eta, sumXi, sumEta);
+
+		const double xiPrime = xi - sumXi;
+		const double etaPrime = eta - sumEta;
+
+		const double sinhEta = std::sinh(etaPrime), cosXi = std::cos(xiPrime);
+
+		const double tauPrime = std::sin(xiPrime) / std::sqrt(sinhEta * sinhEta + cosXi * cosXi);
+
+		// Newton from conformal to geodetic latitude. Three fixed steps reach double precision
+		double tau = tauPrime;
+
+		for (int32 step = 0; step < 3; step++)
+		{
+			const double tauI = conformalTau(tau);
+
+			tau += (tauPrime - tauI) / std::sqrt(1.0 + tauI * tauI) * (1.0 + (1.0 - E2) * tau * tau) / ((1.0 - E2) * std::sqrt(1.0 + tau * tau));
+		}
+
+		latitude[i] = std::atan(tau);
+		longitude[i] = centralMeridian + std::atan2(sinhEta, cosXi);
+	}
+}
@@ -0,0 +1,53 @@
+//*****************************************************************************
+//
+// Copyright (C) SAAB AB
+//
+// All rights, including the copyright, to the computer program(s)
+// herein belong to SAAB AB. The program(s) may be used and/or
+// copied only with the written permission of SAAB AB, or in
+// accordance with the terms and conditions stipulated in the
+// agreement/contract under which the program(s) have been
+// supplied.
+//
+//
+// Information Class:	COMPANY UNCLASSIFIED
+// Defence Secrecy:		NOT CLASSIFIED
+// Export Control:		NOT EXPORT CONTROLLED
+//
+//
+// File			: cswGeoKernels.h
+// Module		: CSW StreamingMap Unreal
+// Description	: WGS84 batch kernels for geodetic, geocentric and UTM
+// Author		: agent
+// Product		: CSW 1.1.2
+//
+//
+//
+// NOTE:	CSW (Common Synthetic World) is a simulation and presentation
+//			framework for large scale digital twins on multiple platforms
+//
+//
+// Revision History...
+//
+// Who	Date	Description
+//
+// AGT	261019	Created file 					(1.1.3)
+//
+//******************************************************************************
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Structure of arrays in and out. Angles in radians, lengths in meters, heights above the WGS84 ellipsoid
+// Loops have no branches or calls besides math so compilers vectorize them with their vector math libraries
+
+//! Geodetic to earth centered earth fixed cartesian
+void cswGeodeticToGeocentric(const double* latitude, const double* longitude, const double* altitude, int32 count, double* x, double* y, double* z);
+
+//! Bowring with one refinement. Sub millimetre from -10 to 100 km heights
+void cswGeocentricToGeodetic(const double* x, const double* y, const double* z, int32 count, double* latitude, double* longitude, double* altitude);
+
+//! Transverse Mercator with the 6th order Kruger series and UTM scale and false easting
+void cswGeodeticToUTM(const double* latitude, const double* longitude, int32 count, double centralMeridian, double falseNorthing, double* easting, double* northing);
+
+void cswUTMToGeodetic(const double* easting, const double* northing, int32 count, double centralMeridian, double falseNorthing, double* latitude, double* longitude);
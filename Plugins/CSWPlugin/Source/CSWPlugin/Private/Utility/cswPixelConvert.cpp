@@ -0,0 +1,250 @@
+//*****************************************************************************
+//
+// Copyright (C) SAAB AB
+//
+// All rights, including the copyright, to the computer program(s)
+// herein belong to SAAB AB. The program(s) may be used and/or
+// copied only with the written permission of SAAB AB, or in
+// accordance with the terms and conditions stipulated in the
+// agreement/contract under which the program(s) have been
+// supplied.
+//
+//
+// Information Class:	COMPANY UNCLASSIFIED
+// Defence Secrecy:		NOT CLASSIFIED
+// Export Control:		NOT EXPORT CONTROLLED
+//
+//
+// File			: cswPixelConvert.cpp
+// Module		: CSW StreamingMap Unreal
+// Description	: Pixel converters for gzImage types UE can not sample
+// Author		: agent
+// Product		: CSW 1.1.2
+//
+//
+//
+// NOTE:	CSW (Common Synthetic World) is a simulation and presentation
+//			framework for large scale digital twins on multiple platforms
+//
+//
+// Revision History...
+//
+// Who	Date	Description
+//
+// AGT	261019	Created file 					(1.1.3)
+//
+//******************************************************************************
+#include "Utility/cswPixelConvert.h"
+#include "Async/ParallelFor.h"
+#include "gzPerformance.h"
+
+namespace
+{
+	// Rows per task when a conversion is split over workers
+	const uint32 ROWS_PER_TASK = 64;
+
+	// Pixels before a conversion is split
+	const uint64 PARALLEL_PIXELS = 256 * 1024;
+
+	// Half 1.0 for padded alpha
+	const uint16 HALF_ONE = 0x3C00;
+
+	// Row loops below work on whole words with no branches so the compiler vectorizes them
+
+	void rgb8Row(const uint8* __restrict source, uint32 width, uint32* __restrict target)
+	{
+		for (uint32 x = 0; x < width; x++)
+			target[x] = source[x * 3] | (source[x * 3 + 1] << 8) | (source[x * 3 + 2] << 16) | 0xFF000000u;
+	}
+
+	void bgr8Row(const uint8* __restrict source, uint32 width, uint32* __restrict target)
+	{
+		for (uint32 x = 0; x < width; x++)
+			target[x] = source[x * 3 + 2] | (source[x * 3 + 1] << 8) | (source[x * 3] << 16) | 0xFF000000u;
+	}
+
+	// Memory order A B G R to R G B A
+	void abgr8Row(const uint32* __restrict source, uint32 width, uint32* __restrict target)
+	{
+		for (uint32 x = 0; x < width; x++)
+		{
+			const uint32 p = source[x];
+
+			target[x] = (p >> 24) | ((p >> 8) & 0xFF00u) | ((p << 8) & 0xFF0000u) | (p << 24);
+		}
+	}
+
+	void bwa8Row(const uint8* __restrict source, uint32 width, uint32* __restrict target)
+	{
+		for (uint32 x = 0; x < width; x++)
+		{
+			const uint32 l = source[x * 2];
+
+			target[x] = l | (l << 8) | (l << 16) | ((uint32)source[x * 2 + 1] << 24);
+		}
+	}
+
+	// Packed 16 bit types use the REV packings of gzImage. First component in name order is in the low bits
+	// and 5551 alpha is bit 15
+	void bgr565Row(const uint16* __restrict source, uint32 width, uint32* __restrict target)
+	{
+		for (uint32 x = 0; x < width; x++)
+		{
+			const uint32 p = source[x];
+
+			const uint32 b = p & 31;
+			const uint32 g = (p >> 5) & 63;
+			const uint32 r = (p >> 11) & 31;
+
+			target[x] = ((r << 3) | (r >> 2)) | (((g << 2) | (g >> 4)) << 8) | (((b << 3) | (b >> 2)) << 16) | 0xFF000000u;
+		}
+	}
+
+	void bgra5551Row(const uint16* __restrict source, uint32 width, uint32* __restrict target)
+	{
+		for (uint32 x = 0; x < width; x++)
+		{
+			const uint32 p = source[x];
+
+			const uint32 b = p & 31;
+			const uint32 g = (p >> 5) & 31;
+			const uint32 r = (p >> 10) & 31;
+
+			target[x] = ((r << 3) | (r >> 2)) | (((g << 3) | (g >> 2)) << 8) | (((b << 3) | (b >> 2)) << 16) | ((0u - (p >> 15)) << 24);
+		}
+	}
+
+	void rgbHalfRow(const uint16* __restrict source, uint32 width, uint16* __restrict target)
+	{
+		for (uint32 x = 0; x < width; x++)
+		{
+			target[x * 4 + 0] = source[x * 3 + 0];
+			target[x * 4 + 1] = source[x * 3 + 1];
+			target[x * 4 + 2] = source[x * 3 + 2];
+			target[x * 4 + 3] = HALF_ONE;
+		}
+	}
+
+	void bwaHalfRow(const uint16* __restrict source, uint32 width, uint16* __restrict target)
+	{
+		for (uint32 x = 0; x < width; x++)
+		{
+			target[x * 4 + 0] = source[x * 2];
+			target[x * 4 + 1] = source[x * 2];
+			target[x * 4 + 2] = source[x * 2];
+			target[x * 4 + 3] = source[x * 2 + 1];
+		}
+	}
+
+	void rgbFloatRow(const float* __restrict source, uint32 width, float* __restrict target)
+	{
+		for (uint32 x = 0; x < width; x++)
+		{
+			target[x * 4 + 0] = source[x * 3 + 0];
+			target[x * 4 + 1] = source[x * 3 + 1];
+			target[x * 4 + 2] = source[x * 3 + 2];
+			target[x * 4 + 3] = 1.0f;
+		}
+	}
+
+	void convertRow(gzImageType type, const uint8* source, uint32 width, uint8* target)
+	{
+		switch (type)
+		{
+			case GZ_IMAGE_TYPE_RGB_8:
+				rgb8Row(source, width, (uint32*)target);
+				break;
+
+			case GZ_IMAGE_TYPE_BGR_8:
+				bgr8Row(source, width, (uint32*)target);
+				break;
+
+			case GZ_IMAGE_TYPE_ABGR_8:
+				abgr8Row((const uint32*)source, width, (uint32*)target);
+				break;
+
+			case GZ_IMAGE_TYPE_BWA_8:
+				bwa8Row(source, width, (uint32*)target);
+				break;
+
+			case GZ_IMAGE_TYPE_BGR_5_6_5:
+				bgr565Row((const uint16*)source, width, (uint32*)target);
+				break;
+
+			case GZ_IMAGE_TYPE_BGRA_5_5_5_1:
+				bgra5551Row((const uint16*)source, width, (uint32*)target);
+				break;
+
+			case GZ_IMAGE_TYPE_RGB_HALF:
+				rgbHalfRow((const uint16*)source, width, (uint16*)target);
+				break;
+
+			case GZ_IMAGE_TYPE_BWA_HALF:
+				bwaHalfRow((const uint16*)source, width, (uint16*)target);
+				break;
+
+			case GZ_IMAGE_TYPE_RGB_FLOAT:
+				rgbFloatRow((const float*)source, width, (float*)target);
+				break;
+
+			default:
+				break;
+		}
+	}
+}
+
+EPixelFormat cswConvertedPixelFormat(gzImageType type)
+{
+	switch (type)
+	{
+		case GZ_IMAGE_TYPE_RGB_8:
+		case GZ_IMAGE_TYPE_BGR_8:
+		case GZ_IMAGE_TYPE_ABGR_8:
+		case GZ_IMAGE_TYPE_BWA_8:
+		case GZ_IMAGE_TYPE_BGR_5_6_5:
+		case GZ_IMAGE_TYPE_BGRA_5_5_5_1:
+			return PF_R8G8B8A8;
+
+		case GZ_IMAGE_TYPE_RGB_HALF:
+		case GZ_IMAGE_TYPE_BWA_HALF:
+			return PF_FloatRGBA;
+
+		case GZ_IMAGE_TYPE_RGB_FLOAT:
+			return PF_A32B32G32R32F;
+
+		default:
+			return PF_Unknown;
+	}
+}
+
+bool cswConvertPixels(gzImageType type, const uint8* source, uint32 sourcePitch, uint32 width, uint32 height, uint8* target)
+{
+	GZ_INSTRUMENT_NAME("cswConvertPixels");
+
+	const EPixelFormat format = cswConvertedPixelFormat(type);
+
+	if (format == PF_Unknown || !source || !target)
+		return false;
+
+	const uint32 targetPitch = width * GPixelFormats[format].BlockBytes;
+
+	if ((uint64)width * height < PARALLEL_PIXELS)
+	{
+		for (uint32 y = 0; y < height; y++)
+			convertRow(type, source + (uint64)y * sourcePitch, width, target + (uint64)y * targetPitch);
+
+		return true;
+	}
+
+	const int32 tasks = (int32)FMath::DivideAndRoundUp(height, ROWS_PER_TASK);
+
+	ParallelFor(tasks, [&](int32 task)
+		{
+			const uint32 last = FMath::Min(height, (task + 1) * ROWS_PER_TASK);
+
+			for (uint32 y = task * ROWS_PER_TASK; y < last; y++)
+				convertRow(type, source + (uint64)y * sourcePitch, width, target + (uint64)y * targetPitch);
+		});
+
+	return true;
+}
@@ -0,0 +1,48 @@
+//*****************************************************************************
+//
+// Copyright (C) SAAB AB
+//
+// All rights, including the copyright, to the computer program(s)
+// herein belong to SAAB AB. The program(s) may be used and/or
+// copied only with the written permission of SAAB AB, or in
+// accordance with the terms and conditions stipulated in the
+// agreement/contract under which the program(s) have been
+// supplied.
+//
+//
+// Information Class:	COMPANY UNCLASSIFIED
+// Defence Secrecy:		NOT CLASSIFIED
+// Export Control:		NOT EXPORT CONTROLLED
+//
+//
+// File			: cswPixelConvert.h
+// Module		: CSW StreamingMap Unreal
+// Description	: Pixel converters for gzImage types UE can not sample
+// Author		: agent
+// Product		: CSW 1.1.2
+//
+//
+//
+// NOTE:	CSW (Common Synthetic World) is a simulation and presentation
+//			framework for large scale digital twins on multiple platforms
+//
+//
+// Revision History...
+//
+// Who	Date	Description
+//
+// AGT	261019	Created file 					(1.1.3)
+//
+//******************************************************************************
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PixelFormat.h"
+#include "gzImage.h"
+
+//! UE format a converter writes for the image type. PF_Unknown if there is no converter
+EPixelFormat cswConvertedPixelFormat(gzImageType type);
+
+//! Convert rows of pitch sourcePitch into packed pixels of cswConvertedPixelFormat(type). Large images are
+//! split over worker threads. Returns false for types without a converter
+bool cswConvertPixels(gzImageType type, const uint8* source, uint32 sourcePitch, uint32 width, uint32 height, uint8* target);
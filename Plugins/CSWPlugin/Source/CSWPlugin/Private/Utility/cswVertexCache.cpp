@@ -0,0 +1,275 @@
+//*****************************************************************************
+//
+// Copyright (C) SAAB AB
+//
+// All rights, including the copyright, to the computer program(s)
+// herein belong to SAAB AB. The program(s) may be used and/or
+// copied only with the written permission of SAAB AB, or in
+// accordance with the terms and conditions stipulated in the
+// agreement/contract under which the program(s) have been
+// supplied.
+//
+//
+// Information Class:	COMPANY UNCLASSIFIED
+// Defence Secrecy:		NOT CLASSIFIED
+// Export Control:		NOT EXPORT CONTROLLED
+//
+//
+// File			: cswVertexCache.cpp
+// Module		: CSW StreamingMap Unreal
+// Description	: Post transform vertex cache optimization
+// Author		: agent
+// Product		: CSW 1.1.2
+//
+//
+//
+// NOTE:	CSW (Common Synthetic World) is a simulation and presentation
+//			framework for large scale digital twins on multiple platforms
+//
+//
+// Revision History...
+//
+// Who	Date	Description
+//
+// AGT	261019	Created file 					(1.1.3)
+//
+//******************************************************************************
+#include "Utility/cswVertexCache.h"
+#include "gzPerformance.h"
+
+namespace
+{
+	// Tuning from the original paper
+	const int32 CACHE_SIZE				= 32;
+	const float CACHE_DECAY_POWER		= 1.5f;
+	const float LAST_TRI_SCORE			= 0.75f;
+	const float VALENCE_BOOST_SCALE		= 2.0f;
+	const float VALENCE_BOOST_POWER		= 0.5f;
+
+	float vertexScore(int32 cachePosition, int32 remainingTris)
+	{
+		if (remainingTris <= 0)
+			return -1.0f;	// No triangles left. Never used again
+
+		float score = 0.0f;
+
+		if (cachePosition >= 0)
+		{
+			if (cachePosition < 3)
+			{
+				// Used by last triangle. Fixed score to avoid favouring a strip order
+				score = LAST_TRI_SCORE;
+			}
+			else
+			{
+				const float scaler = 1.0f / (CACHE_SIZE - 3);
+				score = FMath::Pow(1.0f - (cachePosition - 3) * scaler, CACHE_DECAY_POWER);
+			}
+		}
+
+		// Boost vertices with few triangles left so we finish them off
+		score += VALENCE_BOOST_SCALE * FMath::Pow((float)remainingTris, -VALENCE_BOOST_POWER);
+
+		return score;
+	}
+}
+
+void cswOptimizeVertexCache(TArray<uint32>& indices, uint32 vertexCount)
+{
+	GZ_INSTRUMENT_NAME("cswOptimizeVertexCache");
+
+	const int32 triCount = indices.Num() / 3;
+
+	if (triCount < 2 || !vertexCount)
+		return;
+
+	// Vertex to triangle adjacency ------------------------------------
+
+	TArray<int32> remaining;
+	remaining.Init(0, vertexCount);
+
+	for (int32 i = 0; i < triCount * 3; i++)
+	{
+		if (indices[i] >= vertexCount)
+			return;
+
+		remaining[indices[i]]++;
+	}
+
+	TArray<int32> offsets;
+	offsets.SetNumUninitialized(vertexCount + 1);
+	offsets[0] = 0;
+
+	for (uint32 v = 0; v < vertexCount; v++)
+		offsets[v + 1] = offsets[v] + remaining[v];
+
+	TArray<int32> adjacency;
+	adjacency.SetNumUninitialized(triCount * 3);
+
+	{
+		TArray<int32> fill(offsets.GetData(), vertexCount);
+
+		for (int32 t = 0; t < triCount; t++)
+			for (int32 k = 0; k < 3; k++)
+				adjacency[fill[indices[t * 3 + k]]++] = t;
+	}
+
+	// Initial scores --------------------------------------------------
+
+	TArray<int32> cachePosition;
+	cachePosition.Init(-1, vertexCount);
+
+	TArray<float> vScore;
+	vScore.SetNumUninitialized(vertexCount);
+
+	for (uint32 v = 0; v < vertexCount; v++)
+		vScore[v] = vertexScore(-1, remaining[v]);
+
+	TArray<float> tScore;
+	tScore.SetNumUninitialized(triCount);
+
+	TArray<bool> emitted;
+	emitted.Init(false, triCount);
+
+	int32 best(-1);
+	float bestScore(-1.0f);
+
+	for (int32 t = 0; t < triCount; t++)
+	{
+		tScore[t] = vScore[indices[t * 3]] + vScore[indices[t * 3 + 1]] + vScore[indices[t * 3 + 2]];
+
+		if (tScore[t] > bestScore)
+		{
+			bestScore = tScore[t];
+			best = t;
+		}
+	}
+
+	// Greedy emit -----------------------------------------------------
+
+	TArray<uint32> output;
+	output.Reserve(triCount * 3);
+
+	int32 cache[CACHE_SIZE + 3];
+	int32 cacheCount(0);
+
+	int32 scan(0);
+
+	while (best >= 0)
+	{
+		emitted[best] = true;
+
+		int32 newCache[CACHE_SIZE + 3];
+		int32 newCount(0);
+
+		for (int32 k = 0; k < 3; k++)
+		{
+			const int32 v = indices[best * 3 + k];
+
+			output.Add(v);
+			newCache[newCount++] = v;
+
+			// Remove triangle from vertex adjacency
+			int32* list = adjacency.GetData() + offsets[v];
+
+			for (int32 a = 0; a < remaining[v]; a++)
+			{
+				if (list[a] == best)
+				{
+					list[a] = list[remaining[v] - 1];
+					break;
+				}
+			}
+
+			remaining[v]--;
+		}
+
+		// Push old cache entries behind the new triangle
+		for (int32 i = 0; i < cacheCount; i++)
+		{
+			const int32 v = cache[i];
+
+			if (v != newCache[0] && v != newCache[1] && v != newCache[2])
+				newCache[newCount++] = v;
+		}
+
+		for (int32 i = 0; i < newCount; i++)
+		{
+			const int32 v = newCache[i];
+
+			cachePosition[v] = i < CACHE_SIZE ? i : -1;
+			vScore[v] = vertexScore(cachePosition[v], remaining[v]);
+		}
+
+		cacheCount = FMath::Min(newCount, CACHE_SIZE);
+		FMemory::Memcpy(cache, newCache, cacheCount * sizeof(int32));
+
+		// Rescore triangles touching the cache and pick the best one
+		best = -1;
+		bestScore = -1.0f;
+
+		for (int32 i = 0; i < newCount; i++)
+		{
+			const int32 v = newCache[i];
+
+			for (int32 a = 0; a < remaining[v]; a++)
+			{
+				const int32 t = adjacency[offsets[v] + a];
+
+				tScore[t] = vScore[indices[t * 3]] + vScore[indices[t * 3 + 1]] + vScore[indices[t * 3 + 2]];
+
+				if (tScore[t] > bestScore)
+				{
+					bestScore = tScore[t];
+					best = t;
+				}
+			}
+		}
+
+		// Cache starved. Continue with next unused triangle
+		if (best < 0)
+		{
+			while (scan < triCount && emitted[scan])
+				scan++;
+
+			if (scan < triCount)
+				best = scan;
+		}
+	}
+
+	indices = MoveTemp(output);
+}
+
+float cswVertexCacheACMR(const TArray<uint32>& indices, uint32 cacheSize)
+{
+	const int32 triCount = indices.Num() / 3;
+
+	if (!triCount || !cacheSize)
+		return 0.0f;
+
+	TArray<uint32> fifo;
+	fifo.Reserve(cacheSize);
+
+	int32 head(0);
+	int32 misses(0);
+
+	for (int32 i = 0; i < triCount * 3; i++)
+	{
+		if (fifo.Contains(indices[i]))
+			continue;
+
+		misses++;
+
+		if ((uint32)fifo.Num() < cacheSize)
+		{
+			fifo.Add(indices[i]);
+		}
+		else
+		{
+			fifo[head] = indices[i];
+			head = (head + 1) % cacheSize;
+		}
+	}
+
+	return (float)misses / (float)triCount;
+}
@@ -0,0 +1,46 @@
+//*****************************************************************************
+//
+// Copyright (C) SAAB AB
+//
+// All rights, including the copyright, to the computer program(s)
+// herein belong to SAAB AB. The program(s) may be used and/or
+// copied only with the written permission of SAAB AB, or in
+// accordance with the terms and conditions stipulated in the
+// agreement/contract under which the program(s) have been
+// supplied.
+//
+//
+// Information Class:	COMPANY UNCLASSIFIED
+// Defence Secrecy:		NOT CLASSIFIED
+// Export Control:		NOT EXPORT CONTROLLED
+//
+//
+// File			: cswVertexCache.h
+// Module		: CSW StreamingMap Unreal
+// Description	: Post transform vertex cache optimization
+// Author		: agent
+// Product		: CSW 1.1.2
+//
+//
+//
+// NOTE:	CSW (Common Synthetic World) is a simulation and presentation
+//			framework for large scale digital twins on multiple platforms
+//
+//
+// Revision History...
+//
+// Who	Date	Description
+//
+// AGT	261019	Created file 					(1.1.3)
+//
+//******************************************************************************
+#pragma once
+
+#include "CoreMinimal.h"
+
+//! Reorders triangles for post transform vertex cache reuse (Tom Forsyth, linear speed)
+//! Winding of each triangle is kept. Indices are left untouched if any index is out of range
+void cswOptimizeVertexCache(TArray<uint32>& indices, uint32 vertexCount);
+
+//! Average cache miss ratio (transformed vertices per triangle) for a FIFO cache
+float cswVertexCacheACMR(const TArray<uint32>& indices, uint32 cacheSize = 16);
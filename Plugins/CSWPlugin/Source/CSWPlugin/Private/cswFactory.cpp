@@ -78,7 +78,7 @@ UCSWSceneComponent* cswFactory::newObject(USceneComponent* parent,gzNode* node,
 	return nullptr;
 }
 
-gzReference* cswFactory::preBuildReference(gzNode* node, const gzUInt64& pathID, gzGroup* parent, const gzUInt64& parentPathID, gzState* state)
+gzReference* cswFactory::preBuildReference(gzNode* node, const gzUInt64& pathID, gzGroup* parent, const gzUInt64& parentPathID, gzState* state, const BuildProperties& buildProperties)
 {
 	GZ_INSTRUMENT_NAME("cswFactory::preBuildReference");
 
@@ -96,7 +96,7 @@ gzReference* cswFactory::preBuildReference(gzNode* node, const gzUInt64& pathID,
 			continue;
 		}
 
-		return factory->preBuildReferenceInstance(node,pathID,parent,parentPathID,state);
+		return factory->preBuildReferenceInstance(node,pathID,parent,parentPathID,state,buildProperties);
 	}
 
 	GZMESSAGE(GZ_MESSAGE_WARNING, "Failed to get CSW factory for type (%s)", node->getTypeName());
@@ -104,7 +104,7 @@ gzReference* cswFactory::preBuildReference(gzNode* node, const gzUInt64& pathID,
 	return nullptr;
 }
 
-gzReference* cswFactory::updateReference(gzNode* node, const gzUInt64& pathID, gzGroup* parent, const gzUInt64& parentPathID, gzState* state, gzReference* userdata)
+gzReference* cswFactory::updateReference(gzNode* node, const gzUInt64& pathID, gzGroup* parent, const gzUInt64& parentPathID, gzState* state, gzReference* userdata, const BuildProperties& buildProperties)
 {
 	GZ_INSTRUMENT_NAME("cswFactory::updateReference");
 
@@ -122,7 +122,7 @@ gzReference* cswFactory::updateReference(gzNode* node, const gzUInt64& pathID, g
 			continue;
 		}
 
-		return factory->updateReferenceInstance(node, pathID, parent, parentPathID, state, userdata);
+		return factory->updateReferenceInstance(node, pathID, parent, parentPathID, state, userdata, buildProperties);
 	}
 
 	GZMESSAGE(GZ_MESSAGE_WARNING, "Failed to get CSW factory for type (%s)", node->getTypeName());
@@ -192,7 +192,7 @@ cswFactory * cswFactory::getFactory(const gzString& className)
 	return s_factoryLookup.find(className);
 }
 
-gzReference* cswFactory::preBuildReferenceInstance(gzNode* node, const gzUInt64& pathID, gzGroup* parent, const gzUInt64& parentPathID, gzState* state)
+gzReference* cswFactory::preBuildReferenceInstance(gzNode* node, const gzUInt64& pathID, gzGroup* parent, const gzUInt64& parentPathID, gzState* state, const BuildProperties& buildProperties)
 {
 	// Default do nothing
 	return nullptr;
@@ -203,7 +203,7 @@ gzVoid cswFactory::preDestroyReferenceInstance(gzNode* node, const gzUInt64& pat
 	// Default do nothing
 }
 
-gzReference* cswFactory::updateReferenceInstance(gzNode* node, const gzUInt64& pathID, gzGroup* parent, const gzUInt64& parentPathID, gzState* state,gzReference *userData)
+gzReference* cswFactory::updateReferenceInstance(gzNode* node, const gzUInt64& pathID, gzGroup* parent, const gzUInt64& parentPathID, gzState* state,gzReference *userData, const BuildProperties& buildProperties)
 {
 	return userData;
 }
\ No newline at end of file
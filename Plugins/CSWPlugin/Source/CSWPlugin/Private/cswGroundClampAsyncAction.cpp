@@ -34,7 +34,9 @@ void UCSWGroundClampAsyncAction::Activate()
 	RegisterWithGameInstance(WorldContextObject);
 	ScenePtr->OnGroundClampResponse.AddDynamic(this, &UCSWGroundClampAsyncAction::HandleGroundClamp);
 
-	RequestId = ScenePtr->RequestGroundClampPosition(Latitude, Longitude, Height, bWaitForData);
+	FCSWGroundClampResult approximate;
+
+	RequestId = ScenePtr->RequestGroundClampApproximate(Latitude, Longitude, approximate, Height, bWaitForData);
 	if (RequestId <= 0)
 	{
 		ScenePtr->OnGroundClampResponse.RemoveDynamic(this, &UCSWGroundClampAsyncAction::HandleGroundClamp);
@@ -44,6 +46,9 @@ void UCSWGroundClampAsyncAction::Activate()
 		return;
 	}
 
+	if (approximate.bSuccess)
+		OnApproximate.Broadcast(approximate);
+
 	StartTimeout();
 }
 
@@ -0,0 +1,441 @@
+//*****************************************************************************
+//
+// Copyright (C) SAAB AB
+//
+// All rights, including the copyright, to the computer program(s)
+// herein belong to SAAB AB. The program(s) may be used and/or
+// copied only with the written permission of SAAB AB, or in
+// accordance with the terms and conditions stipulated in the
+// agreement/contract under which the program(s) have been
+// supplied.
+//
+//
+// Information Class:	COMPANY UNCLASSIFIED
+// Defence Secrecy:		NOT CLASSIFIED
+// Export Control:		NOT EXPORT CONTROLLED
+//
+//
+// File			: cswHeightCache.cpp
+// Module		: CSW StreamingMap Unreal
+// Description	: Game thread height cache for synchronous ground queries
+// Author		: agent
+// Product		: CSW 1.1.2
+//
+//
+//
+// NOTE:	CSW (Common Synthetic World) is a simulation and presentation
+//			framework for large scale digital twins on multiple platforms
+//
+//
+// Revision History...
+//
+// Who	Date	Description
+//
+// AGT	261019	Created file 					(1.1.3)
+//
+//******************************************************************************
+#include "cswHeightCache.h"
+
+#include "gzGeometry.h"
+
+GZ_DECLARE_TYPE_CHILD(gzReference, cswHeightTile, "cswHeightTile");
+GZ_DECLARE_TYPE_CHILD(gzReference, cswHeightCache, "cswHeightCache");
+
+static const gzDouble	BUCKET_SIZE = 256.0;			// Map units per tile bucket
+static const gzDouble	CLAMP_CELL_SIZE = 2.0;			// Map units per clamp sample
+static const int32		MAX_CLAMP_SAMPLES = 1 << 20;
+static const int32		MAX_GRID_SIDE = 257;
+static const gzDouble	UP_COSINE = 0.5;				// Triangles steeper than 60 degrees are walls
+static const gzDouble	UP_FRACTION = 0.9;				// Part of the area facing up for a terrain
+
+// ----------------------------------- cswHeightTile ------------------------------------------
+
+gzBool cswHeightTile::sample(const gzDouble& x, const gzDouble& z, gzDouble& height) const
+{
+	const gzDouble u = (x - x0) / spacing;
+	const gzDouble v = (z - z0) / spacing;
+
+	if (u < 0 || v < 0 || u > columns - 1 || v > rows - 1)
+		return FALSE;
+
+	const int32 i = FMath::Min((int32)u, columns - 2);
+	const int32 j = FMath::Min((int32)v, rows - 2);
+
+	const gzFloat* row = heights.GetData() + j * columns + i;
+
+	const gzFloat h00 = row[0];
+	const gzFloat h10 = row[1];
+	const gzFloat h01 = row[columns];
+	const gzFloat h11 = row[columns + 1];
+
+	if (h00 == FLT_MAX || h10 == FLT_MAX || h01 == FLT_MAX || h11 == FLT_MAX)
+		return FALSE;
+
+	const gzDouble fu = u - i;
+	const gzDouble fv = v - j;
+
+	height = FMath::Lerp(FMath::Lerp((gzDouble)h00, (gzDouble)h10, fu), FMath::Lerp((gzDouble)h01, (gzDouble)h11, fu), fv);
+
+	return TRUE;
+}
+
+// Called in prebuild from manager thread
+cswHeightTile* cswBuildHeightTile(gzGeometry* geom)
+{
+	GZ_INSTRUMENT_NAME("cswBuildHeightTile");
+
+	if (!geom || geom->getGeoPrimType() != GZ_PRIM_TRIS)
+		return nullptr;
+
+	gzArray<gzVec3>& coordinates = geom->getCoordinateArray(FALSE);
+	gzArray<gzUInt32>& indices = geom->getIndexArray(FALSE);
+
+	const gzUInt32 vcount = coordinates.getSize();
+	const gzUInt32 icount = indices.getSize() ? indices.getSize() : vcount;
+	const gzUInt32 triangles = icount / 3;
+
+	if (!triangles)
+		return nullptr;
+
+	auto index = [&](gzUInt32 i) -> gzUInt32 { return indices.getSize() ? indices[i] : i; };
+
+	// Terrain faces up over most of its area
+
+	gzDouble upArea = 0, totalArea = 0;
+
+	for (gzUInt32 t = 0; t < triangles; t++)
+	{
+		const gzUInt32 ia = index(3 * t), ib = index(3 * t + 1), ic = index(3 * t + 2);
+
+		if (ia >= vcount || ib >= vcount || ic >= vcount)
+			return nullptr;
+
+		const gzVec3& a = coordinates[ia];
+		const gzVec3& b = coordinates[ib];
+		const gzVec3& c = coordinates[ic];
+
+		const FVector3d e1(b.x - a.x, b.y - a.y, b.z - a.z);
+		const FVector3d e2(c.x - a.x, c.y - a.y, c.z - a.z);
+
+		const FVector3d n = FVector3d::CrossProduct(e1, e2);
+
+		const gzDouble area = n.Size();
+
+		totalArea += area;
+
+		if (FMath::Abs(n.Y) > UP_COSINE * area)
+			upArea += area;
+	}
+
+	if (totalArea <= 0 || upArea < UP_FRACTION * totalArea)
+		return nullptr;
+
+	gzDouble minX = DBL_MAX, minZ = DBL_MAX, maxX = -DBL_MAX, maxZ = -DBL_MAX;
+
+	for (gzUInt32 i = 0; i < vcount; i++)
+	{
+		minX = FMath::Min(minX, (gzDouble)coordinates[i].x);
+		maxX = FMath::Max(maxX, (gzDouble)coordinates[i].x);
+		minZ = FMath::Min(minZ, (gzDouble)coordinates[i].z);
+		maxZ = FMath::Max(maxZ, (gzDouble)coordinates[i].z);
+	}
+
+	const gzDouble extent = FMath::Max(maxX - minX, maxZ - minZ);
+
+	if (extent <= 0)
+		return nullptr;
+
+	// About one sample per vertex of a regular grid mesh
+	const int32 side = FMath::Clamp(FMath::CeilToInt32(FMath::Sqrt(triangles / 2.0)) + 1, 2, MAX_GRID_SIDE);
+
+	cswHeightTile* tile = new cswHeightTile;
+
+	tile->x0 = minX;
+	tile->z0 = minZ;
+	tile->spacing = extent / (side - 1);
+	tile->columns = FMath::Clamp(FMath::CeilToInt32((maxX - minX) / tile->spacing - 1e-6) + 1, 2, MAX_GRID_SIDE);
+	tile->rows = FMath::Clamp(FMath::CeilToInt32((maxZ - minZ) / tile->spacing - 1e-6) + 1, 2, MAX_GRID_SIDE);
+
+	tile->heights.Init(FLT_MAX, tile->columns * tile->rows);
+
+	// Highest surface at each sample
+
+	for (gzUInt32 t = 0; t < triangles; t++)
+	{
+		const gzVec3& a = coordinates[index(3 * t)];
+		const gzVec3& b = coordinates[index(3 * t + 1)];
+		const gzVec3& c = coordinates[index(3 * t + 2)];
+
+		const gzDouble den = (gzDouble)(b.z - c.z) * (a.x - c.x) + (gzDouble)(c.x - b.x) * (a.z - c.z);
+
+		if (FMath::Abs(den) < 1e-12)
+			continue;
+
+		const int32 i0 = FMath::Max(FMath::CeilToInt32((FMath::Min3(a.x, b.x, c.x) - tile->x0) / tile->spacing), 0);
+		const int32 i1 = FMath::Min(FMath::FloorToInt32((FMath::Max3(a.x, b.x, c.x) - tile->x0) / tile->spacing), tile->columns - 1);
+		const int32 j0 = FMath::Max(FMath::CeilToInt32((FMath::Min3(a.z, b.z, c.z) - tile->z0) / tile->spacing), 0);
+		const int32 j1 = FMath::Min(FMath::FloorToInt32((FMath::Max3(a.z, b.z, c.z) - tile->z0) / tile->spacing), tile->rows - 1);
+
+		for (int32 j = j0; j <= j1; j++)
+		{
+			const gzDouble pz = tile->z0 + j * tile->spacing;
+
+			for (int32 i = i0; i <= i1; i++)
+			{
+				const gzDouble px = tile->x0 + i * tile->spacing;
+
+				const gzDouble w0 = ((b.z - c.z) * (px - c.x) + (c.x - b.x) * (pz - c.z)) / den;
+				const gzDouble w1 = ((c.z - a.z) * (px - c.x) + (a.x - c.x) * (pz - c.z)) / den;
+				const gzDouble w2 = 1 - w0 - w1;
+
+				if (w0 < -1e-6 || w1 < -1e-6 || w2 < -1e-6)
+					continue;
+
+				const gzFloat height = (gzFloat)(w0 * a.y + w1 * b.y + w2 * c.y);
+
+				gzFloat& sample = tile->heights[j * tile->columns + i];
+
+				if (sample == FLT_MAX || height > sample)
+					sample = height;
+			}
+		}
+	}
+
+	// Vertices between samples show how well the grid follows the mesh
+
+	for (gzUInt32 i = 0; i < vcount; i++)
+	{
+		gzDouble height;
+
+		if (tile->sample(coordinates[i].x, coordinates[i].z, height))
+			tile->accuracy = FMath::Max(tile->accuracy, (gzFloat)FMath::Abs(height - coordinates[i].y));
+	}
+
+	return tile;
+}
+
+// ----------------------------------- cswHeightCache ------------------------------------------
+
+gzVoid cswHeightCache::addTile(UCSWSceneComponent* component, cswHeightTile* tile, const gzVec3D& offset, gzDouble time)
+{
+	removeTile(component);
+
+	if (!component || !tile)
+		return;
+
+	Tile entry;
+
+	entry.tile = tile;
+	entry.offset = offset;
+	entry.time = time;
+
+	const gzDouble x0 = tile->x0 + offset.v1;
+	const gzDouble z0 = tile->z0 + offset.v3;
+
+	entry.minBucket = FIntPoint(FMath::FloorToInt32(x0 / BUCKET_SIZE), FMath::FloorToInt32(z0 / BUCKET_SIZE));
+	entry.maxBucket = FIntPoint(FMath::FloorToInt32((x0 + (tile->columns - 1) * tile->spacing) / BUCKET_SIZE), FMath::FloorToInt32((z0 + (tile->rows - 1) * tile->spacing) / BUCKET_SIZE));
+
+	linkTile(component, entry, TRUE);
+
+	m_tileBytes += tile->getBytes();
+
+	m_tiles.Add(component, entry);
+}
+
+gzVoid cswHeightCache::removeTile(UCSWSceneComponent* component)
+{
+	Tile entry;
+
+	if (!m_tiles.RemoveAndCopyValue(component, entry))
+		return;
+
+	linkTile(component, entry, FALSE);
+
+	m_tileBytes -= entry.tile->getBytes();
+}
+
+gzVoid cswHeightCache::linkTile(UCSWSceneComponent* component, const Tile& tile, gzBool link)
+{
+	for (int32 j = tile.minBucket.Y; j <= tile.maxBucket.Y; j++)
+	{
+		for (int32 i = tile.minBucket.X; i <= tile.maxBucket.X; i++)
+		{
+			const FIntPoint key(i, j);
+
+			if (link)
+			{
+				m_buckets.FindOrAdd(key).Add(component);
+				continue;
+			}
+
+			TArray<UCSWSceneComponent*>* bucket = m_buckets.Find(key);
+
+			if (!bucket)
+				continue;
+
+			bucket->RemoveSwap(component);
+
+			if (!bucket->Num())
+				m_buckets.Remove(key);
+		}
+	}
+}
+
+gzVoid cswHeightCache::addClampSample(const gzVec3D& position, gzDouble time)
+{
+	const FIntPoint key(FMath::RoundToInt32(position.v1 / CLAMP_CELL_SIZE), FMath::RoundToInt32(position.v3 / CLAMP_CELL_SIZE));
+
+	ClampCell& cell = m_clampCells.FindOrAdd(key);
+
+	cell.height = (gzFloat)position.v2;
+	cell.time = time;
+
+	if (m_clampCells.Num() <= MAX_CLAMP_SAMPLES)
+		return;
+
+	// Old samples go first, then all
+	for (auto it = m_clampCells.CreateIterator(); it; ++it)
+	{
+		if (time - it.Value().time > m_maxAge)
+			it.RemoveCurrent();
+	}
+
+	if (m_clampCells.Num() > MAX_CLAMP_SAMPLES)
+		m_clampCells.Empty();
+}
+
+gzBool cswHeightCache::sampleTiles(const gzDouble& x, const gzDouble& z, gzDouble time, cswHeightSample& result) const
+{
+	const TArray<UCSWSceneComponent*>* bucket = m_buckets.Find(FIntPoint(FMath::FloorToInt32(x / BUCKET_SIZE), FMath::FloorToInt32(z / BUCKET_SIZE)));
+
+	if (!bucket)
+		return FALSE;
+
+	// Finest tile wins when lod levels overlap
+	const Tile* best = nullptr;
+	gzDouble bestHeight = 0;
+
+	for (UCSWSceneComponent* component : *bucket)
+	{
+		const Tile& tile = m_tiles.FindChecked(component);
+
+		if (best && tile.tile->spacing >= best->tile->spacing)
+			continue;
+
+		gzDouble height;
+
+		if (!tile.tile->sample(x - tile.offset.v1, z - tile.offset.v3, height))
+			continue;
+
+		best = &tile;
+		bestHeight = height + tile.offset.v2;
+	}
+
+	if (!best)
+		return FALSE;
+
+	// Loaded terrain is current until it unloads
+	result.height = bestHeight;
+	result.accuracy = best->tile->accuracy;
+	result.age = time - best->time;
+	result.stale = FALSE;
+	result.source = CSW_HEIGHT_SOURCE_TERRAIN;
+
+	return TRUE;
+}
+
+gzBool cswHeightCache::sampleClamp(const gzDouble& x, const gzDouble& z, gzDouble time, cswHeightSample& result) const
+{
+	if (!m_clampCells.Num())
+		return FALSE;
+
+	const gzDouble u = x / CLAMP_CELL_SIZE;
+	const gzDouble v = z / CLAMP_CELL_SIZE;
+
+	const int32 i = FMath::FloorToInt32(u);
+	const int32 j = FMath::FloorToInt32(v);
+
+	const ClampCell* c00 = m_clampCells.Find(FIntPoint(i, j));
+	const ClampCell* c10 = m_clampCells.Find(FIntPoint(i + 1, j));
+	const ClampCell* c01 = m_clampCells.Find(FIntPoint(i, j + 1));
+	const ClampCell* c11 = m_clampCells.Find(FIntPoint(i + 1, j + 1));
+
+	gzDouble sampleTime;
+
+	if (c00 && c10 && c01 && c11)
+	{
+		const gzDouble fu = u - i;
+		const gzDouble fv = v - j;
+
+		result.height = FMath::Lerp(FMath::Lerp((gzDouble)c00->height, (gzDouble)c10->height, fu), FMath::Lerp((gzDouble)c01->height, (gzDouble)c11->height, fu), fv);
+
+		// Spread of the corners bounds what the surface can do between them
+		result.accuracy = FMath::Max(FMath::Max(c00->height, c10->height), FMath::Max(c01->height, c11->height)) - FMath::Min(FMath::Min(c00->height, c10->height), FMath::Min(c01->height, c11->height));
+
+		sampleTime = FMath::Min(FMath::Min(c00->time, c10->time), FMath::Min(c01->time, c11->time));
+	}
+	else
+	{
+		const ClampCell* nearest = m_clampCells.Find(FIntPoint(FMath::RoundToInt32(u), FMath::RoundToInt32(v)));
+
+		if (!nearest)
+			return FALSE;
+
+		result.height = nearest->height;
+		result.accuracy = -1;
+
+		sampleTime = nearest->time;
+	}
+
+	result.age = time - sampleTime;
+	result.stale = result.age > m_maxAge;
+	result.source = CSW_HEIGHT_SOURCE_CLAMP;
+
+	return TRUE;
+}
+
+gzBool cswHeightCache::sample(const gzDouble& x, const gzDouble& z, gzDouble time, cswHeightSample& result)
+{
+	cswHeightSample clamp;
+
+	const gzBool hasClamp = sampleClamp(x, z, time, clamp);
+
+	if (hasClamp && !clamp.stale)
+		result = clamp;
+	else if (!sampleTiles(x, z, time, result))
+	{
+		if (!hasClamp)
+		{
+			m_misses++;
+			return FALSE;
+		}
+
+		result = clamp;
+	}
+
+	m_hits++;
+
+	return TRUE;
+}
+
+gzVoid cswHeightCache::clear()
+{
+	m_tiles.Empty();
+	m_buckets.Empty();
+	m_clampCells.Empty();
+
+	m_tileBytes = 0;
+}
+
+cswHeightCacheStatistics cswHeightCache::getStatistics() const
+{
+	cswHeightCacheStatistics statistics;
+
+	statistics.tiles = m_tiles.Num();
+	statistics.clampSamples = m_clampCells.Num();
+	statistics.bytes = m_tileBytes + m_clampCells.GetAllocatedSize() + m_buckets.GetAllocatedSize();
+	statistics.hits = m_hits;
+	statistics.misses = m_misses;
+
+	return statistics;
+}
@@ -0,0 +1,237 @@
+//*****************************************************************************
+//
+// Copyright (C) SAAB AB
+//
+// All rights, including the copyright, to the computer program(s)
+// herein belong to SAAB AB. The program(s) may be used and/or
+// copied only with the written permission of SAAB AB, or in
+// accordance with the terms and conditions stipulated in the
+// agreement/contract under which the program(s) have been
+// supplied.
+//
+//
+// Information Class:	COMPANY UNCLASSIFIED
+// Defence Secrecy:		NOT CLASSIFIED
+// Export Control:		NOT EXPORT CONTROLLED
+//
+//
+// File			: cswMemoryBudget.cpp
+// Module		: CSW StreamingMap Unreal
+// Description	: Memory budget with LRU eviction of scene resources
+// Author		: agent
+// Product		: CSW 1.1.2
+//
+//
+//
+// NOTE:	CSW (Common Synthetic World) is a simulation and presentation
+//			framework for large scale digital twins on multiple platforms
+//
+//
+// Revision History...
+//
+// Who	Date	Description
+//
+// AGT	261019	Created file 					(1.1.3)
+//
+//******************************************************************************
+#include "cswMemoryBudget.h"
+
+#include "Components/StaticMeshComponent.h"
+#include "Engine/StaticMesh.h"
+
+GZ_DECLARE_TYPE_CHILD(gzReference, cswMemoryBudget, "cswMemoryBudget");
+
+static const gzDouble	BUDGET_INTERVAL = 0.5;			// Seconds between updates
+static const gzDouble	LOD_RAISE_INTERVAL = 2.0;		// Give the scene manager time to unload
+static const gzDouble	LOD_LOWER_INTERVAL = 5.0;
+static const gzFloat	LOD_STEP = 1.25f;
+static const gzFloat	LOW_WATERMARK = 0.8f;			// Usage of budget before the lod factor is lowered
+
+gzVoid cswMemoryBudget::setBudget(gzUInt64 budget, gzFloat maxLodFactorScale, gzFloat evictAge)
+{
+	m_budget = budget;
+	m_maxLodFactorScale = FMath::Max(maxLodFactorScale, 1.0f);
+	m_evictAge = FMath::Max(evictAge, 0.0f);
+
+	m_lodFactorScale = FMath::Min(m_lodFactorScale, m_maxLodFactorScale);
+}
+
+gzVoid cswMemoryBudget::track(UCSWSceneComponent* component, gzDouble time)
+{
+	if (!component)
+		return;
+
+	gzBool hasPrimitives(FALSE);
+
+	const gzUInt64 bytes = meshBytes(component, hasPrimitives);
+
+	// Plain groups have nothing to evict
+	if (!hasPrimitives)
+	{
+		m_entries.Remove(component);
+		return;
+	}
+
+	Entry& entry = m_entries.FindOrAdd(component);
+
+	entry.component = component;
+	entry.bytes = bytes;
+	entry.lastVisible = time;
+}
+
+gzVoid cswMemoryBudget::untrack(UCSWSceneComponent* component)
+{
+	m_entries.Remove(component);
+}
+
+gzBool cswMemoryBudget::update(cswResourceManager* resources, gzDouble time)
+{
+	if (time - m_updateTime < BUDGET_INTERVAL)
+		return FALSE;
+
+	m_updateTime = time;
+
+	GZ_INSTRUMENT_NAME("cswMemoryBudget::update");
+
+	TArray<Entry*> candidates;
+
+	m_statistics.meshBytes = 0;
+	m_statistics.evictedComponents = 0;
+
+	for (auto it = m_entries.CreateIterator(); it; ++it)
+	{
+		Entry& entry = it.Value();
+
+		UCSWSceneComponent* component = entry.component.Get();
+
+		if (!component)
+		{
+			it.RemoveCurrent();
+			continue;
+		}
+
+		entry.lastVisible = FMath::Max(entry.lastVisible, lastRenderTime(component));
+
+		const gzBool visible = time - entry.lastVisible < m_evictAge;
+
+		if (entry.evicted && visible)
+		{
+			if (resources)
+				resources->restoreTextures(component);
+
+			entry.evicted = FALSE;
+
+			m_statistics.restores++;
+		}
+		else if (!entry.evicted && !visible)
+			candidates.Add(&entry);
+
+		if (entry.evicted)
+			m_statistics.evictedComponents++;
+
+		m_statistics.meshBytes += entry.bytes;
+	}
+
+	const cswResourceStatistics resourceStatistics = resources ? resources->getStatistics() : cswResourceStatistics();
+
+	m_statistics.components = m_entries.Num();
+	m_statistics.textureBytes = resourceStatistics.textureMemoryBytes;
+	m_statistics.materialBytes = resourceStatistics.materialBytes;
+	m_statistics.materials = (gzUInt32)resourceStatistics.materialsLive;
+	m_statistics.usedBytes = m_statistics.meshBytes + m_statistics.textureBytes + m_statistics.materialBytes;
+	m_statistics.budgetBytes = m_budget;
+	m_statistics.pressure = m_budget ? (gzFloat)((gzDouble)m_statistics.usedBytes / m_budget) : 0;
+
+	if (!m_budget)
+		return FALSE;
+
+	gzInt64 excess = (gzInt64)m_statistics.usedBytes - (gzInt64)m_budget;
+
+	// Least recently visible first
+	if (excess > 0 && resources)
+	{
+		candidates.Sort([](const Entry& a, const Entry& b) { return a.lastVisible < b.lastVisible; });
+
+		for (Entry* entry : candidates)
+		{
+			if (excess <= 0)
+				break;
+
+			const gzUInt64 freed = resources->evictTextures(entry->component.Get());
+
+			// Nothing resident to drop. Left to the lod factor
+			if (!freed)
+				continue;
+
+			entry->evicted = TRUE;
+
+			excess -= freed;
+
+			m_statistics.evictedComponents++;
+			m_statistics.evictions++;
+		}
+	}
+
+	const gzFloat previous = m_lodFactorScale;
+
+	// Let the scene manager unload detail when eviction is not enough
+	if (excess > 0 && time - m_lodTime >= LOD_RAISE_INTERVAL)
+	{
+		m_lodFactorScale = FMath::Min(m_lodFactorScale * LOD_STEP, m_maxLodFactorScale);
+		m_lodTime = time;
+
+		if (m_lodFactorScale != previous)
+			m_statistics.lodRaises++;
+	}
+	else if (excess <= 0 && m_lodFactorScale > 1.0f && m_statistics.usedBytes < m_budget * LOW_WATERMARK && time - m_lodTime >= LOD_LOWER_INTERVAL)
+	{
+		m_lodFactorScale = FMath::Max(m_lodFactorScale / LOD_STEP, 1.0f);
+		m_lodTime = time;
+
+		m_statistics.lodLowers++;
+	}
+
+	m_statistics.lodFactorScale = m_lodFactorScale;
+
+	return m_lodFactorScale != previous;
+}
+
+cswMemoryBudgetStatistics cswMemoryBudget::getStatistics() const
+{
+	return m_statistics;
+}
+
+gzUInt64 cswMemoryBudget::meshBytes(UCSWSceneComponent* component, gzBool& hasPrimitives)
+{
+	gzUInt64 bytes(0);
+
+	for (USceneComponent* child : component->GetAttachChildren())
+	{
+		UPrimitiveComponent* primitive = Cast<UPrimitiveComponent>(child);
+
+		if (!primitive)
+			continue;
+
+		hasPrimitives = TRUE;
+
+		UStaticMeshComponent* meshComponent = Cast<UStaticMeshComponent>(primitive);
+
+		if (meshComponent && meshComponent->GetStaticMesh())
+			bytes += meshComponent->GetStaticMesh()->GetResourceSizeBytes(EResourceSizeMode::EstimatedTotal);
+	}
+
+	return bytes;
+}
+
+gzDouble cswMemoryBudget::lastRenderTime(UCSWSceneComponent* component)
+{
+	gzDouble time(0);
+
+	for (USceneComponent* child : component->GetAttachChildren())
+	{
+		if (UPrimitiveComponent* primitive = Cast<UPrimitiveComponent>(child))
+			time = FMath::Max(time, (gzDouble)primitive->GetLastRenderTimeOnScreen());
+	}
+
+	return time;
+}
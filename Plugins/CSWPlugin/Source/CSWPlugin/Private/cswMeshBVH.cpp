@@ -0,0 +1,475 @@
+//*****************************************************************************
+//
+// Copyright (C) SAAB AB
+//
+// All rights, including the copyright, to the computer program(s)
+// herein belong to SAAB AB. The program(s) may be used and/or
+// copied only with the written permission of SAAB AB, or in
+// accordance with the terms and conditions stipulated in the
+// agreement/contract under which the program(s) have been
+// supplied.
+//
+//
+// Information Class:	COMPANY UNCLASSIFIED
+// Defence Secrecy:		NOT CLASSIFIED
+// Export Control:		NOT EXPORT CONTROLLED
+//
+//
+// File			: cswMeshBVH.cpp
+// Module		: CSW StreamingMap Unreal
+// Description	: Triangle BVH of built geometry for synchronous intersections
+// Author		: agent
+// Product		: CSW 1.1.2
+//
+//
+//
+// NOTE:	CSW (Common Synthetic World) is a simulation and presentation
+//			framework for large scale digital twins on multiple platforms
+//
+//
+// Revision History...
+//
+// Who	Date	Description
+//
+// AGT	261019	Created file 					(1.1.3)
+//
+//******************************************************************************
+#include "cswMeshBVH.h"
+
+#include "gzGeometry.h"
+
+GZ_DECLARE_TYPE_CHILD(gzReference, cswMeshBVH, "cswMeshBVH");
+GZ_DECLARE_TYPE_CHILD(gzReference, cswSceneBVH, "cswSceneBVH");
+
+static const int32	MAX_LEAF_TRIANGLES = 4;
+static const int32	MAX_LEAF_ENTRIES = 2;
+static const int32	MAX_DEPTH = 60;				// Traversal stack is MAX_DEPTH + 2
+
+// Slab test of origin + t * delta against a box for t in 0..limit
+template <class T> static inline gzBool hitBox(const UE::Math::TVector<T>& min, const UE::Math::TVector<T>& max, const FVector3d& origin, const FVector3d& inverse, gzDouble limit)
+{
+	gzDouble t0 = 0, t1 = limit;
+
+	for (int32 axis = 0; axis < 3; axis++)
+	{
+		gzDouble enter = (min[axis] - origin[axis]) * inverse[axis];
+		gzDouble leave = (max[axis] - origin[axis]) * inverse[axis];
+
+		if (enter > leave)
+			Swap(enter, leave);
+
+		t0 = FMath::Max(t0, enter);
+		t1 = FMath::Min(t1, leave);
+
+		if (t0 > t1)
+			return FALSE;
+	}
+
+	return TRUE;
+}
+
+static inline FVector3d inverseDelta(const FVector3d& delta)
+{
+	return FVector3d(delta.X != 0 ? 1.0 / delta.X : DBL_MAX, delta.Y != 0 ? 1.0 / delta.Y : DBL_MAX, delta.Z != 0 ? 1.0 / delta.Z : DBL_MAX);
+}
+
+// ----------------------------------- cswMeshBVH ------------------------------------------
+
+gzBool cswMeshBVH::intersect(const FVector3d& origin, const FVector3d& delta, cswRayHit& hit) const
+{
+	if (!m_nodes.Num())
+		return FALSE;
+
+	const FVector3d inverse = inverseDelta(delta);
+
+	gzBool found = FALSE;
+
+	int32 stack[MAX_DEPTH + 2];
+	int32 top = 0;
+
+	stack[top++] = 0;
+
+	while (top)
+	{
+		const int32 index = stack[--top];
+		const Node& node = m_nodes[index];
+
+		if (!hitBox(node.min, node.max, origin, inverse, hit.t))
+			continue;
+
+		if (!node.count)
+		{
+			stack[top++] = node.index;
+			stack[top++] = index + 1;
+			continue;
+		}
+
+		// Moller-Trumbore in double as rays can be long compared to the geometry
+		for (int32 i = node.index; i < node.index + node.count; i++)
+		{
+			const FIntVector& triangle = m_triangles[i];
+
+			const FVector3d a(m_vertices[triangle.X]);
+			const FVector3d e1 = FVector3d(m_vertices[triangle.Y]) - a;
+			const FVector3d e2 = FVector3d(m_vertices[triangle.Z]) - a;
+
+			const FVector3d p = delta ^ e2;
+			const gzDouble det = e1 | p;
+
+			if (det == 0)
+				continue;
+
+			const gzDouble inv = 1.0 / det;
+			const FVector3d s = origin - a;
+
+			const gzDouble u = (s | p) * inv;
+
+			if (u < 0 || u > 1)
+				continue;
+
+			const FVector3d q = s ^ e1;
+
+			const gzDouble v = (delta | q) * inv;
+
+			if (v < 0 || u + v > 1)
+				continue;
+
+			const gzDouble t = (e2 | q) * inv;
+
+			if (t < 0 || t >= hit.t)
+				continue;
+
+			FVector3d normal = (e1 ^ e2).GetSafeNormal();
+
+			if ((normal | delta) > 0)
+				normal = -normal;
+
+			hit.t = t;
+			hit.normal = normal;
+
+			found = TRUE;
+		}
+	}
+
+	return found;
+}
+
+int32 cswMeshBVH::buildNode(TArray<FVector3f>& centers, int32 first, int32 count, int32 depth)
+{
+	const int32 index = m_nodes.AddDefaulted();
+
+	FBox3f bounds(ForceInit), centerBounds(ForceInit);
+
+	for (int32 i = first; i < first + count; i++)
+	{
+		const FIntVector& triangle = m_triangles[i];
+
+		bounds += m_vertices[triangle.X];
+		bounds += m_vertices[triangle.Y];
+		bounds += m_vertices[triangle.Z];
+
+		centerBounds += centers[i];
+	}
+
+	m_nodes[index].min = bounds.Min;
+	m_nodes[index].max = bounds.Max;
+
+	if (count <= MAX_LEAF_TRIANGLES || depth >= MAX_DEPTH)
+	{
+		m_nodes[index].index = first;
+		m_nodes[index].count = count;
+
+		return index;
+	}
+
+	// Split the longest axis of the centers in the middle
+	const FVector3f extent = centerBounds.GetExtent();
+	const int32 axis = extent.X >= extent.Y && extent.X >= extent.Z ? 0 : (extent.Y >= extent.Z ? 1 : 2);
+	const gzFloat split = centerBounds.GetCenter()[axis];
+
+	int32 middle = first;
+
+	for (int32 i = first; i < first + count; i++)
+	{
+		if (centers[i][axis] < split)
+		{
+			Swap(centers[i], centers[middle]);
+			Swap(m_triangles[i], m_triangles[middle]);
+			middle++;
+		}
+	}
+
+	// Coincident centers
+	if (middle == first || middle == first + count)
+		middle = first + count / 2;
+
+	buildNode(centers, first, middle - first, depth + 1);
+
+	const int32 second = buildNode(centers, middle, first + count - middle, depth + 1);
+
+	m_nodes[index].index = second;
+
+	return index;
+}
+
+// Called in prebuild from manager thread
+cswMeshBVH* cswBuildMeshBVH(gzGeometry* geom)
+{
+	GZ_INSTRUMENT_NAME("cswBuildMeshBVH");
+
+	if (!geom || geom->getGeoPrimType() != GZ_PRIM_TRIS)
+		return nullptr;
+
+	gzArray<gzVec3>& coordinates = geom->getCoordinateArray(FALSE);
+	gzArray<gzUInt32>& indices = geom->getIndexArray(FALSE);
+
+	const gzUInt32 vcount = coordinates.getSize();
+	const gzUInt32 icount = indices.getSize() ? indices.getSize() : vcount;
+
+	TArray<FVector3f> vertices;
+	TArray<FIntVector> triangles;
+	TArray<FVector3f> centers;
+
+	vertices.SetNumUninitialized(vcount);
+
+	for (gzUInt32 i = 0; i < vcount; i++)
+		vertices[i] = FVector3f(coordinates[i].x, coordinates[i].y, coordinates[i].z);
+
+	triangles.Reserve(icount / 3);
+	centers.Reserve(icount / 3);
+
+	for (gzUInt32 i = 0; i + 2 < icount; i += 3)
+	{
+		const gzUInt32 ia = indices.getSize() ? indices[i] : i;
+		const gzUInt32 ib = indices.getSize() ? indices[i + 1] : i + 1;
+		const gzUInt32 ic = indices.getSize() ? indices[i + 2] : i + 2;
+
+		if (ia >= vcount || ib >= vcount || ic >= vcount)
+			return nullptr;
+
+		// Degenerate triangles can not be hit
+		if (((vertices[ib] - vertices[ia]) ^ (vertices[ic] - vertices[ia])).IsNearlyZero(0))
+			continue;
+
+		triangles.Add(FIntVector(ia, ib, ic));
+		centers.Add((vertices[ia] + vertices[ib] + vertices[ic]) / 3.0f);
+	}
+
+	if (!triangles.Num())
+		return nullptr;
+
+	cswMeshBVH* bvh = new cswMeshBVH;
+
+	bvh->m_vertices = MoveTemp(vertices);
+	bvh->m_triangles = MoveTemp(triangles);
+
+	bvh->m_nodes.Reserve(2 * bvh->m_triangles.Num() / MAX_LEAF_TRIANGLES + 1);
+
+	bvh->buildNode(centers, 0, bvh->m_triangles.Num(), 0);
+
+	bvh->m_nodes.Shrink();
+
+	bvh->m_bounds = FBox3f(bvh->m_nodes[0].min, bvh->m_nodes[0].max);
+
+	return bvh;
+}
+
+// ----------------------------------- cswSceneBVH ------------------------------------------
+
+gzVoid cswSceneBVH::add(UCSWSceneComponent* component, cswMeshBVH* bvh, const FTransform& transform)
+{
+	remove(component);
+
+	if (!component || !bvh)
+		return;
+
+	Entry entry;
+
+	entry.bvh = bvh;
+	entry.transform = transform;
+	entry.bounds = FBox3d(FVector3d(bvh->getBounds().Min), FVector3d(bvh->getBounds().Max)).TransformBy(transform);
+
+	int32& references = m_meshes.FindOrAdd(bvh);
+
+	if (!references++)
+	{
+		m_meshBytes += bvh->getBytes();
+		m_triangles += bvh->getTriangles();
+	}
+
+	m_entries.Add(component, entry);
+
+	m_dirty = TRUE;
+}
+
+gzVoid cswSceneBVH::remove(UCSWSceneComponent* component)
+{
+	Entry entry;
+
+	if (!m_entries.RemoveAndCopyValue(component, entry))
+		return;
+
+	int32& references = m_meshes.FindChecked(entry.bvh);
+
+	if (!--references)
+	{
+		m_meshes.Remove(entry.bvh);
+
+		m_meshBytes -= entry.bvh->getBytes();
+		m_triangles -= entry.bvh->getTriangles();
+	}
+
+	m_dirty = TRUE;
+}
+
+gzVoid cswSceneBVH::rebuild()
+{
+	GZ_INSTRUMENT_NAME("cswSceneBVH::rebuild");
+
+	m_nodes.Reset();
+	m_order.Reset(m_entries.Num());
+
+	for (auto& it : m_entries)
+		m_order.Add({ it.Key, &it.Value });
+
+	if (m_order.Num())
+		buildNode(0, m_order.Num());
+
+	m_dirty = FALSE;
+}
+
+int32 cswSceneBVH::buildNode(int32 first, int32 count)
+{
+	const int32 index = m_nodes.AddDefaulted();
+
+	FBox3d bounds(ForceInit), centerBounds(ForceInit);
+
+	for (int32 i = first; i < first + count; i++)
+	{
+		bounds += m_order[i].entry->bounds;
+		centerBounds += m_order[i].entry->bounds.GetCenter();
+	}
+
+	m_nodes[index].bounds = bounds;
+
+	if (count <= MAX_LEAF_ENTRIES)
+	{
+		m_nodes[index].index = first;
+		m_nodes[index].count = count;
+
+		return index;
+	}
+
+	// Median split keeps the tree balanced for any number of components
+	const FVector3d extent = centerBounds.GetExtent();
+	const int32 axis = extent.X >= extent.Y && extent.X >= extent.Z ? 0 : (extent.Y >= extent.Z ? 1 : 2);
+
+	MakeArrayView(m_order.GetData() + first, count).Sort([axis](const Leaf& a, const Leaf& b) { return a.entry->bounds.GetCenter()[axis] < b.entry->bounds.GetCenter()[axis]; });
+
+	const int32 middle = first + count / 2;
+
+	buildNode(first, middle - first);
+
+	const int32 second = buildNode(middle, first + count - middle);
+
+	m_nodes[index].index = second;
+
+	return index;
+}
+
+gzBool cswSceneBVH::intersect(const FVector3d& origin, const FVector3d& delta, cswRayHit& hit)
+{
+	GZ_INSTRUMENT_NAME("cswSceneBVH::intersect");
+
+	m_queries++;
+
+	if (m_dirty)
+		rebuild();
+
+	if (!m_nodes.Num())
+		return FALSE;
+
+	const FVector3d inverse = inverseDelta(delta);
+
+	gzBool found = FALSE;
+
+	int32 stack[MAX_DEPTH + 2];
+	int32 top = 0;
+
+	stack[top++] = 0;
+
+	while (top)
+	{
+		const int32 index = stack[--top];
+		const Node& node = m_nodes[index];
+
+		if (!hitBox(node.bounds.Min, node.bounds.Max, origin, inverse, hit.t))
+			continue;
+
+		if (!node.count)
+		{
+			stack[top++] = node.index;
+			stack[top++] = index + 1;
+			continue;
+		}
+
+		for (int32 i = node.index; i < node.index + node.count; i++)
+		{
+			const Leaf& leaf = m_order[i];
+
+			if (!leaf.component->IsVisible())
+				continue;
+
+			const FTransform& transform = leaf.entry->transform;
+
+			// Affine transform keeps the segment parameter
+			cswRayHit local = hit;
+
+			if (!leaf.entry->bvh->intersect(transform.InverseTransformPosition(origin), transform.InverseTransformVector(delta), local))
+				continue;
+
+			FVector3d normal = transform.GetRotation().RotateVector(local.normal * transform.GetSafeScaleReciprocal(transform.GetScale3D())).GetSafeNormal();
+
+			if ((normal | delta) > 0)
+				normal = -normal;
+
+			hit.t = local.t;
+			hit.normal = normal;
+			hit.component = leaf.component;
+
+			found = TRUE;
+		}
+	}
+
+	if (found)
+		m_hits++;
+
+	return found;
+}
+
+gzVoid cswSceneBVH::clear()
+{
+	m_entries.Empty();
+	m_meshes.Empty();
+	m_nodes.Empty();
+	m_order.Empty();
+
+	m_dirty = FALSE;
+
+	m_meshBytes = 0;
+	m_triangles = 0;
+}
+
+cswSceneBVHStatistics cswSceneBVH::getStatistics() const
+{
+	cswSceneBVHStatistics statistics;
+
+	statistics.components = m_entries.Num();
+	statistics.meshes = m_meshes.Num();
+	statistics.triangles = m_triangles;
+	statistics.bytes = m_meshBytes + m_entries.GetAllocatedSize() + m_meshes.GetAllocatedSize() + m_nodes.GetAllocatedSize() + m_order.GetAllocatedSize();
+	statistics.queries = m_queries;
+	statistics.hits = m_hits;
+
+	return statistics;
+}
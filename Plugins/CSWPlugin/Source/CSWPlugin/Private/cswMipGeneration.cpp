@@ -0,0 +1,249 @@
+//*****************************************************************************
+//
+// Copyright (C) SAAB AB
+//
+// All rights, including the copyright, to the computer program(s)
+// herein belong to SAAB AB. The program(s) may be used and/or
+// copied only with the written permission of SAAB AB, or in
+// accordance with the terms and conditions stipulated in the
+// agreement/contract under which the program(s) have been
+// supplied.
+//
+//
+// Information Class:	COMPANY UNCLASSIFIED
+// Defence Secrecy:		NOT CLASSIFIED
+// Export Control:		NOT EXPORT CONTROLLED
+//
+//
+// File			: cswMipGeneration.cpp
+// Module		: CSW StreamingMap Unreal
+// Description	: Mip chain generation for images without sub images
+// Author		: agent
+// Product		: CSW 1.1.2
+//
+//
+//
+// NOTE:	CSW (Common Synthetic World) is a simulation and presentation
+//			framework for large scale digital twins on multiple platforms
+//
+//
+// Revision History...
+//
+// Who	Date	Description
+//
+// AGT	261019	Created file 					(1.1.3)
+//
+//******************************************************************************
+#include "cswMipGeneration.h"
+
+#include "CoreMinimal.h"
+#include "Async/ParallelFor.h"
+#include "gzPerformance.h"
+
+namespace
+{
+	// Output rows per worker task
+	const gzUInt32 ROWS_PER_TASK = 32;
+
+	const gzInt32 KAISER_TAPS = 8;
+	const gzDouble KAISER_BETA = 4.0;
+
+	// Linear values are quantized to this many steps before the sRGB lookup
+	const gzUInt32 SRGB_STEPS = 4096;
+
+	struct Tables
+	{
+		gzFloat		toLinear[256];
+		gzUByte		toSRGB[SRGB_STEPS];
+		gzFloat		kaiser[KAISER_TAPS];
+	};
+
+	gzDouble besselI0(gzDouble x)
+	{
+		gzDouble sum(1), term(1);
+
+		for (gzInt32 k = 1; k < 32; k++)
+		{
+			term *= (x / (2 * k)) * (x / (2 * k));
+			sum += term;
+		}
+
+		return sum;
+	}
+
+	Tables createTables()
+	{
+		Tables tables;
+
+		for (gzUInt32 i = 0; i < 256; i++)
+		{
+			const gzDouble c = i / 255.0;
+
+			tables.toLinear[i] = (gzFloat)(c <= 0.04045 ? c / 12.92 : FMath::Pow((c + 0.055) / 1.055, 2.4));
+		}
+
+		for (gzUInt32 i = 0; i < SRGB_STEPS; i++)
+		{
+			const gzDouble l = i / (gzDouble)(SRGB_STEPS - 1);
+
+			const gzDouble c = l <= 0.0031308 ? l * 12.92 : 1.055 * FMath::Pow(l, 1.0 / 2.4) - 0.055;
+
+			tables.toSRGB[i] = (gzUByte)FMath::Clamp(FMath::RoundToInt(c * 255.0), 0, 255);
+		}
+
+		// Half band sinc centered between the two source texels of each target texel
+		gzDouble sum(0);
+
+		for (gzInt32 t = 0; t < KAISER_TAPS; t++)
+		{
+			const gzDouble d = t - (KAISER_TAPS - 1) / 2.0;
+			const gzDouble x = d / 2.0;
+			const gzDouble r = d / (KAISER_TAPS / 2.0);
+
+			const gzDouble sinc = FMath::Abs(x) < 1e-9 ? 1.0 : FMath::Sin(PI * x) / (PI * x);
+			const gzDouble window = besselI0(KAISER_BETA * FMath::Sqrt(FMath::Max(0.0, 1.0 - r * r))) / besselI0(KAISER_BETA);
+
+			tables.kaiser[t] = (gzFloat)(sinc * window);
+			sum += tables.kaiser[t];
+		}
+
+		for (gzInt32 t = 0; t < KAISER_TAPS; t++)
+			tables.kaiser[t] /= (gzFloat)sum;
+
+		return tables;
+	}
+
+	const Tables& tables()
+	{
+		static const Tables instance = createTables();
+
+		return instance;
+	}
+
+	inline gzFloat decode(const Tables& t, gzUByte value, gzInt32 channel, gzBool srgb)
+	{
+		return srgb && channel < 3 ? t.toLinear[value] : value * (1.0f / 255.0f);
+	}
+
+	inline gzUByte encode(const Tables& t, gzFloat value, gzInt32 channel, gzBool srgb)
+	{
+		value = FMath::Clamp(value, 0.0f, 1.0f);
+
+		if (srgb && channel < 3)
+			return t.toSRGB[(gzUInt32)(value * (SRGB_STEPS - 1) + 0.5f)];
+
+		return (gzUByte)(value * 255.0f + 0.5f);
+	}
+
+	gzVoid boxRows(const Tables& t, const gzUByte* source, gzUInt32 width, gzUInt32 height, gzBool srgb, gzUByte* target, gzUInt32 y0, gzUInt32 y1)
+	{
+		const gzUInt32 targetWidth = FMath::Max(width / 2, 1u);
+
+		for (gzUInt32 y = y0; y < y1; y++)
+		{
+			const gzUByte* row0 = source + (gzUInt64)FMath::Min(y * 2, height - 1) * width * 4;
+			const gzUByte* row1 = source + (gzUInt64)FMath::Min(y * 2 + 1, height - 1) * width * 4;
+
+			gzUByte* out = target + (gzUInt64)y * targetWidth * 4;
+
+			for (gzUInt32 x = 0; x < targetWidth; x++)
+			{
+				const gzUInt32 x0 = FMath::Min(x * 2, width - 1) * 4;
+				const gzUInt32 x1 = FMath::Min(x * 2 + 1, width - 1) * 4;
+
+				for (gzInt32 c = 0; c < 4; c++)
+				{
+					const gzFloat sum = decode(t, row0[x0 + c], c, srgb) + decode(t, row0[x1 + c], c, srgb) + decode(t, row1[x0 + c], c, srgb) + decode(t, row1[x1 + c], c, srgb);
+
+					out[x * 4 + c] = encode(t, sum * 0.25f, c, srgb);
+				}
+			}
+		}
+	}
+
+	// Separable filter. Source rows for the task are filtered horizontally into a local buffer first
+	gzVoid kaiserRows(const Tables& t, const gzUByte* source, gzUInt32 width, gzUInt32 height, gzBool srgb, gzUByte* target, gzUInt32 y0, gzUInt32 y1)
+	{
+		const gzUInt32 targetWidth = FMath::Max(width / 2, 1u);
+
+		const gzInt32 half = KAISER_TAPS / 2 - 1;
+		const gzInt32 first = (gzInt32)y0 * 2 - half;
+		const gzInt32 last = (gzInt32)(y1 - 1) * 2 + KAISER_TAPS - half - 1;
+
+		TArray<gzFloat> rows;
+		rows.SetNumUninitialized((last - first + 1) * targetWidth * 4);
+
+		for (gzInt32 sy = first; sy <= last; sy++)
+		{
+			const gzUByte* row = source + (gzUInt64)FMath::Clamp(sy, 0, (gzInt32)height - 1) * width * 4;
+
+			gzFloat* out = rows.GetData() + (gzUInt64)(sy - first) * targetWidth * 4;
+
+			for (gzUInt32 x = 0; x < targetWidth; x++)
+			{
+				gzFloat sum[4] = { 0, 0, 0, 0 };
+
+				for (gzInt32 k = 0; k < KAISER_TAPS; k++)
+				{
+					const gzUByte* pixel = row + FMath::Clamp((gzInt32)x * 2 - half + k, 0, (gzInt32)width - 1) * 4;
+
+					for (gzInt32 c = 0; c < 4; c++)
+						sum[c] += decode(t, pixel[c], c, srgb) * t.kaiser[k];
+				}
+
+				for (gzInt32 c = 0; c < 4; c++)
+					out[x * 4 + c] = sum[c];
+			}
+		}
+
+		for (gzUInt32 y = y0; y < y1; y++)
+		{
+			gzUByte* out = target + (gzUInt64)y * targetWidth * 4;
+
+			const gzFloat* base = rows.GetData() + (gzUInt64)((gzInt32)y * 2 - half - first) * targetWidth * 4;
+
+			for (gzUInt32 x = 0; x < targetWidth * 4; x++)
+			{
+				gzFloat sum(0);
+
+				for (gzInt32 k = 0; k < KAISER_TAPS; k++)
+					sum += base[(gzUInt64)k * targetWidth * 4 + x] * t.kaiser[k];
+
+				out[x] = encode(t, sum, x & 3, srgb);
+			}
+		}
+	}
+}
+
+gzUInt32 cswMipCount(gzUInt32 width, gzUInt32 height)
+{
+	if (!width || !height)
+		return 0;
+
+	return FMath::FloorLog2(FMath::Max(width, height)) + 1;
+}
+
+gzVoid cswDownsampleMip(const gzUByte* source, gzUInt32 width, gzUInt32 height, cswMipFilter filter, gzBool srgb, gzUByte* target)
+{
+	GZ_INSTRUMENT_NAME("cswDownsampleMip");
+
+	if (!source || !target || !width || !height || filter == CSW_MIP_FILTER_NONE)
+		return;
+
+	const Tables& t = tables();
+
+	const gzUInt32 targetHeight = FMath::Max(height / 2, 1u);
+
+	const gzInt32 tasks = (gzInt32)FMath::DivideAndRoundUp(targetHeight, ROWS_PER_TASK);
+
+	ParallelFor(tasks, [&](gzInt32 task)
+		{
+			const gzUInt32 y0 = task * ROWS_PER_TASK;
+			const gzUInt32 y1 = FMath::Min(targetHeight, y0 + ROWS_PER_TASK);
+
+			if (filter == CSW_MIP_FILTER_KAISER)
+				kaiserRows(t, source, width, height, srgb, target, y0, y1);
+			else
+				boxRows(t, source, width, height, srgb, target, y0, y1);
+		}, tasks == 1 ? EParallelForFlags::ForceSingleThread : EParallelForFlags::None);
+}
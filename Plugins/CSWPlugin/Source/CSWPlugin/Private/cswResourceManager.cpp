@@ -38,8 +38,23 @@
 #include "UEGlue/cswUEUtility.h"
 
 #include "Materials/MaterialExpressionTextureSample.h"
+#include "Hash/CityHash.h"
+#include "gzTime.h"
+#include "RenderingThread.h"
+
+#undef UpdateResource
+
+// Mip residency
+static const gzUInt32	RESIDENCY_MIN_SIZE = 64;		// Resident top mip never drops below this size
+static const gzDouble	RESIDENCY_INTERVAL = 0.25;		// Seconds between updates
+static const gzUInt32	RESIDENCY_UPDATES = 16;			// Texture rebuilds per update
+
+// Images read by prepareTexture on manager threads. Their pixels are not dropped meanwhile
+static gzMutex						s_prepareLock;
+static TMap<gzImage*, gzUInt32>		s_preparing;
 
 GZ_DECLARE_TYPE_CHILD(gzObject, cswResourceManager, "cswResourceManager");
+GZ_DECLARE_TYPE_CHILD(gzReference, cswTextureBuild, "cswTextureBuild");
 
 
 UMaterialInterface* cswResourceManager::initializeBaseMaterial()
@@ -58,7 +73,7 @@ UMaterialInterface* cswResourceManager::initializeBaseMaterial()
 	return m_baseMaterial;
 }
 
-UMaterialInterface* cswResourceManager::getMaterial(UCSWSceneComponent* owner,gzState* state, cswMaterialType type)
+UMaterialInterface* cswResourceManager::getMaterial(UCSWSceneComponent* owner,gzState* state, cswMaterialType type, cswAtlasRegion* atlasRegion, cswTextureBuild* prepared)
 {
 	if (!state)
 		return nullptr;
@@ -89,26 +104,879 @@ UMaterialInterface* cswResourceManager::getMaterial(UCSWSceneComponent* owner,gz
 		//image = gzImage::createChecker(gzRGBA(1.f, 1.f, 1.f, 1.f), gzRGBA(0.f, 0.f, 0.f, 1.f), GZ_IMAGE_TYPE_BW_8, 4, 4, 2, 2);
 
 		// Get a texture
-		UTexture2D* ue_texture = cswUETexture2DFromImage(image);
+		UTexture2D* ue_texture = atlasRegion ? getAtlasTexture(atlasRegion) : getTexture(image, prepared);
 
 		if (!ue_texture)
 			return nullptr;
 
-		UMaterialInstanceDynamic* material = UMaterialInstanceDynamic::Create(m_baseMaterial,owner);
+		const gzUInt64 key = materialKey(ue_texture, type);
 
-		if (!material)
-			return nullptr;
+		MaterialEntry* entry = m_materials.Find(key);
+
+		UMaterialInstanceDynamic* material = entry ? entry->material.Get() : nullptr;
+
+		if (material)
+		{
+			m_statistics.materialCacheHits++;
+		}
+		else
+		{
+			// Shared between components so not outered to any of them
+			material = UMaterialInstanceDynamic::Create(m_baseMaterial, GetTransientPackage());
+
+			if (!material)
+				return nullptr;
+
+			material->SetTextureParameterValue(FName("baseTexture"), ue_texture);
+
+			/*
+
+			material->BlendMode = EBlendMode::BLEND_Opaque;
+			material->bUseMaterialAttributes = false;
+			*/
+
+			if (!entry)
+				entry = &m_materials.Add(key);
+
+			entry->material = material;
+			entry->texture = ue_texture;
 
-		material->SetTextureParameterValue(FName("baseTexture"), ue_texture);
+			m_statistics.materialInstances++;
 
-		/*
+			if (++m_materialPurgeCounter >= 256)
+			{
+				purgeMaterials();
+				entry = m_materials.Find(key);
+			}
+		}
 
-		material->BlendMode = EBlendMode::BLEND_Opaque;
-		material->bUseMaterialAttributes = false;
-		*/
+		if (owner)
+		{
+			TArray<gzUInt64>& keys = m_materialOwners.FindOrAdd(owner);
+
+			if (!keys.Contains(key))
+			{
+				keys.Add(key);
+				entry->refs++;
+			}
+		}
 
 		return material;
 	}
 
 	return nullptr;
 }
+
+UTexture2D* cswResourceManager::getTexture(gzImage* image, cswTextureBuild* prepared)
+{
+	GZ_INSTRUMENT_NAME("cswResourceManager::getTexture");
+
+	if (!image)
+		return nullptr;
+
+	if (prepared && prepared->image != image)
+		prepared = nullptr;
+
+	// Drops that waited for a manager thread to finish reading
+	for (int32 i = m_pendingRelease.Num() - 1; i >= 0; i--)
+	{
+		if (releasePixels(m_pendingRelease[i]))
+			m_pendingRelease.RemoveAtSwap(i);
+	}
+
+	if (TextureEntry* entry = m_textureByImage.Find(image))
+	{
+		if (UTexture2D* texture = entry->texture.Get())
+		{
+			m_statistics.textureCacheHits++;
+			m_statistics.textureBytesSaved += entry->bytes;
+
+			return texture;
+		}
+
+		m_textureByImage.Remove(image);
+	}
+
+	// Pixels released by an earlier upload whose entry is gone
+	if (!prepared && !image->getArray().getSize())
+		return nullptr;
+
+	const gzDouble start = gzTime::systemSeconds();
+
+	gzUInt64 hash = 0;
+
+	if (m_textureContentHash)
+	{
+		hash = prepared ? prepared->hash : imageHash(image);
+
+		if (TextureEntry* entry = m_textureByHash.Find(hash))
+		{
+			if (UTexture2D* texture = entry->texture.Get())
+			{
+				TextureEntry& shared = m_textureByImage.Add(image, { image, entry->texture, entry->bytes, hash });
+
+				m_statistics.textureCacheHits++;
+				m_statistics.textureBytesSaved += shared.bytes;
+
+				releaseAfterUpload(shared, texture);
+
+				return texture;
+			}
+
+			m_textureByHash.Remove(hash);
+		}
+	}
+
+	UTexture2D* texture(nullptr);
+
+	if (prepared && prepared->platformData)
+	{
+		if (prepared->store)
+			texture = createResidentTexture(prepared->store, prepared->takePlatformData(), prepared->firstMip);
+		else
+			texture = cswUETexture2DFromPlatformData(prepared->takePlatformData());
+
+		m_statistics.preparedUploads++;
+	}
+	else if (m_mipResidency)
+	{
+		FTexturePlatformData* platformData = cswUETexturePlatformData(image);
+
+		cswTextureMipStorePtr store = platformData && platformData->Mips.Num() > 1 ? cswTextureMipStore::create(platformData) : nullptr;
+
+		if (store)
+		{
+			delete platformData;
+
+			const gzUInt32 firstMip = lowestMip(store);
+
+			texture = createResidentTexture(store, store->createPlatformData(firstMip), firstMip);
+		}
+		else
+			texture = cswUETexture2DFromPlatformData(platformData);
+	}
+	else
+		texture = cswUETexture2DFromImage(image);
+
+	m_statistics.textureGameThreadMicroseconds += (gzUInt64)((gzTime::systemSeconds() - start) * 1e6);
+
+	if (!texture)
+		return nullptr;
+
+	TextureEntry entry = { image, texture, prepared ? prepared->bytes : imageBytes(image), hash };
+
+	if (m_textureContentHash)
+		m_textureByHash.Add(hash, entry);
+
+	m_statistics.textureUploads++;
+	m_statistics.textureUploadBytes += entry.bytes;
+
+	releaseAfterUpload(entry, texture);
+
+	m_textureByImage.Add(image, MoveTemp(entry));
+
+	// Sweep now and then so images of collected textures are released
+	if (++m_texturePurgeCounter >= 256)
+		purgeTextures();
+
+	return texture;
+}
+
+gzVoid cswResourceManager::releaseAfterUpload(TextureEntry& entry, UTexture2D* texture)
+{
+	if (!m_releaseImagePixels)
+		return;
+
+	// Texture bulk data has its own copy now. Another geometry may still be preparing the image
+	if (!releasePixels(entry.image))
+		m_pendingRelease.AddUnique(entry.image);
+
+	entry.pinned.Reset(texture);
+
+	m_statistics.textureReleasedBytes += entry.bytes;
+}
+
+cswTextureBuild* cswResourceManager::prepareTexture(gzImage* image, const BuildProperties& buildProperties)
+{
+	GZ_INSTRUMENT_NAME("cswResourceManager::prepareTexture");
+
+	if (!image)
+		return nullptr;
+
+	{
+		GZ_BODYGUARD(s_prepareLock);
+
+		// Already uploaded and released by the game thread. The cached texture is used
+		if (!image->getArray().getSize())
+			return nullptr;
+
+		s_preparing.FindOrAdd(image)++;
+	}
+
+	cswTextureBuild* build = prepareTextureData(image, buildProperties);
+
+	{
+		GZ_BODYGUARD(s_prepareLock);
+
+		if (!--s_preparing[image])
+			s_preparing.Remove(image);
+	}
+
+	return build;
+}
+
+cswTextureBuild* cswResourceManager::prepareTextureData(gzImage* image, const BuildProperties& buildProperties)
+{
+
+	FTexturePlatformData* platformData(nullptr);
+
+	// Only RGB/RGBA images are encoded. Others keep their format
+	if (buildProperties.compressTextures)
+	{
+		gzFloat rmse;
+
+		platformData = cswUECompressedPlatformData(image, buildProperties.textureCompressionHighQuality, buildProperties.textureCompressionMaxRMSE, &rmse, buildProperties.mipFilter);
+
+		if (buildProperties.statistics)
+		{
+			if (platformData)
+			{
+				const gzUInt64 sourceBytes = imageBytes(image);
+
+				buildProperties.statistics->texturesCompressed++;
+				buildProperties.statistics->textureCompressionBytesSaved += sourceBytes - FMath::Min(sourceBytes, platformBytes(platformData));
+			}
+			else if (rmse >= 0)
+				buildProperties.statistics->texturesCompressionRejected++;
+		}
+	}
+
+	if (!platformData)
+		platformData = cswUETexturePlatformData(image, buildProperties.mipFilter);
+
+	if (!platformData)
+		return nullptr;
+
+	if (buildProperties.statistics && !image->getNumberOfSubImages() && platformData->Mips.Num() > 1)
+		buildProperties.statistics->texturesMipGenerated++;
+
+	cswTextureBuild* build = new cswTextureBuild;
+
+	// Upload starts with the small mips. Residency raises the top mip when users come close
+	if (buildProperties.textureMipResidency && platformData->Mips.Num() > 1)
+	{
+		build->store = cswTextureMipStore::create(platformData);
+
+		delete platformData;
+
+		build->firstMip = lowestMip(build->store);
+
+		platformData = build->store->createPlatformData(build->firstMip);
+	}
+
+	build->image = image;
+	build->platformData = platformData;
+	build->bytes = imageBytes(image);
+	build->hash = imageHash(image);
+
+	return build;
+}
+
+cswTextureBuild::~cswTextureBuild()
+{
+	delete platformData;
+}
+
+FTexturePlatformData* cswTextureBuild::takePlatformData()
+{
+	FTexturePlatformData* data = platformData;
+
+	platformData = nullptr;
+
+	return data;
+}
+
+UTexture2D* cswResourceManager::getAtlasTexture(cswAtlasRegion* region)
+{
+	GZ_INSTRUMENT_NAME("cswResourceManager::getAtlasTexture");
+
+	cswTextureAtlas* atlas = region->getAtlas();
+
+	if (!atlas)
+		return nullptr;
+
+	TStrongObjectPtr<UTexture2D>* page = m_atlasPages.Find(region->page);
+
+	UTexture2D* texture = page ? page->Get() : nullptr;
+
+	if (!texture)
+	{
+		EPixelFormat format;
+		gzUInt32 mipLevels;
+
+		if (!atlas->getPageLayout(region->page, format, mipLevels))
+			return nullptr;
+
+		texture = createAtlasPage(atlas->getPageSize(), format, mipLevels);
+
+		if (!texture)
+			return nullptr;
+
+		m_atlasPages.Add(region->page, TStrongObjectPtr<UTexture2D>(texture));
+
+		m_atlases.AddUnique(atlas);
+	}
+
+	if (region->image)
+	{
+		m_statistics.atlasUploads++;
+		m_statistics.atlasUploadBytes += imageBytes(region->image);
+
+		uploadAtlasRegion(texture, region);
+
+		// Page holds the pixels now
+		region->image = nullptr;
+
+		if (++m_atlasReleaseCounter >= 64)
+			releaseEmptyAtlasPages();
+	}
+
+	return texture;
+}
+
+UTexture2D* cswResourceManager::createAtlasPage(gzUInt32 size, EPixelFormat format, gzUInt32 mipLevels)
+{
+	GZ_INSTRUMENT_NAME("cswResourceManager::createAtlasPage");
+
+	UTexture2D* texture = NewObject<UTexture2D>(GetTransientPackage(), MakeUniqueObjectName(GetTransientPackage(), UTexture2D::StaticClass(), "CSWAtlasPage"), RF_Transient | RF_DuplicateTransient | RF_TextExportTransient);
+
+	if (!texture)
+		return nullptr;
+
+	const FPixelFormatInfo& info = GPixelFormats[format];
+
+	texture->SetPlatformData(new FTexturePlatformData());
+	texture->GetPlatformData()->SizeX = size;
+	texture->GetPlatformData()->SizeY = size;
+	texture->GetPlatformData()->PixelFormat = format;
+	texture->NeverStream = true;
+
+	// Regions are written with texture region updates. Start cleared
+	for (gzUInt32 mip = 0; mip < mipLevels; mip++)
+	{
+		const gzUInt32 mipSize = size >> mip;
+
+		const gzUInt64 bytes = (gzUInt64)FMath::DivideAndRoundUp<gzUInt32>(mipSize, info.BlockSizeX) * FMath::DivideAndRoundUp<gzUInt32>(mipSize, info.BlockSizeY) * info.BlockBytes;
+
+		FTexture2DMipMap* mipMap = new FTexture2DMipMap(mipSize, mipSize, 1);
+
+		mipMap->BulkData.Lock(LOCK_READ_WRITE);
+		FMemory::Memzero(mipMap->BulkData.Realloc(bytes), bytes);
+		mipMap->BulkData.Unlock();
+
+		texture->GetPlatformData()->Mips.Add(mipMap);
+	}
+
+	texture->UpdateResource();
+
+	return texture;
+}
+
+gzVoid cswResourceManager::uploadAtlasRegion(UTexture2D* page, cswAtlasRegion* region)
+{
+	const FPixelFormatInfo& info = GPixelFormats[page->GetPixelFormat()];
+
+	for (int32 mip = 0; mip < page->GetNumMips(); mip++)
+	{
+		gzImage* level = mip ? region->image->getSubImage(mip - 1) : region->image.get();
+
+		if (!level)
+			return;
+
+		const gzUInt32 width = FMath::Max(region->width >> mip, 1u);
+		const gzUInt32 height = FMath::Max(region->height >> mip, 1u);
+
+		const gzUInt32 pitch = (width / info.BlockSizeX) * info.BlockBytes;
+		const gzUInt32 bytes = pitch * (height / info.BlockSizeY);
+
+		// Render thread frees the copy when the update is done
+		uint8* data = (uint8*)FMemory::Malloc(bytes);
+		FMemory::Memcpy(data, level->getArray().getAddress(), bytes);
+
+		FUpdateTextureRegion2D* rect = new FUpdateTextureRegion2D(region->x >> mip, region->y >> mip, 0, 0, width, height);
+
+		page->UpdateTextureRegions(mip, 1, rect, pitch, info.BlockBytes, data, [](uint8* data, const FUpdateTextureRegion2D* rect)
+			{
+				FMemory::Free(data);
+				delete rect;
+			});
+	}
+}
+
+gzVoid cswResourceManager::releaseEmptyAtlasPages()
+{
+	GZ_INSTRUMENT_NAME("cswResourceManager::releaseEmptyAtlasPages");
+
+	m_atlasReleaseCounter = 0;
+
+	for (int32 i = m_atlases.Num() - 1; i >= 0; i--)
+	{
+		cswTextureAtlas* atlas = m_atlases[i];
+
+		atlas->releaseEmptyPages();
+
+		for (gzUInt32 page : atlas->takeReleasedPages())
+			m_atlasPages.Remove(page);
+
+		// Replaced atlas with all regions unloaded
+		if (!atlas->getStatistics().pages)
+			m_atlases.RemoveAt(i);
+	}
+}
+
+UTexture2D* cswResourceManager::createResidentTexture(cswTextureMipStore* store, FTexturePlatformData* platformData, gzUInt32 firstMip)
+{
+	UTexture2D* texture = cswUETexture2DFromPlatformData(platformData);
+
+	if (texture)
+	{
+		ResidencyEntry& entry = m_residency.Add(texture);
+
+		entry.texture = texture;
+		entry.store = store;
+		entry.firstMip = firstMip;
+		entry.wantedMip = firstMip;
+	}
+
+	return texture;
+}
+
+gzUInt32 cswResourceManager::lowestMip(cswTextureMipStore* store)
+{
+	gzUInt32 mip(0);
+
+	while (mip + 1 < store->getNumMips() && store->getMipSize(mip + 1) >= RESIDENCY_MIN_SIZE)
+		mip++;
+
+	return mip;
+}
+
+gzVoid cswResourceManager::applyResidency(ResidencyEntry& entry, gzUInt32 firstMip)
+{
+	UTexture2D* texture = entry.texture.Get();
+
+	if (!texture)
+		return;
+
+	FTexturePlatformData* previous = texture->GetPlatformData();
+
+	texture->SetPlatformData(entry.store->createPlatformData(firstMip));
+	texture->UpdateResource();
+
+	// Queued after the release of the old resource
+	ENQUEUE_RENDER_COMMAND(cswReleasePlatformData)([previous](FRHICommandListImmediate&)
+		{
+			delete previous;
+		});
+
+	entry.firstMip = firstMip;
+
+	m_statistics.mipUpdates++;
+}
+
+gzVoid cswResourceManager::setTextureMipResidency(gzBool on, gzUInt64 budget, gzFloat bias)
+{
+	m_mipResidency = on;
+	m_mipBudget = budget;
+	m_mipBias = FMath::Max(bias, 0.01f);
+}
+
+gzVoid cswResourceManager::updateTextureResidency(const FVector& viewLocation, gzDouble pixelScale)
+{
+	if (!m_mipResidency || !m_residency.Num())
+		return;
+
+	const gzDouble now = gzTime::systemSeconds();
+
+	if (now - m_residencyTime < RESIDENCY_INTERVAL)
+		return;
+
+	m_residencyTime = now;
+
+	GZ_INSTRUMENT_NAME("cswResourceManager::updateTextureResidency");
+
+	for (auto it = m_residency.CreateIterator(); it; ++it)
+	{
+		if (!it.Value().texture.IsValid())
+			it.RemoveCurrent();
+		else
+			it.Value().neededTexels = 0;
+	}
+
+	// Projected size of each user. A tile is assumed to cover its texture once
+	for (const auto& it : m_materialOwners)
+	{
+		UCSWSceneComponent* owner = it.Key;
+
+		if (!IsValid(owner) || m_evictedOwners.Contains(owner))
+			continue;
+
+		FBoxSphereBounds bounds(owner->GetComponentLocation(), FVector::ZeroVector, 0);
+
+		bool hasBounds(false);
+
+		for (USceneComponent* child : owner->GetAttachChildren())
+		{
+			UPrimitiveComponent* primitive = Cast<UPrimitiveComponent>(child);
+
+			if (!primitive || !primitive->IsRegistered())
+				continue;
+
+			bounds = hasBounds ? bounds + primitive->Bounds : primitive->Bounds;
+			hasBounds = true;
+		}
+
+		const gzDouble distance = FVector::Distance(bounds.Origin, viewLocation);
+
+		const gzFloat texels = distance <= bounds.SphereRadius ? FLT_MAX : (gzFloat)(2 * bounds.SphereRadius * pixelScale / distance * m_mipBias);
+
+		for (gzUInt64 key : it.Value)
+		{
+			const MaterialEntry* material = m_materials.Find(key);
+
+			if (!material || !material->texture)
+				continue;
+
+			if (ResidencyEntry* entry = m_residency.Find(material->texture))
+				entry->neededTexels = FMath::Max(entry->neededTexels, texels);
+		}
+	}
+
+	TArray<ResidencyEntry*> entries;
+	entries.Reserve(m_residency.Num());
+
+	gzUInt64 total(0);
+
+	for (auto& it : m_residency)
+	{
+		ResidencyEntry& entry = it.Value;
+
+		entry.wantedMip = lowestMip(entry.store);
+
+		while (entry.wantedMip > 0 && entry.store->getMipSize(entry.wantedMip) < entry.neededTexels)
+			entry.wantedMip--;
+
+		// One level of slack before dropping so the boundary does not rebuild every update
+		if (entry.wantedMip == entry.firstMip + 1)
+			entry.wantedMip = entry.firstMip;
+
+		total += entry.store->getResidentBytes(entry.wantedMip);
+
+		entries.Add(&entry);
+	}
+
+	m_statistics.mipBudgetDrops = 0;
+
+	// Over budget the least needed textures give up one level per pass
+	if (m_mipBudget && total > m_mipBudget)
+	{
+		entries.Sort([](const ResidencyEntry& a, const ResidencyEntry& b) { return a.neededTexels < b.neededTexels; });
+
+		bool dropped(true);
+
+		while (dropped && total > m_mipBudget)
+		{
+			dropped = false;
+
+			for (ResidencyEntry* entry : entries)
+			{
+				if (entry->wantedMip >= lowestMip(entry->store))
+					continue;
+
+				total -= entry->store->getResidentBytes(entry->wantedMip) - entry->store->getResidentBytes(entry->wantedMip + 1);
+
+				entry->wantedMip++;
+
+				m_statistics.mipBudgetDrops++;
+
+				dropped = true;
+
+				if (total <= m_mipBudget)
+					break;
+			}
+		}
+	}
+
+	// Drops first to free memory, then the most needed raises
+	entries.Sort([](const ResidencyEntry& a, const ResidencyEntry& b)
+		{
+			const bool aDrop = a.wantedMip > a.firstMip;
+			const bool bDrop = b.wantedMip > b.firstMip;
+
+			if (aDrop != bDrop)
+				return aDrop;
+
+			return a.neededTexels > b.neededTexels;
+		});
+
+	gzUInt32 updates(0);
+
+	for (ResidencyEntry* entry : entries)
+	{
+		if (entry->wantedMip == entry->firstMip)
+			continue;
+
+		if (updates++ >= RESIDENCY_UPDATES)
+			break;
+
+		applyResidency(*entry, entry->wantedMip);
+	}
+}
+
+gzUInt64 cswResourceManager::evictTextures(UCSWSceneComponent* owner)
+{
+	const TArray<gzUInt64>* keys = m_materialOwners.Find(owner);
+
+	if (!keys || !m_mipResidency)
+		return 0;
+
+	gzUInt64 bytes(0);
+
+	for (gzUInt64 key : *keys)
+	{
+		const MaterialEntry* material = m_materials.Find(key);
+
+		// Shared instances may still be needed by users on screen
+		if (!material || !material->texture || material->refs > 1)
+			continue;
+
+		ResidencyEntry* entry = m_residency.Find(material->texture);
+
+		if (!entry || !entry->texture.IsValid())
+			continue;
+
+		const gzUInt32 lowest = lowestMip(entry->store);
+
+		if (entry->firstMip >= lowest)
+			continue;
+
+		bytes += entry->store->getResidentBytes(entry->firstMip) - entry->store->getResidentBytes(lowest);
+
+		entry->wantedMip = lowest;
+
+		applyResidency(*entry, lowest);
+	}
+
+	if (bytes)
+		m_evictedOwners.Add(owner);
+
+	return bytes;
+}
+
+gzVoid cswResourceManager::restoreTextures(UCSWSceneComponent* owner)
+{
+	m_evictedOwners.Remove(owner);
+}
+
+gzVoid cswResourceManager::purgeTextures()
+{
+	GZ_INSTRUMENT_NAME("cswResourceManager::purgeTextures");
+
+	m_texturePurgeCounter = 0;
+
+	for (auto it = m_textureByImage.CreateIterator(); it; ++it)
+	{
+		TextureEntry& entry = it.Value();
+
+		if (!entry.texture.IsValid())
+		{
+			it.RemoveCurrent();
+			continue;
+		}
+
+		if (!entry.pinned)
+			continue;
+
+		// Unpin when only the cache refers to the image
+		TextureEntry* hashed = m_textureByHash.Find(entry.hash);
+
+		const gzUInt32 cacheRefs = 1 + (hashed && hashed->image == entry.image ? 1 : 0);
+
+		if (entry.image->getRef() <= cacheRefs)
+		{
+			if (hashed && hashed->image == entry.image)
+				m_textureByHash.Remove(entry.hash);
+
+			it.RemoveCurrent();
+		}
+	}
+
+	for (auto it = m_textureByHash.CreateIterator(); it; ++it)
+	{
+		if (!it.Value().texture.IsValid())
+			it.RemoveCurrent();
+	}
+}
+
+gzVoid cswResourceManager::setReleaseImagePixels(gzBool on)
+{
+	m_releaseImagePixels = on;
+}
+
+gzBool cswResourceManager::releasePixels(gzImage* image)
+{
+	GZ_BODYGUARD(s_prepareLock);
+
+	if (s_preparing.Contains(image))
+		return FALSE;
+
+	image->dropArray();
+
+	for (gzUInt32 i = 0; i < image->getNumberOfSubImages(); i++)
+	{
+		gzImage* subImage = image->getSubImage(i);
+
+		if (subImage)
+			subImage->dropArray();
+	}
+
+	return TRUE;
+}
+
+gzVoid cswResourceManager::setTextureContentHash(gzBool on)
+{
+	m_textureContentHash = on;
+
+	if (!on)
+		m_textureByHash.Empty();
+}
+
+cswResourceStatistics cswResourceManager::getStatistics() const
+{
+	cswResourceStatistics statistics = m_statistics;
+
+	TSet<UTexture2D*> textures;
+
+	for (const auto& it : m_textureByImage)
+	{
+		if (UTexture2D* texture = it.Value.texture.Get())
+		{
+			statistics.textureResidentBytes += imageBytes(it.Value.image);
+
+			// Images sharing a texture by content count once
+			bool counted(false);
+			textures.Add(texture, &counted);
+
+			if (!counted)
+				statistics.textureMemoryBytes += texture->CalcTextureMemorySizeEnum(TMC_AllMips);
+		}
+	}
+
+	for (const auto& it : m_atlasPages)
+	{
+		if (it.Value)
+			statistics.textureMemoryBytes += it.Value->CalcTextureMemorySizeEnum(TMC_AllMips);
+	}
+
+	for (const auto& it : m_residency)
+	{
+		if (!it.Value.texture.IsValid())
+			continue;
+
+		statistics.residentTextures++;
+		statistics.mipStoreBytes += it.Value.store->getBytes();
+		statistics.mipResidentBytes += it.Value.store->getResidentBytes(it.Value.firstMip);
+	}
+
+	for (const auto& it : m_materials)
+	{
+		if (UMaterialInstanceDynamic* material = it.Value.material.Get())
+		{
+			statistics.materialsLive++;
+			statistics.materialBytes += material->GetResourceSizeBytes(EResourceSizeMode::EstimatedTotal);
+		}
+
+		if (it.Value.refs)
+		{
+			statistics.materialsInUse++;
+			statistics.materialReferences += it.Value.refs;
+		}
+	}
+
+	return statistics;
+}
+
+gzUInt64 cswResourceManager::platformBytes(FTexturePlatformData* platformData)
+{
+	gzUInt64 bytes(0);
+
+	for (const FTexture2DMipMap& mip : platformData->Mips)
+		bytes += mip.BulkData.GetBulkDataSize();
+
+	return bytes;
+}
+
+gzUInt64 cswResourceManager::imageBytes(gzImage* image)
+{
+	gzUInt64 bytes = image->getArray().getSize();
+
+	for (gzUInt32 i = 0; i < image->getNumberOfSubImages(); i++)
+	{
+		gzImage* subImage = image->getSubImage(i);
+
+		if (subImage)
+			bytes += subImage->getArray().getSize();
+	}
+
+	return bytes;
+}
+
+gzUInt64 cswResourceManager::imageHash(gzImage* image)
+{
+	GZ_INSTRUMENT_NAME("cswResourceManager::imageHash");
+
+	const gzUInt32 layout[] = { image->getWidth(), image->getHeight(), (gzUInt32)image->getImageType(), (gzUInt32)image->getFormat(), image->getNumberOfSubImages() };
+
+	gzUInt64 hash = CityHash64((const char*)layout, sizeof(layout));
+
+	// Mip 0 identifies the content. Sub images are derived from it
+	return CityHash64WithSeed((const char*)image->getArray().getAddress(), image->getArray().getSize(), hash);
+}
+
+gzVoid cswResourceManager::releaseMaterials(UCSWSceneComponent* owner)
+{
+	TArray<gzUInt64> keys;
+
+	m_evictedOwners.Remove(owner);
+
+	if (!m_materialOwners.RemoveAndCopyValue(owner, keys))
+		return;
+
+	for (gzUInt64 key : keys)
+	{
+		MaterialEntry* entry = m_materials.Find(key);
+
+		if (entry && entry->refs)
+			entry->refs--;
+	}
+}
+
+gzVoid cswResourceManager::purgeMaterials()
+{
+	GZ_INSTRUMENT_NAME("cswResourceManager::purgeMaterials");
+
+	m_materialPurgeCounter = 0;
+
+	for (auto it = m_materials.CreateIterator(); it; ++it)
+	{
+		if (!it.Value().refs && !it.Value().material.IsValid())
+			it.RemoveCurrent();
+	}
+}
+
+gzUInt64 cswResourceManager::materialKey(UTexture2D* texture, cswMaterialType type)
+{
+	gzUInt64 hash = CityHash64((const char*)&texture, sizeof(texture));
+
+	return CityHash64WithSeed((const char*)&type, sizeof(type), hash);
+}
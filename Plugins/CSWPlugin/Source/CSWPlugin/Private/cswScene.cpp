@@ -42,6 +42,11 @@
 
 #include "UEGlue/cswUEMatrix.h"
 #include "UEGlue/cswUEUtility.h"
+#include "Utility/cswGeoKernels.h"
+
+#include "Async/ParallelFor.h"
+
+#include "cswSceneManagerBase.h"
 
 #include "Geo/cswGeoModelComponent.h"
 #include "Geo/cswGeoUTMComponent.h"
@@ -52,8 +57,10 @@
 
 // TODO: remove
 #include "Builders/cswGeometry.h"
+#include "Builders/cswLod.h"
+#include "Builders/cswRoiNode.h"
 
-#include "gzCoordinate.h"
+#include "gzGeometry.h"
 
 
 UCSWScene::UCSWScene(const FObjectInitializer& ObjectInitializer): Super(ObjectInitializer), m_indexLUT(IN_MEM_RESOURCE_COUNT),m_slots(GZ_QUEUE_LIFO, IN_MEM_RESOURCE_COUNT), m_components(IN_MEM_RESOURCE_COUNT)
@@ -84,6 +91,9 @@ UCSWScene::UCSWScene(const FObjectInitializer& ObjectInitializer): Super(ObjectI
 UCSWScene::~UCSWScene()
 {
 	unInitSceneManager();
+
+	if (m_altitudeLookup)
+		m_altitudeLookup->stop(TRUE);
 }
 
 void UCSWScene::registerPropertyCallbacks()
@@ -93,8 +103,35 @@ void UCSWScene::registerPropertyCallbacks()
 	registerPropertyUpdate("CoordType", &UCSWScene::onCoordTypePropertyUpdate);
 	registerPropertyUpdate("CenterOrigin", &UCSWScene::onCenterOriginPropertyUpdate);
 	registerPropertyUpdate("AllowCustomOrigin", &UCSWScene::onCenterOriginPropertyUpdate);
+	registerPropertyUpdate("GeoTangentTolerance", &UCSWScene::onGeoContextPropertyUpdate);
+	registerPropertyUpdate("FloatingOrigin", &UCSWScene::onFloatingOriginPropertyUpdate);
+	registerPropertyUpdate("HeightCache", &UCSWScene::onHeightCachePropertyUpdate);
+	registerPropertyUpdate("HeightCacheMaxAge", &UCSWScene::onHeightCachePropertyUpdate);
+	registerPropertyUpdate("LocalIntersect", &UCSWScene::onLocalIntersectPropertyUpdate);
+	registerPropertyUpdate("AltitudeLookupDirectory", &UCSWScene::onAltitudeLookupPropertyUpdate);
 	registerPropertyUpdate("OmniView", &UCSWScene::onOmniViewPropertyUpdate);
 	registerPropertyUpdate("LodFactor", &UCSWScene::onLodFactorPropertyUpdate);
+	registerPropertyUpdate("MergeLodLevels", &UCSWScene::onBuildPropertiesUpdate);
+	registerPropertyUpdate("OptimizeVertexCache", &UCSWScene::onBuildPropertiesUpdate);
+	registerPropertyUpdate("PartialGeometryUpdates", &UCSWScene::onBuildPropertiesUpdate);
+	registerPropertyUpdate("DynamicMeshUpdateRate", &UCSWScene::onBuildPropertiesUpdate);
+	registerPropertyUpdate("DynamicMeshIdleTime", &UCSWScene::onBuildPropertiesUpdate);
+	registerPropertyUpdate("TextureContentHash", &UCSWScene::onResourcePropertiesUpdate);
+	registerPropertyUpdate("ReleaseImagePixels", &UCSWScene::onBuildPropertiesUpdate);
+	registerPropertyUpdate("PrepareTextures", &UCSWScene::onBuildPropertiesUpdate);
+	registerPropertyUpdate("CompressTextures", &UCSWScene::onBuildPropertiesUpdate);
+	registerPropertyUpdate("TextureCompressionHighQuality", &UCSWScene::onBuildPropertiesUpdate);
+	registerPropertyUpdate("TextureCompressionMaxRMSE", &UCSWScene::onBuildPropertiesUpdate);
+	registerPropertyUpdate("GenerateMips", &UCSWScene::onBuildPropertiesUpdate);
+	registerPropertyUpdate("KaiserMipFilter", &UCSWScene::onBuildPropertiesUpdate);
+	registerPropertyUpdate("TextureAtlas", &UCSWScene::onBuildPropertiesUpdate);
+	registerPropertyUpdate("TextureAtlasPageSize", &UCSWScene::onBuildPropertiesUpdate);
+	registerPropertyUpdate("TextureMipResidency", &UCSWScene::onBuildPropertiesUpdate);
+	registerPropertyUpdate("TextureMemoryBudgetMB", &UCSWScene::onResourcePropertiesUpdate);
+	registerPropertyUpdate("TextureResidencyBias", &UCSWScene::onResourcePropertiesUpdate);
+	registerPropertyUpdate("MemoryBudgetMB", &UCSWScene::onMemoryBudgetPropertyUpdate);
+	registerPropertyUpdate("MemoryBudgetMaxLodFactorScale", &UCSWScene::onMemoryBudgetPropertyUpdate);
+	registerPropertyUpdate("MemoryBudgetEvictAge", &UCSWScene::onMemoryBudgetPropertyUpdate);
 }
 
 bool UCSWScene::isEditorComponent()
@@ -125,6 +162,27 @@ void UCSWScene::BeginPlay()
 
 	SubDestroy(this);
 
+	m_topLevelRois.Empty();
+	m_outsideRoiContent.Empty();
+
+	if (m_heightCache)
+		m_heightCache->clear();
+
+	if (m_sceneBVH)
+		m_sceneBVH->clear();
+
+	{
+		GZ_BODYGUARD(m_groundClampLock);
+		m_approximateClamps.Empty();
+	}
+
+	m_approximateClampCounters = cswApproximateClampCounters();
+
+	if (m_floatingOffset.length() > 0)
+		rebaseFloatingOrigin(GZ_ZERO_VEC3D);
+
+	m_floatingOriginRebases = 0;
+
 	//// Test to drive a whole scene from begin play
 	//for(gzUInt32 i = 0; i < 100; )
 	//{
@@ -150,6 +208,88 @@ void UCSWScene::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
 	Super::EndPlay(EndPlayReason);
 
+	if (m_buildProperties.statistics)
+	{
+		FCSWBuildStatistics stats = GetBuildStatistics();
+
+		GZMESSAGE(GZ_MESSAGE_NOTICE, "Built %lld meshes (%lld LODs 16 bit), %lld vertices, index buffers %lld bytes, saved %lld bytes", stats.Meshes, stats.Meshes16Bit, stats.Vertices, stats.IndexBytes, stats.IndexBytesSaved);
+
+		if (stats.MeshesFailed)
+			GZMESSAGE(GZ_MESSAGE_WARNING, "Failed to build %lld meshes", stats.MeshesFailed);
+
+		if (OptimizeVertexCache)
+			GZMESSAGE(GZ_MESSAGE_NOTICE, "Vertex cache ACMR %.3f before and %.3f after reordering", stats.VertexCacheACMRBefore, stats.VertexCacheACMRAfter);
+
+		GZMESSAGE(GZ_MESSAGE_NOTICE, "Prepared %lld textures in prebuild, %.3f ms each on manager thread", stats.TexturesPrepared, stats.TexturesPrepared ? stats.TexturePrepareMilliseconds / stats.TexturesPrepared : 0.0);
+
+		if (CompressTextures)
+			GZMESSAGE(GZ_MESSAGE_NOTICE, "Compressed %lld textures (%lld rejected by RMSE), saved %lld bytes", stats.TexturesCompressed, stats.TexturesCompressionRejected, stats.TextureCompressionBytesSaved);
+
+		if (GenerateMips)
+			GZMESSAGE(GZ_MESSAGE_NOTICE, "Generated mip chains for %lld textures", stats.TexturesMipGenerated);
+
+		if (LocalIntersect)
+			GZMESSAGE(GZ_MESSAGE_NOTICE, "Built %lld intersect trees (%lld bytes), %.3f ms each on manager thread", stats.IntersectTrees, stats.IntersectTreeBytes, stats.IntersectTrees ? stats.IntersectTreeMilliseconds / stats.IntersectTrees : 0.0);
+	}
+
+	if (m_heightCache)
+	{
+		FCSWHeightCacheStatistics stats = GetHeightCacheStatistics();
+
+		GZMESSAGE(GZ_MESSAGE_NOTICE, "Height cache %d terrain tiles, %d clamp samples, %lld bytes, %lld hits, %lld misses", stats.Tiles, stats.ClampSamples, stats.Bytes, stats.Hits, stats.Misses);
+	}
+
+	if (m_sceneBVH)
+	{
+		FCSWLocalIntersectStatistics stats = GetLocalIntersectStatistics();
+
+		GZMESSAGE(GZ_MESSAGE_NOTICE, "Local intersect %d components, %d trees, %lld triangles, %lld bytes, %lld queries, %lld hits", stats.Components, stats.Meshes, stats.Triangles, stats.Bytes, stats.Queries, stats.Hits);
+	}
+
+	if (m_altitudeLookup)
+	{
+		FCSWApproximateClampStatistics stats = GetApproximateClampStatistics();
+
+		GZMESSAGE(GZ_MESSAGE_NOTICE, "Approximate clamps %lld of %lld requests from %d datasets, placed after %.3f ms instead of %.1f ms, error mean %.2f m max %.2f m", stats.Approximated, stats.Requests, stats.Datasets, stats.MeanApproximateMilliseconds, stats.MeanRefinedMilliseconds, stats.MeanError, stats.MaxError);
+	}
+
+	if (FloatingOrigin)
+		GZMESSAGE(GZ_MESSAGE_NOTICE, "Floating origin rebased %d times, %d top level rois, %d components outside rois", m_floatingOriginRebases, m_topLevelRois.Num(), m_outsideRoiContent.Num());
+
+	if (m_resource)
+	{
+		FCSWResourceStatistics stats = GetResourceStatistics();
+
+		GZMESSAGE(GZ_MESSAGE_NOTICE, "Uploaded %lld textures (%lld bytes), %lld duplicate uploads avoided, saved %lld bytes", stats.TextureUploads, stats.TextureUploadBytes, stats.TextureCacheHits, stats.TextureBytesSaved);
+
+		GZMESSAGE(GZ_MESSAGE_NOTICE, "Texture creation on game thread %.3f ms per upload (%lld of %lld prepared in prebuild)", stats.TextureUploads ? stats.TextureGameThreadMilliseconds / stats.TextureUploads : 0.0, stats.PreparedUploads, stats.TextureUploads);
+
+		GZMESSAGE(GZ_MESSAGE_NOTICE, "Image pixels resident %lld bytes, before release %lld bytes", stats.TextureResidentBytes, stats.TextureResidentBytes + stats.TextureReleasedBytes);
+
+		GZMESSAGE(GZ_MESSAGE_NOTICE, "Texture memory resident %lld bytes", stats.TextureMemoryBytes);
+
+		if (useMipResidency())
+			GZMESSAGE(GZ_MESSAGE_NOTICE, "Mip residency %lld textures, %lld of %lld bytes uploaded, %lld rebuilds, %lld mips over budget", stats.ResidentTextures, stats.MipResidentBytes, stats.MipStoreBytes, stats.MipUpdates, stats.MipBudgetDrops);
+
+		if (m_buildProperties.textureAtlas)
+		{
+			FCSWAtlasStatistics atlas = GetAtlasStatistics();
+
+			GZMESSAGE(GZ_MESSAGE_NOTICE, "Atlas %d pages, %d regions (%lld uploads), %.1f%% used, fragmentation %.2f, %lld pages released", atlas.Pages, atlas.Regions, stats.AtlasUploads, atlas.UsedTexels + atlas.FreeTexels ? 100.0 * atlas.UsedTexels / (atlas.UsedTexels + atlas.FreeTexels) : 0.0, atlas.Fragmentation, atlas.ReleasedPages);
+		}
+
+		GZMESSAGE(GZ_MESSAGE_NOTICE, "Created %lld material instances, %lld cache hits, %lld in use by %lld components, %lld live (%lld bytes)", stats.MaterialInstances, stats.MaterialCacheHits, stats.MaterialsInUse, stats.MaterialReferences, stats.MaterialsLive, stats.MaterialBytes);
+	}
+
+	if (m_budget)
+	{
+		FCSWMemoryBudgetStatistics stats = GetMemoryBudgetStatistics();
+
+		GZMESSAGE(GZ_MESSAGE_NOTICE, "Memory budget %lld bytes, used %lld (meshes %lld, textures %lld, %d materials %lld), pressure %.2f, lod factor x%.2f", stats.BudgetBytes, stats.UsedBytes, stats.MeshBytes, stats.TextureBytes, stats.Materials, stats.MaterialBytes, stats.Pressure, stats.LodFactorScale);
+
+		GZMESSAGE(GZ_MESSAGE_NOTICE, "Memory budget %lld evictions, %lld restores, %lld lod raises, %lld lod lowers", stats.Evictions, stats.Restores, stats.LodRaises, stats.LodLowers);
+	}
+
 #if defined GZ_INSTRUMENT_CODE
 
 	gzStopPerformanceThread();
@@ -178,6 +318,12 @@ void UCSWScene::TickComponent(float DeltaTime, enum ELevelTick TickType, FActorC
 	}
 
 	processFrames(m_firstRun);
+
+	if (m_resource && m_viewPixelScale > 0)
+		m_resource->updateTextureResidency(m_viewLocation, m_viewPixelScale);
+
+	if (m_budget && GetWorld() && m_budget->update(m_resource, GetWorld()->GetTimeSeconds()))
+		onLodFactorPropertyUpdate();
 		
 	m_firstRun = false;
 }
@@ -189,6 +335,10 @@ void UCSWScene::initSceneManager()
 	{
 		m_manager = new cswUESceneManager();
 
+		m_buildProperties.statistics = new cswBuildStatistics;
+
+		m_manager->setBuildProperties(m_buildProperties);
+
 		// Do conversion in manager thread
 		m_manager->enableCapabilities(CSW_CAPABILITY_CONVERT_TO_TRIANGLE|CSW_CAPABILITY_INDEX_GEOMETRY/*|CSW_CAPABILITY_REBUILD_INDEX_GEOMETRY*/);
 
@@ -231,6 +381,8 @@ void UCSWScene::initResourceManager()
 	m_resource = new cswResourceManager;
 
 	m_baseMaterial = m_resource->initializeBaseMaterial();
+
+	onResourcePropertiesUpdate();
 }
 
 bool UCSWScene::processCameras(bool forceUpdate)
@@ -241,6 +393,8 @@ bool UCSWScene::processCameras(bool forceUpdate)
 	float		CameraVFOV = 90.0f;
 	float		CameraHFOV = 90.0f;
 
+	FIntPoint	size(0, 0);
+
 	// Check manager
 
 	if (!m_manager)
@@ -270,7 +424,7 @@ bool UCSWScene::processCameras(bool forceUpdate)
 
 		float aspectRatio = 1.0f;
 
-		FIntPoint size = viewport->GetSizeXY();
+		size = viewport->GetSizeXY();
 
 		aspectRatio = (float)size.X / (float)size.Y;
 
@@ -316,7 +470,7 @@ bool UCSWScene::processCameras(bool forceUpdate)
 		if (!viewport)
 			return false;
 
-		FIntPoint size = viewport->GetSizeXY();
+		size = viewport->GetSizeXY();
 
 		aspectRatio = (float)size.X / (float)size.Y;
 
@@ -324,6 +478,10 @@ bool UCSWScene::processCameras(bool forceUpdate)
 		CameraVFOV = atan(tan(CameraHFOV * GZ_DEG2RAD_F / 2) / aspectRatio) * GZ_RAD2DEG_F * 2;
 	}
 
+	// World camera for texture residency
+	m_viewLocation = CameraLocation;
+	m_viewPixelScale = size.Y / (2 * tan(CameraVFOV * GZ_DEG2RAD_F / 2));
+
 	FVector position = GetRelativeLocation();
 
 	// Add possible offset to Camera Location
@@ -337,6 +495,12 @@ bool UCSWScene::processCameras(bool forceUpdate)
 
 	gzVec3D pos = UE_2_GZ(CameraLocation, CoordType,getWorldScale());
 
+	// Root is moved to the floating origin. Small local offset plus origin keeps precision
+
+	pos = pos + m_floatingOffset;
+
+	updateFloatingOrigin(pos);
+
 	// Get rotation matrix from camera
 
 	FMatrix rotation = FRotationMatrix::Make(CameraRotation).RemoveTranslation();
@@ -520,6 +684,14 @@ bool UCSWScene::processGenericBuffer(cswCommandBuffer* buffer)
 			handleGroundClampResponse(groundClamp);
 			continue;
 		}
+
+		cswSceneCommandIntersectResponse* intersect = gzDynamic_Cast<cswSceneCommandIntersectResponse>(command);
+
+		if (intersect)
+		{
+			handleIntersectResponse(intersect);
+			continue;
+		}
 	}
 
 	buffer->unLock();				// finished
@@ -768,6 +940,15 @@ bool UCSWScene::processNewNode(cswSceneCommandNewNode* command)
 	component->RegisterComponent();
 	GZ_LEAVE_PERFORMANCE_SECTION;
 
+	trackFloatingOrigin(component, true);
+
+	updateHeightCache(component, node);
+
+	updateLocalIntersect(component, node);
+
+	if (m_budget && GetWorld())
+		m_budget->track(component, GetWorld()->GetTimeSeconds());
+
 	if(!registerComponent(component, node, pathID))
 	{
 		GZMESSAGE(GZ_MESSAGE_FATAL, "Failed to register component");
@@ -812,6 +993,13 @@ bool UCSWScene::processUpdateNode(cswSceneCommandUpdateNode* command)
 		}
 	}
 
+	if (m_budget && GetWorld())
+		m_budget->track(component, GetWorld()->GetTimeSeconds());
+
+	updateHeightCache(component, node);
+
+	updateLocalIntersect(component, node);
+
 	return true;
 }
 
@@ -839,6 +1027,17 @@ bool UCSWScene::processDeleteNode(cswSceneCommandDeleteNode* command)
 		}
 	}
 
+	if (m_budget)
+		m_budget->untrack(component);
+
+	trackFloatingOrigin(component, false);
+
+	if (m_heightCache)
+		m_heightCache->removeTile(component);
+
+	if (m_sceneBVH)
+		m_sceneBVH->remove(component);
+
 	GZ_ENTER_PERFORMANCE_SECTION("UE:DestroyComponent");
 	component->DestroyComponent();
 	GZ_LEAVE_PERFORMANCE_SECTION;
@@ -949,8 +1148,13 @@ bool UCSWScene::processGeoInfo(cswSceneCommandGeoInfo* command)
 	ModelOriginY = UEOrigin.Y;
 	ModelOriginZ = UEOrigin.Z;
 
+	invalidateGeoContext();
+
 	propertyUpdate("CoordType");
 
+	// Parse once here instead of in every conversion
+	getGeoContext();
+
 	return true;
 }
 
@@ -1041,6 +1245,10 @@ bool UCSWScene::onMapUrlsPropertyUpdate()
 
 		m_manager->addSingleCommand(new cswSceneCommandSetMapUrls(mapURL));
 		m_firstRun = true;
+
+		// Statistics are per map
+		if (m_buildProperties.statistics)
+			m_buildProperties.statistics->reset();
 	}
 	else
 	{
@@ -1064,219 +1272,2002 @@ bool UCSWScene::onLodFactorPropertyUpdate()
 {
 	GZ_INSTRUMENT_NAME("UCSWScene::onLodFactorPropertyUpdate");
 
+	// Memory budget scales on top of the user factor
+	const float lodFactor = LodFactor * (m_budget ? m_budget->getLodFactorScale() : 1.0f);
+
 	if (m_manager)
-		m_manager->addSingleCommand(new cswSceneCommandSetLodFactor(LodFactor), FALSE);
+		m_manager->addSingleCommand(new cswSceneCommandSetLodFactor(lodFactor), FALSE);
 
 	return true;
 }
 
-bool UCSWScene::onCenterOriginPropertyUpdate()
+bool UCSWScene::onMemoryBudgetPropertyUpdate()
 {
-	GZ_INSTRUMENT_NAME("UCSWScene::onCenterOriginPropertyUpdate");
-
-	updateOriginTransform();
+	GZ_INSTRUMENT_NAME("UCSWScene::onMemoryBudgetPropertyUpdate");
 
-	return true;
-}
-
-bool UCSWScene::onCoordTypePropertyUpdate()
-{
-	GZ_INSTRUMENT_NAME("UCSWScene::onCoordTypePropertyUpdate");
+	if (MemoryBudgetMB <= 0)
+	{
+		m_budget = nullptr;
 
-	updateOriginTransform();
+		onBuildPropertiesUpdate();
 
-	return true;
-}
+		return onLodFactorPropertyUpdate();
+	}
 
-void  UCSWScene::updateOriginTransform()
-{
-	if (!AllowCustomOrigin)
+	if (!m_budget)
 	{
-		FTransform m;
-
-		// map SCENE content in Gizmo World to UE world with or without origin
+		m_budget = new cswMemoryBudget;
 
-		gzVec3D origin = CenterOrigin ? UE_2_GZ(FVector3d(ModelOriginX, ModelOriginY, ModelOriginZ), CoordType, getWorldScale()) : GZ_ZERO_VEC3D;
+		const double time = GetWorld() ? GetWorld()->GetTimeSeconds() : 0;
 
-		// Move children negative origin so our map origin ends up in 0,0,0
+		for (gzUInt32 i = 0; i < m_components.getSize(); i++)
+		{
+			if (m_components[i])
+				m_budget->track(m_components[i], time);
+		}
+	}
 
-		m.SetFromMatrix(cswMatrix4_<double>::UEMatrix4(GZ_2_UE(CoordType, getWorldScale(), origin)));
+	m_budget->setBudget((gzUInt64)MemoryBudgetMB << 20, MemoryBudgetMaxLodFactorScale, MemoryBudgetEvictAge);
 
-		// Apply Transform to root
+	// Eviction drops resident mips
+	onBuildPropertiesUpdate();
 
-		SetRelativeTransform(m);
-	}
+	return onLodFactorPropertyUpdate();
 }
 
-gzMatrix4D UCSWScene::UE_2_GZ(enum CoordType type, const double& scale, const gzVec3D& offset) const
+bool UCSWScene::onBuildPropertiesUpdate()
 {
-	gzMatrix4D mat;
-	
-	if(GZ_2_UE(type, scale, offset).inverse(mat))
-		return mat;
-
-	GZMESSAGE(GZ_MESSAGE_WARNING, "Failed to invert local matrix to global");
+	GZ_INSTRUMENT_NAME("UCSWScene::onBuildPropertiesUpdate");
+
+	m_buildProperties.mergeLodLevels = MergeLodLevels;
+	m_buildProperties.optimizeVertexCache = OptimizeVertexCache;
+	m_buildProperties.partialGeometryUpdates = PartialGeometryUpdates;
+	m_buildProperties.dynamicMeshUpdateRate = DynamicMeshUpdateRate;
+	m_buildProperties.dynamicMeshIdleTime = DynamicMeshIdleTime;
+	m_buildProperties.prepareTextures = PrepareTextures;
+	m_buildProperties.compressTextures = CompressTextures && PrepareTextures;
+	m_buildProperties.textureMipResidency = useMipResidency();
+	m_buildProperties.textureCompressionHighQuality = TextureCompressionHighQuality;
+	m_buildProperties.textureCompressionMaxRMSE = FMath::Max(TextureCompressionMaxRMSE, 0.0f);
+	m_buildProperties.mipFilter = GenerateMips && PrepareTextures ? (KaiserMipFilter ? CSW_MIP_FILTER_KAISER : CSW_MIP_FILTER_BOX) : CSW_MIP_FILTER_NONE;
+
+	// Regions built from a replaced atlas keep it alive until they unload
+	const gzUInt32 pageSize = FMath::RoundUpToPowerOfTwo((uint32)FMath::Clamp(TextureAtlasPageSize, 512, 8192));
+
+	if (!TextureAtlas)
+		m_buildProperties.textureAtlas = nullptr;
+	else if (!m_buildProperties.textureAtlas || m_buildProperties.textureAtlas->getPageSize() != pageSize)
+		m_buildProperties.textureAtlas = new cswTextureAtlas(pageSize);
+
+	// Factories read a copy in prebuild. Applies to nodes built from now on
+	if (m_manager)
+		m_manager->setBuildProperties(m_buildProperties);
 
-	return gzMatrix4D::identityMatrix();
+	// Pixel release follows the atlas setting
+	return onResourcePropertiesUpdate();
 }
 
-gzMatrix4D UCSWScene::GZ_2_UE(enum CoordType type, const double& scale, const gzVec3D& offset) const
+bool UCSWScene::onResourcePropertiesUpdate()
 {
-	switch (type)
-	{
-		case CoordType::Geometry:
-			return cswMatrix4d::GZ_2_UE(-offset, scale);
-
-		case CoordType::Projected:
-		case CoordType::UTM:
-			return cswMatrix4d::GZ_UTM_2_UE(-offset, scale);
+	GZ_INSTRUMENT_NAME("UCSWScene::onResourcePropertiesUpdate");
 
-		default:
-			GZ_XXX;
+	if (m_resource)
+	{
+		m_resource->setTextureContentHash(TextureContentHash);
+		m_resource->setReleaseImagePixels(ReleaseImagePixels && !TextureAtlas);
+		m_resource->setTextureMipResidency(useMipResidency(), (gzUInt64)FMath::Max(TextureMemoryBudgetMB, 0) << 20, TextureResidencyBias);
 	}
 
-	return gzMatrix4D::identityMatrix();
+	return true;
 }
 
-
-FVector3d UCSWScene::GZ_2_UE(const gzVec3D& local,enum CoordType type, const double& scale , const gzVec3D& offset) const
+bool UCSWScene::useMipResidency() const
 {
-	return cswVector3d::UEVector3<double>(GZ_2_UE(type,scale,offset) * local);
+	return TextureMipResidency || MemoryBudgetMB > 0;
 }
 
-gzVec3D UCSWScene::UE_2_GZ(const FVector3d& global, enum CoordType type, const double& scale , const gzVec3D& offset) const
+bool UCSWScene::onCenterOriginPropertyUpdate()
 {
-	return  (gzVec3D) (UE_2_GZ(type,scale,offset) * cswVector3d::GZVector3<double>(global));
+	GZ_INSTRUMENT_NAME("UCSWScene::onCenterOriginPropertyUpdate");
+
+	invalidateGeoContext();
+
+	updateOriginTransform();
+
+	return true;
 }
 
-FVector3d UCSWScene::GZ_2_UE_Vector(const gzVec3D& vector, enum CoordType type, const double& scale) const
+bool UCSWScene::onGeoContextPropertyUpdate()
 {
-	// Vector conversion: no translation (offset = 0). Use scale for unit conversion if needed.
-	const gzMatrix4D mat = GZ_2_UE(type, scale, GZ_ZERO_VEC3D);
-	return cswVector3d::UEVector3<double>(mat * vector);
+	invalidateGeoContext();
+
+	return true;
 }
 
-gzVec3D UCSWScene::UE_2_GZ_Vector(const FVector3d& vector, enum CoordType type, const double& scale) const
+bool UCSWScene::onCoordTypePropertyUpdate()
 {
-	// Vector conversion: no translation (offset = 0). Use scale for unit conversion if needed.
-	const gzMatrix4D mat = UE_2_GZ(type, scale, GZ_ZERO_VEC3D);
-	return  (gzVec3D) (mat * cswVector3d::GZVector3<double>(vector));
-}
+	GZ_INSTRUMENT_NAME("UCSWScene::onCoordTypePropertyUpdate");
 
+	invalidateGeoContext();
 
-FVector3d UCSWScene::GZ_2_UE_Local(const gzVec3D& position) const
+	updateOriginTransform();
+
+	return onHeightCachePropertyUpdate();
+}
+
+bool UCSWScene::onHeightCachePropertyUpdate()
 {
-	// GZ position -> UE local, then add scene origin to get UE world
-	const FVector3d local = GZ_2_UE(position, CoordType, getWorldScale());
-	const FVector3d origin = FVector3d(GetRelativeLocation());
-	return local + origin;
+	GZ_INSTRUMENT_NAME("UCSWScene::onHeightCachePropertyUpdate");
+
+	// Grids are in the map x,z plane with y up
+	const bool supported = HeightCache && (CoordType == CoordType::Geometry || CoordType == CoordType::Projected || CoordType == CoordType::UTM);
+
+	if (!supported)
+		m_heightCache = nullptr;
+	else if (!m_heightCache)
+		m_heightCache = new cswHeightCache;
+
+	if (m_heightCache)
+		m_heightCache->setMaxAge(FMath::Max(HeightCacheMaxAge, 0.0f));
+
+	if (m_buildProperties.buildHeightTiles != supported)
+	{
+		m_buildProperties.buildHeightTiles = supported;
+
+		if (m_manager)
+			m_manager->setBuildProperties(m_buildProperties);
+	}
+
+	return true;
 }
 
-gzVec3D UCSWScene::UE_2_GZ_Local(const FVector3d& world) const
+// Height tile and intersect tree of a geometry or a merged LOD
+static void getQueryData(UCSWSceneComponent* component, gzNode* node, cswHeightTile*& heightTile, cswMeshBVH*& intersectTree)
 {
-	// UE world -> UE local (remove origin), then map to GZ position
-	const FVector3d origin = FVector3d(GetRelativeLocation());
-	const FVector3d local = world - origin;
-	return UE_2_GZ(local, CoordType, getWorldScale());
+	heightTile = nullptr;
+	intersectTree = nullptr;
+
+	gzReference* buildData = gzDynamic_Cast<gzReference*>(node->getAttribute(CSW_META, CSW_BUILD_DATA));
+
+	if (cswGeometryBuild* geometryBuild = component->IsA<UCSWGeometry>() ? gzDynamic_Cast<cswGeometryBuild>(buildData) : nullptr)
+	{
+		heightTile = geometryBuild->heightTile;
+		intersectTree = geometryBuild->intersectTree;
+	}
+	else if (cswLodBuild* lodBuild = component->IsA<UCSWLod>() ? gzDynamic_Cast<cswLodBuild>(buildData) : nullptr)
+	{
+		if (!lodBuild->staticMesh)
+			return;
+
+		heightTile = lodBuild->heightTile;
+		intersectTree = lodBuild->intersectTree;
+	}
 }
 
-bool UCSWScene::GeodeticToWorld(double latitudeDeg, double longitudeDeg, double altitudeMeters, FVector3d& outWorld) const
+void UCSWScene::updateHeightCache(UCSWSceneComponent* component, gzNode* node)
 {
-	if (CoordSystem.IsEmpty())
-		return false;
+	if (!m_heightCache || (!component->IsA<UCSWGeometry>() && !component->IsA<UCSWLod>()))
+		return;
 
-	gzCoordSystem system;
-	gzCoordSystemMetaData meta;
+	GZ_INSTRUMENT_NAME("UCSWScene::updateHeightCache");
 
-	if (!gzCoordinate::getCoordinateSystem(toString(CoordSystem), system, meta))
-		return false;
+	cswHeightTile* heightTile;
+	cswMeshBVH* intersectTree;
 
-	// Steg 1: lat/lon/alt (grader) -> gzLatPos (radianer)
-	// Steg 2: gzLatPos -> GZ position i kartans coord system (Gizmo)
-	// Steg 3: GZ position -> UE local via GZ_2_UE (CoordType + skala)
-	// Steg 4: lagg pa scenens origo (root transform). Offset hanteras dar.
+	getQueryData(component, node, heightTile, intersectTree);
 
-	gzLatPos latpos{ latitudeDeg, longitudeDeg, altitudeMeters };
-	latpos.DEG2RAD();
+	// Map placement from relative transforms up to the root. Only translated tiles are cached
+	FTransform transform = FTransform::Identity;
 
-	gzVec3D position;
+	for (USceneComponent* parent = component; parent && parent != this; parent = parent->GetAttachParent())
+		transform = transform * parent->GetRelativeTransform();
 
-	if (!gzCoordinate::get3DCoordinate(latpos, system, meta, position))
-		return false;
+	if (!heightTile || !transform.GetRotation().IsIdentity(1e-6) || !transform.GetScale3D().Equals(FVector::OneVector, 1e-6))
+	{
+		m_heightCache->removeTile(component);
+		return;
+	}
 
-	outWorld = GZ_2_UE_Local(position);
+	const FVector3d translation = transform.GetTranslation();
 
-	return true;
+	m_heightCache->addTile(component, heightTile, gzVec3D(translation.X, translation.Y, translation.Z) + m_floatingOffset, gzTime::systemSeconds());
 }
 
-bool UCSWScene::WorldToGeodetic(const FVector3d& world, double& outLatitudeDeg, double& outLongitudeDeg, double& outAltitudeMeters) const
+bool UCSWScene::sampleHeightCache(const gzVec3D& position, FCSWHeightResult& outResult)
 {
-	if (CoordSystem.IsEmpty())
+	cswHeightSample sample;
+
+	if (!m_heightCache || !m_heightCache->sample(position.v1, position.v3, gzTime::systemSeconds(), sample))
 		return false;
 
-	gzCoordSystem system;
-	gzCoordSystemMetaData meta;
+	outResult.bValid = true;
+	outResult.Altitude = sample.height;
+	outResult.WorldPosition = FVector(GZ_2_UE_Local(gzVec3D(position.v1, sample.height, position.v3)));
+	outResult.Source = sample.source == CSW_HEIGHT_SOURCE_TERRAIN ? ECSWHeightSource::Terrain : ECSWHeightSource::GroundClamp;
+	outResult.Accuracy = sample.accuracy;
+	outResult.Age = (float)sample.age;
+	outResult.bStale = (bool)sample.stale;
 
-	if (!gzCoordinate::getCoordinateSystem(toString(CoordSystem), system, meta))
-		return false;
+	return true;
+}
 
-	// Steg 1: UE world -> local (ta bort scenens origo)
-	// Steg 2: UE local -> GZ via UE_2_GZ (CoordType + skala)
-	// Steg 3: GZ position -> geodetic (lat/lon/alt)
-	// Offset hanteras av root transform, inte i UE_2_GZ anropet
+bool UCSWScene::GetGroundHeight(double latitudeDeg, double longitudeDeg, FCSWHeightResult& outResult, bool requestOnMiss)
+{
+	GZ_INSTRUMENT_NAME("UCSWScene::GetGroundHeight");
 
-	const gzVec3D position = UE_2_GZ_Local(world);
+	outResult = FCSWHeightResult();
 
-	gzLatPos latpos;
+	FVector3d world;
 
-	if (!gzCoordinate::getGlobalCoordinate(position, system, meta, latpos))
+	if (!GeodeticToWorld(latitudeDeg, longitudeDeg, 0, world))
 		return false;
 
-	latpos.RAD2DEG();
+	const bool hit = sampleHeightCache(UE_2_GZ_Local(world), outResult);
 
-	outLatitudeDeg = latpos.latitude;
-	outLongitudeDeg = latpos.longitude;
-	outAltitudeMeters = latpos.altitude;
+	// Async path refines the cache
+	if ((!hit || outResult.bStale) && requestOnMiss)
+		outResult.RequestId = RequestGroundClampPosition(latitudeDeg, longitudeDeg);
 
-	return true;
+	return hit;
 }
 
-
-bool UCSWScene::GeodeticToWorldBP(double latitudeDeg, double longitudeDeg, double altitudeMeters, FVector& outWorld) const
+bool UCSWScene::GetGroundHeightAtWorld(const FVector& world, FCSWHeightResult& outResult, bool requestOnMiss)
 {
-	FVector3d world3d;
-	if (!GeodeticToWorld(latitudeDeg, longitudeDeg, altitudeMeters, world3d))
-		return false;
-	outWorld = FVector(world3d);
-	return true;
+	GZ_INSTRUMENT_NAME("UCSWScene::GetGroundHeightAtWorld");
+
+	outResult = FCSWHeightResult();
+
+	const bool hit = sampleHeightCache(UE_2_GZ_Local(FVector3d(world)), outResult);
+
+	double latitude, longitude, altitude;
+
+	if ((!hit || outResult.bStale) && requestOnMiss && WorldToGeodetic(FVector3d(world), latitude, longitude, altitude))
+		outResult.RequestId = RequestGroundClampPosition(latitude, longitude);
+
+	return hit;
 }
 
-bool UCSWScene::WorldToGeodeticBP(const FVector& world, double& outLatitudeDeg, double& outLongitudeDeg, double& outAltitudeMeters) const
+FCSWHeightCacheStatistics UCSWScene::GetHeightCacheStatistics() const
 {
-	const FVector3d world3d(world);
-	return WorldToGeodetic(world3d, outLatitudeDeg, outLongitudeDeg, outAltitudeMeters);
+	FCSWHeightCacheStatistics result;
+
+	if (!m_heightCache)
+		return result;
+
+	cswHeightCacheStatistics statistics = m_heightCache->getStatistics();
+
+	result.Tiles = statistics.tiles;
+	result.ClampSamples = statistics.clampSamples;
+	result.Bytes = statistics.bytes;
+	result.Hits = statistics.hits;
+	result.Misses = statistics.misses;
+
+	return result;
 }
 
-int32 UCSWScene::RequestGroundClampPosition(double latitudeDeg, double longitudeDeg, double heightAboveGround, bool waitForData)
+bool UCSWScene::onAltitudeLookupPropertyUpdate()
 {
-	if (!m_manager)
+	GZ_INSTRUMENT_NAME("UCSWScene::onAltitudeLookupPropertyUpdate");
+
+	if (m_altitudeLookup)
 	{
-		GZMESSAGE(GZ_MESSAGE_WARNING, "Ground clamp request ignored: scene manager not initialized");
-		return 0;
+		m_altitudeLookup->stop(TRUE);
+		m_altitudeLookup = nullptr;
 	}
 
-	gzUInt32 requestId = 0;
+	if (AltitudeLookupDirectory.IsEmpty())
+		return true;
+
+	m_altitudeLookup = new gzAltitudeLookup;
+
+	if (!m_altitudeLookup->addDirectory(toString(AltitudeLookupDirectory), TRUE) || !m_altitudeLookup->getDatasetCount())
 	{
-		GZ_BODYGUARD(m_groundClampLock);
-		requestId = ++m_groundClampNextRequestId;
+		GZMESSAGE(GZ_MESSAGE_WARNING, "No altitude datasets found in (%s)", (const char*)toString(AltitudeLookupDirectory));
+		m_altitudeLookup = nullptr;
+		return true;
 	}
-	m_manager->requestGroundClampPosition(latitudeDeg, longitudeDeg, heightAboveGround, waitForData ? TRUE : FALSE, requestId);
-	return (int32)requestId;
+
+	// Thread purges datasets not used for a while
+	m_altitudeLookup->run();
+
+	return true;
 }
 
-bool UCSWScene::TryGetGroundClampResponse(int32 requestId, FCSWGroundClampResult& outResult)
+bool UCSWScene::onLocalIntersectPropertyUpdate()
 {
-	if (requestId <= 0)
+	GZ_INSTRUMENT_NAME("UCSWScene::onLocalIntersectPropertyUpdate");
+
+	if (!LocalIntersect)
+		m_sceneBVH = nullptr;
+	else if (!m_sceneBVH)
+		m_sceneBVH = new cswSceneBVH;
+
+	if (m_buildProperties.buildIntersectTrees != LocalIntersect)
+	{
+		m_buildProperties.buildIntersectTrees = LocalIntersect;
+
+		if (m_manager)
+			m_manager->setBuildProperties(m_buildProperties);
+	}
+
+	return true;
+}
+
+void UCSWScene::updateLocalIntersect(UCSWSceneComponent* component, gzNode* node)
+{
+	if (!m_sceneBVH || (!component->IsA<UCSWGeometry>() && !component->IsA<UCSWLod>()))
+		return;
+
+	GZ_INSTRUMENT_NAME("UCSWScene::updateLocalIntersect");
+
+	cswHeightTile* heightTile;
+	cswMeshBVH* intersectTree;
+
+	getQueryData(component, node, heightTile, intersectTree);
+
+	if (!intersectTree)
+	{
+		m_sceneBVH->remove(component);
+		return;
+	}
+
+	// Map placement from relative transforms up to the root like the height cache
+	FTransform transform = FTransform::Identity;
+
+	for (USceneComponent* parent = component; parent && parent != this; parent = parent->GetAttachParent())
+		transform = transform * parent->GetRelativeTransform();
+
+	transform.AddToTranslation(FVector3d(m_floatingOffset.v1, m_floatingOffset.v2, m_floatingOffset.v3));
+
+	m_sceneBVH->add(component, intersectTree, transform);
+}
+
+bool UCSWScene::IntersectSegment(const FVector& start, const FVector& end, FCSWLocalHit& outHit)
+{
+	GZ_INSTRUMENT_NAME("UCSWScene::IntersectSegment");
+
+	outHit = FCSWLocalHit();
+
+	if (!m_sceneBVH)
+		return false;
+
+	const gzVec3D from = UE_2_GZ_Local(FVector3d(start));
+	const gzVec3D to = UE_2_GZ_Local(FVector3d(end));
+
+	const FVector3d origin(from.v1, from.v2, from.v3);
+	const FVector3d delta(to.v1 - from.v1, to.v2 - from.v2, to.v3 - from.v3);
+
+	cswRayHit hit;
+
+	if (!m_sceneBVH->intersect(origin, delta, hit))
+		return false;
+
+	const FVector3d position = origin + delta * hit.t;
+	const gzVec3D normal = gzVec3D(hit.normal.X, hit.normal.Y, hit.normal.Z);
+
+	outHit.bHit = true;
+	outHit.WorldPosition = FVector(GZ_2_UE_Local(gzVec3D(position.X, position.Y, position.Z)));
+	outHit.WorldNormal = FVector(GZ_2_UE_Vector(normal, CoordType).GetSafeNormal());
+	outHit.Distance = FVector::Distance(start, outHit.WorldPosition);
+	outHit.Component = hit.component;
+
+	return true;
+}
+
+bool UCSWScene::IntersectRay(const FVector& start, const FVector& direction, double maxDistance, FCSWLocalHit& outHit)
+{
+	return IntersectSegment(start, start + direction.GetSafeNormal() * maxDistance, outHit);
+}
+
+FCSWLocalIntersectStatistics UCSWScene::GetLocalIntersectStatistics() const
+{
+	FCSWLocalIntersectStatistics result;
+
+	if (!m_sceneBVH)
+		return result;
+
+	cswSceneBVHStatistics statistics = m_sceneBVH->getStatistics();
+
+	result.Components = statistics.components;
+	result.Meshes = statistics.meshes;
+	result.Triangles = statistics.triangles;
+	result.Bytes = statistics.bytes;
+	result.Queries = statistics.queries;
+	result.Hits = statistics.hits;
+
+	return result;
+}
+
+void  UCSWScene::updateOriginTransform()
+{
+	if (!AllowCustomOrigin)
+	{
+		FTransform m;
+
+		// map SCENE content in Gizmo World to UE world with or without origin
+
+		gzVec3D origin = CenterOrigin ? UE_2_GZ(FVector3d(ModelOriginX, ModelOriginY, ModelOriginZ), CoordType, getWorldScale()) : GZ_ZERO_VEC3D;
+
+		// Top level rois are placed relative to the floating origin
+
+		origin = origin - m_floatingOffset;
+
+		// Move children negative origin so our map origin ends up in 0,0,0
+
+		m.SetFromMatrix(cswMatrix4_<double>::UEMatrix4(GZ_2_UE(CoordType, getWorldScale(), origin)));
+
+		// Apply Transform to root
+
+		SetRelativeTransform(m);
+	}
+}
+
+bool UCSWScene::onFloatingOriginPropertyUpdate()
+{
+	GZ_INSTRUMENT_NAME("UCSWScene::onFloatingOriginPropertyUpdate");
+
+	// Back to the fixed origin when disabled
+	updateFloatingOrigin(m_floatingOffset);
+
+	return true;
+}
+
+void UCSWScene::trackFloatingOrigin(UCSWSceneComponent* component, bool add)
+{
+	if (UCSWRoiNode* roi = Cast<UCSWRoiNode>(component))
+	{
+		if (!add)
+			m_topLevelRois.Remove(roi);
+		else if (roi->isTopLevel())
+			m_topLevelRois.Add(roi);
+	}
+	else if (component->IsA<UCSWGeometry>() || component->IsA<UCSWLod>())
+	{
+		if (!add)
+			m_outsideRoiContent.Remove(component);
+		else if (!UCSWRoiNode::findRoi(component))
+		{
+			m_outsideRoiContent.Add(component);
+
+			// Built relative to the fixed origin
+			if (m_floatingOffset.length() > 0)
+				rebaseFloatingOrigin(GZ_ZERO_VEC3D);
+		}
+	}
+}
+
+void UCSWScene::updateFloatingOrigin(const gzVec3D& camera)
+{
+	if (!FloatingOrigin || AllowCustomOrigin || m_outsideRoiContent.Num())
+	{
+		if (m_floatingOffset.length() > 0)
+			rebaseFloatingOrigin(GZ_ZERO_VEC3D);
+
+		return;
+	}
+
+	if ((camera - m_floatingOffset).length() > FloatingOriginDistance)
+		rebaseFloatingOrigin(camera);
+}
+
+void UCSWScene::rebaseFloatingOrigin(const gzVec3D& offset)
+{
+	GZ_INSTRUMENT_NAME("UCSWScene::rebaseFloatingOrigin");
+
+	m_floatingOffset = offset;
+
+	// Rois built from now on get the new offset
+	m_buildProperties.roiOffset = offset;
+
+	for (UCSWRoiNode* roi : m_topLevelRois)
+		roi->rebase(offset);
+
+	updateOriginTransform();
+
+	m_floatingOriginRebases++;
+}
+
+FVector3d UCSWScene::getMapLocation() const
+{
+	return FVector3d(GetRelativeLocation()) - GZ_2_UE_Vector(m_floatingOffset, CoordType, getWorldScale());
+}
+
+static gzMatrix4D createGZ_2_UE(enum CoordType type, const double& scale, const gzVec3D& offset)
+{
+	switch (type)
+	{
+		case CoordType::Geometry:
+			return cswMatrix4d::GZ_2_UE(-offset, scale);
+
+		case CoordType::Projected:
+		case CoordType::UTM:
+			return cswMatrix4d::GZ_UTM_2_UE(-offset, scale);
+
+		default:
+			GZ_XXX;
+	}
+
+	return gzMatrix4D::identityMatrix();
+}
+
+static gzMatrix4D invert(const gzMatrix4D& matrix)
+{
+	gzMatrix4D mat;
+
+	if (matrix.inverse(mat))
+		return mat;
+
+	GZMESSAGE(GZ_MESSAGE_WARNING, "Failed to invert local matrix to global");
+
+	return gzMatrix4D::identityMatrix();
+}
+
+const cswMatrixCacheEntry& UCSWScene::getMatrices(enum CoordType type, const double& scale, const gzVec3D& offset) const
+{
+	for (const cswMatrixCacheEntry& entry : m_matrixCache)
+	{
+		if (entry.valid && entry.type == type && entry.scale == scale && entry.offset.v1 == offset.v1 && entry.offset.v2 == offset.v2 && entry.offset.v3 == offset.v3)
+			return entry;
+	}
+
+	GZ_INSTRUMENT_NAME("UCSWScene::getMatrices");
+
+	// Round robin. Camera, origin and geo info use few combinations
+	cswMatrixCacheEntry& entry = m_matrixCache[m_matrixCacheNext++ % UE_ARRAY_COUNT(m_matrixCache)];
+
+	entry.type = type;
+	entry.scale = scale;
+	entry.offset = offset;
+
+	entry.gzToUE = createGZ_2_UE(type, scale, offset);
+	entry.ueToGZ = invert(entry.gzToUE);
+
+	entry.gzToUERotation = createGZ_2_UE(type, scale, GZ_ZERO_VEC3D);
+	entry.ueToGZRotation = invert(entry.gzToUERotation);
+
+	entry.valid = TRUE;
+
+	return entry;
+}
+
+const cswMatrixCacheEntry& UCSWScene::getRotationMatrices(enum CoordType type, const double& scale) const
+{
+	// Any offset shares the rotation part
+	for (const cswMatrixCacheEntry& entry : m_matrixCache)
+	{
+		if (entry.valid && entry.type == type && entry.scale == scale)
+			return entry;
+	}
+
+	return getMatrices(type, scale, GZ_ZERO_VEC3D);
+}
+
+gzMatrix4D UCSWScene::UE_2_GZ(enum CoordType type, const double& scale, const gzVec3D& offset) const
+{
+	return getMatrices(type, scale, offset).ueToGZ;
+}
+
+gzMatrix4D UCSWScene::GZ_2_UE(enum CoordType type, const double& scale, const gzVec3D& offset) const
+{
+	return getMatrices(type, scale, offset).gzToUE;
+}
+
+
+FVector3d UCSWScene::GZ_2_UE(const gzVec3D& local,enum CoordType type, const double& scale , const gzVec3D& offset) const
+{
+	return cswVector3d::UEVector3<double>(getMatrices(type, scale, offset).gzToUE * local);
+}
+
+gzVec3D UCSWScene::UE_2_GZ(const FVector3d& global, enum CoordType type, const double& scale , const gzVec3D& offset) const
+{
+	return  (gzVec3D) (getMatrices(type, scale, offset).ueToGZ * cswVector3d::GZVector3<double>(global));
+}
+
+FVector3d UCSWScene::GZ_2_UE_Vector(const gzVec3D& vector, enum CoordType type, const double& scale) const
+{
+	// Vector conversion: no translation (offset = 0). Use scale for unit conversion if needed.
+	const gzMatrix4D& mat = getRotationMatrices(type, scale).gzToUERotation;
+	return cswVector3d::UEVector3<double>(mat * vector);
+}
+
+gzVec3D UCSWScene::UE_2_GZ_Vector(const FVector3d& vector, enum CoordType type, const double& scale) const
+{
+	// Vector conversion: no translation (offset = 0). Use scale for unit conversion if needed.
+	const gzMatrix4D& mat = getRotationMatrices(type, scale).ueToGZRotation;
+	return  (gzVec3D) (mat * cswVector3d::GZVector3<double>(vector));
+}
+
+
+FVector3d UCSWScene::GZ_2_UE_Local(const gzVec3D& position) const
+{
+	// GZ position -> UE local, then add scene origin to get UE world
+	const FVector3d local = GZ_2_UE(position, CoordType, getWorldScale());
+	const FVector3d origin = getMapLocation();
+	return local + origin;
+}
+
+gzVec3D UCSWScene::UE_2_GZ_Local(const FVector3d& world) const
+{
+	// UE world -> UE local (remove origin), then map to GZ position
+	const FVector3d origin = getMapLocation();
+	const FVector3d local = world - origin;
+	return UE_2_GZ(local, CoordType, getWorldScale());
+}
+
+// Kernel output in map coordinates. UTM maps use the default swizzle, east x, up y and north -z
+static void kernelForward(const cswGeoContext& context, const double* latitude, const double* longitude, const double* altitude, int32 count, double* x, double* y, double* z)
+{
+	if (context.system.type == GZ_COORDTYPE_UTM)
+	{
+		cswGeodeticToUTM(latitude, longitude, count, context.centralMeridian, context.falseNorthing, x, z);
+
+		for (int32 i = 0; i < count; i++)
+		{
+			y[i] = altitude[i];
+			z[i] = -z[i];
+		}
+	}
+	else
+	{
+		cswGeodeticToGeocentric(latitude, longitude, altitude, count, x, y, z);
+	}
+}
+
+// Overwrites z for UTM
+static void kernelInverse(const cswGeoContext& context, const double* x, const double* y, double* z, int32 count, double* latitude, double* longitude, double* altitude)
+{
+	if (context.system.type == GZ_COORDTYPE_UTM)
+	{
+		for (int32 i = 0; i < count; i++)
+		{
+			z[i] = -z[i];
+			altitude[i] = y[i];
+		}
+
+		cswUTMToGeodetic(x, z, count, context.centralMeridian, context.falseNorthing, latitude, longitude);
+	}
+	else
+	{
+		cswGeocentricToGeodetic(x, y, z, count, latitude, longitude, altitude);
+	}
+}
+
+// Largest difference in meters between the kernels and gzCoordinate around the origin, both ways
+static double kernelError(const cswGeoContext& context, const gzLatPos& origin)
+{
+	double error = 0;
+
+	for (int32 i = 0; i < 18; i++)
+	{
+		gzLatPos latpos{ origin.latitude + (i % 3 - 1) * 0.25 * GZ_DEG2RAD, origin.longitude + (i / 3 % 3 - 1) * 0.25 * GZ_DEG2RAD, i < 9 ? 0.0 : 2000.0 };
+
+		gzVec3D expected;
+
+		if (!gzCoordinate::get3DCoordinate(latpos, context.system, context.meta, expected))
+			return -1;
+
+		double x, y, z;
+
+		kernelForward(context, &latpos.latitude, &latpos.longitude, &latpos.altitude, 1, &x, &y, &z);
+
+		error = FMath::Max(error, (gzVec3D(x, y, z) - expected).length());
+
+		gzLatPos global;
+
+		if (!gzCoordinate::getGlobalCoordinate(expected, context.system, context.meta, global))
+			return -1;
+
+		double latitude, longitude, altitude;
+
+		x = expected.v1;
+		y = expected.v2;
+		z = expected.v3;
+
+		kernelInverse(context, &x, &y, &z, 1, &latitude, &longitude, &altitude);
+
+		error = FMath::Max(error, FMath::Abs(latitude - global.latitude) * 6378137.0);
+		error = FMath::Max(error, FMath::Abs(longitude - global.longitude) * 6378137.0 * FMath::Cos(global.latitude));
+		error = FMath::Max(error, FMath::Abs(altitude - global.altitude));
+	}
+
+	return error;
+}
+
+// UTM zones are 0-59 in gzCoordinate, zone 0 centered on -177 degrees
+static void kernelMeridian(cswGeoContext& context)
+{
+	context.centralMeridian = (context.meta.utm.zone * 6 - 177) * GZ_DEG2RAD;
+	context.falseNorthing = context.meta.utm.north ? 0.0 : 10000000.0;
+}
+
+// Enable the batch kernels when they match gzCoordinate to sub millimetre near the origin
+static void validateKernel(cswGeoContext& context, const gzVec3D& origin)
+{
+	context.kernel = FALSE;
+	context.kernelError = -1;
+
+	if (context.system.datum != GZ_GEODETIC_DATUM_WGS84_ELLIPSOID)
+		return;
+
+	if (context.system.type != GZ_COORDTYPE_GEOCENTRIC && context.system.type != GZ_COORDTYPE_UTM)
+		return;
+
+	gzLatPos latpos;
+
+	if (!gzCoordinate::getGlobalCoordinate(origin, context.system, context.meta, latpos))
+		return;
+
+	kernelMeridian(context);
+
+	context.kernelError = kernelError(context, latpos);
+
+	if (context.kernelError < 0)
+		return;
+
+	if (context.kernelError < 1e-3)
+	{
+		GZMESSAGE(GZ_MESSAGE_DEBUG, "Geo batch kernels enabled, %.6f m from gzCoordinate", context.kernelError);
+
+		context.kernel = TRUE;
+		return;
+	}
+
+	GZMESSAGE(GZ_MESSAGE_NOTICE, "Geo batch kernels differ %.4f m from gzCoordinate. Using gzCoordinate", context.kernelError);
+}
+
+double UCSWScene::CheckGeoKernels(double Latitude, double Longitude) const
+{
+	const gzLatPos latpos{ Latitude * GZ_DEG2RAD, Longitude * GZ_DEG2RAD, 0.0 };
+
+	cswGeoContext context;
+
+	context.system.datum = GZ_GEODETIC_DATUM_WGS84_ELLIPSOID;
+	context.system.projection = GZ_PROJ_UTM;
+	context.system.type = GZ_COORDTYPE_GEOCENTRIC;
+
+	const double geocentric = kernelError(context, latpos);
+
+	// The zone containing the point
+	context.system.type = GZ_COORDTYPE_UTM;
+	context.meta.utm.zone = FMath::Clamp((int32)FMath::FloorToDouble((Longitude + 180.0) / 6.0), 0, 59);
+	context.meta.utm.north = Latitude >= 0;
+
+	kernelMeridian(context);
+
+	const double utm = kernelError(context, latpos);
+
+	if (geocentric < 0 || utm < 0)
+		return -1;
+
+	return FMath::Max(geocentric, utm);
+}
+
+// Altitudes from the origin covered by the tangent expansion
+static const double TANGENT_HEIGHT = 5000.0;
+
+// Inverse iterations stop below this residual in meters
+static const double TANGENT_CONVERGED = 1e-4;
+static const int32	TANGENT_STEPS = 8;
+
+// Offset from the tangent origin, expanded to second order
+static gzVec3D tangentExpand(const cswGeoContext& c, const double d[3])
+{
+	const double q[6] = { d[0] * d[0], d[1] * d[1], d[2] * d[2], 2 * d[0] * d[1], 2 * d[0] * d[2], 2 * d[1] * d[2] };
+
+	double p[3];
+
+	for (int32 k = 0; k < 3; k++)
+	{
+		p[k] = c.tangentJacobian[k][0] * d[0] + c.tangentJacobian[k][1] * d[1] + c.tangentJacobian[k][2] * d[2];
+
+		for (int32 j = 0; j < 6; j++)
+			p[k] += 0.5 * c.tangentHessian[k][j] * q[j];
+	}
+
+	return c.tangentPosition + gzVec3D(p[0], p[1], p[2]);
+}
+
+static bool insideTangent(const cswGeoContext& c, const double d[3], double margin = 1.0)
+{
+	const double north = d[0] * c.tangentScale[0];
+	const double east = d[1] * c.tangentScale[1];
+	const double radius = c.tangentRadius * margin;
+
+	return north * north + east * east <= radius * radius && FMath::Abs(d[2]) <= TANGENT_HEIGHT * margin;
+}
+
+// Inverse of tangentExpand. The linear estimate is checked against the radius before fixed point steps
+// on the curvature. False if outside or if the residual stays above the tolerance
+static bool tangentSolve(const cswGeoContext& c, const gzVec3D& position, double d[3])
+{
+	const gzVec3D offset = position - c.tangentPosition;
+
+	for (int32 k = 0; k < 3; k++)
+		d[k] = c.tangentInverse[k][0] * offset.v1 + c.tangentInverse[k][1] * offset.v2 + c.tangentInverse[k][2] * offset.v3;
+
+	// Curvature moves the result a little. Far outside is not worth iterating
+	if (!insideTangent(c, d, 1.25))
+		return false;
+
+	double residual = 0;
+
+	for (int32 step = 0; step < TANGENT_STEPS; step++)
+	{
+		const gzVec3D error = tangentExpand(c, d) - position;
+
+		residual = error.length();
+
+		if (residual <= TANGENT_CONVERGED)
+			return true;
+
+		for (int32 k = 0; k < 3; k++)
+			d[k] -= c.tangentInverse[k][0] * error.v1 + c.tangentInverse[k][1] * error.v2 + c.tangentInverse[k][2] * error.v3;
+	}
+
+	residual = (tangentExpand(c, d) - position).length();
+
+	return residual <= c.tangentTolerance;
+}
+
+// Latitude and longitude in radians. False outside the radius
+static bool tangentForward(const cswGeoContext& c, const gzLatPos& latpos, gzVec3D& position)
+{
+	const double d[3] = { latpos.latitude - c.tangentOrigin.latitude, FMath::UnwindRadians(latpos.longitude - c.tangentOrigin.longitude), latpos.altitude - c.tangentOrigin.altitude };
+
+	if (!insideTangent(c, d))
+		return false;
+
+	position = tangentExpand(c, d);
+
+	return true;
+}
+
+static bool tangentInverse(const cswGeoContext& c, const gzVec3D& position, gzLatPos& latpos)
+{
+	double d[3];
+
+	if (!tangentSolve(c, position, d) || !insideTangent(c, d))
+		return false;
+
+	latpos.latitude = c.tangentOrigin.latitude + d[0];
+	latpos.longitude = FMath::UnwindRadians(c.tangentOrigin.longitude + d[1]);
+	latpos.altitude = c.tangentOrigin.altitude + d[2];
+
+	return true;
+}
+
+static bool mapPosition(const cswGeoContext& c, const double d[3], gzVec3D& position)
+{
+	const gzLatPos latpos{ c.tangentOrigin.latitude + d[0], c.tangentOrigin.longitude + d[1], c.tangentOrigin.altitude + d[2] };
+
+	return gzCoordinate::get3DCoordinate(latpos, c.system, c.meta, position);
+}
+
+// Largest forward and inverse error in meters on a ring at the current radius. Solves that fail count as errors
+static double tangentRingError(cswGeoContext& c, double ring, int32 directions, int32 altitudes)
+{
+	double error = 0;
+
+	for (int32 i = 0; i < directions * altitudes; i++)
+	{
+		// Directions of the altitude rows are staggered so dense checks do not repeat search samples
+		const double angle = ((i % directions) + 0.5 * ((i / directions) & 1)) * 2 * PI / directions;
+
+		const double altitude = altitudes > 1 ? (2.0 * (i / directions) / (altitudes - 1) - 1) * TANGENT_HEIGHT : 0;
+
+		const double d[3] = { ring * FMath::Cos(angle) / c.tangentScale[0], ring * FMath::Sin(angle) / c.tangentScale[1], altitude };
+
+		gzVec3D exact;
+
+		if (!mapPosition(c, d, exact))
+			return DBL_MAX;
+
+		error = FMath::Max(error, (tangentExpand(c, d) - exact).length());
+
+		double solved[3];
+
+		if (!tangentSolve(c, exact, solved))
+			return DBL_MAX;
+
+		error = FMath::Max(error, FMath::Abs(solved[0] - d[0]) * c.tangentScale[0]);
+		error = FMath::Max(error, FMath::Abs(solved[1] - d[1]) * c.tangentScale[1]);
+		error = FMath::Max(error, FMath::Abs(solved[2] - d[2]));
+	}
+
+	return error;
+}
+
+// Derivatives of the map at the origin by central differences, then the radius where forward and inverse
+// reach the tolerance. Doubling brackets it, bisection finds the crossover and a dense check confirms it
+static void createTangent(cswGeoContext& c, const gzVec3D& origin, double tolerance)
+{
+	c.tangent = FALSE;
+	c.tangentRadius = 0;
+	c.tangentTolerance = tolerance;
+
+	// Angles are not meters
+	if (tolerance <= 0 || c.system.type == GZ_COORDTYPE_GEODETIC)
+		return;
+
+	if (!gzCoordinate::getGlobalCoordinate(origin, c.system, c.meta, c.tangentOrigin))
+		return;
+
+	const double zero[3] = { 0, 0, 0 };
+
+	if (!mapPosition(c, zero, c.tangentPosition))
+		return;
+
+	const double step[3] = { 2e-4, 2e-4, 100.0 };
+
+	const int32 pairs[6][2] = { { 0, 0 }, { 1, 1 }, { 2, 2 }, { 0, 1 }, { 0, 2 }, { 1, 2 } };
+
+	for (int32 i = 0; i < 3; i++)
+	{
+		double plus[3] = { 0, 0, 0 }, minus[3] = { 0, 0, 0 };
+
+		plus[i] = step[i];
+		minus[i] = -step[i];
+
+		gzVec3D p, m;
+
+		if (!mapPosition(c, plus, p) || !mapPosition(c, minus, m))
+			return;
+
+		const gzVec3D first = (p - m) * (0.5 / step[i]);
+		const gzVec3D second = (p - c.tangentPosition * 2.0 + m) * (1.0 / (step[i] * step[i]));
+
+		c.tangentJacobian[0][i] = first.v1;
+		c.tangentJacobian[1][i] = first.v2;
+		c.tangentJacobian[2][i] = first.v3;
+
+		c.tangentHessian[0][i] = second.v1;
+		c.tangentHessian[1][i] = second.v2;
+		c.tangentHessian[2][i] = second.v3;
+	}
+
+	for (int32 j = 3; j < 6; j++)
+	{
+		const int32 a = pairs[j][0], b = pairs[j][1];
+
+		gzVec3D corner[4];
+
+		for (int32 k = 0; k < 4; k++)
+		{
+			double d[3] = { 0, 0, 0 };
+
+			d[a] = (k & 1) ? -step[a] : step[a];
+			d[b] = (k & 2) ? -step[b] : step[b];
+
+			if (!mapPosition(c, d, corner[k]))
+				return;
+		}
+
+		const gzVec3D mixed = (corner[0] - corner[1] - corner[2] + corner[3]) * (1.0 / (4 * step[a] * step[b]));
+
+		c.tangentHessian[0][j] = mixed.v1;
+		c.tangentHessian[1][j] = mixed.v2;
+		c.tangentHessian[2][j] = mixed.v3;
+	}
+
+	const double (*J)[3] = c.tangentJacobian;
+
+	const double det = J[0][0] * (J[1][1] * J[2][2] - J[1][2] * J[2][1]) - J[0][1] * (J[1][0] * J[2][2] - J[1][2] * J[2][0]) + J[0][2] * (J[1][0] * J[2][1] - J[1][1] * J[2][0]);
+
+	if (FMath::Abs(det) < 1e-9)
+		return;
+
+	for (int32 r = 0; r < 3; r++)
+	{
+		for (int32 k = 0; k < 3; k++)
+		{
+			const int32 r1 = (k + 1) % 3, r2 = (k + 2) % 3, c1 = (r + 1) % 3, c2 = (r + 2) % 3;
+
+			c.tangentInverse[r][k] = (J[r1][c1] * J[r2][c2] - J[r1][c2] * J[r2][c1]) / det;
+		}
+	}
+
+	c.tangentScale[0] = FMath::Sqrt(J[0][0] * J[0][0] + J[1][0] * J[1][0] + J[2][0] * J[2][0]);
+	c.tangentScale[1] = FMath::Sqrt(J[0][1] * J[0][1] + J[1][1] * J[1][1] + J[2][1] * J[2][1]);
+
+	if (c.tangentScale[0] <= 0 || c.tangentScale[1] <= 0)
+		return;
+
+	// Error grows with the square of the radius, so rings at the radius bound the disc
+	auto passes = [&](double radius, int32 directions, int32 altitudes)
+	{
+		c.tangentRadius = radius;
+
+		return tangentRingError(c, radius, directions, altitudes) <= tolerance;
+	};
+
+	double good = 0, bad = 0;
+
+	for (double radius = 250.0; radius <= 64000.0; radius *= 2)
+	{
+		if (!passes(radius, 16, 5))
+		{
+			bad = radius;
+			break;
+		}
+
+		good = radius;
+	}
+
+	if (good > 0 && bad > 0)
+	{
+		for (int32 i = 0; i < 8; i++)
+		{
+			const double radius = 0.5 * (good + bad);
+
+			if (passes(radius, 16, 5))
+				good = radius;
+			else
+				bad = radius;
+		}
+	}
+
+	// Crossover found on sparse rings. Confirm with dense rings at and inside it and back off if needed
+	for (int32 i = 0; i < 8 && good > 0; i++)
+	{
+		if (passes(good, 64, 9) && passes(good * 0.75, 32, 5) && passes(good * 0.5, 32, 5))
+			break;
+
+		good = i < 7 ? good * 0.9 : 0;
+	}
+
+	c.tangentRadius = good;
+
+	c.tangent = c.tangentRadius > 0;
+
+	GZMESSAGE(GZ_MESSAGE_DEBUG, "Geo tangent radius %.0f m for %.4f m tolerance", c.tangentRadius, tolerance);
+}
+
+double UCSWScene::CheckGeoTangent(int32 Samples) const
+{
+	const cswGeoContext* context = getGeoContext();
+
+	if (!context || !context->tangent)
+		return -1;
+
+	FRandomStream random(Samples);
+
+	double error = 0;
+
+	for (int32 i = 0; i < Samples; i++)
+	{
+		// Every fourth sample just outside, the others uniform over the outer ring where the error is largest
+		const bool outside = (i & 3) == 3;
+
+		const double ring = context->tangentRadius * (outside ? 1.05 : FMath::Sqrt(random.FRandRange(0.81f, 1.0f)));
+		const double angle = random.FRandRange(0.0f, 2 * PI);
+		const double altitude = random.FRandRange(-1.0f, 1.0f) * TANGENT_HEIGHT;
+
+		const gzLatPos latpos{ context->tangentOrigin.latitude + ring * FMath::Cos(angle) / context->tangentScale[0], context->tangentOrigin.longitude + ring * FMath::Sin(angle) / context->tangentScale[1], context->tangentOrigin.altitude + altitude };
+
+		gzVec3D exact, position;
+
+		if (!gzCoordinate::get3DCoordinate(latpos, context->system, context->meta, exact))
+			return DBL_MAX;
+
+		gzLatPos solved;
+
+		const bool forward = tangentForward(*context, latpos, position);
+		const bool inverse = tangentInverse(*context, exact, solved);
+
+		if (outside)
+		{
+			if (forward)
+				return DBL_MAX;
+
+			continue;
+		}
+
+		// The inverse may fall back near the edge, the forward expansion must not
+		if (!forward)
+			return DBL_MAX;
+
+		error = FMath::Max(error, (position - exact).length());
+
+		if (inverse)
+		{
+			error = FMath::Max(error, FMath::Abs(solved.latitude - latpos.latitude) * context->tangentScale[0]);
+			error = FMath::Max(error, FMath::Abs(FMath::UnwindRadians(solved.longitude - latpos.longitude)) * context->tangentScale[1]);
+			error = FMath::Max(error, FMath::Abs(solved.altitude - latpos.altitude));
+		}
+	}
+
+	return error;
+}
+
+const cswGeoContext* UCSWScene::getGeoContext() const
+{
+	const double scale = getWorldScale();
+
+	if (!m_geoContext.valid || m_geoContext.type != CoordType || m_geoContext.scale != scale)
+	{
+		GZ_INSTRUMENT_NAME("UCSWScene::getGeoContext");
+
+		m_geoContext.hasSystem = !CoordSystem.IsEmpty() && gzCoordinate::getCoordinateSystem(toString(CoordSystem), m_geoContext.system, m_geoContext.meta);
+
+		m_geoContext.type = CoordType;
+		m_geoContext.scale = scale;
+		m_geoContext.gzToUE = GZ_2_UE(CoordType, scale);
+		m_geoContext.ueToGZ = UE_2_GZ(CoordType, scale);
+
+		if (m_geoContext.hasSystem)
+		{
+			const gzVec3D origin = UE_2_GZ(FVector3d(ModelOriginX, ModelOriginY, ModelOriginZ), CoordType, scale);
+
+			validateKernel(m_geoContext, origin);
+			createTangent(m_geoContext, origin, GeoTangentTolerance);
+		}
+
+		m_geoContext.valid = TRUE;
+	}
+
+	return m_geoContext.hasSystem ? &m_geoContext : nullptr;
+}
+
+void UCSWScene::invalidateGeoContext()
+{
+	m_geoContext.valid = FALSE;
+}
+
+// Scalar and batch conversions share these. No scene state is touched so they run on workers too
+static bool geodeticToWorld(const cswGeoContext& context, const FVector3d& origin, double latitudeDeg, double longitudeDeg, double altitudeMeters, FVector3d& outWorld)
+{
+	// Steg 1: lat/lon/alt (grader) -> gzLatPos (radianer)
+	// Steg 2: gzLatPos -> GZ position i kartans coord system (Gizmo)
+	// Steg 3: GZ position -> UE local via GZ_2_UE (CoordType + skala)
+	// Steg 4: lagg pa scenens origo (root transform). Offset hanteras dar.
+
+	gzLatPos latpos{ latitudeDeg, longitudeDeg, altitudeMeters };
+	latpos.DEG2RAD();
+
+	gzVec3D position;
+
+	if (!(context.tangent && tangentForward(context, latpos, position)) && !gzCoordinate::get3DCoordinate(latpos, context.system, context.meta, position))
+		return false;
+
+	outWorld = cswVector3d::UEVector3<double>(context.gzToUE * position) + origin;
+
+	return true;
+}
+
+static bool worldToGeodetic(const cswGeoContext& context, const FVector3d& origin, const FVector3d& world, gzLatPos& latpos)
+{
+	// Steg 1: UE world -> local (ta bort scenens origo)
+	// Steg 2: UE local -> GZ via UE_2_GZ (CoordType + skala)
+	// Steg 3: GZ position -> geodetic (lat/lon/alt)
+	// Offset hanteras av root transform, inte i UE_2_GZ anropet
+
+	const gzVec3D position = (gzVec3D)(context.ueToGZ * cswVector3d::GZVector3<double>(world - origin));
+
+	if (!(context.tangent && tangentInverse(context, position, latpos)) && !gzCoordinate::getGlobalCoordinate(position, context.system, context.meta, latpos))
+		return false;
+
+	latpos.RAD2DEG();
+
+	return true;
+}
+
+// Items per worker task in batch conversions
+static const int32 GEO_BATCH_SIZE = 1024;
+
+bool UCSWScene::GeodeticToWorld(double latitudeDeg, double longitudeDeg, double altitudeMeters, FVector3d& outWorld) const
+{
+	const cswGeoContext* context = getGeoContext();
+
+	if (!context)
+		return false;
+
+	return geodeticToWorld(*context, getMapLocation(), latitudeDeg, longitudeDeg, altitudeMeters, outWorld);
+}
+
+bool UCSWScene::WorldToGeodetic(const FVector3d& world, double& outLatitudeDeg, double& outLongitudeDeg, double& outAltitudeMeters) const
+{
+	const cswGeoContext* context = getGeoContext();
+
+	if (!context)
+		return false;
+
+	gzLatPos latpos;
+
+	if (!worldToGeodetic(*context, getMapLocation(), world, latpos))
+		return false;
+
+	outLatitudeDeg = latpos.latitude;
+	outLongitudeDeg = latpos.longitude;
+	outAltitudeMeters = latpos.altitude;
+
+	return true;
+}
+
+
+int32 UCSWScene::GeodeticToWorldBatch(TConstArrayView<double> latitudesDeg, TConstArrayView<double> longitudesDeg, TConstArrayView<double> altitudesMeters, FCSWWorldPositions& outWorld) const
+{
+	GZ_INSTRUMENT_NAME("UCSWScene::GeodeticToWorldBatch");
+
+	const int32 count = latitudesDeg.Num();
+
+	outWorld.X.SetNumZeroed(count);
+	outWorld.Y.SetNumZeroed(count);
+	outWorld.Z.SetNumZeroed(count);
+	outWorld.Valid.SetNumZeroed(count);
+
+	if (longitudesDeg.Num() != count || (altitudesMeters.Num() && altitudesMeters.Num() != count))
+	{
+		GZMESSAGE(GZ_MESSAGE_WARNING, "GeodeticToWorldBatch: latitude, longitude and altitude counts differ");
+		return 0;
+	}
+
+	const cswGeoContext* context = getGeoContext();
+
+	if (!context || !count)
+		return 0;
+
+	const FVector3d origin(getMapLocation());
+
+	const int32 tasks = FMath::DivideAndRoundUp(count, GEO_BATCH_SIZE);
+
+	ParallelFor(tasks, [&](int32 task)
+		{
+			const int32 first = task * GEO_BATCH_SIZE;
+			const int32 last = FMath::Min(count, first + GEO_BATCH_SIZE);
+
+			if (context->kernel)
+			{
+				const int32 num = last - first;
+
+				TArray<double> buffer;
+				buffer.SetNumUninitialized(num * 6);
+
+				double* latitude = buffer.GetData();
+				double* longitude = latitude + num;
+				double* altitude = longitude + num;
+				double* x = altitude + num;
+				double* y = x + num;
+				double* z = y + num;
+
+				for (int32 i = 0; i < num; i++)
+				{
+					latitude[i] = latitudesDeg[first + i] * GZ_DEG2RAD;
+					longitude[i] = longitudesDeg[first + i] * GZ_DEG2RAD;
+					altitude[i] = altitudesMeters.Num() ? altitudesMeters[first + i] : 0.0;
+				}
+
+				kernelForward(*context, latitude, longitude, altitude, num, x, y, z);
+
+				for (int32 i = 0; i < num; i++)
+				{
+					// Kernels have no status. Points they cannot map come out non finite and take the scalar path
+					FVector3d world;
+
+					if (FMath::IsFinite(x[i]) && FMath::IsFinite(y[i]) && FMath::IsFinite(z[i]))
+						world = cswVector3d::UEVector3<double>(context->gzToUE * gzVec3D(x[i], y[i], z[i])) + origin;
+					else if (!geodeticToWorld(*context, origin, latitudesDeg[first + i], longitudesDeg[first + i], altitude[i], world))
+						continue;
+
+					outWorld.X[first + i] = world.X;
+					outWorld.Y[first + i] = world.Y;
+					outWorld.Z[first + i] = world.Z;
+					outWorld.Valid[first + i] = true;
+				}
+
+				return;
+			}
+
+			for (int32 i = first; i < last; i++)
+			{
+				FVector3d world;
+
+				if (!geodeticToWorld(*context, origin, latitudesDeg[i], longitudesDeg[i], altitudesMeters.Num() ? altitudesMeters[i] : 0.0, world))
+					continue;
+
+				outWorld.X[i] = world.X;
+				outWorld.Y[i] = world.Y;
+				outWorld.Z[i] = world.Z;
+				outWorld.Valid[i] = true;
+			}
+		}, tasks == 1 ? EParallelForFlags::ForceSingleThread : EParallelForFlags::None);
+
+	int32 converted = 0;
+
+	for (bool valid : outWorld.Valid)
+		converted += valid;
+
+	return converted;
+}
+
+int32 UCSWScene::WorldToGeodeticBatch(TConstArrayView<FVector3d> world, FCSWGeodeticPositions& outGeodetic) const
+{
+	GZ_INSTRUMENT_NAME("UCSWScene::WorldToGeodeticBatch");
+
+	const int32 count = world.Num();
+
+	outGeodetic.Latitude.SetNumZeroed(count);
+	outGeodetic.Longitude.SetNumZeroed(count);
+	outGeodetic.Altitude.SetNumZeroed(count);
+	outGeodetic.Valid.SetNumZeroed(count);
+
+	const cswGeoContext* context = getGeoContext();
+
+	if (!context || !count)
+		return 0;
+
+	const FVector3d origin(getMapLocation());
+
+	const int32 tasks = FMath::DivideAndRoundUp(count, GEO_BATCH_SIZE);
+
+	ParallelFor(tasks, [&](int32 task)
+		{
+			const int32 first = task * GEO_BATCH_SIZE;
+			const int32 last = FMath::Min(count, first + GEO_BATCH_SIZE);
+
+			if (context->kernel)
+			{
+				const int32 num = last - first;
+
+				TArray<double> buffer;
+				buffer.SetNumUninitialized(num * 6);
+
+				double* x = buffer.GetData();
+				double* y = x + num;
+				double* z = y + num;
+				double* latitude = z + num;
+				double* longitude = latitude + num;
+				double* altitude = longitude + num;
+
+				for (int32 i = 0; i < num; i++)
+				{
+					const gzVec3D position = (gzVec3D)(context->ueToGZ * cswVector3d::GZVector3<double>(world[first + i] - origin));
+
+					x[i] = position.v1;
+					y[i] = position.v2;
+					z[i] = position.v3;
+				}
+
+				kernelInverse(*context, x, y, z, num, latitude, longitude, altitude);
+
+				for (int32 i = 0; i < num; i++)
+				{
+					if (FMath::IsFinite(latitude[i]) && FMath::IsFinite(longitude[i]) && FMath::IsFinite(altitude[i]))
+					{
+						outGeodetic.Latitude[first + i] = latitude[i] * GZ_RAD2DEG;
+						outGeodetic.Longitude[first + i] = longitude[i] * GZ_RAD2DEG;
+						outGeodetic.Altitude[first + i] = altitude[i];
+					}
+					else
+					{
+						gzLatPos latpos;
+
+						if (!worldToGeodetic(*context, origin, world[first + i], latpos))
+							continue;
+
+						outGeodetic.Latitude[first + i] = latpos.latitude;
+						outGeodetic.Longitude[first + i] = latpos.longitude;
+						outGeodetic.Altitude[first + i] = latpos.altitude;
+					}
+
+					outGeodetic.Valid[first + i] = true;
+				}
+
+				return;
+			}
+
+			for (int32 i = first; i < last; i++)
+			{
+				gzLatPos latpos;
+
+				if (!worldToGeodetic(*context, origin, world[i], latpos))
+					continue;
+
+				outGeodetic.Latitude[i] = latpos.latitude;
+				outGeodetic.Longitude[i] = latpos.longitude;
+				outGeodetic.Altitude[i] = latpos.altitude;
+				outGeodetic.Valid[i] = true;
+			}
+		}, tasks == 1 ? EParallelForFlags::ForceSingleThread : EParallelForFlags::None);
+
+	int32 converted = 0;
+
+	for (bool valid : outGeodetic.Valid)
+		converted += valid;
+
+	return converted;
+}
+
+int32 UCSWScene::GeodeticToWorldBatchBP(const TArray<double>& latitudesDeg, const TArray<double>& longitudesDeg, const TArray<double>& altitudesMeters, FCSWWorldPositions& outWorld) const
+{
+	return GeodeticToWorldBatch(latitudesDeg, longitudesDeg, altitudesMeters, outWorld);
+}
+
+int32 UCSWScene::WorldToGeodeticBatchBP(const TArray<FVector>& world, FCSWGeodeticPositions& outGeodetic) const
+{
+	return WorldToGeodeticBatch(world, outGeodetic);
+}
+
+bool UCSWScene::GeodeticToWorldBP(double latitudeDeg, double longitudeDeg, double altitudeMeters, FVector& outWorld) const
+{
+	FVector3d world3d;
+	if (!GeodeticToWorld(latitudeDeg, longitudeDeg, altitudeMeters, world3d))
+		return false;
+	outWorld = FVector(world3d);
+	return true;
+}
+
+bool UCSWScene::WorldToGeodeticBP(const FVector& world, double& outLatitudeDeg, double& outLongitudeDeg, double& outAltitudeMeters) const
+{
+	const FVector3d world3d(world);
+	return WorldToGeodetic(world3d, outLatitudeDeg, outLongitudeDeg, outAltitudeMeters);
+}
+
+int32 UCSWScene::RequestGroundClampPosition(double latitudeDeg, double longitudeDeg, double heightAboveGround, bool waitForData)
+{
+	if (!m_manager)
+	{
+		GZMESSAGE(GZ_MESSAGE_WARNING, "Ground clamp request ignored: scene manager not initialized");
+		return 0;
+	}
+
+	gzUInt32 requestId = 0;
+	{
+		GZ_BODYGUARD(m_groundClampLock);
+		requestId = ++m_groundClampNextRequestId;
+	}
+	m_manager->requestGroundClampPosition(latitudeDeg, longitudeDeg, heightAboveGround, waitForData ? TRUE : FALSE, requestId);
+	return (int32)requestId;
+}
+
+bool UCSWScene::GetApproximateGroundPosition(double latitudeDeg, double longitudeDeg, FCSWGroundClampResult& outResult)
+{
+	GZ_INSTRUMENT_NAME("UCSWScene::GetApproximateGroundPosition");
+
+	outResult = FCSWGroundClampResult();
+	outResult.bApproximate = true;
+
+	if (!m_altitudeLookup)
+		return false;
+
+	gzBool ok = FALSE;
+
+	const gzDouble altitude = m_altitudeLookup->getAltitude(latitudeDeg * GZ_DEG2RAD, longitudeDeg * GZ_DEG2RAD, TRUE, &ok);
+
+	FVector3d world, above;
+
+	if (!ok || !GeodeticToWorld(latitudeDeg, longitudeDeg, altitude, world) || !GeodeticToWorld(latitudeDeg, longitudeDeg, altitude + 1, above))
+		return false;
+
+	outResult.bSuccess = true;
+	outResult.Altitude = altitude;
+	outResult.WorldPosition = FVector(world);
+
+	// No slope from the DEM samples. Normal is up
+	outResult.WorldUp = FVector(above - world).GetSafeNormal();
+	outResult.WorldNormal = outResult.WorldUp;
+
+	return true;
+}
+
+int32 UCSWScene::RequestGroundClampApproximate(double latitudeDeg, double longitudeDeg, FCSWGroundClampResult& outApproximate, double heightAboveGround, bool waitForData)
+{
+	GZ_INSTRUMENT_NAME("UCSWScene::RequestGroundClampApproximate");
+
+	const gzDouble start = gzTime::systemSeconds();
+
+	const bool valid = GetApproximateGroundPosition(latitudeDeg, longitudeDeg, outApproximate);
+
+	const gzDouble approximated = gzTime::systemSeconds();
+
+	const int32 requestId = RequestGroundClampPosition(latitudeDeg, longitudeDeg, heightAboveGround, waitForData);
+
+	outApproximate.RequestId = requestId;
+
+	if (!requestId)
+		return 0;
+
+	m_approximateClampCounters.requests++;
+
+	if (valid)
+	{
+		m_approximateClampCounters.approximated++;
+		m_approximateClampCounters.approximateSeconds += approximated - start;
+	}
+
+	cswApproximateClamp pending;
+
+	pending.altitude = outApproximate.Altitude;
+	pending.time = start;
+	pending.valid = valid;
+
+	// Responses are handled on the game thread so this is in place before it arrives
+	{
+		GZ_BODYGUARD(m_groundClampLock);
+		m_approximateClamps.Add((gzUInt32)requestId, pending);
+	}
+
+	return requestId;
+}
+
+FCSWApproximateClampStatistics UCSWScene::GetApproximateClampStatistics() const
+{
+	FCSWApproximateClampStatistics result;
+
+	const cswApproximateClampCounters& counters = m_approximateClampCounters;
+
+	result.Datasets = m_altitudeLookup ? m_altitudeLookup->getDatasetCount() : 0;
+	result.Requests = counters.requests;
+	result.Approximated = counters.approximated;
+	result.Refined = counters.refined;
+	result.MeanApproximateMilliseconds = counters.approximated ? 1000.0 * counters.approximateSeconds / counters.approximated : 0.0;
+	result.MeanRefinedMilliseconds = counters.refined ? 1000.0 * counters.refinedSeconds / counters.refined : 0.0;
+	result.MeanError = counters.errorSamples ? counters.errorSum / counters.errorSamples : 0.0;
+	result.MaxError = counters.errorMax;
+
+	return result;
+}
+
+int32 UCSWScene::RequestGroundClampBatch(TConstArrayView<double> latitudesDeg, TConstArrayView<double> longitudesDeg, double heightAboveGround, bool waitForData)
+{
+	GZ_INSTRUMENT_NAME("UCSWScene::RequestGroundClampBatch");
+
+	if (!m_manager)
+	{
+		GZMESSAGE(GZ_MESSAGE_WARNING, "Ground clamp batch ignored: scene manager not initialized");
+		return 0;
+	}
+
+	const int32 count = latitudesDeg.Num();
+
+	if (!count || longitudesDeg.Num() != count)
+	{
+		GZMESSAGE(GZ_MESSAGE_WARNING, "Ground clamp batch ignored: latitude and longitude counts differ or are empty");
+		return 0;
+	}
+
+	cswGroundClampBatch batch;
+
+	batch.result.WorldPositions.SetNumZeroed(count);
+	batch.result.WorldNormals.Init(FVector::UpVector, count);
+	batch.result.Altitudes.SetNumZeroed(count);
+	batch.result.Valid.SetNumZeroed(count);
+
+	gzUInt32 requestId = 0;
+	gzUInt32 firstId = 0;
+	{
+		GZ_BODYGUARD(m_groundClampLock);
+
+		// One id for the batch followed by one per point
+		requestId = ++m_groundClampNextRequestId;
+		firstId = m_groundClampNextRequestId + 1;
+		m_groundClampNextRequestId += (gzUInt32)count;
+
+		batch.firstId = firstId;
+		batch.result.RequestId = (int32)requestId;
+
+		m_groundClampBatches.Add(MoveTemp(batch));
+	}
+
+	for (int32 i = 0; i < count; i++)
+		m_manager->requestGroundClampPosition(latitudesDeg[i], longitudesDeg[i], heightAboveGround, waitForData ? TRUE : FALSE, firstId + (gzUInt32)i);
+
+	return (int32)requestId;
+}
+
+int32 UCSWScene::RequestGroundClampBatchBP(const TArray<double>& latitudesDeg, const TArray<double>& longitudesDeg, double heightAboveGround, bool waitForData)
+{
+	return RequestGroundClampBatch(latitudesDeg, longitudesDeg, heightAboveGround, waitForData);
+}
+
+bool UCSWScene::TryGetGroundClampBatchResponse(int32 requestId, FCSWGroundClampBatchResult& outResult)
+{
+	if (requestId <= 0)
+		return false;
+
+	GZ_BODYGUARD(m_groundClampLock);
+
+	return m_groundClampBatchResponses.RemoveAndCopyValue((gzUInt32)requestId, outResult);
+}
+
+int32 UCSWScene::RequestRayIntersections(TConstArrayView<FVector3d> starts, TConstArrayView<FVector3d> directions, double maxDistance, int32 intersectMask, bool waitForData)
+{
+	GZ_INSTRUMENT_NAME("UCSWScene::RequestRayIntersections");
+
+	const int32 count = starts.Num();
+
+	if (!count || directions.Num() != count || maxDistance <= 0)
+	{
+		GZMESSAGE(GZ_MESSAGE_WARNING, "Ray intersections ignored: start and direction counts differ, are empty or no distance");
+		return 0;
+	}
+
+	TArray<gzVec3D> rays;
+	rays.SetNumUninitialized(count);
+
+	for (int32 i = 0; i < count; i++)
+		rays[i] = UE_2_GZ_Vector(directions[i].GetSafeNormal() * maxDistance, CoordType, getWorldScale());
+
+	return requestIntersections(TArray<FVector3d>(starts.GetData(), count), rays, TArray<double>(), intersectMask, waitForData);
+}
+
+int32 UCSWScene::RequestRayIntersectionsBP(const TArray<FVector>& starts, const TArray<FVector>& directions, double maxDistance, int32 intersectMask, bool waitForData)
+{
+	return RequestRayIntersections(starts, directions, maxDistance, intersectMask, waitForData);
+}
+
+int32 UCSWScene::RequestLineOfSight(TConstArrayView<FVector3d> from, TConstArrayView<FVector3d> to, int32 intersectMask, bool waitForData)
+{
+	GZ_INSTRUMENT_NAME("UCSWScene::RequestLineOfSight");
+
+	const int32 count = from.Num();
+
+	if (!count || to.Num() != count)
+	{
+		GZMESSAGE(GZ_MESSAGE_WARNING, "Line of sight ignored: from and to counts differ or are empty");
+		return 0;
+	}
+
+	TArray<gzVec3D> rays;
+	TArray<double> lengths;
+
+	rays.SetNumUninitialized(count);
+	lengths.SetNumUninitialized(count);
+
+	for (int32 i = 0; i < count; i++)
+	{
+		rays[i] = UE_2_GZ_Vector(to[i] - from[i], CoordType, getWorldScale());
+		lengths[i] = (to[i] - from[i]).Size();
+	}
+
+	return requestIntersections(TArray<FVector3d>(from.GetData(), count), rays, MoveTemp(lengths), intersectMask, waitForData);
+}
+
+int32 UCSWScene::RequestLineOfSightBP(const TArray<FVector>& from, const TArray<FVector>& to, int32 intersectMask, bool waitForData)
+{
+	return RequestLineOfSight(from, to, intersectMask, waitForData);
+}
+
+int32 UCSWScene::requestIntersections(TArray<FVector3d>&& starts, const TArray<gzVec3D>& rays, TArray<double>&& lengths, int32 intersectMask, bool waitForData)
+{
+	if (!m_manager)
+	{
+		GZMESSAGE(GZ_MESSAGE_WARNING, "Intersection request ignored: scene manager not initialized");
+		return 0;
+	}
+
+	const int32 count = starts.Num();
+
+	TArray<gzVec3D> startsGZ;
+	startsGZ.SetNumUninitialized(count);
+
+	for (int32 i = 0; i < count; i++)
+		startsGZ[i] = UE_2_GZ_Local(starts[i]);
+
+	cswIntersectBatch batch;
+
+	batch.starts = MoveTemp(starts);
+	batch.lengths = MoveTemp(lengths);
+
+	batch.result.bLineOfSight = batch.lengths.Num() > 0;
+	batch.result.Hit.SetNumZeroed(count);
+	batch.result.WorldPositions.SetNumZeroed(count);
+	batch.result.WorldNormals.Init(FVector::UpVector, count);
+	batch.result.Distances.SetNumZeroed(count);
+
+	if (batch.result.bLineOfSight)
+		batch.result.Visible.SetNumZeroed(count);
+
+	gzUInt32 requestId = 0;
+	gzUInt32 firstId = 0;
+	{
+		GZ_BODYGUARD(m_groundClampLock);
+
+		// One id for the request followed by one per ray
+		requestId = ++m_groundClampNextRequestId;
+		firstId = m_groundClampNextRequestId + 1;
+		m_groundClampNextRequestId += (gzUInt32)count;
+
+		batch.firstId = firstId;
+		batch.result.RequestId = (int32)requestId;
+
+		m_intersectBatches.Add(MoveTemp(batch));
+	}
+
+	for (int32 i = 0; i < count; i++)
+		m_manager->intersect(startsGZ[i], gzVec3((gzFloat)rays[i].v1, (gzFloat)rays[i].v2, (gzFloat)rays[i].v3), waitForData ? TRUE : FALSE, firstId + (gzUInt32)i, (gzIntersectMaskValue)intersectMask);
+
+	return (int32)requestId;
+}
+
+bool UCSWScene::TryGetIntersectResponse(int32 requestId, FCSWIntersectResult& outResult)
+{
+	if (requestId <= 0)
+		return false;
+
+	GZ_BODYGUARD(m_groundClampLock);
+
+	return m_intersectResponses.RemoveAndCopyValue((gzUInt32)requestId, outResult);
+}
+
+void UCSWScene::handleIntersectResponse(cswSceneCommandIntersectResponse* response)
+{
+	if (!response)
+		return;
+
+	const gzUInt32 refId = response->getCommandRefID();
+
+	const bool hit = (bool)response->getStatus();
+
+	const FVector3d position = hit ? GZ_2_UE_Local(response->getPosition()) : FVector3d::ZeroVector;
+	const FVector3d normal = hit ? GZ_2_UE_Vector((gzVec3D)response->getNormal(), CoordType, getWorldScale()).GetSafeNormal() : FVector3d::UpVector;
+
+	FCSWIntersectResult completed;
+
+	{
+		GZ_BODYGUARD(m_groundClampLock);
+
+		for (int32 i = 0; i < m_intersectBatches.Num(); i++)
+		{
+			cswIntersectBatch& batch = m_intersectBatches[i];
+
+			const int32 index = (int32)(refId - batch.firstId);
+
+			if (refId < batch.firstId || index >= batch.result.Hit.Num())
+				continue;
+
+			// UE units from the hit position
+			const double distance = hit ? (position - batch.starts[index]).Size() : 0;
+
+			batch.result.Hit[index] = hit;
+			batch.result.WorldPositions[index] = FVector(position);
+			batch.result.WorldNormals[index] = FVector(normal);
+			batch.result.Distances[index] = distance;
+
+			if (hit)
+				batch.result.Hits++;
+
+			// A hit at the end point itself does not block
+			if (batch.result.bLineOfSight)
+				batch.result.Visible[index] = !hit || distance >= batch.lengths[index] - FMath::Max(1.0, batch.lengths[index] * 1e-4);
+
+			if (++batch.received == batch.result.Hit.Num())
+			{
+				completed = MoveTemp(batch.result);
+				m_intersectBatches.RemoveAtSwap(i);
+				m_intersectResponses.Add((gzUInt32)completed.RequestId, completed);
+			}
+
+			break;
+		}
+	}
+
+	if (completed.RequestId)
+		OnIntersectResponse.Broadcast(completed);
+}
+
+FCSWBuildStatistics UCSWScene::GetBuildStatistics() const
+{
+	FCSWBuildStatistics result;
+
+	cswBuildStatistics* statistics = m_buildProperties.statistics;
+
+	if (!statistics)
+		return result;
+
+	result.Meshes = statistics->meshes;
+	result.MeshesFailed = statistics->meshesFailed;
+	result.Meshes16Bit = statistics->meshes16Bit;
+	result.Vertices = statistics->vertices;
+	result.IndexBytes = statistics->indexBytes;
+	result.IndexBytesSaved = (int64)statistics->sourceIndexBytes - (int64)statistics->indexBytes;
+
+	if (const gzUInt64 triangles = statistics->vertexCacheTriangles)
+	{
+		result.VertexCacheACMRBefore = (double)statistics->vertexCacheMissesBefore / triangles;
+		result.VertexCacheACMRAfter = (double)statistics->vertexCacheMissesAfter / triangles;
+	}
+
+	result.TexturesPrepared = statistics->texturesPrepared;
+	result.TexturePrepareMilliseconds = statistics->texturePrepareMicroseconds / 1000.0;
+
+	result.TexturesCompressed = statistics->texturesCompressed;
+	result.TexturesCompressionRejected = statistics->texturesCompressionRejected;
+	result.TextureCompressionBytesSaved = statistics->textureCompressionBytesSaved;
+
+	result.TexturesMipGenerated = statistics->texturesMipGenerated;
+
+	result.IntersectTrees = statistics->intersectTrees;
+	result.IntersectTreeMilliseconds = statistics->intersectTreeMicroseconds / 1000.0;
+	result.IntersectTreeBytes = statistics->intersectTreeBytes;
+
+	return result;
+}
+
+bool UCSWScene::CheckPartialGeometryUpdate() const
+{
+	BuildProperties buildProperties = m_buildProperties;
+
+	buildProperties.fastBuild = true;
+	buildProperties.partialGeometryUpdates = true;
+	buildProperties.dynamicMeshUpdateRate = 0;
+	buildProperties.prepareTextures = false;
+	buildProperties.textureAtlas = nullptr;
+	buildProperties.statistics = nullptr;
+	buildProperties.buildHeightTiles = false;
+	buildProperties.buildIntersectTrees = false;
+
+	gzGeometryPtr geom = new gzGeometry("csw partial update check");
+
+	geom->setGeoPrimType(GZ_PRIM_TRIS);
+
+	gzArray<gzVec3>& coordinates = geom->getCoordinateArray();
+
+	coordinates.setSize(12);
+
+	// Fan around a center that moves inside the bounds
+	const gzVec3 corners[4] = { gzVec3(0, 0, 0), gzVec3(1, 0, 0), gzVec3(1, 0, 1), gzVec3(0, 0, 1) };
+
+	for (gzUInt32 i = 0; i < 4; i++)
+	{
+		coordinates[i * 3] = gzVec3(0.5f, 0, 0.5f);
+		coordinates[i * 3 + 1] = corners[i];
+		coordinates[i * 3 + 2] = corners[(i + 1) % 4];
+	}
+
+	auto moveCenter = [&](gzFloat x)
+	{
+		gzArray<gzVec3>& moved = geom->getCoordinateArray();
+
+		for (gzUInt32 i = 0; i < 4; i++)
+			moved[i * 3] = gzVec3(x, 0, 0.5f);
+
+		geom->updateID();
+	};
+
+	auto update = [&](gzReference* existing) -> cswGeometryBuild*
+	{
+		GZ_EDIT_GUARD;
+
+		return gzDynamic_Cast<cswGeometryBuild>(cswFactory::updateReference(geom, 0, nullptr, 0, nullptr, existing, buildProperties));
+	};
+
+	cswGeometryBuildPtr initial;
+
+	{
+		GZ_EDIT_GUARD;
+
+		initial = gzDynamic_Cast<cswGeometryBuild>(cswFactory::preBuildReference(geom, 0, nullptr, 0, nullptr, buildProperties));
+	}
+
+	if (!initial || !initial->staticMesh)
+		return false;
+
+	initial->shown = true;
+
+	// Initial builds have no fingerprint. This one has and is never shown
+	moveCenter(0.4f);
+
+	cswGeometryBuildPtr full = update(initial);
+
+	if (!full || full->delta || !full->staticMesh || !full->fingerprint)
+		return false;
+
+	moveCenter(0.6f);
+
+	cswGeometryBuildPtr rebuilt = update(full);
+
+	if (!rebuilt || rebuilt->delta || !rebuilt->staticMesh || rebuilt->staticMesh == full->staticMesh)
+		return false;
+
+	// As UCSWGeometry::update does when it shows the mesh
+	rebuilt->shown = true;
+
+	moveCenter(0.45f);
+
+	cswGeometryBuildPtr partial = update(rebuilt);
+
+	return partial && partial->delta && partial->staticMesh == rebuilt->staticMesh;
+}
+
+FCSWResourceStatistics UCSWScene::GetResourceStatistics() const
+{
+	FCSWResourceStatistics result;
+
+	if (!m_resource)
+		return result;
+
+	cswResourceStatistics statistics = m_resource->getStatistics();
+
+	result.TextureUploads = statistics.textureUploads;
+	result.TextureUploadBytes = statistics.textureUploadBytes;
+	result.TextureCacheHits = statistics.textureCacheHits;
+	result.TextureBytesSaved = statistics.textureBytesSaved;
+
+	result.TextureResidentBytes = statistics.textureResidentBytes;
+	result.TextureReleasedBytes = statistics.textureReleasedBytes;
+	result.TextureMemoryBytes = statistics.textureMemoryBytes;
+
+	result.TextureGameThreadMilliseconds = statistics.textureGameThreadMicroseconds / 1000.0;
+	result.PreparedUploads = statistics.preparedUploads;
+
+	result.ResidentTextures = statistics.residentTextures;
+	result.MipStoreBytes = statistics.mipStoreBytes;
+	result.MipResidentBytes = statistics.mipResidentBytes;
+	result.MipUpdates = statistics.mipUpdates;
+	result.MipBudgetDrops = statistics.mipBudgetDrops;
+
+	result.AtlasUploads = statistics.atlasUploads;
+	result.AtlasUploadBytes = statistics.atlasUploadBytes;
+
+	result.MaterialInstances = statistics.materialInstances;
+	result.MaterialCacheHits = statistics.materialCacheHits;
+	result.MaterialsInUse = statistics.materialsInUse;
+	result.MaterialReferences = statistics.materialReferences;
+	result.MaterialsLive = statistics.materialsLive;
+	result.MaterialBytes = statistics.materialBytes;
+
+	return result;
+}
+
+FCSWAtlasStatistics UCSWScene::GetAtlasStatistics() const
+{
+	FCSWAtlasStatistics result;
+
+	cswTextureAtlas* atlas = m_buildProperties.textureAtlas;
+
+	if (!atlas)
+		return result;
+
+	cswAtlasStatistics statistics = atlas->getStatistics();
+
+	result.Pages = statistics.pages;
+	result.Regions = statistics.regions;
+	result.Allocations = statistics.allocations;
+	result.UsedTexels = statistics.usedTexels;
+	result.FreeTexels = statistics.freeTexels;
+	result.LargestFreeTexels = statistics.largestFreeTexels;
+	result.Fragmentation = statistics.fragmentation;
+	result.ReleasedPages = statistics.releasedPages;
+
+	return result;
+}
+
+FCSWMemoryBudgetStatistics UCSWScene::GetMemoryBudgetStatistics() const
+{
+	FCSWMemoryBudgetStatistics result;
+
+	if (!m_budget)
+		return result;
+
+	cswMemoryBudgetStatistics statistics = m_budget->getStatistics();
+
+	result.BudgetBytes = statistics.budgetBytes;
+	result.UsedBytes = statistics.usedBytes;
+	result.MeshBytes = statistics.meshBytes;
+	result.TextureBytes = statistics.textureBytes;
+	result.MaterialBytes = statistics.materialBytes;
+	result.Materials = statistics.materials;
+	result.Components = statistics.components;
+	result.EvictedComponents = statistics.evictedComponents;
+	result.Pressure = statistics.pressure;
+	result.LodFactorScale = statistics.lodFactorScale;
+	result.Evictions = statistics.evictions;
+	result.Restores = statistics.restores;
+	result.LodRaises = statistics.lodRaises;
+	result.LodLowers = statistics.lodLowers;
+
+	return result;
+}
+
+void UCSWScene::ReleaseEmptyAtlasPages()
+{
+	if (m_resource)
+		m_resource->releaseEmptyAtlasPages();
+}
+
+bool UCSWScene::TryGetGroundClampResponse(int32 requestId, FCSWGroundClampResult& outResult)
+{
+	if (requestId <= 0)
 		return false;
 
 	{
@@ -1314,11 +3305,75 @@ void UCSWScene::handleGroundClampResponse(cswSceneCommandGroundClampPositionResp
 	result.WorldNormal = FVector(worldNormal).GetSafeNormal();
 	result.WorldUp = FVector(worldUp).GetSafeNormal();
 
+	if (m_heightCache && result.bSuccess)
+		m_heightCache->addClampSample(positionGZ, gzTime::systemSeconds());
+
+	// Points of a batch are collected and the batch is reported once
+	const gzUInt32 refId = response->getCommandRefID();
+
+	FCSWGroundClampBatchResult completed;
+	bool inBatch = false;
+
 	{
 		GZ_BODYGUARD(m_groundClampLock);
-		m_groundClampResponses.Add((gzUInt32)result.RequestId, result);
+
+		cswApproximateClamp approximate;
+
+		// Refines an approximate answer of the same request
+		if (m_approximateClamps.RemoveAndCopyValue(refId, approximate) && result.bSuccess)
+		{
+			cswApproximateClampCounters& counters = m_approximateClampCounters;
+
+			counters.refined++;
+			counters.refinedSeconds += gzTime::systemSeconds() - approximate.time;
+
+			if (approximate.valid)
+			{
+				result.ApproximationError = result.Altitude - approximate.altitude;
+
+				counters.errorSamples++;
+				counters.errorSum += FMath::Abs(result.ApproximationError);
+				counters.errorMax = FMath::Max(counters.errorMax, FMath::Abs(result.ApproximationError));
+			}
+		}
+
+		for (int32 i = 0; i < m_groundClampBatches.Num(); i++)
+		{
+			cswGroundClampBatch& batch = m_groundClampBatches[i];
+
+			const int32 index = (int32)(refId - batch.firstId);
+
+			if (refId < batch.firstId || index >= batch.result.Valid.Num())
+				continue;
+
+			inBatch = true;
+
+			batch.result.WorldPositions[index] = result.WorldPosition;
+			batch.result.WorldNormals[index] = result.WorldNormal;
+			batch.result.Altitudes[index] = result.Altitude;
+			batch.result.Valid[index] = result.bSuccess;
+
+			if (result.bSuccess)
+				batch.result.Clamped++;
+
+			if (++batch.received == batch.result.Valid.Num())
+			{
+				completed = MoveTemp(batch.result);
+				m_groundClampBatches.RemoveAtSwap(i);
+				m_groundClampBatchResponses.Add((gzUInt32)completed.RequestId, completed);
+			}
+
+			break;
+		}
+
+		if (!inBatch)
+			m_groundClampResponses.Add((gzUInt32)result.RequestId, result);
 	}
-	OnGroundClampResponse.Broadcast(result);
+
+	if (!inBatch)
+		OnGroundClampResponse.Broadcast(result);
+	else if (completed.RequestId)
+		OnGroundClampBatchResponse.Broadcast(completed);
 }
 
 double UCSWScene::getWorldScale() const
@@ -0,0 +1,362 @@
+//*****************************************************************************
+//
+// Copyright (C) SAAB AB
+//
+// All rights, including the copyright, to the computer program(s)
+// herein belong to SAAB AB. The program(s) may be used and/or
+// copied only with the written permission of SAAB AB, or in
+// accordance with the terms and conditions stipulated in the
+// agreement/contract under which the program(s) have been
+// supplied.
+//
+//
+// Information Class:	COMPANY UNCLASSIFIED
+// Defence Secrecy:		NOT CLASSIFIED
+// Export Control:		NOT EXPORT CONTROLLED
+//
+//
+// File			: cswTextureAtlas.cpp
+// Module		: CSW StreamingMap Unreal
+// Description	: Shared texture pages for small tile images
+// Author		: agent
+// Product		: CSW 1.1.2
+//
+//
+//
+// NOTE:	CSW (Common Synthetic World) is a simulation and presentation
+//			framework for large scale digital twins on multiple platforms
+//
+//
+// Revision History...
+//
+// Who	Date	Description
+//
+// AGT	261019	Created file 					(1.1.3)
+//
+//******************************************************************************
+#include "cswTextureAtlas.h"
+#include "UEGlue/cswUEUtility.h"
+#include "gzPerformance.h"
+
+#include <atomic>
+
+GZ_DECLARE_TYPE_CHILD(gzReference, cswAtlasRegion, "cswAtlasRegion");
+GZ_DECLARE_TYPE_CHILD(gzReference, cswTextureAtlas, "cswTextureAtlas");
+
+// Page textures are keyed by id so ids stay unique when the atlas is replaced
+static std::atomic<gzUInt32> s_nextPageId(1);
+
+cswAtlasRegion::~cswAtlasRegion()
+{
+	if (m_atlas)
+		m_atlas->free(page, x, y, size);
+}
+
+cswTextureAtlas::cswTextureAtlas(gzUInt32 pageSize, gzUInt32 minTileSize, gzUInt32 maxTileSize)
+{
+	m_pageSize = FMath::RoundUpToPowerOfTwo(FMath::Max(pageSize, 64u));
+	m_minTileSize = FMath::Clamp((gzUInt32)FMath::RoundUpToPowerOfTwo(minTileSize), 4u, m_pageSize);
+	m_maxTileSize = FMath::Clamp((gzUInt32)FMath::RoundUpToPowerOfTwo(maxTileSize), m_minTileSize, m_pageSize / 2);
+
+	m_levels = FMath::FloorLog2(m_pageSize / m_minTileSize) + 1;
+}
+
+gzUInt32 cswTextureAtlas::levelOf(gzUInt32 size) const
+{
+	return FMath::FloorLog2(m_pageSize / size);
+}
+
+gzUInt32 cswTextureAtlas::pageMipLevels() const
+{
+	// Stop while the smallest tile is 4 texels so filtering bleeds at most one texel
+	return FMath::FloorLog2(m_minTileSize / 4) + 1;
+}
+
+bool cswTextureAtlas::validImage(gzImage* image, EPixelFormat format, gzUInt32 mipLevels)
+{
+	const FPixelFormatInfo& info = GPixelFormats[format];
+
+	const gzUInt32 width = image->getWidth();
+	const gzUInt32 height = image->getHeight();
+
+	for (gzUInt32 mip = 0; mip < mipLevels; mip++)
+	{
+		gzImage* level = mip ? image->getSubImage(mip - 1) : image;
+
+		if (!level)
+			return false;
+
+		const gzUInt32 levelWidth = FMath::Max(width >> mip, 1u);
+		const gzUInt32 levelHeight = FMath::Max(height >> mip, 1u);
+
+		if (level->getWidth() != levelWidth || level->getHeight() != levelHeight)
+			return false;
+
+		// Page regions are written in whole compression blocks
+		if (levelWidth % info.BlockSizeX || levelHeight % info.BlockSizeY)
+			return false;
+
+		const gzUInt64 bytes = (gzUInt64)(levelWidth / info.BlockSizeX) * (levelHeight / info.BlockSizeY) * info.BlockBytes;
+
+		if (level->getArray().getSize() < bytes)
+			return false;
+	}
+
+	return true;
+}
+
+cswAtlasRegionPtr cswTextureAtlas::allocate(gzImage* image)
+{
+	GZ_INSTRUMENT_NAME("cswTextureAtlas::allocate");
+
+	if (!image)
+		return nullptr;
+
+	const gzUInt32 width = image->getWidth();
+	const gzUInt32 height = image->getHeight();
+
+	if (!FMath::IsPowerOfTwo(width) || !FMath::IsPowerOfTwo(height))
+		return nullptr;
+
+	const gzUInt32 size = FMath::Max3(width, height, m_minTileSize);
+
+	if (size > m_maxTileSize)
+		return nullptr;
+
+	const EPixelFormat format = cswUEPixelFormat(image);
+
+	switch (format)
+	{
+		case PF_G8:
+		case PF_R8G8B8A8:
+		case PF_DXT1:
+		case PF_DXT3:
+		case PF_DXT5:
+			break;
+
+		default:
+			return nullptr;
+	}
+
+	const gzUInt32 mipLevels = image->getNumberOfSubImages() ? pageMipLevels() : 1;
+
+	if (!validImage(image, format, mipLevels))
+		return nullptr;
+
+	const gzUInt32 level = levelOf(size);
+
+	GZ_BODYGUARD(m_lock);
+
+	Page* page(nullptr);
+	FIntPoint position;
+
+	for (Page& candidate : m_pages)
+	{
+		if (candidate.format == format && candidate.mipLevels == mipLevels && allocateBlock(candidate, level, position))
+		{
+			page = &candidate;
+			break;
+		}
+	}
+
+	if (!page)
+	{
+		page = &m_pages.AddDefaulted_GetRef();
+
+		page->id = s_nextPageId++;
+		page->format = format;
+		page->mipLevels = mipLevels;
+		page->freeBlocks.SetNum(m_levels);
+		page->freeBlocks[0].Add(FIntPoint(0, 0));
+
+		allocateBlock(*page, level, position);
+	}
+
+	page->regions++;
+	page->usedTexels += (gzUInt64)size * size;
+
+	m_allocations++;
+
+	cswAtlasRegionPtr region = new cswAtlasRegion;
+
+	region->page = page->id;
+	region->x = position.X;
+	region->y = position.Y;
+	region->size = size;
+	region->width = width;
+	region->height = height;
+	region->uvScale = FVector2f((float)width / m_pageSize, (float)height / m_pageSize);
+	region->uvOffset = FVector2f((float)position.X / m_pageSize, (float)position.Y / m_pageSize);
+	region->image = image;
+	region->m_atlas = this;
+
+	return region;
+}
+
+bool cswTextureAtlas::allocateBlock(Page& page, gzUInt32 level, FIntPoint& position)
+{
+	int32 current = level;
+
+	while (current >= 0 && !page.freeBlocks[current].Num())
+		current--;
+
+	if (current < 0)
+		return false;
+
+	FIntPoint block = page.freeBlocks[current].Pop(false);
+
+	// Split down to requested level. Keep first quadrant
+	while ((gzUInt32)current < level)
+	{
+		current++;
+
+		const int32 half = m_pageSize >> current;
+
+		page.freeBlocks[current].Add(FIntPoint(block.X + half, block.Y));
+		page.freeBlocks[current].Add(FIntPoint(block.X, block.Y + half));
+		page.freeBlocks[current].Add(FIntPoint(block.X + half, block.Y + half));
+	}
+
+	position = block;
+
+	return true;
+}
+
+gzVoid cswTextureAtlas::freeBlock(Page& page, gzUInt32 level, FIntPoint position)
+{
+	// Merge with free buddies as long as all four quadrants are free
+	while (level > 0)
+	{
+		const int32 size = m_pageSize >> level;
+		const int32 mask = ~(2 * size - 1);
+
+		const FIntPoint parent(position.X & mask, position.Y & mask);
+
+		TArray<FIntPoint>& list = page.freeBlocks[level];
+
+		FIntPoint buddies[3];
+		gzUInt32 count(0);
+
+		for (int32 i = 0; i < 4; i++)
+		{
+			const FIntPoint quadrant(parent.X + (i & 1) * size, parent.Y + (i >> 1) * size);
+
+			if (quadrant != position)
+				buddies[count++] = quadrant;
+		}
+
+		if (!list.Contains(buddies[0]) || !list.Contains(buddies[1]) || !list.Contains(buddies[2]))
+			break;
+
+		for (const FIntPoint& buddy : buddies)
+			list.RemoveSingleSwap(buddy, false);
+
+		position = parent;
+		level--;
+	}
+
+	page.freeBlocks[level].Add(position);
+}
+
+gzVoid cswTextureAtlas::free(gzUInt32 id, gzUInt32 x, gzUInt32 y, gzUInt32 size)
+{
+	GZ_BODYGUARD(m_lock);
+
+	for (Page& page : m_pages)
+	{
+		if (page.id != id)
+			continue;
+
+		freeBlock(page, levelOf(size), FIntPoint((int32)x, (int32)y));
+
+		page.regions--;
+		page.usedTexels -= (gzUInt64)size * size;
+
+		return;
+	}
+}
+
+gzVoid cswTextureAtlas::releaseEmptyPages()
+{
+	GZ_INSTRUMENT_NAME("cswTextureAtlas::releaseEmptyPages");
+
+	GZ_BODYGUARD(m_lock);
+
+	for (int32 i = m_pages.Num() - 1; i >= 0; i--)
+	{
+		if (m_pages[i].regions)
+			continue;
+
+		m_releasedPages.Add(m_pages[i].id);
+		m_releasedPageCount++;
+
+		m_pages.RemoveAt(i);
+	}
+
+	// Regions are not moved as meshes have baked uvs. New regions fill dense pages first
+	m_pages.StableSort([](const Page& a, const Page& b) { return a.usedTexels > b.usedTexels; });
+}
+
+TArray<gzUInt32> cswTextureAtlas::takeReleasedPages()
+{
+	GZ_BODYGUARD(m_lock);
+
+	return MoveTemp(m_releasedPages);
+}
+
+bool cswTextureAtlas::getPageLayout(gzUInt32 id, EPixelFormat& format, gzUInt32& mipLevels) const
+{
+	GZ_BODYGUARD(m_lock);
+
+	for (const Page& page : m_pages)
+	{
+		if (page.id == id)
+		{
+			format = page.format;
+			mipLevels = page.mipLevels;
+
+			return true;
+		}
+	}
+
+	return false;
+}
+
+cswAtlasStatistics cswTextureAtlas::getStatistics() const
+{
+	GZ_BODYGUARD(m_lock);
+
+	cswAtlasStatistics statistics;
+
+	statistics.pages = m_pages.Num();
+	statistics.allocations = m_allocations;
+	statistics.releasedPages = m_releasedPageCount;
+
+	const gzUInt64 pageTexels = (gzUInt64)m_pageSize * m_pageSize;
+
+	gzUInt64 largestPerPage(0);
+
+	for (const Page& page : m_pages)
+	{
+		statistics.regions += page.regions;
+		statistics.usedTexels += page.usedTexels;
+		statistics.freeTexels += pageTexels - page.usedTexels;
+
+		for (gzUInt32 level = 0; level < m_levels; level++)
+		{
+			if (page.freeBlocks[level].Num())
+			{
+				const gzUInt64 blockSize = m_pageSize >> level;
+
+				statistics.largestFreeTexels = FMath::Max(statistics.largestFreeTexels, blockSize * blockSize);
+				largestPerPage += blockSize * blockSize;
+				break;
+			}
+		}
+	}
+
+	if (statistics.freeTexels)
+		statistics.fragmentation = 1.0f - (gzFloat)largestPerPage / statistics.freeTexels;
+
+	return statistics;
+}
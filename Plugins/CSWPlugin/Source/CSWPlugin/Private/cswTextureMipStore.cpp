@@ -0,0 +1,116 @@
+//*****************************************************************************
+//
+// Copyright (C) SAAB AB
+//
+// All rights, including the copyright, to the computer program(s)
+// herein belong to SAAB AB. The program(s) may be used and/or
+// copied only with the written permission of SAAB AB, or in
+// accordance with the terms and conditions stipulated in the
+// agreement/contract under which the program(s) have been
+// supplied.
+//
+//
+// Information Class:	COMPANY UNCLASSIFIED
+// Defence Secrecy:		NOT CLASSIFIED
+// Export Control:		NOT EXPORT CONTROLLED
+//
+//
+// File			: cswTextureMipStore.cpp
+// Module		: CSW StreamingMap Unreal
+// Description	: CPU copy of texture mips for residency control
+// Author		: agent
+// Product		: CSW 1.1.2
+//
+//
+//
+// NOTE:	CSW (Common Synthetic World) is a simulation and presentation
+//			framework for large scale digital twins on multiple platforms
+//
+//
+// Revision History...
+//
+// Who	Date	Description
+//
+// AGT	261019	Created file 					(1.1.3)
+//
+//******************************************************************************
+#include "cswTextureMipStore.h"
+
+#include "Engine/Texture2D.h"
+
+GZ_DECLARE_TYPE_CHILD(gzReference, cswTextureMipStore, "cswTextureMipStore");
+
+cswTextureMipStore* cswTextureMipStore::create(const FTexturePlatformData* platformData)
+{
+	if (!platformData || !platformData->Mips.Num())
+		return nullptr;
+
+	cswTextureMipStore* store = new cswTextureMipStore;
+
+	store->m_format = platformData->PixelFormat;
+	store->m_mips.Reserve(platformData->Mips.Num());
+
+	for (const FTexture2DMipMap& source : platformData->Mips)
+	{
+		Mip& mip = store->m_mips.AddDefaulted_GetRef();
+
+		mip.width = source.SizeX;
+		mip.height = source.SizeY;
+
+		FByteBulkData& bulkData = const_cast<FByteBulkData&>(source.BulkData);
+
+		const int64 bytes = bulkData.GetBulkDataSize();
+
+		mip.data.SetNumUninitialized(bytes);
+		FMemory::Memcpy(mip.data.GetData(), bulkData.LockReadOnly(), bytes);
+		bulkData.Unlock();
+	}
+
+	return store;
+}
+
+FTexturePlatformData* cswTextureMipStore::createPlatformData(gzUInt32 firstMip) const
+{
+	firstMip = FMath::Min<gzUInt32>(firstMip, m_mips.Num() - 1);
+
+	FTexturePlatformData* platformData = new FTexturePlatformData();
+
+	platformData->SizeX = m_mips[firstMip].width;
+	platformData->SizeY = m_mips[firstMip].height;
+	platformData->PixelFormat = m_format;
+
+	platformData->Mips.Reserve(m_mips.Num() - firstMip);
+
+	for (gzUInt32 i = firstMip; i < (gzUInt32)m_mips.Num(); i++)
+	{
+		const Mip& source = m_mips[i];
+
+		FTexture2DMipMap* mip = new FTexture2DMipMap(source.width, source.height, 1);
+
+		mip->BulkData.Lock(LOCK_READ_WRITE);
+		FMemory::Memcpy(mip->BulkData.Realloc(source.data.Num()), source.data.GetData(), source.data.Num());
+		mip->BulkData.Unlock();
+
+		platformData->Mips.Add(mip);
+	}
+
+	return platformData;
+}
+
+gzUInt32 cswTextureMipStore::getMipSize(gzUInt32 mip) const
+{
+	if (mip >= (gzUInt32)m_mips.Num())
+		return 0;
+
+	return FMath::Max(m_mips[mip].width, m_mips[mip].height);
+}
+
+gzUInt64 cswTextureMipStore::getResidentBytes(gzUInt32 firstMip) const
+{
+	gzUInt64 bytes(0);
+
+	for (gzUInt32 i = firstMip; i < (gzUInt32)m_mips.Num(); i++)
+		bytes += m_mips[i].data.Num();
+
+	return bytes;
+}
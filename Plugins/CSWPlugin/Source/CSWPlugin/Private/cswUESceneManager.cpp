@@ -37,18 +37,30 @@
 #include "cswUESceneManager.h"
 #include "cswFactory.h"
 
+gzVoid cswUESceneManager::setBuildProperties(const BuildProperties& buildProperties)
+{
+	GZ_BODYGUARD(m_buildPropertiesLock);
+	m_buildProperties = buildProperties;
+}
+
+BuildProperties cswUESceneManager::getBuildProperties() const
+{
+	GZ_BODYGUARD(m_buildPropertiesLock);
+	return m_buildProperties;
+}
+
 // Called in EDIT LOCK
 gzReference* cswUESceneManager::preBuildReference(gzNode* node, const gzUInt64& pathID, gzGroup* parent, const gzUInt64& parentPathID, gzState* state)
 {
 	// Route pre build into factories
-	return cswFactory::preBuildReference(node, pathID, parent, parentPathID, state);
+	return cswFactory::preBuildReference(node, pathID, parent, parentPathID, state, getBuildProperties());
 }
 
 // Called in EDIT LOCK
 gzReference* cswUESceneManager::updateReference(gzNode* node, const gzUInt64& pathID, gzGroup* parent, const gzUInt64& parentPathID, gzState* state, gzReference* userdata)
 {
 	// Route update into factories
-	return cswFactory::updateReference(node, pathID, parent, parentPathID, state , userdata);
+	return cswFactory::updateReference(node, pathID, parent, parentPathID, state , userdata, getBuildProperties());
 }
 
 // Called in EDIT LOCK
@@ -35,6 +35,8 @@
 //
 //******************************************************************************
 #include "UEGlue/cswUEUtility.h"
+#include "Utility/cswBlockCompression.h"
+#include "Utility/cswPixelConvert.h"
 
 //#if WITH_EDITOR
 //#include "TextureCompiler.h"
@@ -42,18 +44,12 @@
 
 #undef UpdateResource
 
-UTexture2D* cswUETexture2DFromImage(gzImage* image)
+EPixelFormat cswUEPixelFormat(gzImage* image)
 {
-	if (!image)
-		return nullptr;
-
-	gzImagePtr _image;
-
-	UTexture2D* newTexture(nullptr);
-
 	EPixelFormat pixelFormat(PF_Unknown);
 
-	// Check compatible pixel format
+	if (!image)
+		return pixelFormat;
 
 	switch (image->getImageType())
 	{
@@ -69,6 +65,27 @@ UTexture2D* cswUETexture2DFromImage(gzImage* image)
 			pixelFormat = PF_R8G8B8A8;
 			break;
 
+		// Sampled by UE as is
+
+		case GZ_IMAGE_TYPE_BGRA_8:
+			pixelFormat = PF_B8G8R8A8;
+			break;
+
+		case GZ_IMAGE_TYPE_RGBA_HALF:
+			pixelFormat = PF_FloatRGBA;
+			break;
+
+		case GZ_IMAGE_TYPE_BW_HALF:
+			pixelFormat = PF_R16F;
+			break;
+
+		case GZ_IMAGE_TYPE_RGBA_FLOAT:
+			pixelFormat = PF_A32B32G32R32F;
+			break;
+
+		case GZ_IMAGE_TYPE_BW_FLOAT:
+			pixelFormat = PF_R32_FLOAT;
+			break;
 
 		case GZ_IMAGE_TYPE_RGB_8_DXT1:
 		case GZ_IMAGE_TYPE_RGBA_8_DXT1:
@@ -135,6 +152,87 @@ UTexture2D* cswUETexture2DFromImage(gzImage* image)
 			break;
 	}
 
+	return pixelFormat;
+}
+
+// Copy or convert the pixels of an image level into a mip
+static FTexture2DMipMap* createMip(gzImage* level, EPixelFormat pixelFormat, gzBool convert)
+{
+	const gzUInt64 bytes = convert ? (gzUInt64)level->getWidth() * level->getHeight() * GPixelFormats[pixelFormat].BlockBytes : level->getArray().getSize();
+
+	FTexture2DMipMap* mip = new FTexture2DMipMap(level->getWidth(), level->getHeight(), 1);
+
+	mip->BulkData.Lock(LOCK_READ_WRITE);
+
+	uint8* data = (uint8*)mip->BulkData.Realloc(bytes);
+
+	if (convert)
+		cswConvertPixels(level->getImageType(), (const uint8*)level->getArray().getAddress(), level->getAlignedRowSize(level->getWidth()), level->getWidth(), level->getHeight(), data);
+	else
+		FMemory::Memcpy(data, level->getArray().getAddress(), bytes);
+
+	mip->BulkData.Unlock();
+
+	return mip;
+}
+
+// Downsample the last 8 bit mip until 1x1
+static gzVoid generateMips(FTexturePlatformData* platformData, cswMipFilter filter)
+{
+	while (platformData->Mips.Last().SizeX > 1 || platformData->Mips.Last().SizeY > 1)
+	{
+		FTexture2DMipMap& last = platformData->Mips.Last();
+
+		FTexture2DMipMap* mip = new FTexture2DMipMap(FMath::Max(last.SizeX / 2, 1), FMath::Max(last.SizeY / 2, 1), 1);
+
+		const uint8* source = (const uint8*)last.BulkData.LockReadOnly();
+
+		mip->BulkData.Lock(LOCK_READ_WRITE);
+		cswDownsampleMip(source, last.SizeX, last.SizeY, filter, TRUE, (uint8*)mip->BulkData.Realloc((int64)mip->SizeX * mip->SizeY * 4));
+		mip->BulkData.Unlock();
+
+		last.BulkData.Unlock();
+
+		platformData->Mips.Add(mip);
+	}
+}
+
+// Encode an RGBA level into a block compressed mip
+static FTexture2DMipMap* createBlockMip(gzImage* level, gzBool alpha, cswBlockQuality quality)
+{
+	const uint32 bytes = cswBlockBytes(level->getWidth(), level->getHeight(), alpha);
+
+	FTexture2DMipMap* mip = new FTexture2DMipMap(level->getWidth(), level->getHeight(), 1);
+
+	mip->BulkData.Lock(LOCK_READ_WRITE);
+	cswEncodeBlocks((const uint8*)level->getArray().getAddress(), level->getWidth(), level->getHeight(), alpha, quality, (uint8*)mip->BulkData.Realloc(bytes));
+	mip->BulkData.Unlock();
+
+	return mip;
+}
+
+FTexturePlatformData* cswUETexturePlatformData(gzImage* image, cswMipFilter mipFilter)
+{
+	GZ_INSTRUMENT_NAME("cswUETexturePlatformData");
+
+	if (!image)
+		return nullptr;
+
+	gzImagePtr _image;
+
+	// Check compatible pixel format
+	EPixelFormat pixelFormat = cswUEPixelFormat(image);
+
+	// Dedicated converter writes the mips
+	gzBool convert(FALSE);
+
+	if (pixelFormat == PF_Unknown)
+	{
+		pixelFormat = cswConvertedPixelFormat(image->getImageType());
+
+		convert = pixelFormat != PF_Unknown;
+	}
+
 	if (pixelFormat == PF_Unknown)
 	{
 		GZMESSAGE(GZ_MESSAGE_WARNING, "No conversion found for pixel format %d", image->getFormat());
@@ -148,38 +246,23 @@ UTexture2D* cswUETexture2DFromImage(gzImage* image)
 		pixelFormat = PF_R8G8B8A8;
 	}
 
-	// Create the texure
-	// newTexture = UTexture2D::CreateTransient(image->getWidth(), image->getHeight(), pixelFormat, (const char*)image->getName());
-	newTexture = NewObject<UTexture2D>(GetTransientPackage(), MakeUniqueObjectName(GetTransientPackage(), UTexture2D::StaticClass(), "CSWTexture"), RF_Transient | RF_DuplicateTransient | RF_TextExportTransient);
-
-
-	// Initialize the texture properties
-	newTexture->SetPlatformData(new FTexturePlatformData());
-	newTexture->GetPlatformData()->SizeX = image->getWidth();
-	newTexture->GetPlatformData()->SizeY = image->getHeight();
-	newTexture->GetPlatformData()->PixelFormat = pixelFormat;
-	newTexture->NeverStream = true;
-
-	if (!newTexture)
+	if (!image->getArray().getSize())
 		return nullptr;
 
-	// Dont do this in constructor as we add mode mips lateron and this is not thread safe
+	FTexturePlatformData* platformData = new FTexturePlatformData();
 
+	// Initialize the texture properties
+	platformData->SizeX = image->getWidth();
+	platformData->SizeY = image->getHeight();
+	platformData->PixelFormat = pixelFormat;
 
 	gzUInt32 MipSize = image->getNumberOfSubImages() + 1;
 
 	// ---------- MIP 0 ----------------------------
 
-	newTexture->GetPlatformData()->Mips.Reserve(MipSize); // Ok to reserve, but we need to allocate
-	FTexture2DMipMap* Mip = new FTexture2DMipMap(image->getWidth(), image->getHeight());
-
-	Mip->BulkData.Lock(LOCK_READ_WRITE);
-	gzUInt32 BytesForImage = image->getArray().getSize();
-	void* DestImageData = Mip->BulkData.Realloc(BytesForImage);
-	FMemory::Memcpy(DestImageData, (uint8*)image->getArray().getAddress(), BytesForImage);
-	Mip->BulkData.Unlock();
+	platformData->Mips.Reserve(MipSize); // Ok to reserve, but we need to allocate
 
-	newTexture->GetPlatformData()->Mips.Add(Mip);
+	platformData->Mips.Add(createMip(image, pixelFormat, convert));
 
 
 	// ---------- SUB MIPS -------------------------------
@@ -200,23 +283,153 @@ UTexture2D* cswUETexture2DFromImage(gzImage* image)
 				if (subImage->getHeight() == 0)
 					GZBREAK;
 
-				BytesForImage = subImage->getArray().getSize();
+				if (subImage->getArray().getSize())
+					platformData->Mips.Add(createMip(subImage, pixelFormat, convert));
+			}
+		}
+	}
+	else if (mipFilter != CSW_MIP_FILTER_NONE && (pixelFormat == PF_R8G8B8A8 || pixelFormat == PF_B8G8R8A8))
+	{
+		generateMips(platformData, mipFilter);
+	}
+
+	return platformData;
+}
 
-				if (BytesForImage)
-				{
-					Mip = new FTexture2DMipMap(subImage->getWidth(), subImage->getHeight(), 1);
+FTexturePlatformData* cswUECompressedPlatformData(gzImage* image, gzBool highQuality, gzFloat maxRMSE, gzFloat* rmse, cswMipFilter mipFilter)
+{
+	GZ_INSTRUMENT_NAME("cswUECompressedPlatformData");
 
-					Mip->BulkData.Lock(LOCK_READ_WRITE);
-					DestImageData = Mip->BulkData.Realloc(BytesForImage);
-					FMemory::Memcpy(DestImageData, (uint8*)subImage->getArray().getAddress(), BytesForImage);
-					Mip->BulkData.Unlock();
+	if (rmse)
+		*rmse = -1;
 
-					newTexture->GetPlatformData()->Mips.Add(Mip);
-				}
-			}
+	if (!image || !image->getArray().getSize())
+		return nullptr;
+
+	// 8 bit colors only
+	if (image->getImageType() != GZ_IMAGE_TYPE_RGBA_8 && cswConvertedPixelFormat(image->getImageType()) != PF_R8G8B8A8)
+		return nullptr;
+
+	// UE needs whole blocks in mip 0
+	if ((image->getWidth() & 3) || (image->getHeight() & 3))
+		return nullptr;
+
+	const gzBool alpha = image->hasSignificantAlpha();
+
+	const cswBlockQuality quality = highQuality ? CSW_BLOCK_QUALITY_HIGH : CSW_BLOCK_QUALITY_FAST;
+
+	FTexturePlatformData* platformData = new FTexturePlatformData();
+
+	platformData->SizeX = image->getWidth();
+	platformData->SizeY = image->getHeight();
+	platformData->PixelFormat = alpha ? PF_DXT5 : PF_DXT1;
+
+	platformData->Mips.Reserve(image->getNumberOfSubImages() + 1);
+
+	gzImagePtr level0;
+
+	for (gzUInt32 i = 0; i <= image->getNumberOfSubImages(); i++)
+	{
+		gzImagePtr level = i ? image->getSubImage(i - 1) : image;
+
+		if (!level || !level->getWidth() || !level->getHeight() || !level->getArray().getSize())
+			break;
+
+		if (level->getImageType() != GZ_IMAGE_TYPE_RGBA_8)
+		{
+			gzImagePtr rgba = gzImage::createImage(GZ_IMAGE_TYPE_RGBA_8);
+
+			rgba->setSize(level->getWidth(), level->getHeight());
+			rgba->createArray();
+
+			if (!cswConvertPixels(level->getImageType(), (const uint8*)level->getArray().getAddress(), level->getAlignedRowSize(level->getWidth()), level->getWidth(), level->getHeight(), (uint8*)rgba->getArray().getAddress()))
+				break;
+
+			level = rgba;
 		}
+
+		if (!level || level->getArray().getSize() < (gzUInt64)level->getWidth() * level->getHeight() * 4)
+			break;
+
+		if (!i)
+			level0 = level;
+
+		platformData->Mips.Add(createBlockMip(level, alpha, quality));
 	}
 
+	if (!level0)
+	{
+		delete platformData;
+		return nullptr;
+	}
+
+	// Filter the chain from uncompressed mip 0 and encode each level
+	if (!image->getNumberOfSubImages() && mipFilter != CSW_MIP_FILTER_NONE)
+	{
+		gzImagePtr level = level0;
+
+		while (level->getWidth() > 1 || level->getHeight() > 1)
+		{
+			gzImagePtr next = gzImage::createImage(GZ_IMAGE_TYPE_RGBA_8);
+
+			next->setSize(FMath::Max(level->getWidth() / 2, 1u), FMath::Max(level->getHeight() / 2, 1u));
+			next->createArray();
+
+			cswDownsampleMip((const gzUByte*)level->getArray().getAddress(), level->getWidth(), level->getHeight(), mipFilter, TRUE, (gzUByte*)next->getArray().getAddress());
+
+			platformData->Mips.Add(createBlockMip(next, alpha, quality));
+
+			level = next;
+		}
+	}
+
+	// Decode mip 0 again and measure the loss
+	if (maxRMSE > 0 || rmse)
+	{
+		gzImagePtr decoded = gzImage::createImage(GZ_IMAGE_TYPE_RGBA_8);
+
+		decoded->setSize(level0->getWidth(), level0->getHeight());
+		decoded->createArray();
+
+		const uint8* blocks = (const uint8*)platformData->Mips[0].BulkData.LockReadOnly();
+		cswDecodeBlocks(blocks, level0->getWidth(), level0->getHeight(), alpha, (uint8*)decoded->getArray().getAddress());
+		platformData->Mips[0].BulkData.Unlock();
+
+		const gzFloat error = level0->compareRMSE(decoded, alpha);
+
+		if (rmse)
+			*rmse = error;
+
+		if (maxRMSE > 0 && (error < 0 || error > maxRMSE))
+		{
+			delete platformData;
+			return nullptr;
+		}
+	}
+
+	return platformData;
+}
+
+UTexture2D* cswUETexture2DFromPlatformData(FTexturePlatformData* platformData)
+{
+	GZ_INSTRUMENT_NAME("cswUETexture2DFromPlatformData");
+
+	if (!platformData)
+		return nullptr;
+
+	// Create the texure
+	// newTexture = UTexture2D::CreateTransient(image->getWidth(), image->getHeight(), pixelFormat, (const char*)image->getName());
+	UTexture2D* newTexture = NewObject<UTexture2D>(GetTransientPackage(), MakeUniqueObjectName(GetTransientPackage(), UTexture2D::StaticClass(), "CSWTexture"), RF_Transient | RF_DuplicateTransient | RF_TextExportTransient);
+
+	if (!newTexture)
+	{
+		delete platformData;
+		return nullptr;
+	}
+
+	newTexture->SetPlatformData(platformData);
+	newTexture->NeverStream = true;
+
 	// Now we release it to texture compiler
 
 	newTexture->UpdateResource();
@@ -228,6 +441,11 @@ UTexture2D* cswUETexture2DFromImage(gzImage* image)
 	return newTexture;
 }
 
+UTexture2D* cswUETexture2DFromImage(gzImage* image)
+{
+	return cswUETexture2DFromPlatformData(cswUETexturePlatformData(image));
+}
+
 void cswScreenMessage(const gzString& message, const gzInt32& line, const FColor& color)
 {
 	GZ_SYNCRONIZED;
@@ -38,9 +38,67 @@
 
 #include "gzNode.h"
 #include "Engine/EngineTypes.h"
+#include "cswTextureAtlas.h"
+#include "cswMipGeneration.h"
+
+#include <atomic>
 
 class UCSWSceneComponent;
 
+// Mesh build counters. Updated from manager thread, read from game thread
+class cswBuildStatistics : public gzReference
+{
+public:
+
+	std::atomic<gzUInt64>	meshes = 0;
+	std::atomic<gzUInt64>	meshesFailed = 0;		// Geometry that could not be converted and is not shown
+	std::atomic<gzUInt64>	meshes16Bit = 0;		// LODs built with 16 bit index buffers
+	std::atomic<gzUInt64>	vertices = 0;			// Render vertices after compaction
+	std::atomic<gzUInt64>	indexBytes = 0;			// Index buffer size as built by UE
+	std::atomic<gzUInt64>	sourceIndexBytes = 0;	// Index size as gzUInt32 from gizmo
+
+	std::atomic<gzUInt64>	vertexCacheTriangles = 0;		// Triangles reordered for the vertex cache
+	std::atomic<gzUInt64>	vertexCacheMissesBefore = 0;	// FIFO cache misses in source order
+	std::atomic<gzUInt64>	vertexCacheMissesAfter = 0;		// and after reordering
+
+	std::atomic<gzUInt64>	texturesPrepared = 0;			// Texture data copied in prebuild
+	std::atomic<gzUInt64>	texturePrepareMicroseconds = 0;	// Manager thread time for it
+
+	std::atomic<gzUInt64>	texturesCompressed = 0;			// Encoded to BC1/BC3 in prebuild
+	std::atomic<gzUInt64>	texturesCompressionRejected = 0;	// Kept uncompressed as RMSE was too high
+	std::atomic<gzUInt64>	textureCompressionBytesSaved = 0;	// Image pixel bytes minus block bytes
+
+	std::atomic<gzUInt64>	texturesMipGenerated = 0;		// Prepared images that got a filtered chain
+
+	std::atomic<gzUInt64>	intersectTrees = 0;				// Triangle BVHs built in prebuild
+	std::atomic<gzUInt64>	intersectTreeMicroseconds = 0;	// Manager thread time for them
+	std::atomic<gzUInt64>	intersectTreeBytes = 0;
+
+	gzVoid reset()
+	{
+		meshes = 0;
+		meshesFailed = 0;
+		meshes16Bit = 0;
+		vertices = 0;
+		indexBytes = 0;
+		sourceIndexBytes = 0;
+		vertexCacheTriangles = 0;
+		vertexCacheMissesBefore = 0;
+		vertexCacheMissesAfter = 0;
+		texturesPrepared = 0;
+		texturePrepareMicroseconds = 0;
+		texturesCompressed = 0;
+		texturesCompressionRejected = 0;
+		textureCompressionBytesSaved = 0;
+		texturesMipGenerated = 0;
+		intersectTrees = 0;
+		intersectTreeMicroseconds = 0;
+		intersectTreeBytes = 0;
+	}
+};
+
+GZ_DECLARE_REFPTR(cswBuildStatistics);
+
 struct BuildProperties
 {
 	// Use fastbuild for meshes as default
@@ -54,6 +112,54 @@ struct BuildProperties
 
 	// turn of collsion
 	ECollisionEnabled::Type collision = ECollisionEnabled::NoCollision;
+
+	// build gzLod children into one multi LOD static mesh and let UE switch
+	bool mergeLodLevels = false;
+
+	// reorder triangles for post transform vertex cache
+	bool optimizeVertexCache = false;
+
+	// write changed vertex ranges into existing meshes when topology is unchanged
+	bool partialGeometryUpdates = false;
+
+	// updates per second before a geometry is shown by a procedural mesh. 0 disables
+	float dynamicMeshUpdateRate = 0;
+
+	// seconds without updates before a procedural mesh is baked back to static
+	float dynamicMeshIdleTime = 2.0f;
+
+	// copy texture data in prebuild so the game thread only creates the texture object
+	bool prepareTextures = false;
+
+	// encode prepared RGB/RGBA textures to BC1/BC3 on the manager thread
+	bool compressTextures = false;
+
+	// principal axis endpoints with a least squares pass instead of the bounding box
+	bool textureCompressionHighQuality = true;
+
+	// largest accepted RMSE (0..1) of mip 0 after compression. 0 accepts all
+	float textureCompressionMaxRMSE = 0.02f;
+
+	// filter a mip chain for prepared images without sub images. Gamma correct for 8 bit colors
+	cswMipFilter mipFilter = CSW_MIP_FILTER_NONE;
+
+	// keep full mips in a CPU store and upload only the levels needed on screen
+	bool textureMipResidency = false;
+
+	// pack small tile textures into shared pages and remap uvs. nullptr disables
+	cswTextureAtlasPtr textureAtlas;
+
+	// optional counters for built meshes
+	cswBuildStatisticsPtr statistics;
+
+	// sample terrain geometry into height grids in prebuild for the scene height cache
+	bool buildHeightTiles = false;
+
+	// triangle bvh per geometry in prebuild for synchronous scene intersections
+	bool buildIntersectTrees = false;
+
+	// floating origin in map coordinates. Subtracted from top level roi positions
+	gzVec3D roiOffset = gzVec3D(0, 0, 0);
 };
 
 class cswResourceManager;
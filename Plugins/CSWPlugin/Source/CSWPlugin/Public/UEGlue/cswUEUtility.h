@@ -44,6 +44,22 @@
 
 // CSW/Gizmo includes
 #include "gzGraphLibrary.h"
+#include "cswMipGeneration.h"
+
+//! UE pixel format matching the image data or PF_Unknown if it needs a conversion
+CSWPLUGIN_API EPixelFormat cswUEPixelFormat(gzImage* image);
+
+//! Texture data with all mips of a gzImage. Converts unknown formats to RGBA. Safe off the game thread
+//! 8 bit RGBA/BGRA images without sub images get a generated chain when mipFilter is set
+CSWPLUGIN_API FTexturePlatformData* cswUETexturePlatformData(gzImage* image, cswMipFilter mipFilter = CSW_MIP_FILTER_NONE);
+
+//! BC1 or BC3 (significant alpha) texture data encoded on the CPU. Safe off the game thread
+//! Returns nullptr for sizes not a multiple of 4, unsupported formats or when the RMSE of mip 0 exceeds maxRMSE
+//! Images without sub images get a chain generated from mip 0 before encoding when mipFilter is set
+CSWPLUGIN_API FTexturePlatformData* cswUECompressedPlatformData(gzImage* image, gzBool highQuality, gzFloat maxRMSE, gzFloat* rmse = nullptr, cswMipFilter mipFilter = CSW_MIP_FILTER_NONE);
+
+//! Create a UTexture2D that takes ownership of the platform data. Game thread
+CSWPLUGIN_API UTexture2D* cswUETexture2DFromPlatformData(FTexturePlatformData* platformData);
 
 //! Create a UTexture2D from a gzImage 
 CSWPLUGIN_API UTexture2D* cswUETexture2DFromImage(gzImage* image);
@@ -37,6 +37,8 @@
 #pragma once
 
 #include "gzNode.h"
+#include "Interfaces/cswBuildInterface.h"
+
 class UCSWSceneComponent;
 
 class cswFactory : public gzObject
@@ -50,11 +52,11 @@ public:
 
 	CSWPLUGIN_API static UCSWSceneComponent* newObject(USceneComponent* parent,gzNode* node, EObjectFlags Flags = RF_NoFlags, UObject* Template = nullptr, bool bCopyTransientsFromClassDefaults = false, FObjectInstancingGraph* InInstanceGraph = nullptr);
 
-	CSWPLUGIN_API static gzReference* preBuildReference(gzNode* node, const gzUInt64& pathID, gzGroup* parent, const gzUInt64& parentPathID, gzState* state);
+	CSWPLUGIN_API static gzReference* preBuildReference(gzNode* node, const gzUInt64& pathID, gzGroup* parent, const gzUInt64& parentPathID, gzState* state, const BuildProperties& buildProperties);
 
 	CSWPLUGIN_API static gzVoid preDestroyReference(gzNode* node, const gzUInt64& pathID, gzReference* userdata);
 
-	CSWPLUGIN_API static gzReference* updateReference(gzNode* node, const gzUInt64& pathID, gzGroup* parent, const gzUInt64& parentPathID, gzState* state, gzReference* userdata);
+	CSWPLUGIN_API static gzReference* updateReference(gzNode* node, const gzUInt64& pathID, gzGroup* parent, const gzUInt64& parentPathID, gzState* state, gzReference* userdata, const BuildProperties& buildProperties);
 
 
 	CSWPLUGIN_API static gzBool registerFactory(const gzString &className, cswFactory *factory);
@@ -70,9 +72,9 @@ protected:
 
 	CSWPLUGIN_API virtual UCSWSceneComponent* newObjectInstance(USceneComponent* parent,gzNode *node, EObjectFlags Flags, UObject* Template, bool bCopyTransientsFromClassDefaults , FObjectInstancingGraph* InInstanceGraph ) = 0;
 
-	CSWPLUGIN_API virtual gzReference* preBuildReferenceInstance(gzNode* node, const gzUInt64& pathID, gzGroup* parent, const gzUInt64& parentPathID, gzState* state);
+	CSWPLUGIN_API virtual gzReference* preBuildReferenceInstance(gzNode* node, const gzUInt64& pathID, gzGroup* parent, const gzUInt64& parentPathID, gzState* state, const BuildProperties& buildProperties);
 
-	CSWPLUGIN_API virtual gzReference* updateReferenceInstance(gzNode* node, const gzUInt64& pathID, gzGroup* parent, const gzUInt64& parentPathID, gzState* state, gzReference* userdata);
+	CSWPLUGIN_API virtual gzReference* updateReferenceInstance(gzNode* node, const gzUInt64& pathID, gzGroup* parent, const gzUInt64& parentPathID, gzState* state, gzReference* userdata, const BuildProperties& buildProperties);
 
 	CSWPLUGIN_API virtual gzVoid preDestroyReferenceInstance(gzNode* node, const gzUInt64& pathID, gzReference* userdata);
 };
@@ -20,6 +20,10 @@ public:
 	UPROPERTY(BlueprintAssignable, Category="CSW|GroundClamp")
 	FCSWGroundClampResponse OnFail;
 
+	// Fires at once with a DEM altitude when the scene has AltitudeLookupDirectory. OnSuccess refines it
+	UPROPERTY(BlueprintAssignable, Category="CSW|GroundClamp")
+	FCSWGroundClampResponse OnApproximate;
+
 	UFUNCTION(BlueprintCallable, meta = (BlueprintInternalUseOnly = "true", WorldContext = "WorldContextObject"), Category="CSW|GroundClamp")
 	static UCSWGroundClampAsyncAction* GroundClampAsync(UObject* WorldContextObject, UCSWScene* Scene, double LatitudeDeg, double LongitudeDeg, double HeightAboveGround = 1000.0, bool WaitForData = false, float TimeoutSeconds = 2.0f);
 
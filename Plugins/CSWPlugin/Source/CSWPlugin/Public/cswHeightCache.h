@@ -0,0 +1,150 @@
+//*****************************************************************************
+//
+// Copyright (C) SAAB AB
+//
+// All rights, including the copyright, to the computer program(s)
+// herein belong to SAAB AB. The program(s) may be used and/or
+// copied only with the written permission of SAAB AB, or in
+// accordance with the terms and conditions stipulated in the
+// agreement/contract under which the program(s) have been
+// supplied.
+//
+//
+// Information Class:	COMPANY UNCLASSIFIED
+// Defence Secrecy:		NOT CLASSIFIED
+// Export Control:		NOT EXPORT CONTROLLED
+//
+//
+// File			: cswHeightCache.h
+// Module		: CSW StreamingMap Unreal
+// Description	: Game thread height cache for synchronous ground queries
+// Author		: agent
+// Product		: CSW 1.1.2
+//
+//
+//
+// NOTE:	CSW (Common Synthetic World) is a simulation and presentation
+//			framework for large scale digital twins on multiple platforms
+//
+//
+// Revision History...
+//
+// Who	Date	Description
+//
+// AGT	261019	Created file 					(1.1.3)
+//
+//******************************************************************************
+#pragma once
+
+#include "cswSceneComponent.h"
+
+class gzGeometry;
+
+enum cswHeightSource
+{
+	CSW_HEIGHT_SOURCE_NONE,
+	CSW_HEIGHT_SOURCE_TERRAIN,		// Height grid of a loaded terrain geometry
+	CSW_HEIGHT_SOURCE_CLAMP,		// Ground clamp responses
+};
+
+//! Regular height grid of one terrain geometry in its local frame, y up. Built in prebuild from manager thread
+class cswHeightTile : public gzReference
+{
+public:
+	GZ_DECLARE_TYPE_INTERFACE;
+
+	//! Bilinear height at local x,z. FALSE outside or where a corner is not covered by a triangle
+	gzBool sample(const gzDouble& x, const gzDouble& z, gzDouble& height) const;
+
+	gzUInt64 getBytes() const { return heights.GetAllocatedSize(); }
+
+	gzDouble		x0 = 0;				// First sample
+	gzDouble		z0 = 0;
+	gzDouble		spacing = 1;
+	int32			columns = 0;
+	int32			rows = 0;
+	TArray<gzFloat>	heights;			// rows * columns. FLT_MAX where no triangle covers the sample
+	gzFloat			accuracy = 0;		// Largest difference between grid and mesh vertices
+};
+
+GZ_DECLARE_REFPTR(cswHeightTile);
+
+//! Grid at about vertex resolution for triangle geometry facing up. nullptr for other geometry such as walls
+cswHeightTile* cswBuildHeightTile(gzGeometry* geom);
+
+struct cswHeightSample
+{
+	gzDouble		height = 0;
+	gzFloat			accuracy = -1;		// Meters. Negative when not known
+	gzDouble		age = 0;			// Seconds since the data was built or measured
+	gzBool			stale = FALSE;
+	cswHeightSource	source = CSW_HEIGHT_SOURCE_NONE;
+};
+
+struct cswHeightCacheStatistics
+{
+	gzUInt32	tiles = 0;
+	gzUInt32	clampSamples = 0;
+	gzUInt64	bytes = 0;
+	gzUInt64	hits = 0;
+	gzUInt64	misses = 0;
+};
+
+//! Heights in map coordinates (x,z plane, y up) from terrain tiles and clamp responses. Tiles are found through
+//! buckets of fixed size so a query is O(1). Fresh clamp samples win over tiles, tiles over stale samples. Game thread
+class cswHeightCache : public gzReference
+{
+public:
+	GZ_DECLARE_TYPE_INTERFACE;
+
+	//! Clamp samples older than this are returned as stale
+	gzVoid setMaxAge(gzDouble maxAge) { m_maxAge = maxAge; }
+
+	//! Add or replace the tile of a component. Offset moves local tile coordinates to map coordinates
+	gzVoid addTile(UCSWSceneComponent* component, cswHeightTile* tile, const gzVec3D& offset, gzDouble time);
+
+	gzVoid removeTile(UCSWSceneComponent* component);
+
+	//! Clamped ground position in map coordinates
+	gzVoid addClampSample(const gzVec3D& position, gzDouble time);
+
+	gzBool sample(const gzDouble& x, const gzDouble& z, gzDouble time, cswHeightSample& result);
+
+	gzVoid clear();
+
+	cswHeightCacheStatistics getStatistics() const;
+
+private:
+
+	struct Tile
+	{
+		cswHeightTilePtr	tile;
+		gzVec3D				offset;
+		gzDouble			time = 0;
+		FIntPoint			minBucket;
+		FIntPoint			maxBucket;
+	};
+
+	struct ClampCell
+	{
+		gzFloat				height = 0;
+		gzDouble			time = 0;
+	};
+
+	gzBool sampleTiles(const gzDouble& x, const gzDouble& z, gzDouble time, cswHeightSample& result) const;
+	gzBool sampleClamp(const gzDouble& x, const gzDouble& z, gzDouble time, cswHeightSample& result) const;
+
+	gzVoid linkTile(UCSWSceneComponent* component, const Tile& tile, gzBool link);
+
+	TMap<UCSWSceneComponent*, Tile>					m_tiles;
+	TMap<FIntPoint, TArray<UCSWSceneComponent*>>	m_buckets;
+	TMap<FIntPoint, ClampCell>						m_clampCells;
+
+	gzDouble										m_maxAge = 60;
+
+	gzUInt64										m_tileBytes = 0;
+	gzUInt64										m_hits = 0;
+	gzUInt64										m_misses = 0;
+};
+
+GZ_DECLARE_REFPTR(cswHeightCache);
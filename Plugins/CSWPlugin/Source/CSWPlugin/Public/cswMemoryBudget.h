@@ -0,0 +1,110 @@
+//*****************************************************************************
+//
+// Copyright (C) SAAB AB
+//
+// All rights, including the copyright, to the computer program(s)
+// herein belong to SAAB AB. The program(s) may be used and/or
+// copied only with the written permission of SAAB AB, or in
+// accordance with the terms and conditions stipulated in the
+// agreement/contract under which the program(s) have been
+// supplied.
+//
+//
+// Information Class:	COMPANY UNCLASSIFIED
+// Defence Secrecy:		NOT CLASSIFIED
+// Export Control:		NOT EXPORT CONTROLLED
+//
+//
+// File			: cswMemoryBudget.h
+// Module		: CSW StreamingMap Unreal
+// Description	: Memory budget with LRU eviction of scene resources
+// Author		: agent
+// Product		: CSW 1.1.2
+//
+//
+//
+// NOTE:	CSW (Common Synthetic World) is a simulation and presentation
+//			framework for large scale digital twins on multiple platforms
+//
+//
+// Revision History...
+//
+// Who	Date	Description
+//
+// AGT	261019	Created file 					(1.1.3)
+//
+//******************************************************************************
+#pragma once
+
+#include "cswResourceManager.h"
+
+struct cswMemoryBudgetStatistics
+{
+	gzUInt64	budgetBytes = 0;
+	gzUInt64	usedBytes = 0;			// Mesh, texture and material memory
+	gzUInt64	meshBytes = 0;			// Static meshes of tracked components
+	gzUInt64	textureBytes = 0;		// Cached textures and atlas pages
+	gzUInt64	materialBytes = 0;		// Cached material instances
+	gzUInt32	materials = 0;
+	gzUInt32	components = 0;			// Tracked components with meshes
+	gzUInt32	evictedComponents = 0;	// Not visible with textures dropped to lowest mips
+	gzFloat		pressure = 0;			// Used / budget
+	gzFloat		lodFactorScale = 1;		// Applied on top of the scene LodFactor
+	gzUInt64	evictions = 0;
+	gzUInt64	restores = 0;			// Evicted components seen again
+	gzUInt64	lodRaises = 0;
+	gzUInt64	lodLowers = 0;
+};
+
+//! Tracks the bytes of scene components and keeps them inside a budget. Over budget the least recently
+//! visible components get their resident textures dropped to the smallest mips (the scene turns on mip
+//! residency with a budget), then the scene lod factor is raised
+//! so the scene manager unloads detail. The factor is lowered again when usage falls. Game thread
+class cswMemoryBudget : public gzReference
+{
+public:
+	GZ_DECLARE_TYPE_INTERFACE;
+
+	//! Budget in bytes. 0 only collects statistics
+	gzVoid setBudget(gzUInt64 budget, gzFloat maxLodFactorScale = 4.0f, gzFloat evictAge = 10.0f);
+
+	//! Add or refresh a component after build or update
+	gzVoid track(UCSWSceneComponent* component, gzDouble time);
+
+	gzVoid untrack(UCSWSceneComponent* component);
+
+	//! Evict and adjust the lod factor scale. Returns TRUE when the scale changed. Time is world seconds
+	gzBool update(cswResourceManager* resources, gzDouble time);
+
+	gzFloat getLodFactorScale() const { return m_lodFactorScale; }
+
+	cswMemoryBudgetStatistics getStatistics() const;
+
+private:
+
+	struct Entry
+	{
+		TWeakObjectPtr<UCSWSceneComponent>	component;
+		gzUInt64							bytes = 0;
+		gzDouble							lastVisible = 0;
+		gzBool								evicted = FALSE;
+	};
+
+	static gzUInt64 meshBytes(UCSWSceneComponent* component, gzBool& hasPrimitives);
+
+	static gzDouble lastRenderTime(UCSWSceneComponent* component);
+
+	TMap<UCSWSceneComponent*, Entry>	m_entries;
+
+	gzUInt64					m_budget = 0;
+	gzFloat						m_maxLodFactorScale = 4.0f;
+	gzFloat						m_evictAge = 10.0f;
+
+	gzFloat						m_lodFactorScale = 1.0f;
+	gzDouble					m_lodTime = 0;
+	gzDouble					m_updateTime = -1;
+
+	cswMemoryBudgetStatistics	m_statistics;
+};
+
+GZ_DECLARE_REFPTR(cswMemoryBudget);
@@ -0,0 +1,159 @@
+//*****************************************************************************
+//
+// Copyright (C) SAAB AB
+//
+// All rights, including the copyright, to the computer program(s)
+// herein belong to SAAB AB. The program(s) may be used and/or
+// copied only with the written permission of SAAB AB, or in
+// accordance with the terms and conditions stipulated in the
+// agreement/contract under which the program(s) have been
+// supplied.
+//
+//
+// Information Class:	COMPANY UNCLASSIFIED
+// Defence Secrecy:		NOT CLASSIFIED
+// Export Control:		NOT EXPORT CONTROLLED
+//
+//
+// File			: cswMeshBVH.h
+// Module		: CSW StreamingMap Unreal
+// Description	: Triangle BVH of built geometry for synchronous intersections
+// Author		: agent
+// Product		: CSW 1.1.2
+//
+//
+//
+// NOTE:	CSW (Common Synthetic World) is a simulation and presentation
+//			framework for large scale digital twins on multiple platforms
+//
+//
+// Revision History...
+//
+// Who	Date	Description
+//
+// AGT	261019	Created file 					(1.1.3)
+//
+//******************************************************************************
+#pragma once
+
+#include "cswSceneComponent.h"
+
+class gzGeometry;
+
+//! Nearest hit along origin + t * delta. t is shared by all frames as delta is not normalized
+struct cswRayHit
+{
+	gzDouble				t = 1;							// Segment parameter 0..1. Only closer hits replace it
+	FVector3d				normal = FVector3d::ZeroVector;	// Face normal facing the ray origin
+	UCSWSceneComponent*		component = nullptr;
+};
+
+//! Triangle BVH of one geometry in its local frame. Built in prebuild from manager thread, read only after that
+class CSWPLUGIN_API cswMeshBVH : public gzReference
+{
+public:
+	GZ_DECLARE_TYPE_INTERFACE;
+
+	//! TRUE and updated hit if a triangle is closer than hit.t
+	gzBool intersect(const FVector3d& origin, const FVector3d& delta, cswRayHit& hit) const;
+
+	const FBox3f& getBounds() const { return m_bounds; }
+
+	gzUInt32 getTriangles() const { return m_triangles.Num(); }
+
+	gzUInt64 getBytes() const { return m_nodes.GetAllocatedSize() + m_triangles.GetAllocatedSize() + m_vertices.GetAllocatedSize(); }
+
+private:
+
+	friend CSWPLUGIN_API cswMeshBVH* cswBuildMeshBVH(gzGeometry* geom);
+
+	// Inner nodes have the first child next in the array and the second at index. Leaves have count > 0
+	struct Node
+	{
+		FVector3f	min;
+		int32		index = 0;
+		FVector3f	max;
+		int32		count = 0;
+	};
+
+	int32 buildNode(TArray<FVector3f>& centers, int32 first, int32 count, int32 depth);
+
+	TArray<Node>		m_nodes;
+	TArray<FIntVector>	m_triangles;		// Vertex indices in leaf order
+	TArray<FVector3f>	m_vertices;
+	FBox3f				m_bounds = FBox3f(ForceInit);
+};
+
+GZ_DECLARE_REFPTR(cswMeshBVH);
+
+//! Tree over triangle geometry. nullptr for points, lines and empty geometry
+CSWPLUGIN_API cswMeshBVH* cswBuildMeshBVH(gzGeometry* geom);
+
+struct cswSceneBVHStatistics
+{
+	gzUInt32	components = 0;
+	gzUInt32	meshes = 0;				// Unique trees. Instanced geometry shares one
+	gzUInt64	triangles = 0;
+	gzUInt64	bytes = 0;
+	gzUInt64	queries = 0;
+	gzUInt64	hits = 0;
+};
+
+//! Top level tree over the mesh trees of scene components in map coordinates. Rebuilt on the first query after a
+//! change. Hidden components are skipped in queries so activations do not cause rebuilds. Game thread
+class cswSceneBVH : public gzReference
+{
+public:
+	GZ_DECLARE_TYPE_INTERFACE;
+
+	//! Add or replace the tree of a component. Transform goes from geometry local to map coordinates
+	gzVoid add(UCSWSceneComponent* component, cswMeshBVH* bvh, const FTransform& transform);
+
+	gzVoid remove(UCSWSceneComponent* component);
+
+	//! Nearest hit on origin + t * delta for t in 0..hit.t in map coordinates. Normal in map coordinates
+	gzBool intersect(const FVector3d& origin, const FVector3d& delta, cswRayHit& hit);
+
+	gzVoid clear();
+
+	cswSceneBVHStatistics getStatistics() const;
+
+private:
+
+	struct Entry
+	{
+		cswMeshBVHPtr	bvh;
+		FTransform		transform;
+		FBox3d			bounds;			// Map coordinates
+	};
+
+	struct Node
+	{
+		FBox3d			bounds;
+		int32			index = 0;		// Second child or first entry
+		int32			count = 0;		// Entries in leaf
+	};
+
+	struct Leaf
+	{
+		UCSWSceneComponent*	component;
+		const Entry*		entry;			// Into m_entries. Valid until the next change
+	};
+
+	gzVoid rebuild();
+	int32 buildNode(int32 first, int32 count);
+
+	TMap<UCSWSceneComponent*, Entry>	m_entries;
+	TMap<cswMeshBVH*, int32>			m_meshes;			// Components per tree for unique memory
+
+	TArray<Node>						m_nodes;
+	TArray<Leaf>						m_order;			// Entries in leaf order
+	gzBool								m_dirty = FALSE;
+
+	gzUInt64							m_meshBytes = 0;
+	gzUInt64							m_triangles = 0;
+	gzUInt64							m_queries = 0;
+	gzUInt64							m_hits = 0;
+};
+
+GZ_DECLARE_REFPTR(cswSceneBVH);
@@ -0,0 +1,53 @@
+//*****************************************************************************
+//
+// Copyright (C) SAAB AB
+//
+// All rights, including the copyright, to the computer program(s)
+// herein belong to SAAB AB. The program(s) may be used and/or
+// copied only with the written permission of SAAB AB, or in
+// accordance with the terms and conditions stipulated in the
+// agreement/contract under which the program(s) have been
+// supplied.
+//
+//
+// Information Class:	COMPANY UNCLASSIFIED
+// Defence Secrecy:		NOT CLASSIFIED
+// Export Control:		NOT EXPORT CONTROLLED
+//
+//
+// File			: cswMipGeneration.h
+// Module		: CSW StreamingMap Unreal
+// Description	: Mip chain generation for images without sub images
+// Author		: agent
+// Product		: CSW 1.1.2
+//
+//
+//
+// NOTE:	CSW (Common Synthetic World) is a simulation and presentation
+//			framework for large scale digital twins on multiple platforms
+//
+//
+// Revision History...
+//
+// Who	Date	Description
+//
+// AGT	261019	Created file 					(1.1.3)
+//
+//******************************************************************************
+#pragma once
+
+#include "gzBase.h"
+
+enum cswMipFilter
+{
+	CSW_MIP_FILTER_NONE,
+	CSW_MIP_FILTER_BOX,			// 2x2 average
+	CSW_MIP_FILTER_KAISER,		// 8 tap Kaiser windowed sinc. Sharper, costs about 4x box
+};
+
+//! Levels in a full chain down to 1x1
+CSWPLUGIN_API gzUInt32 cswMipCount(gzUInt32 width, gzUInt32 height);
+
+//! Next level of packed 4 byte pixels with alpha in byte 3. Target is max(1, w/2) x max(1, h/2)
+//! Color is filtered in linear light when srgb is set, alpha always linearly. Rows are split over worker threads
+CSWPLUGIN_API gzVoid cswDownsampleMip(const gzUByte* source, gzUInt32 width, gzUInt32 height, cswMipFilter filter, gzBool srgb, gzUByte* target);
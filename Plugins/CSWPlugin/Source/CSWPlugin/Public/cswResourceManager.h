@@ -39,6 +39,11 @@
 #include "gzNode.h"
 #include "Materials/Material.h"
 #include "cswSceneComponent.h"
+#include "cswTextureAtlas.h"
+#include "cswTextureMipStore.h"
+#include "UObject/StrongObjectPtr.h"
+
+struct FTexturePlatformData;
 
 
 enum cswMaterialType
@@ -51,6 +56,59 @@ enum cswMaterialType
 GZ_USE_BIT_LOGIC(cswMaterialType);
 
 
+struct cswResourceStatistics
+{
+	gzUInt64	textureUploads = 0;
+	gzUInt64	textureUploadBytes = 0;
+	gzUInt64	textureCacheHits = 0;		// Duplicate uploads avoided
+	gzUInt64	textureBytesSaved = 0;
+
+	gzUInt64	textureResidentBytes = 0;		// Pixels still held by gizmo images of cached textures
+	gzUInt64	textureReleasedBytes = 0;		// Pixels dropped from gizmo images after upload
+	gzUInt64	textureMemoryBytes = 0;			// Texture memory of live cached textures and atlas pages
+
+	gzUInt64	textureGameThreadMicroseconds = 0;	// Game thread time creating textures
+	gzUInt64	preparedUploads = 0;		// Uploads from data prepared in prebuild
+
+	gzUInt64	residentTextures = 0;		// Textures with mip residency control
+	gzUInt64	mipStoreBytes = 0;			// CPU copies of their full mip chains
+	gzUInt64	mipResidentBytes = 0;		// Mips of them uploaded to the GPU
+	gzUInt64	mipUpdates = 0;				// Textures rebuilt with another top mip
+	gzUInt64	mipBudgetDrops = 0;			// Mips held back by the budget in last update
+
+	gzUInt64	atlasUploads = 0;			// Images copied into atlas pages
+	gzUInt64	atlasUploadBytes = 0;
+
+	gzUInt64	materialInstances = 0;		// Created material instances
+	gzUInt64	materialCacheHits = 0;
+	gzUInt64	materialsInUse = 0;			// Cached instances referenced by components
+	gzUInt64	materialReferences = 0;		// Component references to cached instances
+	gzUInt64	materialsLive = 0;			// Cached instances not yet collected
+	gzUInt64	materialBytes = 0;			// Resource size of them
+};
+
+//! Texture data prepared in prebuild. The game thread only creates the UTexture2D
+class cswTextureBuild : public gzReference
+{
+public:
+	GZ_DECLARE_TYPE_INTERFACE;
+
+	virtual ~cswTextureBuild();
+
+	//! Hand the platform data to a texture
+	FTexturePlatformData* takePlatformData();
+
+	gzImagePtr				image;
+	FTexturePlatformData*	platformData = nullptr;
+	gzUInt64				bytes = 0;				// Image pixel bytes
+	gzUInt64				hash = 0;				// Content hash of mip 0
+
+	cswTextureMipStorePtr	store;					// Full mips when residency is controlled
+	gzUInt32				firstMip = 0;			// Top mip in platformData
+};
+
+GZ_DECLARE_REFPTR(cswTextureBuild);
+
 //! The resource manager will keep track of used materials and states and recycle them
 class cswResourceManager : public gzObject
 {
@@ -61,11 +119,138 @@ public:
 
 	CSWPLUGIN_API UMaterialInterface* initializeBaseMaterial();
 
-	CSWPLUGIN_API UMaterialInterface* getMaterial(UCSWSceneComponent *owner, gzState* state, cswMaterialType type = CSW_MATERIAL_TYPE_BASE_MATERIAL);
+	//! Shared material instance for equal states. The owner holds a reference until releaseMaterials
+	//! With an atlas region the page texture replaces texture 0 of the state
+	//! Prepared texture data for texture 0 is used if the texture is not cached
+	CSWPLUGIN_API UMaterialInterface* getMaterial(UCSWSceneComponent *owner, gzState* state, cswMaterialType type = CSW_MATERIAL_TYPE_BASE_MATERIAL, cswAtlasRegion* atlasRegion = nullptr, cswTextureBuild* prepared = nullptr);
+
+	//! Drop all material references held by owner. Call on destroy or before new materials are assigned
+	CSWPLUGIN_API gzVoid releaseMaterials(UCSWSceneComponent* owner);
+
+	//! Shared texture for an image. Cached by image and optionally by content
+	CSWPLUGIN_API UTexture2D* getTexture(gzImage* image, cswTextureBuild* prepared = nullptr);
+
+	//! Copy image mips into texture data, block compressed if enabled. Thread safe, called from factories in prebuild
+	CSWPLUGIN_API static cswTextureBuild* prepareTexture(gzImage* image, const BuildProperties& buildProperties);
+
+	//! Also match equal images with different gzImage instances. Costs a hash of mip 0 per new image
+	CSWPLUGIN_API gzVoid setTextureContentHash(gzBool on);
+
+	//! Drop gizmo image pixels once uploaded so only the texture keeps a copy. The texture is then
+	//! pinned until the image leaves the scene graph, as it can not be uploaded again
+	CSWPLUGIN_API gzVoid setReleaseImagePixels(gzBool on);
+
+	//! Keep a CPU copy of the mips and upload only the levels needed by the screen size of the components
+	//! using each texture. Budget in bytes of uploaded mips, 0 is unlimited. Bias scales the needed texels
+	CSWPLUGIN_API gzVoid setTextureMipResidency(gzBool on, gzUInt64 budget = 0, gzFloat bias = 1.0f);
+
+	//! Change resident mips from the view. Pixel scale is viewport height / (2 tan(vfov/2)). Game thread
+	CSWPLUGIN_API gzVoid updateTextureResidency(const FVector& viewLocation, gzDouble pixelScale);
+
+	//! Drop resident textures used only by owner to the smallest chain and keep them there until restored
+	//! Returns the uploaded bytes freed. The owner is only marked evicted when that is not 0
+	CSWPLUGIN_API gzUInt64 evictTextures(UCSWSceneComponent* owner);
+
+	CSWPLUGIN_API gzVoid restoreTextures(UCSWSceneComponent* owner);
+
+	CSWPLUGIN_API cswResourceStatistics getStatistics() const;
+
+	//! Release empty atlas pages and their textures
+	CSWPLUGIN_API gzVoid releaseEmptyAtlasPages();
 
 private:
 
+	struct TextureEntry
+	{
+		gzImagePtr					image;		// Keeps the key address valid while the entry lives
+		TWeakObjectPtr<UTexture2D>	texture;	// Freed by GC when the last material goes away
+		gzUInt64					bytes = 0;
+		gzUInt64					hash = 0;
+
+		TStrongObjectPtr<UTexture2D>	pinned;	// Set when image pixels are released
+	};
+
+	struct MaterialEntry
+	{
+		TWeakObjectPtr<UMaterialInstanceDynamic>	material;	// Kept alive by the components using it
+		gzUInt32									refs = 0;
+		UTexture2D*									texture = nullptr;	// Key into m_residency only
+	};
+
+	struct ResidencyEntry
+	{
+		TWeakObjectPtr<UTexture2D>	texture;
+		cswTextureMipStorePtr		store;
+		gzUInt32					firstMip = 0;		// Resident top mip
+		gzUInt32					wantedMip = 0;
+		gzFloat						neededTexels = 0;	// Largest on screen size of any user
+	};
+
+	// Remove entries whose texture is collected
+	gzVoid purgeTextures();
+
+	// Remove unreferenced entries whose material is collected
+	gzVoid purgeMaterials();
+
+	// Only what the instance sets. The base material has no color or blend parameters
+	static gzUInt64 materialKey(UTexture2D* texture, cswMaterialType type);
+
+	// Page texture with the region pixels uploaded
+	UTexture2D* getAtlasTexture(cswAtlasRegion* region);
+
+	static UTexture2D* createAtlasPage(gzUInt32 size, EPixelFormat format, gzUInt32 mipLevels);
+
+	static gzVoid uploadAtlasRegion(UTexture2D* page, cswAtlasRegion* region);
+
+	static gzUInt64 imageBytes(gzImage* image);
+
+	static gzUInt64 platformBytes(FTexturePlatformData* platformData);
+
+	// Top mip of the smallest resident chain. New textures start here
+	static gzUInt32 lowestMip(cswTextureMipStore* store);
+
+	// Rebuild the texture resource with mips from firstMip
+	gzVoid applyResidency(ResidencyEntry& entry, gzUInt32 firstMip);
+
+	// Texture from platform data starting at firstMip of the store, with an entry in m_residency
+	UTexture2D* createResidentTexture(cswTextureMipStore* store, FTexturePlatformData* platformData, gzUInt32 firstMip);
+
+	// FALSE while a manager thread prepares the image
+	static gzBool releasePixels(gzImage* image);
+
+	// Drop image pixels of an uploaded entry and pin its texture
+	gzVoid releaseAfterUpload(TextureEntry& entry, UTexture2D* texture);
+
+	static cswTextureBuild* prepareTextureData(gzImage* image, const BuildProperties& buildProperties);
+
+	static gzUInt64 imageHash(gzImage* image);
+
 	TObjectPtr<UMaterialInterface>	m_baseMaterial;
+
+	// Game thread only
+	TMap<gzImage*, TextureEntry>	m_textureByImage;
+	TMap<gzUInt64, TextureEntry>	m_textureByHash;
+	gzBool							m_textureContentHash = FALSE;
+	gzBool							m_releaseImagePixels = FALSE;
+	TArray<gzImagePtr>				m_pendingRelease;		// Uploaded images still read by prepareTexture
+	gzUInt32						m_texturePurgeCounter = 0;
+
+	TMap<gzUInt64, MaterialEntry>					m_materials;
+	TMap<UCSWSceneComponent*, TArray<gzUInt64>>		m_materialOwners;
+	gzUInt32										m_materialPurgeCounter = 0;
+
+	TMap<gzUInt32, TStrongObjectPtr<UTexture2D>>	m_atlasPages;		// Page id to texture
+	TArray<cswTextureAtlasPtr>						m_atlases;			// Atlases with pages in m_atlasPages
+	gzUInt32										m_atlasReleaseCounter = 0;
+
+	TMap<UTexture2D*, ResidencyEntry>	m_residency;
+	TSet<UCSWSceneComponent*>			m_evictedOwners;
+	gzBool								m_mipResidency = FALSE;
+	gzUInt64							m_mipBudget = 0;
+	gzFloat								m_mipBias = 1.0f;
+	gzDouble							m_residencyTime = 0;
+
+	cswResourceStatistics			m_statistics;
 };
 
 GZ_DECLARE_REFPTR(cswResourceManager);
@@ -43,7 +43,12 @@
 #include "cswUESceneManager.h"
 #include "cswCommandReceiver.h"
 #include "cswResourceManager.h"
+#include "cswMemoryBudget.h"
+#include "cswHeightCache.h"
+#include "cswMeshBVH.h"
 #include "gzMutex.h"
+#include "gzCoordinate.h"
+#include "gzAltitudeLookup.h"
 
 #include "UEGlue/cswUETemplates.h"
 #include "UEGlue//cswUETypes.h"
@@ -51,6 +56,8 @@
 
 #include "CSWScene.generated.h"
 class cswSceneCommandGroundClampPositionResponse;
+class cswSceneCommandIntersectResponse;
+class UCSWRoiNode;
 
 USTRUCT(BlueprintType)
 struct FCSWGroundClampResult
@@ -74,9 +81,599 @@ struct FCSWGroundClampResult
 
 	UPROPERTY(BlueprintReadOnly, Category="CSW|GroundClamp")
 	int32 RequestId = 0;
+
+	// Altitude from the DEM of AltitudeLookupDirectory. A clamp response with the same RequestId refines it
+	UPROPERTY(BlueprintReadOnly, Category="CSW|GroundClamp")
+	bool bApproximate = false;
+
+	// Meters from the approximate altitude to this response. 0 if the request had no approximation
+	UPROPERTY(BlueprintReadOnly, Category="CSW|GroundClamp")
+	double ApproximationError = 0.0;
+};
+
+// Batch ground clamp result as structure of arrays in request order
+USTRUCT(BlueprintType)
+struct FCSWGroundClampBatchResult
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category="CSW|GroundClamp")
+	int32 RequestId = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category="CSW|GroundClamp")
+	TArray<FVector> WorldPositions;
+
+	UPROPERTY(BlueprintReadOnly, Category="CSW|GroundClamp")
+	TArray<FVector> WorldNormals;
+
+	UPROPERTY(BlueprintReadOnly, Category="CSW|GroundClamp")
+	TArray<double> Altitudes;
+
+	// False where the point could not be clamped
+	UPROPERTY(BlueprintReadOnly, Category="CSW|GroundClamp")
+	TArray<bool> Valid;
+
+	UPROPERTY(BlueprintReadOnly, Category="CSW|GroundClamp")
+	int32 Clamped = 0;
+};
+
+// Gizmo intersect mask bits
+UENUM(BlueprintType, meta = (Bitflags))
+enum class ECSWIntersectMask : uint8
+{
+	Custom				= 0,
+	Ground				= 1,
+	Water				= 2,
+	Building			= 3,
+	Forest				= 4,
+	Human				= 5,
+	Animal				= 6,
+	Vehicle				= 7,
+	Overlay				= 8,
+	Underlay			= 9,
+	Collider			= 10,
+	GroundConstruction	= 11,
+	ScatteredObject		= 12,
+};
+
+// Ray or line of sight batch result as structure of arrays in request order
+USTRUCT(BlueprintType)
+struct FCSWIntersectResult
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Intersect")
+	int32 RequestId = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Intersect")
+	bool bLineOfSight = false;
+
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Intersect")
+	TArray<bool> Hit;
+
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Intersect")
+	TArray<FVector> WorldPositions;
+
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Intersect")
+	TArray<FVector> WorldNormals;
+
+	// UE units from the start to the hit
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Intersect")
+	TArray<double> Distances;
+
+	// Line of sight only. True where nothing is hit before the end point
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Intersect")
+	TArray<bool> Visible;
+
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Intersect")
+	int32 Hits = 0;
+};
+
+// Synchronous intersection with built geometry
+USTRUCT(BlueprintType)
+struct FCSWLocalHit
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Intersect")
+	bool bHit = false;
+
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Intersect")
+	FVector WorldPosition = FVector::ZeroVector;
+
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Intersect")
+	FVector WorldNormal = FVector::ZeroVector;
+
+	// UE units from the start
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Intersect")
+	double Distance = 0.0;
+
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Intersect")
+	TObjectPtr<UCSWSceneComponent> Component = nullptr;
+};
+
+UENUM(BlueprintType)
+enum class ECSWHeightSource : uint8
+{
+	None,
+	Terrain,		// Height grid of loaded terrain geometry
+	GroundClamp,	// Earlier ground clamp responses
+};
+
+// Synchronous height query result
+USTRUCT(BlueprintType)
+struct FCSWHeightResult
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category="CSW|GroundClamp")
+	bool bValid = false;
+
+	UPROPERTY(BlueprintReadOnly, Category="CSW|GroundClamp")
+	FVector WorldPosition = FVector::ZeroVector;
+
+	UPROPERTY(BlueprintReadOnly, Category="CSW|GroundClamp")
+	double Altitude = 0.0;
+
+	UPROPERTY(BlueprintReadOnly, Category="CSW|GroundClamp")
+	ECSWHeightSource Source = ECSWHeightSource::None;
+
+	// Estimated error in meters. Negative when not known
+	UPROPERTY(BlueprintReadOnly, Category="CSW|GroundClamp")
+	float Accuracy = -1.0f;
+
+	// Seconds since the data was built or measured
+	UPROPERTY(BlueprintReadOnly, Category="CSW|GroundClamp")
+	float Age = 0.0f;
+
+	// Ground clamp data older than HeightCacheMaxAge
+	UPROPERTY(BlueprintReadOnly, Category="CSW|GroundClamp")
+	bool bStale = false;
+
+	// Ground clamp requested on a miss or stale data. 0 if none
+	UPROPERTY(BlueprintReadOnly, Category="CSW|GroundClamp")
+	int32 RequestId = 0;
+};
+
+// Batch geodetic to world result as structure of arrays
+USTRUCT(BlueprintType)
+struct FCSWWorldPositions
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Geo")
+	TArray<double> X;
+
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Geo")
+	TArray<double> Y;
+
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Geo")
+	TArray<double> Z;
+
+	// False where the position could not be converted
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Geo")
+	TArray<bool> Valid;
+};
+
+// Batch world to geodetic result as structure of arrays. Degrees and meters
+USTRUCT(BlueprintType)
+struct FCSWGeodeticPositions
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Geo")
+	TArray<double> Latitude;
+
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Geo")
+	TArray<double> Longitude;
+
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Geo")
+	TArray<double> Altitude;
+
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Geo")
+	TArray<bool> Valid;
+};
+
+USTRUCT(BlueprintType)
+struct FCSWBuildStatistics
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Statistics")
+	int64 Meshes = 0;
+
+	// Geometry that could not be converted to a mesh and is not shown
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Statistics")
+	int64 MeshesFailed = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Statistics")
+	int64 Meshes16Bit = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Statistics")
+	int64 Vertices = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Statistics")
+	int64 IndexBytes = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Statistics")
+	int64 IndexBytesSaved = 0;
+
+	// Average transformed vertices per triangle for a 16 entry FIFO cache with OptimizeVertexCache, before and
+	// after reordering. 0 when nothing was reordered
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Statistics")
+	double VertexCacheACMRBefore = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Statistics")
+	double VertexCacheACMRAfter = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Statistics")
+	int64 TexturesPrepared = 0;
+
+	// Manager thread time copying texture data in prebuild
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Statistics")
+	double TexturePrepareMilliseconds = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Statistics")
+	int64 TexturesCompressed = 0;
+
+	// Kept uncompressed as the RMSE was above TextureCompressionMaxRMSE
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Statistics")
+	int64 TexturesCompressionRejected = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Statistics")
+	int64 TextureCompressionBytesSaved = 0;
+
+	// Images without sub images that got a generated mip chain
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Statistics")
+	int64 TexturesMipGenerated = 0;
+
+	// Triangle BVHs for LocalIntersect
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Statistics")
+	int64 IntersectTrees = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Statistics")
+	double IntersectTreeMilliseconds = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Statistics")
+	int64 IntersectTreeBytes = 0;
+};
+
+USTRUCT(BlueprintType)
+struct FCSWResourceStatistics
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Statistics")
+	int64 TextureUploads = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Statistics")
+	int64 TextureUploadBytes = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Statistics")
+	int64 TextureCacheHits = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Statistics")
+	int64 TextureBytesSaved = 0;
+
+	// Pixel bytes still held by gizmo images of cached textures
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Statistics")
+	int64 TextureResidentBytes = 0;
+
+	// Pixel bytes dropped from gizmo images after upload
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Statistics")
+	int64 TextureReleasedBytes = 0;
+
+	// Texture memory of cached textures and atlas pages
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Statistics")
+	int64 TextureMemoryBytes = 0;
+
+	// Game thread time creating textures
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Statistics")
+	double TextureGameThreadMilliseconds = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Statistics")
+	int64 PreparedUploads = 0;
+
+	// Textures with mips uploaded by screen size
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Statistics")
+	int64 ResidentTextures = 0;
+
+	// CPU copies of their full mip chains
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Statistics")
+	int64 MipStoreBytes = 0;
+
+	// Mips of them uploaded to the GPU
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Statistics")
+	int64 MipResidentBytes = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Statistics")
+	int64 MipUpdates = 0;
+
+	// Mips held back by TextureMemoryBudgetMB in the last update
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Statistics")
+	int64 MipBudgetDrops = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Statistics")
+	int64 AtlasUploads = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Statistics")
+	int64 AtlasUploadBytes = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Statistics")
+	int64 MaterialInstances = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Statistics")
+	int64 MaterialCacheHits = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Statistics")
+	int64 MaterialsInUse = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Statistics")
+	int64 MaterialReferences = 0;
+
+	// Cached material instances not yet collected and their resource size
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Statistics")
+	int64 MaterialsLive = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Statistics")
+	int64 MaterialBytes = 0;
+};
+
+USTRUCT(BlueprintType)
+struct FCSWAtlasStatistics
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Statistics")
+	int32 Pages = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Statistics")
+	int32 Regions = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Statistics")
+	int64 Allocations = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Statistics")
+	int64 UsedTexels = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Statistics")
+	int64 FreeTexels = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Statistics")
+	int64 LargestFreeTexels = 0;
+
+	// 1 - sum of largest free block per page / free area
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Statistics")
+	float Fragmentation = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Statistics")
+	int64 ReleasedPages = 0;
+};
+
+USTRUCT(BlueprintType)
+struct FCSWMemoryBudgetStatistics
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Statistics")
+	int64 BudgetBytes = 0;
+
+	// Mesh, texture and material memory
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Statistics")
+	int64 UsedBytes = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Statistics")
+	int64 MeshBytes = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Statistics")
+	int64 TextureBytes = 0;
+
+	// Cached material instances
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Statistics")
+	int64 MaterialBytes = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Statistics")
+	int32 Materials = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Statistics")
+	int32 Components = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Statistics")
+	int32 EvictedComponents = 0;
+
+	// Used / budget
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Statistics")
+	float Pressure = 0;
+
+	// Applied on top of LodFactor
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Statistics")
+	float LodFactorScale = 1;
+
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Statistics")
+	int64 Evictions = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Statistics")
+	int64 Restores = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Statistics")
+	int64 LodRaises = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Statistics")
+	int64 LodLowers = 0;
+};
+
+USTRUCT(BlueprintType)
+struct FCSWHeightCacheStatistics
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Statistics")
+	int32 Tiles = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Statistics")
+	int32 ClampSamples = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Statistics")
+	int64 Bytes = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Statistics")
+	int64 Hits = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Statistics")
+	int64 Misses = 0;
+};
+
+USTRUCT(BlueprintType)
+struct FCSWApproximateClampStatistics
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Statistics")
+	int32 Datasets = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Statistics")
+	int64 Requests = 0;
+
+	// Requests the DEM covered
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Statistics")
+	int64 Approximated = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Statistics")
+	int64 Refined = 0;
+
+	// Time to the approximate answer and to the clamp response, from the request
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Statistics")
+	double MeanApproximateMilliseconds = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Statistics")
+	double MeanRefinedMilliseconds = 0;
+
+	// Meters between approximate and refined altitudes
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Statistics")
+	double MeanError = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Statistics")
+	double MaxError = 0;
+};
+
+USTRUCT(BlueprintType)
+struct FCSWLocalIntersectStatistics
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Statistics")
+	int32 Components = 0;
+
+	// Unique trees. Instanced geometry shares one
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Statistics")
+	int32 Meshes = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Statistics")
+	int64 Triangles = 0;
+
+	// Mesh trees and the top level tree
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Statistics")
+	int64 Bytes = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Statistics")
+	int64 Queries = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category="CSW|Statistics")
+	int64 Hits = 0;
 };
 
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FCSWGroundClampResponse, const FCSWGroundClampResult&, Result);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FCSWGroundClampBatchResponse, const FCSWGroundClampBatchResult&, Result);
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FCSWIntersectResponse, const FCSWIntersectResult&, Result);
+
+// Approximate ground clamp waiting for its response
+struct cswApproximateClamp
+{
+	double		altitude = 0;
+	double		time = 0;					// gzTime::systemSeconds of the request
+	bool		valid = false;				// DEM covered the position
+};
+
+struct cswApproximateClampCounters
+{
+	gzUInt64	requests = 0;
+	gzUInt64	approximated = 0;
+	gzUInt64	refined = 0;
+	gzDouble	approximateSeconds = 0;
+	gzDouble	refinedSeconds = 0;
+	gzUInt64	errorSamples = 0;
+	gzDouble	errorSum = 0;
+	gzDouble	errorMax = 0;
+};
+
+// Pending ray or line of sight batch. Rays use request ids firstId .. firstId + count - 1
+struct cswIntersectBatch
+{
+	gzUInt32					firstId = 0;
+	int32						received = 0;
+
+	TArray<FVector3d>			starts;			// UE world
+	TArray<double>				lengths;		// Line of sight segment lengths in UE units
+
+	FCSWIntersectResult			result;
+};
+
+// Pending ground clamp batch. Points use request ids firstId .. firstId + count - 1
+struct cswGroundClampBatch
+{
+	gzUInt32					firstId = 0;
+	int32						received = 0;
+
+	FCSWGroundClampBatchResult	result;
+};
+
+// GZ/UE matrices for one CoordType, scale and offset. Rotation parts have no offset and are used for vectors
+struct cswMatrixCacheEntry
+{
+	gzBool					valid = FALSE;
+
+	CoordType				type = CoordType::Geometry;
+	double					scale = 0;
+	gzVec3D					offset;
+
+	gzMatrix4D				gzToUE;
+	gzMatrix4D				ueToGZ;
+	gzMatrix4D				gzToUERotation;
+	gzMatrix4D				ueToGZRotation;
+};
+
+// Parsed map coordinate system and GZ/UE matrices used by the geodetic conversions
+struct cswGeoContext
+{
+	gzBool					valid = FALSE;		// Cleared on new geo info, CoordType or origin change
+	gzBool					hasSystem = FALSE;	// CoordSystem could be parsed
+
+	gzCoordSystem			system;
+	gzCoordSystemMetaData	meta;
+
+	CoordType				type = CoordType::Geometry;
+	double					scale = 0;			// WorldToMeters of the matrices
+
+	gzMatrix4D				gzToUE;
+	gzMatrix4D				ueToGZ;
+
+	gzBool					kernel = FALSE;		// Batches use the WGS84 geocentric or UTM kernels
+	double					kernelError = -1;	// Largest difference to gzCoordinate in meters near the origin
+	double					centralMeridian = 0;	// UTM radians
+	double					falseNorthing = 0;
+
+	// Second order expansion of the map around the origin in (latitude, longitude, altitude)
+	gzBool					tangent = FALSE;
+	double					tangentRadius = 0;		// Meters where the error stays below GeoTangentTolerance
+	double					tangentTolerance = 0;	// Largest inverse residual accepted in meters
+	gzLatPos				tangentOrigin;			// Radians
+	gzVec3D					tangentPosition;
+	double					tangentScale[2];		// Meters per radian of latitude and longitude
+	double					tangentJacobian[3][3];	// Map axis by (latitude, longitude, altitude)
+	double					tangentInverse[3][3];
+	double					tangentHessian[3][6];	// lat2, lon2, alt2, lat lon, lat alt, lon alt
+};
 
 UCLASS(meta = (BlueprintSpawnableComponent))
 class CSWPLUGIN_API UCSWScene : public UCSWSceneComponent,
@@ -132,12 +729,129 @@ public:
 	UPROPERTY(EditAnywhere, Category = "CSW")
 	uint32 FrameSkipLatency = 5;
 
+	// Build gzLod children into one multi LOD static mesh. UE switches LOD by screen size
+	UPROPERTY(EditAnywhere, Category = "CSW")
+	bool MergeLodLevels = false;
+
+	// Reorder triangles for post transform vertex cache reuse (Forsyth)
+	UPROPERTY(EditAnywhere, Category = "CSW")
+	bool OptimizeVertexCache = false;
+
+	// Updated geometry with unchanged topology writes changed vertex ranges in place
+	UPROPERTY(EditAnywhere, Category = "CSW")
+	bool PartialGeometryUpdates = false;
+
+	// Geometry updated more often than this (per second) uses a procedural mesh. 0 disables
+	UPROPERTY(EditAnywhere, Category = "CSW")
+	float DynamicMeshUpdateRate = 0;
+
+	// Seconds without updates before a procedural mesh goes back to a static mesh
+	UPROPERTY(EditAnywhere, Category = "CSW")
+	float DynamicMeshIdleTime = 2.0;
+
+	// Share textures between equal images from different tiles, not only the same gzImage
+	UPROPERTY(EditAnywhere, Category = "CSW")
+	bool TextureContentHash = false;
+
+	// Copy texture data in prebuild on the manager thread. Game thread only creates the texture object
+	UPROPERTY(EditAnywhere, Category = "CSW")
+	bool PrepareTextures = true;
+
+	// Drop gizmo image pixels after texture upload so one copy is kept. Not applied with TextureAtlas
+	UPROPERTY(EditAnywhere, Category = "CSW")
+	bool ReleaseImagePixels = false;
+
+	// Encode RGB/RGBA textures to BC1 (opaque) or BC3 (alpha) in prebuild. Needs PrepareTextures
+	UPROPERTY(EditAnywhere, Category = "CSW")
+	bool CompressTextures = false;
+
+	// Slower principal axis encoder with a least squares pass. Off uses bounding box endpoints
+	UPROPERTY(EditAnywhere, Category = "CSW")
+	bool TextureCompressionHighQuality = true;
+
+	// Textures with a higher RMSE (0..1) after compression stay uncompressed. 0 accepts all
+	UPROPERTY(EditAnywhere, Category = "CSW")
+	float TextureCompressionMaxRMSE = 0.02;
+
+	// Filter a gamma correct mip chain on worker threads for images without mips. Needs PrepareTextures
+	UPROPERTY(EditAnywhere, Category = "CSW")
+	bool GenerateMips = false;
+
+	// Kaiser windowed sinc keeps more detail in distant mips. Off uses a 2x2 box
+	UPROPERTY(EditAnywhere, Category = "CSW")
+	bool KaiserMipFilter = false;
+
+	// Keep full mips on the CPU and upload only the levels needed by the screen size of each tile
+	UPROPERTY(EditAnywhere, Category = "CSW")
+	bool TextureMipResidency = false;
+
+	// Budget for uploaded mips of resident textures in MB. 0 is unlimited
+	UPROPERTY(EditAnywhere, Category = "CSW")
+	int32 TextureMemoryBudgetMB = 0;
+
+	// Scale of the texels needed per screen pixel. Lower keeps smaller mips
+	UPROPERTY(EditAnywhere, Category = "CSW")
+	float TextureResidencyBias = 1.0;
+
+	// Mesh, texture and material memory budget in MB. 0 disables. Turns on mip residency. Over budget textures
+	// of components not seen for MemoryBudgetEvictAge drop to small mips, then LodFactor is raised
+	UPROPERTY(EditAnywhere, Category = "CSW")
+	int32 MemoryBudgetMB = 0;
+
+	// Largest factor the budget applies to LodFactor
+	UPROPERTY(EditAnywhere, Category = "CSW")
+	float MemoryBudgetMaxLodFactorScale = 4.0;
+
+	// Seconds off screen before a component can be evicted
+	UPROPERTY(EditAnywhere, Category = "CSW")
+	float MemoryBudgetEvictAge = 10.0;
+
+	// Pack small power of two tile textures into shared pages. Applies to geometry built from now on
+	UPROPERTY(EditAnywhere, Category = "CSW")
+	bool TextureAtlas = false;
+
+	// Atlas page size in texels (512..8192). Tiles up to 256 texels are packed
+	UPROPERTY(EditAnywhere, Category = "CSW")
+	int32 TextureAtlasPageSize = 2048;
+
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CSW")
 	bool AllowCustomOrigin = false;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CSW")
 	bool CenterOrigin = true;
 
+	// Geodetic conversions near the map origin use a local second order expansion with at most this error
+	// in meters. The radius is found when the map is loaded. 0 always uses the exact conversion
+	UPROPERTY(EditAnywhere, Category = "CSW")
+	float GeoTangentTolerance = 0;
+
+	// Rebase the root and top level rois to the camera when it is further than FloatingOriginDistance map units
+	// from the current origin. Paused while content outside rois is loaded
+	UPROPERTY(EditAnywhere, Category = "CSW")
+	bool FloatingOrigin = false;
+
+	UPROPERTY(EditAnywhere, Category = "CSW")
+	double FloatingOriginDistance = 10000;
+
+	// Directory searched recursively for .alt DEM datasets. RequestGroundClampApproximate answers from them at
+	// once before terrain is loaded. Empty disables
+	UPROPERTY(EditAnywhere, Category = "CSW")
+	FString AltitudeLookupDirectory;
+
+	// Keep terrain heights and ground clamp responses on the game thread for GetGroundHeight.
+	// Projected, UTM and geometry maps only. Applies to terrain built from now on
+	UPROPERTY(EditAnywhere, Category = "CSW")
+	bool HeightCache = false;
+
+	// Seconds before a cached ground clamp response is stale
+	UPROPERTY(EditAnywhere, Category = "CSW")
+	float HeightCacheMaxAge = 60.0;
+
+	// Keep a triangle BVH of built geometry on the CPU for IntersectSegment and IntersectRay.
+	// Applies to geometry built from now on. Costs memory, see GetLocalIntersectStatistics
+	UPROPERTY(EditAnywhere, Category = "CSW")
+	bool LocalIntersect = false;
+
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "CSW")
 	UCSWGeoComponent* GeoOrigin;
 
@@ -206,15 +920,48 @@ protected:
 	bool onMapUrlsPropertyUpdate();
 	bool onCoordTypePropertyUpdate();
 	bool onCenterOriginPropertyUpdate();
+	bool onGeoContextPropertyUpdate();
 	bool onOmniViewPropertyUpdate();
 	bool onLodFactorPropertyUpdate();
+	bool onBuildPropertiesUpdate();
+	bool onResourcePropertiesUpdate();
+	bool onMemoryBudgetPropertyUpdate();
+	bool onFloatingOriginPropertyUpdate();
+	bool onHeightCachePropertyUpdate();
+	bool onLocalIntersectPropertyUpdate();
+	bool onAltitudeLookupPropertyUpdate();
+
+	// TextureMipResidency or a memory budget, which evicts through it
+	bool useMipResidency() const;
 
 	// Utilities
 	double getWorldScale() const;
 	void updateOriginTransform();
 
+	// Floating origin. Only the root and top level rois are moved
+	void trackFloatingOrigin(UCSWSceneComponent* component, bool add);
+	void updateFloatingOrigin(const gzVec3D& camera);
+	void rebaseFloatingOrigin(const gzVec3D& offset);
+
+	// Height tile of built terrain geometry into the height cache
+	void updateHeightCache(UCSWSceneComponent* component, gzNode* node);
+	bool sampleHeightCache(const gzVec3D& position, FCSWHeightResult& outResult);
+
+	// Triangle BVH of built geometry into the top level tree
+	void updateLocalIntersect(UCSWSceneComponent* component, gzNode* node);
+
 	virtual gzVoid onCommand(cswSceneManager* manager, cswCommandBuffer* buffer) override;
 
+	// Matrices are built and inverted once per CoordType, scale and offset. Game thread
+	const cswMatrixCacheEntry& getMatrices(enum CoordType type, const double& scale, const gzVec3D& offset) const;
+	const cswMatrixCacheEntry& getRotationMatrices(enum CoordType type, const double& scale) const;
+
+	// Cached coordinate system for geodetic conversions. nullptr without a valid CoordSystem. Game thread
+	const cswGeoContext* getGeoContext() const;
+	void invalidateGeoContext();
+
+
+public:
 	FVector3d GZ_2_UE(const gzVec3D& local, enum CoordType type, const double& scale = 1.0, const gzVec3D& offset = gzVec3D(0, 0, 0)) const;
 	gzVec3D UE_2_GZ(const FVector3d& global,enum CoordType type, const double& scale = 1.0, const gzVec3D& offset = gzVec3D(0, 0, 0)) const;
 
@@ -225,12 +972,13 @@ protected:
 	gzMatrix4D GZ_2_UE(enum CoordType type, const double& scale=1.0, const gzVec3D& offset = gzVec3D(0, 0, 0)) const;
 	gzMatrix4D UE_2_GZ(enum CoordType type, const double& scale=1.0, const gzVec3D& offset = gzVec3D(0, 0, 0)) const;
 
+	// UE location of the map origin without floating origin offset
+	FVector3d getMapLocation() const;
+
 	// Local coordinate conversion (includes scene origin offset)
 	FVector3d GZ_2_UE_Local(const gzVec3D& position) const;
 	gzVec3D UE_2_GZ_Local(const FVector3d& world) const;
 
-
-public:
 	// Geodetic <-> UE world conversion (current map coordinate system)
 	bool GeodeticToWorld(double latitudeDeg, double longitudeDeg, double altitudeMeters, FVector3d& outWorld) const;
 	bool WorldToGeodetic(const FVector3d& world, double& outLatitudeDeg, double& outLongitudeDeg, double& outAltitudeMeters) const;
@@ -239,6 +987,15 @@ public:
 	UFUNCTION(BlueprintCallable, Category="CSW|Geo")
 	bool WorldToGeodeticBP(const FVector& world, double& outLatitudeDeg, double& outLongitudeDeg, double& outAltitudeMeters) const;
 
+	// Batch conversions through the cached coordinate system. Batches above 1024 items run on worker threads
+	// Altitudes may be empty for 0. Returns the number of converted positions
+	int32 GeodeticToWorldBatch(TConstArrayView<double> latitudesDeg, TConstArrayView<double> longitudesDeg, TConstArrayView<double> altitudesMeters, FCSWWorldPositions& outWorld) const;
+	int32 WorldToGeodeticBatch(TConstArrayView<FVector3d> world, FCSWGeodeticPositions& outGeodetic) const;
+	UFUNCTION(BlueprintCallable, Category="CSW|Geo")
+	int32 GeodeticToWorldBatchBP(const TArray<double>& latitudesDeg, const TArray<double>& longitudesDeg, const TArray<double>& altitudesMeters, FCSWWorldPositions& outWorld) const;
+	UFUNCTION(BlueprintCallable, Category="CSW|Geo")
+	int32 WorldToGeodeticBatchBP(const TArray<FVector>& world, FCSWGeodeticPositions& outGeodetic) const;
+
 	UFUNCTION(BlueprintCallable, Category="CSW|GroundClamp")
 	int32 RequestGroundClampPosition(double latitudeDeg, double longitudeDeg, double heightAboveGround = 1000.0, bool waitForData = false);
 
@@ -249,6 +1006,110 @@ public:
 	UPROPERTY(BlueprintAssignable, Category="CSW|GroundClamp")
 	FCSWGroundClampResponse OnGroundClampResponse;
 
+	// Ground clamp that also answers at once from the DEM of AltitudeLookupDirectory. outApproximate is flagged
+	// bApproximate and valid when the DEM covers the position. The clamp response refines it as usual
+	UFUNCTION(BlueprintCallable, Category="CSW|GroundClamp")
+	int32 RequestGroundClampApproximate(double latitudeDeg, double longitudeDeg, FCSWGroundClampResult& outApproximate, double heightAboveGround = 1000.0, bool waitForData = false);
+
+	// Ground position from the DEM only. False without AltitudeLookupDirectory or outside the datasets
+	UFUNCTION(BlueprintCallable, Category="CSW|GroundClamp")
+	bool GetApproximateGroundPosition(double latitudeDeg, double longitudeDeg, FCSWGroundClampResult& outResult);
+
+	// Clamps all points with one id allocation and one result. Responses are collected per point and
+	// OnGroundClampBatchResponse fires once when the last one arrives. Returns the batch request id
+	int32 RequestGroundClampBatch(TConstArrayView<double> latitudesDeg, TConstArrayView<double> longitudesDeg, double heightAboveGround = 1000.0, bool waitForData = false);
+	UFUNCTION(BlueprintCallable, Category="CSW|GroundClamp")
+	int32 RequestGroundClampBatchBP(const TArray<double>& latitudesDeg, const TArray<double>& longitudesDeg, double heightAboveGround = 1000.0, bool waitForData = false);
+
+	// True once all points of the batch are answered
+	UFUNCTION(BlueprintCallable, Category="CSW|GroundClamp")
+	bool TryGetGroundClampBatchResponse(int32 requestId, FCSWGroundClampBatchResult& outResult);
+
+	UPROPERTY(BlueprintAssignable, Category="CSW|GroundClamp")
+	FCSWGroundClampBatchResponse OnGroundClampBatchResponse;
+
+	// Rays from UE world starts along directions up to maxDistance UE units. All rays share one request id and
+	// OnIntersectResponse fires once when the last one is answered. Mask bits are ECSWIntersectMask
+	int32 RequestRayIntersections(TConstArrayView<FVector3d> starts, TConstArrayView<FVector3d> directions, double maxDistance, int32 intersectMask = 6, bool waitForData = false);
+	UFUNCTION(BlueprintCallable, Category="CSW|Intersect")
+	int32 RequestRayIntersectionsBP(const TArray<FVector>& starts, const TArray<FVector>& directions, double maxDistance, UPARAM(meta = (Bitmask, BitmaskEnum = "/Script/CSWPlugin.ECSWIntersectMask")) int32 intersectMask = 6, bool waitForData = false);
+
+	// Segments between UE world points. Visible where nothing in the mask is hit before the end point
+	int32 RequestLineOfSight(TConstArrayView<FVector3d> from, TConstArrayView<FVector3d> to, int32 intersectMask = 6, bool waitForData = false);
+	UFUNCTION(BlueprintCallable, Category="CSW|Intersect")
+	int32 RequestLineOfSightBP(const TArray<FVector>& from, const TArray<FVector>& to, UPARAM(meta = (Bitmask, BitmaskEnum = "/Script/CSWPlugin.ECSWIntersectMask")) int32 intersectMask = 6, bool waitForData = false);
+
+	// True once all rays of the request are answered
+	UFUNCTION(BlueprintCallable, Category="CSW|Intersect")
+	bool TryGetIntersectResponse(int32 requestId, FCSWIntersectResult& outResult);
+
+	UPROPERTY(BlueprintAssignable, Category="CSW|Intersect")
+	FCSWIntersectResponse OnIntersectResponse;
+
+	// Ground height from the height cache at once. Returns false on a miss. On a miss or stale data a ground clamp
+	// is requested when requestOnMiss is set and its id returned in the result; the response refines the cache
+	UFUNCTION(BlueprintCallable, Category="CSW|GroundClamp")
+	bool GetGroundHeight(double latitudeDeg, double longitudeDeg, FCSWHeightResult& outResult, bool requestOnMiss = true);
+
+	UFUNCTION(BlueprintCallable, Category="CSW|GroundClamp")
+	bool GetGroundHeightAtWorld(const FVector& world, FCSWHeightResult& outResult, bool requestOnMiss = true);
+
+	// Nearest hit with visible built geometry between UE world points at once. Needs LocalIntersect and only
+	// sees geometry loaded on the game thread; use RequestLineOfSight for the full scene graph
+	UFUNCTION(BlueprintCallable, Category="CSW|Intersect")
+	bool IntersectSegment(const FVector& start, const FVector& end, FCSWLocalHit& outHit);
+
+	UFUNCTION(BlueprintCallable, Category="CSW|Intersect")
+	bool IntersectRay(const FVector& start, const FVector& direction, double maxDistance, FCSWLocalHit& outHit);
+
+	// Mesh build counters for current map
+	UFUNCTION(BlueprintCallable, Category="CSW|Statistics")
+	FCSWBuildStatistics GetBuildStatistics() const;
+
+	// Runs the geometry factory on a test fan with partial updates. A vertex edit after a full build that was
+	// never shown must rebuild the mesh, and one after a shown build must reuse it with a delta. Game thread
+	UFUNCTION(BlueprintCallable, Category="CSW")
+	bool CheckPartialGeometryUpdate() const;
+
+	// Texture and material sharing counters for current map
+	UFUNCTION(BlueprintCallable, Category="CSW|Statistics")
+	FCSWResourceStatistics GetResourceStatistics() const;
+
+	// Page usage of the texture atlas
+	UFUNCTION(BlueprintCallable, Category="CSW|Statistics")
+	FCSWAtlasStatistics GetAtlasStatistics() const;
+
+	// Usage and pressure of the memory budget
+	UFUNCTION(BlueprintCallable, Category="CSW|Statistics")
+	FCSWMemoryBudgetStatistics GetMemoryBudgetStatistics() const;
+
+	// Tiles, clamp samples and hit rate of the height cache
+	UFUNCTION(BlueprintCallable, Category="CSW|Statistics")
+	FCSWHeightCacheStatistics GetHeightCacheStatistics() const;
+
+	// Trees, memory and queries of LocalIntersect
+	UFUNCTION(BlueprintCallable, Category="CSW|Statistics")
+	FCSWLocalIntersectStatistics GetLocalIntersectStatistics() const;
+
+	// Approximate ground clamps and how far the refined responses moved them
+	UFUNCTION(BlueprintCallable, Category="CSW|Statistics")
+	FCSWApproximateClampStatistics GetApproximateClampStatistics() const;
+
+	// Largest difference in meters between the WGS84 geocentric and UTM batch kernels and gzCoordinate around
+	// a point in degrees, in the UTM zone of the point. Negative if gzCoordinate fails
+	UFUNCTION(BlueprintCallable, Category="CSW|Geo")
+	double CheckGeoKernels(double Latitude, double Longitude) const;
+
+	// Largest forward or inverse difference in meters between the geo tangent and gzCoordinate at random points
+	// just inside the tangent radius. Also fails if the tangent is used just outside. Negative without a tangent
+	UFUNCTION(BlueprintCallable, Category="CSW|Geo")
+	double CheckGeoTangent(int32 Samples = 256) const;
+
+	// Release empty atlas pages now. Also done every 64 atlas uploads. Regions are not moved, so
+	// fragmentation inside pages only drops as tiles unload
+	UFUNCTION(BlueprintCallable, Category="CSW")
+	void ReleaseEmptyAtlasPages();
+
 
 protected:
 	// Register component
@@ -265,12 +1126,28 @@ protected:
 	// the shared resources
 	cswResourceManagerPtr	m_resource;
 
+	// nullptr without MemoryBudgetMB
+	cswMemoryBudgetPtr		m_budget;
+
+	// nullptr without HeightCache
+	cswHeightCachePtr		m_heightCache;
+
+	// nullptr without LocalIntersect
+	cswSceneBVHPtr			m_sceneBVH;
+
+	// nullptr without AltitudeLookupDirectory
+	gzAltitudeLookupPtr		m_altitudeLookup;
+
 	UPROPERTY(Transient)
 	TObjectPtr<UMaterialInterface> m_baseMaterial;
 
 private:
 
 	void handleGroundClampResponse(cswSceneCommandGroundClampPositionResponse* response);
+	void handleIntersectResponse(cswSceneCommandIntersectResponse* response);
+
+	// Starts and GZ ray vectors of a batch. Lengths only for line of sight
+	int32 requestIntersections(TArray<FVector3d>&& starts, const TArray<gzVec3D>& rays, TArray<double>&& lengths, int32 intersectMask, bool waitForData);
 
 
 	gzEvent									m_bufferInLock;		// Lock for callback accessing bufferIn
@@ -289,7 +1166,31 @@ private:
 	TMap<gzUInt32, FCSWGroundClampResult>	m_groundClampResponses;
 	gzUInt32							m_groundClampNextRequestId = 0;
 
+	TArray<cswGroundClampBatch>				m_groundClampBatches;		// Pending, few at a time
+
+	// Approximated requests waiting for refinement
+	TMap<gzUInt32, cswApproximateClamp>		m_approximateClamps;
+	cswApproximateClampCounters				m_approximateClampCounters;	// Game thread
+	TMap<gzUInt32, FCSWGroundClampBatchResult>	m_groundClampBatchResponses;
+
+	// Request ids are shared with ground clamp so responses route by id
+	TArray<cswIntersectBatch>				m_intersectBatches;
+	TMap<gzUInt32, FCSWIntersectResult>		m_intersectResponses;
+
 	bool									m_firstRun=false;
+
+	FVector									m_viewLocation = FVector::ZeroVector;	// Last camera for texture residency
+	double									m_viewPixelScale = 0;
+
+	mutable cswGeoContext					m_geoContext;
+
+	mutable cswMatrixCacheEntry				m_matrixCache[4];
+	mutable gzUInt32						m_matrixCacheNext = 0;
+
+	TSet<UCSWRoiNode*>						m_topLevelRois;
+	TSet<UCSWSceneComponent*>				m_outsideRoiContent;	// Geometry without roi pauses the floating origin
+	gzVec3D									m_floatingOffset = gzVec3D(0, 0, 0);
+	gzUInt32								m_floatingOriginRebases = 0;
 };
 
 
@@ -0,0 +1,152 @@
+//*****************************************************************************
+//
+// Copyright (C) SAAB AB
+//
+// All rights, including the copyright, to the computer program(s)
+// herein belong to SAAB AB. The program(s) may be used and/or
+// copied only with the written permission of SAAB AB, or in
+// accordance with the terms and conditions stipulated in the
+// agreement/contract under which the program(s) have been
+// supplied.
+//
+//
+// Information Class:	COMPANY UNCLASSIFIED
+// Defence Secrecy:		NOT CLASSIFIED
+// Export Control:		NOT EXPORT CONTROLLED
+//
+//
+// File			: cswTextureAtlas.h
+// Module		: CSW StreamingMap Unreal
+// Description	: Shared texture pages for small tile images
+// Author		: agent
+// Product		: CSW 1.1.2
+//
+//
+//
+// NOTE:	CSW (Common Synthetic World) is a simulation and presentation
+//			framework for large scale digital twins on multiple platforms
+//
+//
+// Revision History...
+//
+// Who	Date	Description
+//
+// AGT	261019	Created file 					(1.1.3)
+//
+//******************************************************************************
+#pragma once
+
+#include "gzImage.h"
+#include "gzMutex.h"
+#include "PixelFormat.h"
+
+class cswTextureAtlas;
+
+// Region of an atlas page. The area is freed when the last reference goes
+class cswAtlasRegion : public gzReference
+{
+public:
+	GZ_DECLARE_TYPE_INTERFACE;
+
+	virtual ~cswAtlasRegion();
+
+	gzUInt32	page = 0;			// Page id. Unique over all atlases
+	gzUInt32	x = 0;				// Texel position in page mip 0
+	gzUInt32	y = 0;
+	gzUInt32	size = 0;			// Allocated square block
+	gzUInt32	width = 0;			// Image size inside the block
+	gzUInt32	height = 0;
+
+	FVector2f	uvScale;			// Atlas uv = uvOffset + uv * uvScale
+	FVector2f	uvOffset;
+
+	gzImagePtr	image;				// Pixels to copy into the page. Dropped after upload. Game thread
+
+	cswTextureAtlas* getAtlas() const { return m_atlas; }
+
+private:
+
+	friend class cswTextureAtlas;
+
+	gzRefPointer<cswTextureAtlas>	m_atlas;
+};
+
+GZ_DECLARE_REFPTR(cswAtlasRegion);
+
+struct cswAtlasStatistics
+{
+	gzUInt32	pages = 0;
+	gzUInt32	regions = 0;
+	gzUInt64	allocations = 0;		// Regions handed out since start
+	gzUInt64	usedTexels = 0;			// Allocated block area in mip 0
+	gzUInt64	freeTexels = 0;
+	gzUInt64	largestFreeTexels = 0;	// Largest free block in any page
+	gzFloat		fragmentation = 0;		// 1 - sum of largest free block per page / free area
+	gzUInt64	releasedPages = 0;		// Empty pages released by compaction
+};
+
+//! Buddy allocated square pages for small power of two images with the same pixel format and mip count
+//! Regions keep their block aligned in every page mip. Thread safe
+class cswTextureAtlas : public gzReference
+{
+public:
+	GZ_DECLARE_TYPE_INTERFACE;
+
+	cswTextureAtlas(gzUInt32 pageSize = 2048, gzUInt32 minTileSize = 64, gzUInt32 maxTileSize = 256);
+
+	//! Region for the image or nullptr if it is not an atlas candidate
+	cswAtlasRegionPtr allocate(gzImage* image);
+
+	//! Release pages without regions and order pages densest first so new regions fill dense pages
+	//! Regions never move as meshes have baked uvs, so this can not reduce fragmentation inside pages
+	gzVoid releaseEmptyPages();
+
+	//! Pages released since last call. The owner of the page textures drops them
+	TArray<gzUInt32> takeReleasedPages();
+
+	bool getPageLayout(gzUInt32 page, EPixelFormat& format, gzUInt32& mipLevels) const;
+
+	gzUInt32 getPageSize() const { return m_pageSize; }
+
+	cswAtlasStatistics getStatistics() const;
+
+private:
+
+	friend class cswAtlasRegion;
+
+	struct Page
+	{
+		gzUInt32					id = 0;
+		EPixelFormat				format = PF_Unknown;
+		gzUInt32					mipLevels = 1;
+		gzUInt32					regions = 0;
+		gzUInt64					usedTexels = 0;
+		TArray<TArray<FIntPoint>>	freeBlocks;		// Per level. Level 0 is the whole page
+	};
+
+	gzVoid free(gzUInt32 page, gzUInt32 x, gzUInt32 y, gzUInt32 size);
+
+	gzUInt32 levelOf(gzUInt32 size) const;
+
+	bool allocateBlock(Page& page, gzUInt32 level, FIntPoint& position);
+	gzVoid freeBlock(Page& page, gzUInt32 level, FIntPoint position);
+
+	// Mip count shared by all pages for images with mips. Smallest tile keeps one compression block
+	gzUInt32 pageMipLevels() const;
+
+	static bool validImage(gzImage* image, EPixelFormat format, gzUInt32 mipLevels);
+
+	gzUInt32			m_pageSize;
+	gzUInt32			m_minTileSize;
+	gzUInt32			m_maxTileSize;
+	gzUInt32			m_levels;			// Block levels from page size down to min tile size
+
+	mutable gzMutex		m_lock;
+
+	TArray<Page>		m_pages;			// Densest first after compaction
+	TArray<gzUInt32>	m_releasedPages;
+	gzUInt64			m_allocations = 0;
+	gzUInt64			m_releasedPageCount = 0;
+};
+
+GZ_DECLARE_REFPTR(cswTextureAtlas);
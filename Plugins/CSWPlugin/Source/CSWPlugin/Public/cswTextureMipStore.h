@@ -0,0 +1,80 @@
+//*****************************************************************************
+//
+// Copyright (C) SAAB AB
+//
+// All rights, including the copyright, to the computer program(s)
+// herein belong to SAAB AB. The program(s) may be used and/or
+// copied only with the written permission of SAAB AB, or in
+// accordance with the terms and conditions stipulated in the
+// agreement/contract under which the program(s) have been
+// supplied.
+//
+//
+// Information Class:	COMPANY UNCLASSIFIED
+// Defence Secrecy:		NOT CLASSIFIED
+// Export Control:		NOT EXPORT CONTROLLED
+//
+//
+// File			: cswTextureMipStore.h
+// Module		: CSW StreamingMap Unreal
+// Description	: CPU copy of texture mips for residency control
+// Author		: agent
+// Product		: CSW 1.1.2
+//
+//
+//
+// NOTE:	CSW (Common Synthetic World) is a simulation and presentation
+//			framework for large scale digital twins on multiple platforms
+//
+//
+// Revision History...
+//
+// Who	Date	Description
+//
+// AGT	261019	Created file 					(1.1.3)
+//
+//******************************************************************************
+#pragma once
+
+#include "gzReference.h"
+#include "PixelFormat.h"
+
+struct FTexturePlatformData;
+
+//! Full mip chain of a texture on the CPU. The GPU texture holds a tail of it and is rebuilt
+//! from the store when the resident top mip changes. Immutable after creation
+class cswTextureMipStore : public gzReference
+{
+public:
+	GZ_DECLARE_TYPE_INTERFACE;
+
+	//! Copy all mips of the platform data. Thread safe
+	static cswTextureMipStore* create(const FTexturePlatformData* platformData);
+
+	//! New platform data with mips from firstMip and down
+	FTexturePlatformData* createPlatformData(gzUInt32 firstMip) const;
+
+	gzUInt32 getNumMips() const { return m_mips.Num(); }
+
+	//! Largest side of a mip
+	gzUInt32 getMipSize(gzUInt32 mip) const;
+
+	//! Bytes of mips from firstMip and down
+	gzUInt64 getResidentBytes(gzUInt32 firstMip) const;
+
+	gzUInt64 getBytes() const { return getResidentBytes(0); }
+
+private:
+
+	struct Mip
+	{
+		gzUInt32		width = 0;
+		gzUInt32		height = 0;
+		TArray64<uint8>	data;
+	};
+
+	EPixelFormat	m_format = PF_Unknown;
+	TArray<Mip>		m_mips;
+};
+
+GZ_DECLARE_REFPTR(cswTextureMipStore);
@@ -37,14 +37,24 @@
 #pragma once
 
 #include "cswSceneManager.h"
+#include "Interfaces/cswBuildInterface.h"
 
 class cswUESceneManager : public cswSceneManager
 {
 public:
 
+	// Build properties used by factories in prebuild. Set from game thread
+	gzVoid					setBuildProperties(const BuildProperties& buildProperties);
+	BuildProperties			getBuildProperties() const;
+
 	virtual gzReference*	preBuildReference(gzNode* node, const gzUInt64& pathID, gzGroup* parent, const gzUInt64& parentPathID, gzState* state) override;
 	virtual gzVoid			preDestroyReference(gzNode* node, const gzUInt64& pathID, gzReference* userdata) override;
 	virtual gzReference*	updateReference(gzNode* node, const gzUInt64& pathID, gzGroup* parent, const gzUInt64& parentPathID, gzState* state, gzReference* userdata) override;
+
+private:
+
+	mutable gzMutex			m_buildPropertiesLock;
+	BuildProperties			m_buildProperties;
 };
 
 GZ_DECLARE_REFPTR(cswUESceneManager);
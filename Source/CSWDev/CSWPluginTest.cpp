@@ -3,6 +3,7 @@
 
 #include "CSWPluginTest.h"
 #include "cswGroundClampAsyncAction.h"
+#include "cswMeshBVH.h"
 #include "UEGlue/cswUEUtility.h"
 #include "UEGlue/cswUEGlue.h"
 #include "UEGlue/cswUETemplates.h"
@@ -29,6 +30,19 @@ void ACSWDevTest::BeginPlay()
 	bGroundClampTestInFlight = false;
 	bGroundClampTestLogged = false;
 	GroundClampRequestId = 0;
+	GroundClampBatchRequestId = 0;
+	bGroundClampBatchLogged = false;
+	bHeightCacheTestLogged = false;
+	HeightCacheRequestId = 0;
+	LineOfSightRequestId = 0;
+	bLineOfSightLogged = false;
+	bLocalIntersectLogged = false;
+	ApproximateClampIds.Reset();
+	bApproximateClampLogged = false;
+	bMipBenchmarkLogged = false;
+	bSelfChecksLogged = false;
+	bSceneChecksLogged = false;
+	bGeoBenchmarkLogged = false;
 }
 
 
@@ -40,6 +54,288 @@ UCSWGroundClampAsyncAction* ACSWDevTest::RunGroundClampAsyncExample(float Timeou
 	return UCSWGroundClampAsyncAction::GroundClampAsync(this, Scene, GroundClampLatitude, GroundClampLongitude, GroundClampHeightAboveGround, bGroundClampWaitForData, TimeoutSeconds);
 }
 
+// Full chain in milliseconds, best of a few runs
+static double timeMipChain(const TArray<uint8>& level0, uint32 size, cswMipFilter filter)
+{
+	TArray<uint8> source, target;
+
+	double best = 0;
+
+	for (int32 run = 0; run < 3; run++)
+	{
+		source = level0;
+
+		const double start = gzTime::systemSeconds();
+
+		for (uint32 width = size, height = size; width > 1 || height > 1; width = FMath::Max(width / 2, 1u), height = FMath::Max(height / 2, 1u))
+		{
+			target.SetNumUninitialized(FMath::Max(width / 2, 1u) * FMath::Max(height / 2, 1u) * 4);
+
+			cswDownsampleMip(source.GetData(), width, height, filter, TRUE, target.GetData());
+
+			Swap(source, target);
+		}
+
+		const double time = (gzTime::systemSeconds() - start) * 1000.0;
+
+		if (!run || time < best)
+			best = time;
+	}
+
+	return best;
+}
+
+// Largest component difference between the converted texture and gzImage::getPixel, negative if not converted
+static float checkPixelConvert(gzImageType type)
+{
+	const gzUInt32 size = 4;
+
+	gzImagePtr image = gzImage::createImage(type);
+
+	if (!image)
+		return -1;
+
+	image->setSize(size, size);
+	image->createArray(TRUE);
+
+	for (gzUInt32 y = 0; y < size; y++)
+		for (gzUInt32 x = 0; x < size; x++)
+			image->setPixel(x, y, gzRGBA(x / 3.0f, y / 3.0f, (x + y) / 6.0f, (y * size + x) / 15.0f));
+
+	FTexturePlatformData* data = cswUETexturePlatformData(image);
+
+	if (!data || !data->Mips.Num())
+	{
+		delete data;
+		return -1;
+	}
+
+	const uint8* pixels = (const uint8*)data->Mips[0].BulkData.LockReadOnly();
+
+	float error = 0;
+
+	for (gzUInt32 y = 0; y < size && pixels; y++)
+	{
+		for (gzUInt32 x = 0; x < size; x++)
+		{
+			const uint32 index = (y * size + x) * 4;
+
+			float value[4];
+
+			switch (data->PixelFormat)
+			{
+				case PF_R8G8B8A8:
+					for (uint32 c = 0; c < 4; c++)
+						value[c] = pixels[index + c] / 255.0f;
+					break;
+
+				case PF_B8G8R8A8:
+					for (uint32 c = 0; c < 4; c++)
+						value[c] = pixels[index + (c < 3 ? 2 - c : 3)] / 255.0f;
+					break;
+
+				case PF_FloatRGBA:
+					for (uint32 c = 0; c < 4; c++)
+						value[c] = ((const FFloat16*)pixels)[index + c].GetFloat();
+					break;
+
+				case PF_A32B32G32R32F:
+					for (uint32 c = 0; c < 4; c++)
+						value[c] = ((const float*)pixels)[index + c];
+					break;
+
+				default:
+					data->Mips[0].BulkData.Unlock();
+					delete data;
+					return -1;
+			}
+
+			const gzRGBA reference = image->getPixel(x, y);
+
+			error = FMath::Max(error, FMath::Abs(value[0] - reference.getRed()));
+			error = FMath::Max(error, FMath::Abs(value[1] - reference.getGreen()));
+			error = FMath::Max(error, FMath::Abs(value[2] - reference.getBlue()));
+			error = FMath::Max(error, FMath::Abs(value[3] - reference.getAlpha()));
+		}
+	}
+
+	data->Mips[0].BulkData.Unlock();
+	delete data;
+
+	return pixels ? error : -1;
+}
+
+// BC1 color endpoints in 0..1
+static void decode565(uint16 color, float rgb[3])
+{
+	rgb[0] = ((color >> 11) & 31) / 31.0f;
+	rgb[1] = ((color >> 5) & 63) / 63.0f;
+	rgb[2] = (color & 31) / 31.0f;
+}
+
+// RMSE of all components against gzImage::getPixel with the blocks decoded here from the BC1/BC3 layout, not by
+// the plugin decoder. reported is the RMSE the plugin measured. Negative if not compressed to the expected format
+static float checkBlockCompression(gzImage* image, gzBool highQuality, EPixelFormat format, float& reported)
+{
+	FTexturePlatformData* data = cswUECompressedPlatformData(image, highQuality, 0, &reported);
+
+	if (!data || !data->Mips.Num() || data->PixelFormat != format)
+	{
+		delete data;
+		return -1;
+	}
+
+	const uint8* blocks = (const uint8*)data->Mips[0].BulkData.LockReadOnly();
+
+	const bool alpha = format == PF_DXT5;
+	const uint32 blockBytes = alpha ? 16 : 8;
+	const uint32 width = image->getWidth(), height = image->getHeight();
+
+	double sum = 0;
+
+	for (uint32 by = 0; by < height / 4 && blocks; by++)
+	{
+		for (uint32 bx = 0; bx < width / 4; bx++)
+		{
+			const uint8* block = blocks + (by * (width / 4) + bx) * blockBytes;
+			const uint8* color = alpha ? block + 8 : block;
+
+			const uint16 c0 = color[0] | (color[1] << 8);
+			const uint16 c1 = color[2] | (color[3] << 8);
+			const uint32 indices = color[4] | (color[5] << 8) | (color[6] << 16) | ((uint32)color[7] << 24);
+
+			float palette[4][4];
+
+			decode565(c0, palette[0]);
+			decode565(c1, palette[1]);
+
+			palette[0][3] = palette[1][3] = palette[2][3] = palette[3][3] = 1;
+
+			// BC3 colors always use four colors
+			const bool four = alpha || c0 > c1;
+
+			for (uint32 c = 0; c < 3; c++)
+			{
+				palette[2][c] = four ? (2 * palette[0][c] + palette[1][c]) / 3 : (palette[0][c] + palette[1][c]) / 2;
+				palette[3][c] = four ? (palette[0][c] + 2 * palette[1][c]) / 3 : 0;
+			}
+
+			if (!four)
+				palette[3][3] = 0;
+
+			uint64 alphaIndices = 0;
+
+			for (uint32 i = 0; i < 6 && alpha; i++)
+				alphaIndices |= (uint64)block[2 + i] << (8 * i);
+
+			for (uint32 i = 0; i < 16; i++)
+			{
+				float value[4];
+
+				FMemory::Memcpy(value, palette[(indices >> (2 * i)) & 3], sizeof(value));
+
+				if (alpha)
+				{
+					const float a0 = block[0] / 255.0f, a1 = block[1] / 255.0f;
+					const uint32 k = (alphaIndices >> (3 * i)) & 7;
+
+					if (k < 2)
+						value[3] = k ? a1 : a0;
+					else if (block[0] > block[1])
+						value[3] = ((8 - k) * a0 + (k - 1) * a1) / 7;
+					else
+						value[3] = k < 6 ? ((6 - k) * a0 + (k - 1) * a1) / 5 : (k == 6 ? 0.0f : 1.0f);
+				}
+
+				const gzRGBA reference = image->getPixel(bx * 4 + i % 4, by * 4 + i / 4);
+
+				sum += FMath::Square(value[0] - reference.getRed()) + FMath::Square(value[1] - reference.getGreen()) + FMath::Square(value[2] - reference.getBlue());
+
+				if (alpha)
+					sum += FMath::Square(value[3] - reference.getAlpha());
+			}
+		}
+	}
+
+	data->Mips[0].BulkData.Unlock();
+	delete data;
+
+	return blocks ? (float)FMath::Sqrt(sum / ((double)width * height * (alpha ? 4 : 3))) : -1;
+}
+
+// Rays against a tree of a 16x16 quad floor at z 0 with one known triangle above it at z 1. Empty if all match
+static gzString checkMeshBVH()
+{
+	const gzUInt32 cells = 16;
+
+	gzGeometryPtr geom = new gzGeometry;
+
+	geom->setGeoPrimType(GZ_PRIM_TRIS);
+
+	gzArray<gzVec3>& coordinates = geom->getCoordinateArray();
+
+	coordinates.setSize(cells * cells * 6 + 3);
+
+	gzUInt32 index = 0;
+
+	for (gzUInt32 y = 0; y < cells; y++)
+	{
+		for (gzUInt32 x = 0; x < cells; x++)
+		{
+			const gzFloat x0 = (gzFloat)x, y0 = (gzFloat)y;
+
+			const gzVec3 corners[4] = { gzVec3(x0, y0, 0), gzVec3(x0 + 1, y0, 0), gzVec3(x0 + 1, y0 + 1, 0), gzVec3(x0, y0 + 1, 0) };
+
+			for (gzUInt32 corner : { 0, 1, 2, 0, 2, 3 })
+				coordinates[index++] = corners[corner];
+		}
+	}
+
+	coordinates[index++] = gzVec3(5, 5, 1);
+	coordinates[index++] = gzVec3(6, 5, 1);
+	coordinates[index++] = gzVec3(5, 6, 1);
+
+	cswMeshBVHPtr bvh = cswBuildMeshBVH(geom);
+
+	if (!bvh)
+		return "no tree";
+
+	if (bvh->getTriangles() != cells * cells * 2 + 1)
+		return gzString::formatString("%d triangles", bvh->getTriangles());
+
+	// Origin, delta, expected t or 0 for a miss
+	const struct { FVector3d origin; FVector3d delta; double t; } rays[] = {
+		{ FVector3d(5.25, 5.25, 10), FVector3d(0, 0, -20), 0.45 },		// Known triangle before the floor
+		{ FVector3d(5.75, 5.75, 10), FVector3d(0, 0, -20), 0.5 },		// Beside it, on the floor
+		{ FVector3d(2.5, 12.5, 10), FVector3d(0, 0, -20), 0.5 },
+		{ FVector3d(5.25, 5.25, -10), FVector3d(0, 0, 20), 0.5 },		// From below the floor hides the triangle
+		{ FVector3d(5.25, 5.25, 10), FVector3d(0, 0, -5), 0 },			// Ends above the triangle
+		{ FVector3d(20, 20, 10), FVector3d(0, 0, -20), 0 },				// Outside
+	};
+
+	for (const auto& ray : rays)
+	{
+		cswRayHit hit;
+
+		const gzBool found = bvh->intersect(ray.origin, ray.delta, hit);
+
+		if (!ray.t)
+		{
+			if (found)
+				return gzString::formatString("hit at t=%.4f from (%.2f, %.2f, %.2f)", hit.t, ray.origin.X, ray.origin.Y, ray.origin.Z);
+
+			continue;
+		}
+
+		const FVector3d facing(0, 0, -FMath::Sign(ray.delta.Z));
+
+		if (!found || FMath::Abs(hit.t - ray.t) > 1e-6 || !hit.normal.Equals(facing, 1e-6))
+			return gzString::formatString("t=%.4f normal (%.2f, %.2f, %.2f) from (%.2f, %.2f, %.2f), expected t=%.4f", found ? hit.t : -1.0, hit.normal.X, hit.normal.Y, hit.normal.Z, ray.origin.X, ray.origin.Y, ray.origin.Z, ray.t);
+	}
+
+	return gzString();
+}
+
 // Called every frame
 void ACSWDevTest::Tick(float DeltaTime)
 {
@@ -72,6 +368,268 @@ void ACSWDevTest::Tick(float DeltaTime)
 		bGeoTestLogged = true;
 	}
 
+	if (bRunGeoBenchmark && !bGeoBenchmarkLogged && Scene && !Scene->CoordSystem.IsEmpty())
+	{
+		const int32 calls = FMath::Max(GeoBenchmarkCalls, 1);
+
+		FVector3d world(0);
+		double lat(0), lon(0), alt(0);
+
+		double start = gzTime::systemSeconds();
+
+		for (int32 i = 0; i < calls; i++)
+		{
+			Scene->GeodeticToWorld(TestLatitude + (i % 1000) * 1e-5, TestLongitude, TestAltitude, world);
+		}
+
+		const double toWorld = calls / FMath::Max(gzTime::systemSeconds() - start, 1e-9);
+
+		start = gzTime::systemSeconds();
+
+		for (int32 i = 0; i < calls; i++)
+		{
+			Scene->WorldToGeodetic(world + FVector3d(i % 1000, 0, 0), lat, lon, alt);
+		}
+
+		const double toGeodetic = calls / FMath::Max(gzTime::systemSeconds() - start, 1e-9);
+
+		gzString message = gzString::formatString("GeodeticToWorld %.0f calls/s, WorldToGeodetic %.0f calls/s", toWorld, toGeodetic);
+
+		GZMESSAGE(GZ_MESSAGE_NOTICE, "%s", (const char*)message);
+		cswScreenMessage(message);
+
+		// Near the map origin the tangent path applies when GeoTangentTolerance is set. Far always uses gzCoordinate
+		double originLat(0), originLon(0), originAlt(0);
+
+		if (Scene->WorldToGeodetic(FVector3d(Scene->ModelOriginX, Scene->ModelOriginY, Scene->ModelOriginZ) + Scene->getMapLocation(), originLat, originLon, originAlt))
+		{
+			double rates[2];
+
+			for (int32 far = 0; far < 2; far++)
+			{
+				start = gzTime::systemSeconds();
+
+				for (int32 i = 0; i < calls; i++)
+					Scene->GeodeticToWorld(originLat + (far ? 1.0 : 0.0) + (i % 100) * 1e-5, originLon + (i / 100 % 100) * 1e-5, originAlt, world);
+
+				rates[far] = calls / FMath::Max(gzTime::systemSeconds() - start, 1e-9);
+			}
+
+			message = gzString::formatString("GeodeticToWorld near origin %.0f calls/s, 1 degree away %.0f calls/s (tolerance %.3f m)", rates[0], rates[1], Scene->GeoTangentTolerance);
+
+			GZMESSAGE(GZ_MESSAGE_NOTICE, "%s", (const char*)message);
+			cswScreenMessage(message);
+		}
+
+		// GZ/UE matrix conversions as used by camera and ground clamp updates
+		gzVec3D position(0, 0, 0);
+		FVector3d back(0);
+
+		start = gzTime::systemSeconds();
+
+		for (int32 i = 0; i < calls; i++)
+		{
+			position = Scene->UE_2_GZ_Local(world + FVector3d(i % 1000, 0, 0));
+			back = Scene->GZ_2_UE_Local(position);
+		}
+
+		const double matrixConversions = 2.0 * calls / FMath::Max(gzTime::systemSeconds() - start, 1e-9);
+
+		message = gzString::formatString("GZ/UE position conversions %.0f calls/s", matrixConversions);
+
+		GZMESSAGE(GZ_MESSAGE_NOTICE, "%s", (const char*)message);
+		cswScreenMessage(message);
+
+		// Batch throughput for a track picture of 10k and 100k entities
+		for (int32 count : { 10000, 100000 })
+		{
+			TArray<double> latitudes, longitudes, altitudes;
+
+			for (int32 i = 0; i < count; i++)
+			{
+				latitudes.Add(TestLatitude + (i % 1000) * 1e-5);
+				longitudes.Add(TestLongitude + (i / 1000) * 1e-5);
+				altitudes.Add(TestAltitude);
+			}
+
+			FCSWWorldPositions positions;
+
+			start = gzTime::systemSeconds();
+
+			Scene->GeodeticToWorldBatch(latitudes, longitudes, altitudes, positions);
+
+			const double batchToWorld = count / FMath::Max(gzTime::systemSeconds() - start, 1e-9);
+
+			TArray<FVector3d> points;
+
+			for (int32 i = 0; i < count; i++)
+				points.Add(FVector3d(positions.X[i], positions.Y[i], positions.Z[i]));
+
+			FCSWGeodeticPositions geodetic;
+
+			start = gzTime::systemSeconds();
+
+			Scene->WorldToGeodeticBatch(points, geodetic);
+
+			const double batchToGeodetic = count / FMath::Max(gzTime::systemSeconds() - start, 1e-9);
+
+			message = gzString::formatString("Batch %d: GeodeticToWorld %.0f points/s, WorldToGeodetic %.0f points/s", count, batchToWorld, batchToGeodetic);
+
+			GZMESSAGE(GZ_MESSAGE_NOTICE, "%s", (const char*)message);
+			cswScreenMessage(message);
+		}
+
+		bGeoBenchmarkLogged = true;
+	}
+
+	if (bRunMipBenchmark && !bMipBenchmarkLogged)
+	{
+		for (uint32 size : { 256u, 1024u, 4096u })
+		{
+			TArray<uint8> level0;
+			level0.SetNumUninitialized(size * size * 4);
+
+			FRandomStream random(size);
+
+			for (uint8& value : level0)
+				value = (uint8)random.RandHelper(256);
+
+			const double box = timeMipChain(level0, size, CSW_MIP_FILTER_BOX);
+			const double kaiser = timeMipChain(level0, size, CSW_MIP_FILTER_KAISER);
+
+			gzString message = gzString::formatString("Mip chain %dx%d: box %.2f ms, kaiser %.2f ms", size, size, box, kaiser);
+
+			GZMESSAGE(GZ_MESSAGE_NOTICE, "%s", (const char*)message);
+			cswScreenMessage(message);
+		}
+
+		bMipBenchmarkLogged = true;
+	}
+
+	if (bRunSelfChecks && !bSelfChecksLogged)
+	{
+		const struct { gzImageType type; const char* name; } convertTypes[] = {
+			{ GZ_IMAGE_TYPE_RGB_8, "RGB_8" },
+			{ GZ_IMAGE_TYPE_BGR_8, "BGR_8" },
+			{ GZ_IMAGE_TYPE_ABGR_8, "ABGR_8" },
+			{ GZ_IMAGE_TYPE_BWA_8, "BWA_8" },
+			{ GZ_IMAGE_TYPE_BGR_5_6_5, "BGR_5_6_5" },
+			{ GZ_IMAGE_TYPE_BGRA_5_5_5_1, "BGRA_5_5_5_1" },
+			{ GZ_IMAGE_TYPE_RGB_HALF, "RGB_HALF" },
+			{ GZ_IMAGE_TYPE_BWA_HALF, "BWA_HALF" },
+			{ GZ_IMAGE_TYPE_RGB_FLOAT, "RGB_FLOAT" },
+		};
+
+		for (const auto& convert : convertTypes)
+		{
+			// Both sides decode the same stored bits so only rounding may differ
+			const float error = checkPixelConvert(convert.type);
+			const bool passed = error >= 0 && error < 0.005f;
+
+			gzString message = gzString::formatString("Pixel convert %s: %s (max error %.4f)", convert.name, passed ? "pass" : "FAIL", error);
+
+			GZMESSAGE(passed ? GZ_MESSAGE_NOTICE : GZ_MESSAGE_WARNING, "%s", (const char*)message);
+			cswScreenMessage(message, -1, passed ? FColor::Green : FColor::Red);
+		}
+
+		// Flat, smooth and alpha blocks. Bounds are the default TextureCompressionMaxRMSE
+		const struct { const char* name; EPixelFormat format; float bound; } compressTypes[] = {
+			{ "flat", PF_DXT1, 0.01f },
+			{ "gradient", PF_DXT1, 0.02f },
+			{ "alpha gradient", PF_DXT5, 0.02f },
+		};
+
+		const gzUInt32 size = 64;
+
+		for (int32 i = 0; i < UE_ARRAY_COUNT(compressTypes); i++)
+		{
+			const auto& compress = compressTypes[i];
+
+			gzImagePtr image = gzImage::createImage(GZ_IMAGE_TYPE_RGBA_8);
+
+			image->setSize(size, size);
+			image->createArray(TRUE);
+
+			for (gzUInt32 y = 0; y < size; y++)
+			{
+				for (gzUInt32 x = 0; x < size; x++)
+				{
+					const float u = x / (size - 1.0f), v = y / (size - 1.0f);
+
+					if (i == 0)
+						image->setPixel(x, y, gzRGBA(0.3f, 0.6f, 0.2f, 1.0f));
+					else if (i == 1)
+						image->setPixel(x, y, gzRGBA(u, v, 0.5f, 1.0f));
+					else
+						image->setPixel(x, y, gzRGBA(0.8f, 0.4f, 0.1f, u));
+				}
+			}
+
+			for (gzBool highQuality : { FALSE, TRUE })
+			{
+				float reported = -1;
+
+				const float error = checkBlockCompression(image, highQuality, compress.format, reported);
+				const bool passed = error >= 0 && error <= compress.bound && reported >= 0 && reported <= compress.bound;
+
+				gzString message = gzString::formatString("Block compression %s %s: %s (RMSE %.4f, reported %.4f, bound %.3f)", compress.name, highQuality ? "high" : "fast", passed ? "pass" : "FAIL", error, reported, compress.bound);
+
+				GZMESSAGE(passed ? GZ_MESSAGE_NOTICE : GZ_MESSAGE_WARNING, "%s", (const char*)message);
+				cswScreenMessage(message, -1, passed ? FColor::Green : FColor::Red);
+			}
+		}
+
+		const gzString bvhError = checkMeshBVH();
+
+		gzString message = !bvhError.isEmpty() ? gzString("Mesh BVH rays: FAIL (") + bvhError + ")" : gzString("Mesh BVH rays: pass");
+
+		GZMESSAGE(!bvhError.isEmpty() ? GZ_MESSAGE_WARNING : GZ_MESSAGE_NOTICE, "%s", (const char*)message);
+		cswScreenMessage(message, -1, !bvhError.isEmpty() ? FColor::Red : FColor::Green);
+
+		bSelfChecksLogged = true;
+	}
+
+	if (bRunSelfChecks && !bSceneChecksLogged && Scene)
+	{
+		// Full build and vertex edit without a game thread update between them
+		{
+			const bool passed = Scene->CheckPartialGeometryUpdate();
+
+			gzString message = gzString::formatString("Partial geometry update after unshown build: %s", passed ? "pass" : "FAIL");
+
+			GZMESSAGE(passed ? GZ_MESSAGE_NOTICE : GZ_MESSAGE_WARNING, "%s", (const char*)message);
+			cswScreenMessage(message, -1, passed ? FColor::Green : FColor::Red);
+		}
+
+		// Points in zones on both hemispheres and both sides of Greenwich, away from zone edges
+		const double kernelPoints[][2] = { { 59.33, 18.5 }, { 69.65, 25.5 }, { 0.5, -177.0 }, { 40.7, -74.0 }, { -33.9, 151.2 }, { -45.0, 170.5 } };
+
+		for (const auto& point : kernelPoints)
+		{
+			const double error = Scene->CheckGeoKernels(point[0], point[1]);
+			const bool passed = error >= 0 && error < 1e-3;
+
+			gzString message = gzString::formatString("Geo kernels lat=%.2f lon=%.2f: %s (max error %.6f m)", point[0], point[1], passed ? "pass" : "FAIL", error);
+
+			GZMESSAGE(passed ? GZ_MESSAGE_NOTICE : GZ_MESSAGE_WARNING, "%s", (const char*)message);
+			cswScreenMessage(message, -1, passed ? FColor::Green : FColor::Red);
+		}
+
+		// The tangent needs the map coordinate system
+		if (!Scene->CoordSystem.IsEmpty() && Scene->GeoTangentTolerance > 0)
+		{
+			const double error = Scene->CheckGeoTangent();
+			const bool passed = error >= 0 && error <= Scene->GeoTangentTolerance;
+
+			gzString message = error < 0 ? gzString("Geo tangent: not used at the origin") : gzString::formatString("Geo tangent at crossover radius: %s (max error %.4f m, tolerance %.4f m)", passed ? "pass" : "FAIL", error, Scene->GeoTangentTolerance);
+
+			GZMESSAGE(passed || error < 0 ? GZ_MESSAGE_NOTICE : GZ_MESSAGE_WARNING, "%s", (const char*)message);
+			cswScreenMessage(message, -1, passed ? FColor::Green : FColor::Red);
+		}
+
+		bSceneChecksLogged = true;
+	}
+
 	if (bRunGroundClampTest && !bGroundClampTestLogged && !bGroundClampTestInFlight && Scene && !Scene->CoordSystem.IsEmpty())
 	{
 		GroundClampRequestId = Scene->RequestGroundClampPosition(GroundClampLatitude, GroundClampLongitude, GroundClampHeightAboveGround, bGroundClampWaitForData);
@@ -99,6 +657,210 @@ void ACSWDevTest::Tick(float DeltaTime)
 				OnGroundClampTestFailed();
 		}
 	}
+
+	if (bRunGroundClampBatchTest && !bGroundClampBatchLogged && !GroundClampBatchRequestId && Scene && !Scene->CoordSystem.IsEmpty() && GroundClampBatchSize > 0)
+	{
+		// Square grid with 10 m spacing
+		const int32 side = FMath::CeilToInt32(FMath::Sqrt((double)GroundClampBatchSize));
+
+		TArray<double> latitudes, longitudes;
+
+		latitudes.SetNumUninitialized(GroundClampBatchSize);
+		longitudes.SetNumUninitialized(GroundClampBatchSize);
+
+		for (int32 i = 0; i < GroundClampBatchSize; i++)
+		{
+			latitudes[i] = GroundClampLatitude + (i / side - side / 2) * 1e-4;
+			longitudes[i] = GroundClampLongitude + (i % side - side / 2) * 2e-4;
+		}
+
+		GroundClampBatchStart = gzTime::systemSeconds();
+		GroundClampBatchRequestId = Scene->RequestGroundClampBatch(latitudes, longitudes, GroundClampHeightAboveGround, bGroundClampWaitForData);
+
+		if (!GroundClampBatchRequestId)
+			bGroundClampBatchLogged = true;
+	}
+
+	if (GroundClampBatchRequestId && !bGroundClampBatchLogged && Scene)
+	{
+		FCSWGroundClampBatchResult result;
+
+		if (Scene->TryGetGroundClampBatchResponse(GroundClampBatchRequestId, result))
+		{
+			gzString message = gzString::formatString("Ground clamp batch %d points, %d clamped in %.1f ms", result.Valid.Num(), result.Clamped, (gzTime::systemSeconds() - GroundClampBatchStart) * 1000.0);
+
+			GZMESSAGE(GZ_MESSAGE_NOTICE, "%s", (const char*)message);
+			cswScreenMessage(message);
+
+			bGroundClampBatchLogged = true;
+		}
+	}
+
+	if (bRunLineOfSightTest && !bLineOfSightLogged && !LineOfSightRequestId && Scene && !Scene->CoordSystem.IsEmpty() && LineOfSightBatchSize > 0)
+	{
+		TArray<FVector3d> from, to;
+
+		from.SetNumUninitialized(LineOfSightBatchSize);
+		to.SetNumUninitialized(LineOfSightBatchSize);
+
+		bool valid = true;
+
+		// Observer 100 m up, targets on the ground 1 km away
+		for (int32 i = 0; i < LineOfSightBatchSize && valid; i++)
+		{
+			const double angle = 2 * UE_DOUBLE_PI * i / LineOfSightBatchSize;
+
+			valid = Scene->GeodeticToWorld(GroundClampLatitude, GroundClampLongitude, 100, from[i]) &&
+					Scene->GeodeticToWorld(GroundClampLatitude + 0.009 * FMath::Cos(angle), GroundClampLongitude + 0.018 * FMath::Sin(angle), 0, to[i]);
+		}
+
+		LineOfSightStart = gzTime::systemSeconds();
+		LineOfSightRequestId = valid ? Scene->RequestLineOfSight(from, to) : 0;
+
+		if (!LineOfSightRequestId)
+			bLineOfSightLogged = true;
+	}
+
+	if (LineOfSightRequestId && !bLineOfSightLogged && Scene)
+	{
+		FCSWIntersectResult result;
+
+		if (Scene->TryGetIntersectResponse(LineOfSightRequestId, result))
+		{
+			const double seconds = gzTime::systemSeconds() - LineOfSightStart;
+
+			int32 visible = 0;
+
+			for (bool v : result.Visible)
+				visible += v ? 1 : 0;
+
+			gzString message = gzString::formatString("Line of sight %d checks, %d visible in %.1f ms (%.0f checks/s)", result.Visible.Num(), visible, seconds * 1000.0, result.Visible.Num() / FMath::Max(seconds, 1e-9));
+
+			GZMESSAGE(GZ_MESSAGE_NOTICE, "%s", (const char*)message);
+			cswScreenMessage(message);
+
+			bLineOfSightLogged = true;
+		}
+	}
+
+	if (bRunApproximateClampTest && !bApproximateClampLogged && !ApproximateClampIds.Num() && Scene && !Scene->CoordSystem.IsEmpty() && ApproximateClampCount > 0)
+	{
+		const int32 side = FMath::CeilToInt32(FMath::Sqrt((double)ApproximateClampCount));
+
+		ApproximateClampStart = gzTime::systemSeconds();
+
+		for (int32 i = 0; i < ApproximateClampCount; i++)
+		{
+			FCSWGroundClampResult approximate;
+
+			const int32 requestId = Scene->RequestGroundClampApproximate(GroundClampLatitude + 0.001 * (i % side), GroundClampLongitude + 0.002 * (i / side), approximate, GroundClampHeightAboveGround);
+
+			if (requestId)
+				ApproximateClampIds.Add(requestId);
+		}
+
+		if (!ApproximateClampIds.Num())
+			bApproximateClampLogged = true;
+	}
+
+	if (ApproximateClampIds.Num() && !bApproximateClampLogged && Scene)
+	{
+		for (int32 i = ApproximateClampIds.Num() - 1; i >= 0; i--)
+		{
+			FCSWGroundClampResult result;
+
+			if (Scene->TryGetGroundClampResponse(ApproximateClampIds[i], result))
+				ApproximateClampIds.RemoveAtSwap(i);
+		}
+
+		// Unanswered requests give up after a while
+		if (!ApproximateClampIds.Num() || gzTime::systemSeconds() - ApproximateClampStart > 30.0)
+		{
+			FCSWApproximateClampStatistics stats = Scene->GetApproximateClampStatistics();
+
+			gzString message = gzString::formatString("Approximate clamp %lld of %lld placed after %.3f ms, refined %lld after %.1f ms. Error mean %.2f m max %.2f m", stats.Approximated, stats.Requests, stats.MeanApproximateMilliseconds, stats.Refined, stats.MeanRefinedMilliseconds, stats.MeanError, stats.MaxError);
+
+			GZMESSAGE(GZ_MESSAGE_NOTICE, "%s", (const char*)message);
+			cswScreenMessage(message);
+
+			bApproximateClampLogged = true;
+		}
+	}
+
+	// Wait for some geometry to be built before measuring
+	if (bRunLocalIntersectTest && !bLocalIntersectLogged && Scene && !Scene->CoordSystem.IsEmpty() && LineOfSightBatchSize > 0 && Scene->GetLocalIntersectStatistics().Components)
+	{
+		TArray<FVector> from, to;
+
+		for (int32 i = 0; i < LineOfSightBatchSize; i++)
+		{
+			const double angle = 2 * UE_DOUBLE_PI * i / LineOfSightBatchSize;
+
+			FVector3d a, b;
+
+			if (!Scene->GeodeticToWorld(GroundClampLatitude, GroundClampLongitude, 100, a) ||
+				!Scene->GeodeticToWorld(GroundClampLatitude + 0.009 * FMath::Cos(angle), GroundClampLongitude + 0.018 * FMath::Sin(angle), 0, b))
+				continue;
+
+			// End point on the ground is not a blocker
+			from.Add(FVector(a));
+			to.Add(FVector(b - (b - a).GetSafeNormal() * 100.0));
+		}
+
+		const int32 valid = from.Num();
+
+		int32 clear = 0;
+
+		const double start = gzTime::systemSeconds();
+
+		for (int32 i = 0; i < valid; i++)
+		{
+			FCSWLocalHit hit;
+
+			if (!Scene->IntersectSegment(from[i], to[i], hit))
+				clear++;
+		}
+
+		const double seconds = gzTime::systemSeconds() - start;
+
+		FCSWLocalIntersectStatistics stats = Scene->GetLocalIntersectStatistics();
+
+		gzString message = gzString::formatString("Local intersect %d segments, %d clear in %.2f ms (%.0f/s). %d trees, %lld triangles, %lld bytes", valid, clear, seconds * 1000.0, valid / FMath::Max(seconds, 1e-9), stats.Meshes, stats.Triangles, stats.Bytes);
+
+		GZMESSAGE(GZ_MESSAGE_NOTICE, "%s", (const char*)message);
+		cswScreenMessage(message);
+
+		bLocalIntersectLogged = true;
+	}
+
+	if (bRunHeightCacheTest && !bHeightCacheTestLogged && Scene && Scene->HeightCache && !Scene->CoordSystem.IsEmpty())
+	{
+		FCSWHeightResult result;
+
+		// One async request fills the cache if no terrain covers the position
+		if (Scene->GetGroundHeight(GroundClampLatitude, GroundClampLongitude, result, !HeightCacheRequestId))
+		{
+			const int32 queries = 100000;
+
+			const double start = gzTime::systemSeconds();
+
+			FCSWHeightResult query;
+
+			for (int32 i = 0; i < queries; i++)
+				Scene->GetGroundHeight(GroundClampLatitude + (i % 100) * 1e-6, GroundClampLongitude, query, false);
+
+			const double rate = queries / FMath::Max(gzTime::systemSeconds() - start, 1e-9);
+
+			gzString message = gzString::formatString("Height cache %.2f m from %s (accuracy %.2f m), %.0f queries/s", result.Altitude, result.Source == ECSWHeightSource::Terrain ? "terrain" : "ground clamp", result.Accuracy, rate);
+
+			GZMESSAGE(GZ_MESSAGE_NOTICE, "%s", (const char*)message);
+			cswScreenMessage(message);
+
+			bHeightCacheTestLogged = true;
+		}
+		else if (result.RequestId)
+			HeightCacheRequestId = result.RequestId;
+	}
 }
 
 #include "data.h"
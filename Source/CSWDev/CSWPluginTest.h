@@ -47,6 +47,51 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="CSW|Test")
 	bool bGroundClampWaitForData = false;
 
+	// Clamp a grid of points around the ground clamp position in one batch once and report the time
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="CSW|Test")
+	bool bRunGroundClampBatchTest = false;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="CSW|Test")
+	int32 GroundClampBatchSize = 5000;
+
+	// Line of sight from above the ground clamp position to a ring of points once and report checks per second
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="CSW|Test")
+	bool bRunLineOfSightTest = false;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="CSW|Test")
+	int32 LineOfSightBatchSize = 1000;
+
+	// Approximate clamps around the ground clamp position and time to first placement against the refined answers.
+	// Needs AltitudeLookupDirectory on the scene for the approximate part
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="CSW|Test")
+	bool bRunApproximateClampTest = false;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="CSW|Test")
+	int32 ApproximateClampCount = 100;
+
+	// Same segments through the local intersect trees once. Needs LocalIntersect on the scene
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="CSW|Test")
+	bool bRunLocalIntersectTest = false;
+
+	// Query the scene height cache at the ground clamp position until it hits, then report the query rate once
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="CSW|Test")
+	bool bRunHeightCacheTest = false;
+
+	// Calls per second of GeodeticToWorld and WorldToGeodetic around the test position once, then batch throughput
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="CSW|Test")
+	bool bRunGeoBenchmark = false;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="CSW|Test")
+	int32 GeoBenchmarkCalls = 100000;
+
+	// Time box and Kaiser mip chains for 256, 1024 and 4096 RGBA images once
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="CSW|Test")
+	bool bRunMipBenchmark = false;
+
+	// Compare plugin utilities against reference results once and report pass or fail
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="CSW|Test")
+	bool bRunSelfChecks = false;
+
 	UFUNCTION(BlueprintCallable, Category="CSW|Test")
 	UCSWGroundClampAsyncAction* RunGroundClampAsyncExample(float TimeoutSeconds = 2.0f);
 
@@ -75,6 +120,54 @@ public:
 
 	UPROPERTY(Transient)
 	bool bGroundClampTestLogged = false;
+
+	UPROPERTY(Transient)
+	int32 GroundClampBatchRequestId = 0;
+
+	UPROPERTY(Transient)
+	double GroundClampBatchStart = 0;
+
+	UPROPERTY(Transient)
+	bool bGroundClampBatchLogged = false;
+
+	UPROPERTY(Transient)
+	bool bHeightCacheTestLogged = false;
+
+	UPROPERTY(Transient)
+	int32 LineOfSightRequestId = 0;
+
+	UPROPERTY(Transient)
+	double LineOfSightStart = 0;
+
+	UPROPERTY(Transient)
+	bool bLineOfSightLogged = false;
+
+	UPROPERTY(Transient)
+	bool bLocalIntersectLogged = false;
+
+	UPROPERTY(Transient)
+	TArray<int32> ApproximateClampIds;
+
+	UPROPERTY(Transient)
+	double ApproximateClampStart = 0;
+
+	UPROPERTY(Transient)
+	bool bApproximateClampLogged = false;
+
+	UPROPERTY(Transient)
+	int32 HeightCacheRequestId = 0;
+
+	UPROPERTY(Transient)
+	bool bMipBenchmarkLogged = false;
+
+	UPROPERTY(Transient)
+	bool bSelfChecksLogged = false;
+
+	UPROPERTY(Transient)
+	bool bSceneChecksLogged = false;
+
+	UPROPERTY(Transient)
+	bool bGeoBenchmarkLogged = false;
 protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;